@@ -11,7 +11,6 @@
 
 #include "../renderer/pathtrace.h"
 
-#include "../datatypes/vertexbuffer.h"
 #include "../datatypes/poly.h"
 #include "../datatypes/vector.h"
 #include "../datatypes/bbox.h"
@@ -19,6 +18,7 @@
 #include "../datatypes/mesh.h"
 #include "../datatypes/sphere.h"
 #include "../datatypes/instance.h"
+#include "../utils/mempool.h"
 
 /*
  * This BVH builder is based on "On fast Construction of SAH-based Bounding Volume Hierarchies",
@@ -45,6 +45,7 @@ struct bvh {
 	struct bvhNode* nodes;
 	int *primIndices;
 	unsigned nodeCount;
+	unsigned primCount;
 };
 
 // Bin used to approximate the SAH.
@@ -72,10 +73,10 @@ static inline void loadBBoxFromNode(struct boundingBox *bbox, const struct bvhNo
 	bbox->max.z = node->bounds[5];
 }
 
-static inline float nodeArea(const struct bvhNode *node) {
+static inline float nodeCost(const struct bvhNode *node, float (*cost)(const struct boundingBox *)) {
 	struct boundingBox bbox;
 	loadBBoxFromNode(&bbox, node);
-	return bboxHalfArea(&bbox);
+	return cost(&bbox);
 }
 
 static inline void makeLeaf(struct bvhNode* node, unsigned begin, unsigned primCount) {
@@ -134,6 +135,7 @@ static void buildBvhRecursive(
 	struct bvh *bvh,
 	const struct boundingBox *bboxes,
 	const struct vector *centers,
+	float (*cost)(const struct boundingBox *),
 	unsigned begin, unsigned end,
 	unsigned depth)
 {
@@ -173,7 +175,7 @@ static void buildBvhRecursive(
 			Bin *bin = &bins[axis][i - 1];
 			curCount += bin->count;
 			extendBBox(&curBBox, &bin->bbox);
-			bin->cost = curCount * bboxHalfArea(&curBBox);
+			bin->cost = curCount * cost(&curBBox);
 		}
 
 		// Sweep from the left to the right to compute the full cost and find the minimum.
@@ -183,10 +185,10 @@ static void buildBvhRecursive(
 			Bin *bin = &bins[axis][i];
 			curCount += bin->count;
 			extendBBox(&curBBox, &bin->bbox);
-			float cost = curCount * bboxHalfArea(&curBBox) + bins[axis][i + 1].cost;
-			if (cost < minCost[axis]) {
+			float splitCost = curCount * cost(&curBBox) + bins[axis][i + 1].cost;
+			if (splitCost < minCost[axis]) {
 				minBin[axis] = i + 1;
-				minCost[axis] = cost;
+				minCost[axis] = splitCost;
 			}
 		}
 	}
@@ -197,7 +199,7 @@ static void buildBvhRecursive(
 	if (minCost[2] < minCost[minAxis]) minAxis = 2;
 
 	// Determine if splitting is beneficial or not
-	float leafCost = nodeArea(node) * (primCount - TRAVERSAL_COST);
+	float leafCost = nodeCost(node, cost) * (primCount - TRAVERSAL_COST);
 	if (minCost[minAxis] > leafCost) {
 		if (primCount > MAX_LEAF_SIZE) {
 			// Fallback strategy to avoid large leaves: Approximate median split
@@ -234,22 +236,24 @@ static void buildBvhRecursive(
 		node->firstChildOrPrim = leftIndex;
 		node->isLeaf = false;
 
-		buildBvhRecursive(leftIndex, bvh, bboxes, centers, begin, beginRight, depth + 1);
-		buildBvhRecursive(rightIndex, bvh, bboxes, centers, beginRight, end, depth + 1);
+		buildBvhRecursive(leftIndex, bvh, bboxes, centers, cost, begin, beginRight, depth + 1);
+		buildBvhRecursive(rightIndex, bvh, bboxes, centers, cost, beginRight, end, depth + 1);
 	} else {
 		makeLeaf(node, begin, primCount);
 	}
 }
 
 // Builds a BVH using the provided callback to obtain bounding boxes and centers for each primitive
-static inline struct bvh *buildBvhGeneric(
+struct bvh *buildBvhGeneric(
 	void* userData,
 	void (*getBBoxAndCenter)(void*, unsigned, struct boundingBox*, struct vector*),
+	float (*cost)(const struct boundingBox *),
 	unsigned count)
 {
 	if (count < 1) {
 		struct bvh *bvh = malloc(sizeof(struct bvh));
 		bvh->nodeCount = 0;
+		bvh->primCount = 0;
 		bvh->nodes = NULL;
 		bvh->primIndices = NULL;
 		return bvh;
@@ -273,11 +277,12 @@ static inline struct bvh *buildBvhGeneric(
 
 	struct bvh *bvh = malloc(sizeof(struct bvh));
 	bvh->nodeCount = 1;
+	bvh->primCount = count;
 	bvh->nodes = malloc(sizeof(struct bvhNode) * maxNodes);
 	bvh->primIndices = primIndices;
 	storeBBoxInNode(&bvh->nodes[0], &rootBBox);
 
-	buildBvhRecursive(0, bvh, bboxes, centers, 0, count, 0);
+	buildBvhRecursive(0, bvh, bboxes, centers, cost, 0, count, 0);
 
 	// Shrink array of nodes (since some leaves may contain more than 1 primitive)
 	bvh->nodes = realloc(bvh->nodes, sizeof(struct bvhNode) * bvh->nodeCount);
@@ -287,10 +292,11 @@ static inline struct bvh *buildBvhGeneric(
 }
 
 static void getPolyBBoxAndCenter(void *userData, unsigned i, struct boundingBox *bbox, struct vector *center) {
-	struct poly *polys = userData;
-	struct vector v0 = g_vertices[polys[i].vertexIndex[0]];
-	struct vector v1 = g_vertices[polys[i].vertexIndex[1]];
-	struct vector v2 = g_vertices[polys[i].vertexIndex[2]];
+	const struct mesh *mesh = userData;
+	const struct poly *p = &mesh->polygons[i];
+	struct vector v0 = mesh->vertices[p->vertexIndex[0]];
+	struct vector v1 = mesh->vertices[p->vertexIndex[1]];
+	struct vector v2 = mesh->vertices[p->vertexIndex[2]];
 	*center = getMidPoint(v0, v1, v2);
 	bbox->min = vecMin(v0, vecMin(v1, v2));
 	bbox->max = vecMax(v0, vecMax(v1, v2));
@@ -302,8 +308,46 @@ struct boundingBox getRootBoundingBox(const struct bvh *bvh) {
 	return box;
 }
 
-struct bvh *buildBottomLevelBvh(struct poly *polys, unsigned count) {
-	return buildBvhGeneric(polys, getPolyBBoxAndCenter, count);
+unsigned getBvhNodeCount(const struct bvh *bvh) {
+	return bvh->nodeCount;
+}
+
+bool getBvhNode(const struct bvh *bvh, unsigned index, struct boundingBox *bbox, unsigned *firstChildOrPrim, unsigned *primCount) {
+	const struct bvhNode *node = &bvh->nodes[index];
+	loadBBoxFromNode(bbox, node);
+	*firstChildOrPrim = node->firstChildOrPrim;
+	*primCount = node->primCount;
+	return node->isLeaf;
+}
+
+int getBvhPrimIndex(const struct bvh *bvh, unsigned index) {
+	return bvh->primIndices[index];
+}
+
+size_t bvhNodeSize(void) {
+	return sizeof(struct bvhNode);
+}
+
+void getBvhData(const struct bvh *bvh, const void **nodes, unsigned *nodeCount, const int **primIndices, unsigned *primCount) {
+	*nodes = bvh->nodes;
+	*nodeCount = bvh->nodeCount;
+	*primIndices = bvh->primIndices;
+	*primCount = bvh->primCount;
+}
+
+struct bvh *wrapBvhData(const void *nodes, unsigned nodeCount, const int *primIndices, unsigned primCount, struct block **pool) {
+	struct bvh *bvh = allocBlock(pool, sizeof(*bvh));
+	*bvh = (struct bvh){
+		.nodes = (struct bvhNode *)nodes,
+		.primIndices = (int *)primIndices,
+		.nodeCount = nodeCount,
+		.primCount = primCount
+	};
+	return bvh;
+}
+
+struct bvh *buildBottomLevelBvh(const struct mesh *mesh) {
+	return buildBvhGeneric((void *)mesh, getPolyBBoxAndCenter, bboxHalfArea, mesh->polyCount);
 }
 
 static void getInstanceBBoxAndCenter(void *userData, unsigned i, struct boundingBox *bbox, struct vector *center) {
@@ -312,7 +356,7 @@ static void getInstanceBBoxAndCenter(void *userData, unsigned i, struct bounding
 }
 
 struct bvh *buildTopLevelBvh(struct instance *instances, unsigned instanceCount) {
-	return buildBvhGeneric(instances, getInstanceBBoxAndCenter, instanceCount);
+	return buildBvhGeneric(instances, getInstanceBBoxAndCenter, bboxHalfArea, instanceCount);
 }
 
 static inline float fastMultiplyAdd(float a, float b, float c) {
@@ -446,11 +490,11 @@ static inline bool intersectBottomLevelLeaf(
 	const struct lightRay *ray,
 	struct hitRecord *isect)
 {
-	struct poly *polygons = userData;
+	const struct mesh *mesh = userData;
 	bool found = false;
 	for (int i = 0; i < leaf->primCount; ++i) {
-		struct poly *p = &polygons[bvh->primIndices[leaf->firstChildOrPrim + i]];
-		if (rayIntersectsWithPolygon(ray, p, isect)) {
+		struct poly *p = &mesh->polygons[bvh->primIndices[leaf->firstChildOrPrim + i]];
+		if (rayIntersectsWithPolygon(ray, p, mesh->vertices, isect)) {
 			isect->polygon = p;
 			found = true;
 		}
@@ -459,7 +503,7 @@ static inline bool intersectBottomLevelLeaf(
 }
 
 bool traverseBottomLevelBvh(const struct mesh *mesh, const struct lightRay *ray, struct hitRecord *isect) {
-	return traverseBvhGeneric(mesh->polygons, mesh->bvh, intersectBottomLevelLeaf, ray, isect);
+	return traverseBvhGeneric((void *)mesh, mesh->bvh, intersectBottomLevelLeaf, ray, isect);
 }
 
 static inline bool intersectTopLevelLeaf(
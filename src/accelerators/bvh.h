@@ -9,6 +9,7 @@
 #pragma once
 
 #include <stdbool.h>
+#include <stddef.h>
 
 struct lightRay;
 struct hitRecord;
@@ -16,22 +17,48 @@ struct mesh;
 struct poly;
 struct instance;
 struct boundingBox;
+struct vector;
+struct block;
 
 struct bvh;
 
 /// Returns the bounding box of the root of the given BVH
 struct boundingBox getRootBoundingBox(const struct bvh *bvh);
 
-/// Builds a BVH for a given set of polygons
-/// @param polygons Array of polygons to process
-/// @param count Amount of polygons given
-struct bvh *buildBottomLevelBvh(struct poly *polys, unsigned count);
+/// Builds a BVH for any kind of primitive
+/// @param userData Passed to getBBoxAndCenter
+/// @param getBBoxAndCenter Callback that returns the bounding box and center of the i-th primitive
+/// @param cost Cost of a node, per primitive in it. bboxHalfArea() gives the regular surface area heuristic.
+/// @param count Amount of primitives
+struct bvh *buildBvhGeneric(void *userData, void (*getBBoxAndCenter)(void *, unsigned, struct boundingBox *, struct vector *), float (*cost)(const struct boundingBox *), unsigned count);
+
+/// Builds a BVH for the polygons of a mesh
+/// @param mesh Mesh to process
+struct bvh *buildBottomLevelBvh(const struct mesh *mesh);
 
 /// Builds a top-level BVH for a given set of instances
 /// @param instances Instances to build a top-level BVH for
 /// @param instanceCount Amount of instances
 struct bvh *buildTopLevelBvh(struct instance *instances, unsigned instanceCount);
 
+/// Node access, for structures that mirror the topology of a BVH.
+/// The children of an inner node are at firstChildOrPrim and firstChildOrPrim + 1,
+/// leaves span primCount entries in the primitive index array, starting at firstChildOrPrim.
+unsigned getBvhNodeCount(const struct bvh *bvh);
+/// @return true if the node is a leaf
+bool getBvhNode(const struct bvh *bvh, unsigned index, struct boundingBox *bbox, unsigned *firstChildOrPrim, unsigned *primCount);
+int getBvhPrimIndex(const struct bvh *bvh, unsigned index);
+
+/// Size of one node in the arrays returned by getBvhData()
+size_t bvhNodeSize(void);
+
+/// Raw node and primitive index arrays of a BVH, for writing it out as is
+void getBvhData(const struct bvh *bvh, const void **nodes, unsigned *nodeCount, const int **primIndices, unsigned *primCount);
+
+/// Wrap arrays written out from getBvhData(), without copying them
+/// @param pool Memory pool to allocate the BVH from. The arrays stay owned by the caller, so these are never passed to destroyBvh().
+struct bvh *wrapBvhData(const void *nodes, unsigned nodeCount, const int *primIndices, unsigned primCount, struct block **pool);
+
 /// Intersect a ray with a scene top-level BVH
 bool traverseTopLevelBvh(const struct instance *instances, const struct bvh *bvh, const struct lightRay *ray, struct hitRecord *isect);
 
@@ -21,6 +21,7 @@
 #include "utils/platform/terminal.h"
 #include "utils/assert.h"
 #include "datatypes/image/texture.h"
+#include "datatypes/image/texturecache.h"
 #include "utils/ui.h"
 #include "utils/timer.h"
 #include "utils/args.h"
@@ -29,6 +30,8 @@
 #include "utils/protocol/server.h"
 #include "utils/protocol/worker.h"
 #include "utils/filecache.h"
+#include "utils/benchmark.h"
+#include "utils/loaders/bakedscene.h"
 
 #define VERSION "0.6.3"
 
@@ -88,10 +91,11 @@ void crWriteImage() {
 			struct imageFile *file = newImageFile(currentImage, g_renderer->prefs.imgFilePath, g_renderer->prefs.imgFileName, g_renderer->prefs.imgCount, g_renderer->prefs.imgType);
 			file->info = (struct renderInfo){
 				.bounces = crGetBounces(),
-				.samples = crGetSampleCount(),
+				.samples = g_renderer->state.completedSamples,
 				.crayVersion = crGetVersion(),
 				.gitHash = crGitHash(),
 				.renderTime = getMs(*g_renderer->state.timer),
+				.timeLimit = g_renderer->prefs.timeLimit,
 				.threadCount = crGetThreadCount()
 			};
 			writeImage(file);
@@ -150,6 +154,18 @@ int crLoadSceneFromBuf(char *buf) {
 	return loadScene(g_renderer, buf);
 }
 
+bool crIsBakedScene(char *filePath) {
+	return isBakedScene(filePath);
+}
+
+int crLoadBakedScene(char *filePath) {
+	return loadBakedScene(g_renderer, filePath);
+}
+
+int crBakeScene() {
+	return bakeScene(g_renderer, stringPref("bake")) ? 0 : -1;
+}
+
 void crLog(const char *fmt, ...) {
 	char buf[512];
 	va_list vl;
@@ -279,6 +295,7 @@ void crStartRenderer() {
 	startTimer(g_renderer->state.timer);
 	currentImage = renderFrame(g_renderer);
 	printDuration(getMs(*g_renderer->state.timer));
+	if (g_renderer->scene->textureCache) printTextureCacheStats(g_renderer->scene->textureCache);
 	destroyDisplay();
 }
 
@@ -286,6 +303,10 @@ void crStartRenderWorker() {
 	startWorkerServer();
 }
 
+int crRunBenchmark() {
+	return runBenchmark();
+}
+
 //Interactive mode
 void crStartInteractive(void) {
 	ASSERT_NOT_REACHED();
@@ -39,6 +39,10 @@ void crDestroyRenderer(void);
 int crLoadSceneFromFile(char *filePath);
 int crLoadSceneFromBuf(char *buf);
 
+bool crIsBakedScene(char *filePath);
+int crLoadBakedScene(char *filePath);
+int crBakeScene(void); //Write the loaded scene out to the path given with --bake
+
 void crLoadMeshFromFile(char *filePath);
 void crLoadMeshFromBuf(char *buf);
 
@@ -91,6 +95,9 @@ void crStartRenderer(void);
 //Network render worker
 void crStartRenderWorker(void);
 
+//Headless benchmark, prints JSON results to stdout
+int crRunBenchmark(void);
+
 //Interactive mode
 void crStartInteractive(void);
 void crPauseInteractive(void); //Toggle paused state
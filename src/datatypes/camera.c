@@ -86,6 +86,11 @@ struct lightRay getCameraRay(struct camera *cam, int x, int y, struct sampler *s
 	return newRay;
 }
 
+float cameraPixelSpread(const struct camera *cam) {
+	//The sensor is one unit away, so this is about the angle one pixel covers
+	return cam->sensorSize.y / cam->height;
+}
+
 void destroyCamera(struct camera *cam) {
 	if (cam) {
 		free(cam);
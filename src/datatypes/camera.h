@@ -36,4 +36,7 @@ struct camera *newCamera(unsigned width, unsigned height, float FOV, float focal
 
 struct lightRay getCameraRay(struct camera *cam, int x, int y, struct sampler *sampler);
 
+/// Angle covered by a single pixel, which camera ray cones start out with
+float cameraPixelSpread(const struct camera *cam);
+
 void destroyCamera(struct camera *cam);
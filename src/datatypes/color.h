@@ -116,4 +116,9 @@ static inline bool colorEquals(struct color a, struct color b) {
 	return a.red == b.red && a.green == b.green && a.blue == b.blue && a.alpha == b.alpha;
 }
 
+// Rec. 709 relative luminance, ignores alpha
+static inline float luminance(struct color c) {
+	return 0.2126f * c.red + 0.7152f * c.green + 0.0722f * c.blue;
+}
+
 struct color colorForKelvin(float kelvin);
@@ -13,11 +13,12 @@
 
 struct hitRecord {
 	struct lightRay incident;		//Light ray that encountered this intersection
-	struct material material;		//Material of the intersected object
+	const struct material *material;//Material of the intersected object
 	struct vector hitPoint;			//Hit point vector in 3D space
 	struct vector surfaceNormal;	//Surface normal at that point of intersection
-	struct coord uv;				//UV barycentric coordinates for intersection point
+	struct coord uv;				//Barycentric coordinates during traversal, texture coordinates once resolved
 	float distance;					//Distance to intersection point
+	float footprint;				//Width of the incident ray cone in texture space, 0 for full resolution lookups
 	struct poly *polygon;			//ptr to polygon that was encountered
 	int instIndex;					//Instance index, negative if no intersection
 };
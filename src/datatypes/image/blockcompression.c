@@ -0,0 +1,208 @@
+//
+//  blockcompression.c
+//  C-Ray
+//
+//  Created by Valtteri Koskivuori on 18/10/2026.
+//  Copyright © 2026 Valtteri Koskivuori. All rights reserved.
+//
+
+#include "../../includes.h"
+#include "blockcompression.h"
+
+#include <string.h>
+#include <math.h>
+#include <float.h>
+#include <limits.h>
+
+static uint32_t quantize565(const float *rgb) {
+	const uint32_t r = (uint32_t)(min(max(rgb[0], 0.0f), 255.0f) * 31.0f / 255.0f + 0.5f);
+	const uint32_t g = (uint32_t)(min(max(rgb[1], 0.0f), 255.0f) * 63.0f / 255.0f + 0.5f);
+	const uint32_t b = (uint32_t)(min(max(rgb[2], 0.0f), 255.0f) * 31.0f / 255.0f + 0.5f);
+	return r << 11 | g << 5 | b;
+}
+
+// Same palette the decoder builds, in four colour mode
+static void colorPalette(uint32_t c0, uint32_t c1, uint32_t palette[4][3]) {
+	bcExpand565(c0, palette[0]);
+	bcExpand565(c1, palette[1]);
+	for (int c = 0; c < 3; ++c) {
+		palette[2][c] = (2 * palette[0][c] + palette[1][c] + 1) / 3;
+		palette[3][c] = (palette[0][c] + 2 * palette[1][c] + 1) / 3;
+	}
+}
+
+// Picks the closest palette entry for every texel, and returns the total squared error
+static uint32_t assignIndices(const unsigned char *rgba, uint32_t c0, uint32_t c1, uint32_t *indices) {
+	uint32_t palette[4][3];
+	colorPalette(c0, c1, palette);
+	uint32_t error = 0;
+	*indices = 0;
+	for (int i = 0; i < 16; ++i) {
+		const unsigned char *texel = &rgba[i * 4];
+		uint32_t best = 0;
+		uint32_t bestError = UINT32_MAX;
+		for (uint32_t p = 0; p < 4; ++p) {
+			const int dr = (int)texel[0] - (int)palette[p][0];
+			const int dg = (int)texel[1] - (int)palette[p][1];
+			const int db = (int)texel[2] - (int)palette[p][2];
+			const uint32_t e = (uint32_t)(dr * dr + dg * dg + db * db);
+			if (e < bestError) {
+				bestError = e;
+				best = p;
+			}
+		}
+		*indices |= best << (2 * i);
+		error += bestError;
+	}
+	return error;
+}
+
+// Least squares endpoints for the current indices, like stb_dxt's refinement step
+static bool refineEndpoints(const unsigned char *rgba, uint32_t indices, float *e0, float *e1) {
+	static const float weights[4] = { 1.0f, 0.0f, 2.0f / 3.0f, 1.0f / 3.0f };
+	float aa = 0.0f, bb = 0.0f, ab = 0.0f;
+	float ax[3] = { 0 }, bx[3] = { 0 };
+	for (int i = 0; i < 16; ++i) {
+		const float a = weights[(indices >> (2 * i)) & 3];
+		const float b = 1.0f - a;
+		aa += a * a;
+		bb += b * b;
+		ab += a * b;
+		for (int c = 0; c < 3; ++c) {
+			ax[c] += a * rgba[i * 4 + c];
+			bx[c] += b * rgba[i * 4 + c];
+		}
+	}
+	const float determinant = aa * bb - ab * ab;
+	if (fabsf(determinant) < 1e-6f) return false;
+	for (int c = 0; c < 3; ++c) {
+		e0[c] = (ax[c] * bb - bx[c] * ab) / determinant;
+		e1[c] = (bx[c] * aa - ax[c] * ab) / determinant;
+	}
+	return true;
+}
+
+// c0 > c1 selects four colour mode, so order the endpoints that way and remap the indices to match
+static void writeColorBlock(uint32_t c0, uint32_t c1, uint32_t indices, unsigned char *block) {
+	if (c0 < c1) {
+		const uint32_t swap = c0;
+		c0 = c1;
+		c1 = swap;
+		indices ^= 0x55555555; // 0 <-> 1, 2 <-> 3
+	} else if (c0 == c1) {
+		indices = 0;
+	}
+	block[0] = c0 & 0xFF;
+	block[1] = (unsigned char)(c0 >> 8);
+	block[2] = c1 & 0xFF;
+	block[3] = (unsigned char)(c1 >> 8);
+	for (int i = 0; i < 4; ++i) block[4 + i] = (unsigned char)(indices >> (8 * i));
+}
+
+void encodeBC1Block(const unsigned char *rgba, unsigned char *block) {
+	// Endpoints go at the extremes along the principal axis of the colours
+	float mean[3] = { 0 };
+	for (int i = 0; i < 16; ++i) {
+		for (int c = 0; c < 3; ++c) mean[c] += rgba[i * 4 + c] / 16.0f;
+	}
+	float covariance[6] = { 0 };
+	for (int i = 0; i < 16; ++i) {
+		const float r = rgba[i * 4 + 0] - mean[0];
+		const float g = rgba[i * 4 + 1] - mean[1];
+		const float b = rgba[i * 4 + 2] - mean[2];
+		covariance[0] += r * r;
+		covariance[1] += r * g;
+		covariance[2] += r * b;
+		covariance[3] += g * g;
+		covariance[4] += g * b;
+		covariance[5] += b * b;
+	}
+	// Power iteration, starting from the covariances of the channel that varies the most.
+	// A fixed start like the grey axis can be orthogonal to the answer, e.g. for a red to green ramp.
+	float axis[3] = { covariance[0], covariance[1], covariance[2] };
+	if (covariance[3] > covariance[0] && covariance[3] >= covariance[5]) {
+		axis[0] = covariance[1];
+		axis[1] = covariance[3];
+		axis[2] = covariance[4];
+	} else if (covariance[5] > covariance[0] && covariance[5] > covariance[3]) {
+		axis[0] = covariance[2];
+		axis[1] = covariance[4];
+		axis[2] = covariance[5];
+	}
+	for (int iteration = 0; iteration < 4; ++iteration) {
+		const float x = axis[0] * covariance[0] + axis[1] * covariance[1] + axis[2] * covariance[2];
+		const float y = axis[0] * covariance[1] + axis[1] * covariance[3] + axis[2] * covariance[4];
+		const float z = axis[0] * covariance[2] + axis[1] * covariance[4] + axis[2] * covariance[5];
+		const float length = max(fabsf(x), max(fabsf(y), fabsf(z)));
+		if (length < 1e-6f) break;
+		axis[0] = x / length;
+		axis[1] = y / length;
+		axis[2] = z / length;
+	}
+	int lowest = 0;
+	int highest = 0;
+	float lowestDot = FLT_MAX;
+	float highestDot = -FLT_MAX;
+	for (int i = 0; i < 16; ++i) {
+		const float dot = rgba[i * 4 + 0] * axis[0] + rgba[i * 4 + 1] * axis[1] + rgba[i * 4 + 2] * axis[2];
+		if (dot < lowestDot) {
+			lowestDot = dot;
+			lowest = i;
+		}
+		if (dot > highestDot) {
+			highestDot = dot;
+			highest = i;
+		}
+	}
+	float e0[3], e1[3];
+	for (int c = 0; c < 3; ++c) {
+		e0[c] = rgba[highest * 4 + c];
+		e1[c] = rgba[lowest * 4 + c];
+	}
+	uint32_t c0 = quantize565(e0);
+	uint32_t c1 = quantize565(e1);
+	uint32_t indices;
+	uint32_t error = assignIndices(rgba, c0, c1, &indices);
+
+	// One round of refinement, kept only if it helps
+	if (error && refineEndpoints(rgba, indices, e0, e1)) {
+		const uint32_t r0 = quantize565(e0);
+		const uint32_t r1 = quantize565(e1);
+		uint32_t refined;
+		if (assignIndices(rgba, r0, r1, &refined) < error) {
+			c0 = r0;
+			c1 = r1;
+			indices = refined;
+		}
+	}
+	writeColorBlock(c0, c1, indices, block);
+}
+
+void encodeBC4Block(const unsigned char *values, size_t stride, unsigned char *block) {
+	unsigned char lo = 255;
+	unsigned char hi = 0;
+	for (int i = 0; i < 16; ++i) {
+		lo = min(lo, values[i * stride]);
+		hi = max(hi, values[i * stride]);
+	}
+	// Eight value mode, needs a0 > a1. With a flat block every index is 0 either way.
+	memset(block, 0, 8);
+	block[0] = hi;
+	block[1] = lo;
+	if (hi == lo) return;
+	uint64_t bits = 0;
+	for (int i = 0; i < 16; ++i) {
+		const int value = values[i * stride];
+		uint64_t best = 0;
+		int bestError = INT_MAX;
+		for (uint32_t index = 0; index < 8; ++index) {
+			const int error = abs((int)bc4Value(hi, lo, index) - value);
+			if (error < bestError) {
+				bestError = error;
+				best = index;
+			}
+		}
+		bits |= best << (3 * i);
+	}
+	for (int i = 0; i < 6; ++i) block[2 + i] = (unsigned char)(bits >> (8 * i));
+}
@@ -0,0 +1,74 @@
+//
+//  blockcompression.h
+//  C-Ray
+//
+//  Created by Valtteri Koskivuori on 18/10/2026.
+//  Copyright © 2026 Valtteri Koskivuori. All rights reserved.
+//
+
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+
+// Fixed rate compression of 4x4 texel blocks, in the BC1, BC3 and BC4 layouts GPUs use.
+// BC1 stores RGB in 8 bytes, BC3 adds a BC4 block for alpha, and BC4 stores one channel in 8 bytes.
+// Texels can be decoded one at a time, straight from the compressed data.
+
+#define BC_BLOCK_DIM 4
+
+/// Compress 16 texels, in row order
+/// @param rgba Texels with 4 channels each. Alpha is ignored.
+/// @param block Output, 8 bytes
+void encodeBC1Block(const unsigned char *rgba, unsigned char *block);
+
+/// Compress 16 values of one channel
+/// @param values Values, stride bytes apart
+/// @param block Output, 8 bytes
+void encodeBC4Block(const unsigned char *values, size_t stride, unsigned char *block);
+
+static inline uint32_t bcRead32(const unsigned char *p) {
+	return (uint32_t)p[0] | (uint32_t)p[1] << 8 | (uint32_t)p[2] << 16 | (uint32_t)p[3] << 24;
+}
+
+// 5:6:5 endpoint to 8 bits per channel, by replicating the top bits into the bottom
+static inline void bcExpand565(uint32_t c, uint32_t *rgb) {
+	rgb[0] = (c >> 11) << 3 | (c >> 13);
+	rgb[1] = ((c >> 5) & 63) << 2 | ((c >> 9) & 3);
+	rgb[2] = (c & 31) << 3 | ((c >> 2) & 7);
+}
+
+/// Decode texel i of a BC1 block
+/// @param rgb Output, 3 bytes
+static inline void decodeBC1Texel(const unsigned char *block, size_t i, unsigned char *rgb) {
+	const uint32_t c0 = block[0] | block[1] << 8;
+	const uint32_t c1 = block[2] | block[3] << 8;
+	const uint32_t index = (bcRead32(block + 4) >> (2 * i)) & 3;
+	uint32_t e0[3], e1[3];
+	bcExpand565(c0, e0);
+	bcExpand565(c1, e1);
+	if (c0 > c1 || index < 2) {
+		// Four colour mode, entries are thirds of the way between the endpoints, the first two the endpoints themselves
+		static const uint32_t weights[4] = { 3, 0, 2, 1 };
+		const uint32_t w = weights[index];
+		for (int c = 0; c < 3; ++c) rgb[c] = (unsigned char)((w * e0[c] + (3 - w) * e1[c] + 1) / 3);
+	} else {
+		// Three colour mode, halfway and black
+		for (int c = 0; c < 3; ++c) rgb[c] = (unsigned char)(index == 2 ? (e0[c] + e1[c] + 1) / 2 : 0);
+	}
+}
+
+// Value of index in a BC4 block with endpoints a0 and a1
+static inline unsigned char bc4Value(uint32_t a0, uint32_t a1, uint32_t index) {
+	if (index < 2) return (unsigned char)(index ? a1 : a0);
+	if (a0 > a1) return (unsigned char)(((8 - index) * a0 + (index - 1) * a1 + 3) / 7);
+	if (index < 6) return (unsigned char)(((6 - index) * a0 + (index - 1) * a1 + 2) / 5);
+	return index == 6 ? 0 : 255;
+}
+
+/// Decode texel i of a BC4 block
+static inline unsigned char decodeBC4Texel(const unsigned char *block, size_t i) {
+	// The 48 index bits straddle a 4 byte read for texels 8 and up
+	const uint32_t bits = i < 8 ? bcRead32(block + 2) >> (3 * i) : bcRead32(block + 4) >> (3 * i - 16);
+	return bc4Value(block[0], block[1], bits & 7);
+}
@@ -18,6 +18,7 @@ struct renderInfo {
 	int samples;
 	int bounces;
 	unsigned long long renderTime;
+	unsigned long long timeLimit; // 0 if the render wasn't time-limited
 	int threadCount;
 	char *arch;
 	char *crayVersion;
@@ -9,12 +9,15 @@
 #include "../../includes.h"
 
 #include "texture.h"
+#include "texturecache.h"
+#include "blockcompression.h"
 #include "../../utils/logging.h"
 #include "../../utils/assert.h"
+#include "../../utils/mempool.h"
 
 //General-purpose setPixel function
 void setPixel(struct texture *t, struct color c, size_t x, size_t y) {
-	ASSERT(x < t->width); ASSERT(y < t->height);
+	ASSERT(x < t->width); ASSERT(y < t->height); ASSERT(t->compression == uncompressed);
 	if (t->precision == char_p) {
 		t->data.byte_p[(x + (t->height - (y + 1)) * t->width) * t->channels + 0] = (unsigned char)min(c.red * 255.0f, 255.0f);
 		t->data.byte_p[(x + (t->height - (y + 1)) * t->width) * t->channels + 1] = (unsigned char)min(c.green * 255.0f, 255.0f);
@@ -29,53 +32,303 @@ void setPixel(struct texture *t, struct color c, size_t x, size_t y) {
 	}
 }
 
-static struct color textureGetPixelInternal(const struct texture *t, size_t x, size_t y) {
-	struct color output = {0.0f, 0.0f, 0.0f, 0.0f};
-	x = x % t->width;
-	y = y % t->height;
-	
-	if (t->channels == 1) {
-		if (t->precision == float_p) {
-			output.red   = t->data.float_p[(x + ((t->height - 1) - y) * t->width) * t->channels];
-			output.green = output.red;
-			output.blue  = output.red;
-			output.alpha = 1.0f;
-		} else {
-			output.red =   t->data.byte_p[(x + ((t->height - 1) - y) * t->width) * t->channels] / 255.0f;
-			output.green = output.red;
-			output.blue =  output.red;
-			output.alpha = 1.0f;
-		}
-	} else {
-		if (t->precision == float_p) {
-			output.red   = t->data.float_p[(x + ((t->height - 1) - y) * t->width) * t->channels + 0];
-			output.green = t->data.float_p[(x + ((t->height - 1) - y) * t->width) * t->channels + 1];
-			output.blue  = t->data.float_p[(x + ((t->height - 1) - y) * t->width) * t->channels + 2];
-			output.alpha = t->hasAlpha ? t->data.float_p[(x + ((t->height - 1) - y) * t->width) * t->channels + 3] : 1.0f;
+// sRGB encoded byte to linear
+static const float srgbToLinear[256] = {
+	0.0f, 0.000303526984f, 0.000607053967f, 0.000910580951f, 0.00121410793f, 0.00151763492f, 0.0018211619f, 0.00212468888f,
+	0.00242821587f, 0.00273174285f, 0.00303526984f, 0.00334653576f, 0.00367650732f, 0.00402471702f, 0.00439144204f, 0.00477695348f,
+	0.0051815167f, 0.00560539162f, 0.00604883302f, 0.00651209079f, 0.00699541019f, 0.00749903204f, 0.00802319299f, 0.00856812562f,
+	0.0091340587f, 0.00972121732f, 0.010329823f, 0.010960094f, 0.0116122452f, 0.0122864884f, 0.0129830323f, 0.013702083f,
+	0.0144438436f, 0.0152085144f, 0.0159962934f, 0.0168073758f, 0.0176419545f, 0.0185002201f, 0.019382361f, 0.0202885631f,
+	0.0212190104f, 0.0221738848f, 0.0231533662f, 0.0241576324f, 0.0251868596f, 0.0262412219f, 0.0273208916f, 0.0284260395f,
+	0.0295568344f, 0.0307134437f, 0.0318960331f, 0.0331047666f, 0.0343398068f, 0.0356013149f, 0.0368894504f, 0.0382043716f,
+	0.0395462353f, 0.0409151969f, 0.0423114106f, 0.0437350293f, 0.0451862044f, 0.0466650863f, 0.0481718242f, 0.049706566f,
+	0.0512694584f, 0.052860647f, 0.0544802764f, 0.05612849f, 0.0578054302f, 0.0595112382f, 0.0612460542f, 0.0630100177f,
+	0.0648032667f, 0.0666259386f, 0.0684781698f, 0.0703600957f, 0.0722718507f, 0.0742135684f, 0.0761853815f, 0.0781874218f,
+	0.0802198203f, 0.0822827071f, 0.0843762115f, 0.086500462f, 0.0886555863f, 0.0908417112f, 0.0930589628f, 0.0953074666f,
+	0.0975873471f, 0.0998987282f, 0.102241733f, 0.104616484f, 0.107023103f, 0.109461711f, 0.111932428f, 0.114435374f,
+	0.116970668f, 0.119538428f, 0.122138772f, 0.124771818f, 0.12743768f, 0.130136477f, 0.132868322f, 0.13563333f,
+	0.138431615f, 0.141263291f, 0.144128471f, 0.147027266f, 0.14995979f, 0.152926152f, 0.155926464f, 0.158960835f,
+	0.162029376f, 0.165132195f, 0.1682694f, 0.171441101f, 0.174647404f, 0.177888416f, 0.181164244f, 0.184474995f,
+	0.187820772f, 0.191201683f, 0.19461783f, 0.19806932f, 0.201556254f, 0.205078736f, 0.20863687f, 0.212230757f,
+	0.2158605f, 0.2195262f, 0.223227957f, 0.226965874f, 0.230740049f, 0.234550582f, 0.238397574f, 0.242281122f,
+	0.246201327f, 0.250158285f, 0.254152094f, 0.258182853f, 0.262250658f, 0.266355605f, 0.270497791f, 0.274677312f,
+	0.278894263f, 0.28314874f, 0.287440838f, 0.29177065f, 0.296138271f, 0.300543794f, 0.304987314f, 0.309468923f,
+	0.313988713f, 0.318546778f, 0.323143209f, 0.327778098f, 0.332451536f, 0.337163615f, 0.341914425f, 0.346704056f,
+	0.3515326f, 0.356400144f, 0.36130678f, 0.366252596f, 0.37123768f, 0.376262123f, 0.381326011f, 0.386429434f,
+	0.391572478f, 0.396755231f, 0.40197778f, 0.407240212f, 0.412542613f, 0.417885071f, 0.42326767f, 0.428690497f,
+	0.434153636f, 0.439657174f, 0.445201195f, 0.450785783f, 0.456411023f, 0.462077f, 0.467783796f, 0.473531496f,
+	0.479320183f, 0.48514994f, 0.49102085f, 0.496932995f, 0.502886458f, 0.508881321f, 0.514917665f, 0.520995573f,
+	0.527115126f, 0.533276404f, 0.539479489f, 0.545724461f, 0.552011402f, 0.55834039f, 0.564711506f, 0.571124829f,
+	0.57758044f, 0.584078418f, 0.590618841f, 0.597201788f, 0.603827339f, 0.610495571f, 0.617206562f, 0.623960392f,
+	0.630757136f, 0.637596874f, 0.644479682f, 0.651405637f, 0.658374817f, 0.665387298f, 0.672443157f, 0.67954247f,
+	0.686685312f, 0.693871761f, 0.701101892f, 0.70837578f, 0.715693501f, 0.723055129f, 0.73046074f, 0.737910409f,
+	0.74540421f, 0.752942217f, 0.760524505f, 0.768151147f, 0.775822218f, 0.783537792f, 0.79129794f, 0.799102738f,
+	0.806952258f, 0.814846572f, 0.822785754f, 0.830769877f, 0.838799012f, 0.846873232f, 0.854992608f, 0.863157213f,
+	0.871367119f, 0.879622397f, 0.887923118f, 0.896269353f, 0.904661174f, 0.913098652f, 0.921581856f, 0.930110858f,
+	0.938685728f, 0.947306537f, 0.955973353f, 0.964686248f, 0.97344529f, 0.98225055f, 0.991102097f, 1.0f
+};
+
+// Color channels of sRGB textures go through the table, so they're filtered in linear space. Alpha is always linear.
+static inline float byteToColor(const struct texture *t, unsigned char value) {
+	return t->colorspace == sRGB ? srgbToLinear[value] : value / 255.0f;
+}
+
+// Closest sRGB encoded byte to a linear value
+static unsigned char linearToByte(float value) {
+	unsigned lo = 0;
+	unsigned hi = 255;
+	while (lo + 1 < hi) {
+		const unsigned mid = (lo + hi) / 2;
+		if (srgbToLinear[mid] <= value) {
+			lo = mid;
 		} else {
-			output.red =   t->data.byte_p[(x + ((t->height - 1) - y) * t->width) * t->channels + 0] / 255.0f;
-			output.green = t->data.byte_p[(x + ((t->height - 1) - y) * t->width) * t->channels + 1] / 255.0f;
-			output.blue =  t->data.byte_p[(x + ((t->height - 1) - y) * t->width) * t->channels + 2] / 255.0f;
-			output.alpha = t->hasAlpha ? t->data.byte_p[(x + ((t->height - 1) - y) * t->width) * t->channels + 3] / 255.0f : 1.0f;
+			hi = mid;
 		}
 	}
-	return output;
+	return (unsigned char)(value - srgbToLinear[lo] < srgbToLinear[hi] - value ? lo : hi);
+}
+
+// Texel fetches for each storage format, picked once by textureSelectFetch() so lookups don't branch on the format.
+// They take coordinates in storage order, rows are flipped by the caller.
+#define unorm(value) ((value) / 255.0f)
+#define srgb(value) (srgbToLinear[value])
+#define identity(value) (value)
+
+#define TEXEL_FETCHES(name, type, member, decode, decodeAlpha) \
+	static struct color name##1(const struct texture *t, size_t x, size_t y) { \
+		const float value = decode(t->data.member[y * t->width + x]); \
+		return (struct color){ value, value, value, 1.0f }; \
+	} \
+	static struct color name##3(const struct texture *t, size_t x, size_t y) { \
+		const type *texel = &t->data.member[(y * t->width + x) * 3]; \
+		return (struct color){ decode(texel[0]), decode(texel[1]), decode(texel[2]), 1.0f }; \
+	} \
+	static struct color name##4(const struct texture *t, size_t x, size_t y) { \
+		const type *texel = &t->data.member[(y * t->width + x) * 4]; \
+		return (struct color){ decode(texel[0]), decode(texel[1]), decode(texel[2]), decodeAlpha(texel[3]) }; \
+	}
+
+TEXEL_FETCHES(fetchUnorm, unsigned char, byte_p, unorm, unorm)
+TEXEL_FETCHES(fetchSRGB, unsigned char, byte_p, srgb, unorm)
+TEXEL_FETCHES(fetchFloat, float, float_p, identity, identity)
+
+// Blocks are stored in rows, like texels. Only the texel asked for is decoded.
+static inline const unsigned char *blockAt(const struct texture *t, size_t x, size_t y, size_t blockBytes) {
+	const size_t blocksX = (t->width + BC_BLOCK_DIM - 1) / BC_BLOCK_DIM;
+	return &t->data.byte_p[((y / BC_BLOCK_DIM) * blocksX + x / BC_BLOCK_DIM) * blockBytes];
+}
+
+static inline size_t texelInBlock(size_t x, size_t y) {
+	return (y % BC_BLOCK_DIM) * BC_BLOCK_DIM + x % BC_BLOCK_DIM;
+}
+
+#define BLOCK_FETCHES(name, decode) \
+	static struct color name##BC1(const struct texture *t, size_t x, size_t y) { \
+		unsigned char rgb[3]; \
+		decodeBC1Texel(blockAt(t, x, y, 8), texelInBlock(x, y), rgb); \
+		return (struct color){ decode(rgb[0]), decode(rgb[1]), decode(rgb[2]), 1.0f }; \
+	} \
+	static struct color name##BC3(const struct texture *t, size_t x, size_t y) { \
+		const unsigned char *block = blockAt(t, x, y, 16); \
+		unsigned char rgb[3]; \
+		decodeBC1Texel(block + 8, texelInBlock(x, y), rgb); \
+		return (struct color){ decode(rgb[0]), decode(rgb[1]), decode(rgb[2]), unorm(decodeBC4Texel(block, texelInBlock(x, y))) }; \
+	} \
+	static struct color name##BC4(const struct texture *t, size_t x, size_t y) { \
+		const float value = decode(decodeBC4Texel(blockAt(t, x, y, 8), texelInBlock(x, y))); \
+		return (struct color){ value, value, value, 1.0f }; \
+	}
+
+BLOCK_FETCHES(fetchUnorm, unorm)
+BLOCK_FETCHES(fetchSRGB, srgb)
+
+// Any other channel layout
+static struct color fetchGeneric(const struct texture *t, size_t x, size_t y) {
+	const size_t index = (y * t->width + x) * t->channels;
+	if (t->precision == float_p) {
+		const float *texel = &t->data.float_p[index];
+		return (struct color){ texel[0], texel[1], texel[2], t->hasAlpha ? texel[3] : 1.0f };
+	}
+	const unsigned char *texel = &t->data.byte_p[index];
+	return (struct color){ byteToColor(t, texel[0]), byteToColor(t, texel[1]), byteToColor(t, texel[2]), t->hasAlpha ? unorm(texel[3]) : 1.0f };
+}
+
+static struct color fetchNone(const struct texture *t, size_t x, size_t y) {
+	(void)t; (void)x; (void)y;
+	return (struct color){ 0.0f, 0.0f, 0.0f, 0.0f };
+}
+
+void textureSelectFetch(struct texture *t) {
+	// Power of two sizes wrap with a mask instead of a division
+	t->wrapMaskX = t->width && !(t->width & (t->width - 1)) ? t->width - 1 : 0;
+	t->wrapMaskY = t->height && !(t->height & (t->height - 1)) ? t->height - 1 : 0;
+	const bool rgb = t->channels == 3 && !t->hasAlpha;
+	const bool rgba = t->channels == 4 && t->hasAlpha;
+	const bool srgb = t->colorspace == sRGB;
+	switch (t->compression) {
+		case bc1_c:
+			t->fetch = srgb ? fetchSRGBBC1 : fetchUnormBC1;
+			return;
+		case bc3_c:
+			t->fetch = srgb ? fetchSRGBBC3 : fetchUnormBC3;
+			return;
+		case bc4_c:
+			t->fetch = srgb ? fetchSRGBBC4 : fetchUnormBC4;
+			return;
+		default:
+			break;
+	}
+	switch (t->precision) {
+		case char_p:
+			if (srgb) {
+				t->fetch = t->channels == 1 ? fetchSRGB1 : rgb ? fetchSRGB3 : rgba ? fetchSRGB4 : fetchGeneric;
+			} else {
+				t->fetch = t->channels == 1 ? fetchUnorm1 : rgb ? fetchUnorm3 : rgba ? fetchUnorm4 : fetchGeneric;
+			}
+			break;
+		case float_p:
+			t->fetch = t->channels == 1 ? fetchFloat1 : rgb ? fetchFloat3 : rgba ? fetchFloat4 : fetchGeneric;
+			break;
+		default:
+			t->fetch = fetchNone;
+			break;
+	}
+}
+
+static inline size_t wrap(size_t coord, size_t size, size_t mask) {
+	return mask ? coord & mask : coord % size;
+}
+
+// Rows are stored bottom up
+static inline size_t storageRow(const struct texture *t, size_t y) {
+	return (t->height - 1) - wrap(y, t->height, t->wrapMaskY);
+}
+
+static inline struct color textureGetPixelInternal(const struct texture *t, size_t x, size_t y) {
+	return t->fetch(t, wrap(x, t->width, t->wrapMaskX), storageRow(t, y));
+}
+
+struct color textureFilterTexels(const struct texture *t, size_t x, size_t y, float fx, float fy) {
+	const size_t x0 = wrap(x, t->width, t->wrapMaskX);
+	const size_t x1 = wrap(x + 1, t->width, t->wrapMaskX);
+	const size_t row0 = storageRow(t, y);
+	const size_t row1 = storageRow(t, y + 1);
+	const struct color topleft = t->fetch(t, x0, row0);
+	const struct color topright = t->fetch(t, x1, row0);
+	const struct color botleft = t->fetch(t, x0, row1);
+	const struct color botright = t->fetch(t, x1, row1);
+	// One weighted sum of all four taps, instead of three dependent lerps. Each channel is the same
+	// expression, so the compiler can do them side by side in vector registers.
+	const float w00 = (1.0f - fx) * (1.0f - fy);
+	const float w10 = fx * (1.0f - fy);
+	const float w01 = (1.0f - fx) * fy;
+	const float w11 = fx * fy;
+	return (struct color){
+		topleft.red * w00 + topright.red * w10 + botleft.red * w01 + botright.red * w11,
+		topleft.green * w00 + topright.green * w10 + botleft.green * w01 + botright.green * w11,
+		topleft.blue * w00 + topright.blue * w10 + botleft.blue * w01 + botright.blue * w11,
+		topleft.alpha * w00 + topright.alpha * w10 + botleft.alpha * w01 + botright.alpha * w11
+	};
 }
 
 //FIXME: This API is confusing. The semantic meaning of x and y change completely based on the filtered flag.
 struct color textureGetPixel(const struct texture *t, float x, float y, bool filtered) {
+	if (t->tiles) return tiledTextureGetPixel(t->tiles, 0, x, y, filtered);
 	if (!filtered) return textureGetPixelInternal(t, (size_t)x, (size_t)y);
-	x = x * t->width;
-	y = y * t->height;
-	float xcopy = x - 0.5f;
-	float ycopy = y - 0.5f;
-	int xint = (int)xcopy;
-	int yint = (int)ycopy;
-	struct color topleft = textureGetPixelInternal(t, xint, yint);
-	struct color topright = textureGetPixelInternal(t, xint + 1, yint);
-	struct color botleft = textureGetPixelInternal(t, xint, yint + 1);
-	struct color botright = textureGetPixelInternal(t, xint + 1, yint + 1);
-	return lerp(lerp(topleft, topright, xcopy - xint), lerp(botleft, botright, xcopy - xint), ycopy - yint);
+	const float xcopy = x * t->width - 0.5f;
+	const float ycopy = y * t->height - 0.5f;
+	const int xint = (int)xcopy;
+	const int yint = (int)ycopy;
+	return textureFilterTexels(t, xint, yint, xcopy - xint, ycopy - yint);
+}
+
+static inline struct color levelGetPixel(const struct texture *t, size_t level, float x, float y) {
+	if (t->tiles) return tiledTextureGetPixel(t->tiles, level, x, y, true);
+	return textureGetPixel(level ? &t->mips[min(level, t->mipCount) - 1] : t, x, y, true);
+}
+
+struct color textureGetPixelLod(const struct texture *t, float x, float y, float footprint) {
+	if (!t->mipCount || !(footprint > 0.0f)) return textureGetPixel(t, x, y, true);
+	// Level where one texel is about as wide as the footprint
+	const float lod = log2f(footprint * max(t->width, t->height));
+	if (!(lod > 0.0f)) return textureGetPixel(t, x, y, true);
+	if (lod >= t->mipCount) return levelGetPixel(t, t->mipCount, x, y);
+	const size_t level = (size_t)lod;
+	const struct color fine = levelGetPixel(t, level, x, y);
+	const struct color coarse = levelGetPixel(t, level + 1, x, y);
+	return lerp(fine, coarse, lod - level);
+}
+
+// Average 2x2 blocks of src into dst. Rows are averaged as they're stored, odd edges are repeated.
+// sRGB colors are averaged in linear space, otherwise every level would come out darker than the last.
+static void downsample(const struct texture *src, struct texture *dst) {
+	for (size_t y = 0; y < dst->height; ++y) {
+		const size_t rows[] = { (2 * y) * src->width, min(2 * y + 1, src->height - 1) * src->width };
+		for (size_t x = 0; x < dst->width; ++x) {
+			const size_t cols[] = { 2 * x, min(2 * x + 1, src->width - 1) };
+			const size_t texels[] = { rows[0] + cols[0], rows[0] + cols[1], rows[1] + cols[0], rows[1] + cols[1] };
+			for (size_t c = 0; c < src->channels; ++c) {
+				const size_t out = (x + y * dst->width) * dst->channels + c;
+				if (src->precision == float_p) {
+					float sum = 0.0f;
+					for (int i = 0; i < 4; ++i) sum += src->data.float_p[texels[i] * src->channels + c];
+					dst->data.float_p[out] = 0.25f * sum;
+				} else if (src->colorspace == sRGB && !(src->hasAlpha && c == src->channels - 1)) {
+					float sum = 0.0f;
+					for (int i = 0; i < 4; ++i) sum += srgbToLinear[src->data.byte_p[texels[i] * src->channels + c]];
+					dst->data.byte_p[out] = linearToByte(0.25f * sum);
+				} else {
+					unsigned sum = 2; // Round to nearest
+					for (int i = 0; i < 4; ++i) sum += src->data.byte_p[texels[i] * src->channels + c];
+					dst->data.byte_p[out] = (unsigned char)(sum / 4);
+				}
+			}
+		}
+	}
+}
+
+// Level headers and their data are one allocation, so destroyTexture() only has to free one thing
+static size_t levelHeaderBytes(size_t count) {
+	const size_t bytes = count * sizeof(struct texture);
+	return bytes + sizeof(cray_max_align_t) - bytes % sizeof(cray_max_align_t);
+}
+
+void generateMipmaps(struct texture *t, struct block **pool) {
+	t->mips = NULL;
+	t->mipCount = 0;
+	if (t->precision == none || t->compression != uncompressed || !t->data.byte_p) return;
+	size_t count = 0;
+	for (size_t w = t->width, h = t->height; w > 1 || h > 1; w = max(w / 2, 1), h = max(h / 2, 1)) count++;
+	if (!count) return;
+	
+	const size_t unitSize = t->precision == float_p ? sizeof(float) : sizeof(unsigned char);
+	size_t bytes = 0;
+	for (size_t w = t->width / 2, h = t->height / 2, i = 0; i < count; ++i, w /= 2, h /= 2) {
+		bytes += max(w, 1) * max(h, 1) * t->channels * unitSize;
+	}
+	const size_t headerBytes = levelHeaderBytes(count);
+	char *buffer = pool ? allocBlock(pool, headerBytes + bytes) : malloc(headerBytes + bytes);
+	if (!buffer) {
+		logr(warning, "Failed to allocate mips for %zux%zu texture.\n", t->width, t->height);
+		return;
+	}
+	t->mips = (struct texture *)buffer;
+	char *data = buffer + headerBytes;
+	const struct texture *previous = t;
+	for (size_t i = 0; i < count; ++i) {
+		struct texture *level = &t->mips[i];
+		*level = *previous;
+		level->width = max(previous->width / 2, 1);
+		level->height = max(previous->height / 2, 1);
+		level->data.byte_p = (unsigned char *)data;
+		level->mips = NULL;
+		level->mipCount = 0;
+		textureSelectFetch(level);
+		data += level->width * level->height * level->channels * unitSize;
+		downsample(previous, level);
+		previous = level;
+	}
+	t->mipCount = count;
 }
 
 struct texture *newTexture(enum precision p, size_t width, size_t height, size_t channels) {
@@ -91,6 +344,7 @@ struct texture *newTexture(enum precision p, size_t width, size_t height, size_t
 	if (channels > 3) {
 		t->hasAlpha = true;
 	}
+	textureSelectFetch(t);
 	
 	switch (t->precision) {
 		case char_p: {
@@ -117,24 +371,134 @@ struct texture *newTexture(enum precision p, size_t width, size_t height, size_t
 	return t;
 }
 
-void textureFromSRGB(struct texture *t) {
-	if (t->colorspace == sRGB) return;
-	for (unsigned x = 0; x < t->width; ++x) {
-		for (unsigned y = 0; y < t->height; ++y) {
-			setPixel(t, fromSRGB(textureGetPixel(t, x, y, false)), x, y);
+// BC4 for one channel, BC1 for opaque RGB and BC3 for RGBA. Anything else stays uncompressed.
+static enum compression compressionFor(const struct texture *t) {
+	if (t->precision != char_p || t->compression != uncompressed || !t->data.byte_p) return uncompressed;
+	if (t->channels == 1) return bc4_c;
+	if (t->channels == 3 && !t->hasAlpha) return bc1_c;
+	if (t->channels == 4 && t->hasAlpha) return bc3_c;
+	return uncompressed;
+}
+
+static size_t compressedSize(size_t width, size_t height, enum compression compression) {
+	const size_t blocks = ((width + BC_BLOCK_DIM - 1) / BC_BLOCK_DIM) * ((height + BC_BLOCK_DIM - 1) / BC_BLOCK_DIM);
+	return blocks * (compression == bc3_c ? 16 : 8);
+}
+
+size_t textureLevelBytes(const struct texture *t) {
+	if (t->compression != uncompressed) return compressedSize(t->width, t->height, t->compression);
+	if (t->precision == none) return 0;
+	return t->width * t->height * t->channels * (t->precision == float_p ? sizeof(float) : sizeof(unsigned char));
+}
+
+// Blocks that hang over the edges repeat the edge texels
+static void compressLevel(const struct texture *src, struct texture *dst) {
+	unsigned char *block = dst->data.byte_p;
+	for (size_t by = 0; by < src->height; by += BC_BLOCK_DIM) {
+		for (size_t bx = 0; bx < src->width; bx += BC_BLOCK_DIM) {
+			unsigned char texels[BC_BLOCK_DIM * BC_BLOCK_DIM * 4];
+			for (size_t i = 0; i < BC_BLOCK_DIM * BC_BLOCK_DIM; ++i) {
+				const size_t x = min(bx + i % BC_BLOCK_DIM, src->width - 1);
+				const size_t y = min(by + i / BC_BLOCK_DIM, src->height - 1);
+				const unsigned char *texel = &src->data.byte_p[(y * src->width + x) * src->channels];
+				for (size_t c = 0; c < 4; ++c) texels[i * 4 + c] = texel[min(c, src->channels - 1)];
+			}
+			switch (dst->compression) {
+				case bc1_c:
+					encodeBC1Block(texels, block);
+					block += 8;
+					break;
+				case bc3_c:
+					encodeBC4Block(texels + 3, 4, block);
+					encodeBC1Block(texels, block + 8);
+					block += 16;
+					break;
+				default:
+					encodeBC4Block(texels, 4, block);
+					block += 8;
+					break;
+			}
 		}
 	}
-	t->colorspace = linear;
 }
 
-void textureToSRGB(struct texture *t) {
-	if (t->colorspace == linear) return;
-	for (unsigned x = 0; x < t->width; ++x) {
-		for (unsigned y = 0; y < t->height; ++y) {
-			setPixel(t, toSRGB(textureGetPixel(t, x, y, false)), x, y);
+struct texture *compressTexture(const struct texture *t, struct block **pool) {
+	const enum compression compression = compressionFor(t);
+	if (compression == uncompressed) return NULL;
+	size_t mipBytes = 0;
+	for (size_t i = 0; i < t->mipCount; ++i) mipBytes += compressedSize(t->mips[i].width, t->mips[i].height, compression);
+	const size_t bytes = compressedSize(t->width, t->height, compression);
+	const size_t headerBytes = levelHeaderBytes(t->mipCount);
+	struct texture *new = pool ? allocBlock(pool, sizeof(*new)) : malloc(sizeof(*new));
+	*new = *t;
+	new->compression = compression;
+	new->data.byte_p = pool ? allocBlock(pool, bytes) : malloc(bytes);
+	new->mips = NULL;
+	if (t->mipCount) new->mips = pool ? allocBlock(pool, headerBytes + mipBytes) : malloc(headerBytes + mipBytes);
+	if (!new->data.byte_p || (t->mipCount && !new->mips)) {
+		logr(warning, "Failed to allocate compressed %zux%zu texture.\n", t->width, t->height);
+		if (!pool) destroyTexture(new);
+		return NULL;
+	}
+	compressLevel(t, new);
+	textureSelectFetch(new);
+	unsigned char *data = (unsigned char *)new->mips + headerBytes;
+	for (size_t i = 0; i < t->mipCount; ++i) {
+		struct texture *level = &new->mips[i];
+		*level = t->mips[i];
+		level->compression = compression;
+		level->data.byte_p = data;
+		compressLevel(&t->mips[i], level);
+		textureSelectFetch(level);
+		data += compressedSize(level->width, level->height, compression);
+	}
+	return new;
+}
+
+// Run the color channels of t and its mips through convert, leaving alpha alone.
+// Bytes go through a table, so that's 256 calls to convert instead of one per texel.
+static void convertColors(struct texture *t, float (*convert)(float)) {
+	unsigned char table[256];
+	for (int i = 0; i < 256; ++i) {
+		table[i] = (unsigned char)(min(max(convert(i / 255.0f), 0.0f), 1.0f) * 255.0f + 0.5f);
+	}
+	const size_t colorChannels = t->hasAlpha ? t->channels - 1 : t->channels;
+	for (size_t level = 0; level <= t->mipCount; ++level) {
+		const struct texture *l = level ? &t->mips[level - 1] : t;
+		const size_t count = l->width * l->height * l->channels;
+		if (l->precision == float_p) {
+			float *data = l->data.float_p;
+			for (size_t i = 0; i < count; i += l->channels) {
+				for (size_t c = 0; c < colorChannels; ++c) data[i + c] = convert(data[i + c]);
+			}
+		} else {
+			unsigned char *data = l->data.byte_p;
+			for (size_t i = 0; i < count; i += l->channels) {
+				for (size_t c = 0; c < colorChannels; ++c) data[i + c] = table[data[i + c]];
+			}
 		}
 	}
-	t->colorspace = sRGB;
+}
+
+static void setColorspace(struct texture *t, enum colorspace colorspace) {
+	t->colorspace = colorspace;
+	textureSelectFetch(t);
+	for (size_t i = 0; i < t->mipCount; ++i) {
+		t->mips[i].colorspace = colorspace;
+		textureSelectFetch(&t->mips[i]);
+	}
+}
+
+void textureFromSRGB(struct texture *t) {
+	if (t->colorspace == linear || t->compression != uncompressed || !t->data.byte_p) return;
+	convertColors(t, SRGBToLinear);
+	setColorspace(t, linear);
+}
+
+void textureToSRGB(struct texture *t) {
+	if (t->colorspace == sRGB || t->compression != uncompressed || !t->data.byte_p) return;
+	convertColors(t, linearToSRGB);
+	setColorspace(t, sRGB);
 }
 
 struct texture *flipHorizontal(struct texture *t) {
@@ -153,6 +517,7 @@ struct texture *flipHorizontal(struct texture *t) {
 void destroyTexture(struct texture *t) {
 	if (t) {
 		free(t->data.byte_p);
+		free(t->mips);
 		free(t);
 		t = NULL;
 	}
@@ -22,10 +22,20 @@ enum precision {
 	none
 };
 
+// Byte textures can be stored as 4x4 blocks, see blockcompression.h
+enum compression {
+	uncompressed,
+	bc1_c, // RGB
+	bc3_c, // RGBA
+	bc4_c  // Grayscale
+};
+
 struct texture {
 	bool hasAlpha;
-	enum colorspace colorspace;
+	bool shared; //Owned by a textureRegistry or a baked scene, which share it between materials, instead of the materials using it
+	enum colorspace colorspace; //Of the stored texels. Lookups decode sRGB bytes into linear colors.
 	enum precision precision;
+	enum compression compression; //Compressed textures can only be read, not written to
 	union {
 		unsigned char *byte_p; //For 24/32bit
 		float *float_p; //For hdr
@@ -33,18 +43,52 @@ struct texture {
 	size_t channels;
 	size_t width;
 	size_t height;
+	struct texture *mips; //Levels 1 to mipCount, each half the size of the previous one
+	size_t mipCount;
+	struct tiledTexture *tiles; //Set for textures paged in through a textureCache, these have no data of their own
+	struct color (*fetch)(const struct texture *t, size_t x, size_t y); //Reads one texel, with y in storage order. Picked for the format by textureSelectFetch()
+	size_t wrapMaskX, wrapMaskY; //width - 1 and height - 1 for power of two sizes, 0 to wrap with a modulo instead
 };
 
+struct block;
+
 struct texture *newTexture(enum precision p, size_t width, size_t height, size_t channels);
 
+/// Build a box filtered mip chain for a texture, down to 1x1
+/// @param t Texture to generate mips for
+/// @param pool Optional, memory pool to store the levels in
+void generateMipmaps(struct texture *t, struct block **pool);
+
+/// Compress a byte texture and its mips into 4x4 blocks, to about a quarter of the memory for RGBA and a sixth for RGB.
+/// @param pool Optional, memory pool to store the compressed texture in
+/// @return Compressed copy of t, or NULL if its format can't be compressed
+struct texture *compressTexture(const struct texture *t, struct block **pool);
+
+/// Pick the texel fetch for the format of a texture. Has to be called again after changing its
+/// precision, channels, colorspace or size. newTexture() and the loaders already do this.
+void textureSelectFetch(struct texture *t);
+
+/// @return Bytes of texel data in t, not counting its mips
+size_t textureLevelBytes(const struct texture *t);
+
 void setPixel(struct texture *t, struct color c, size_t x, size_t y);
 
 /// Get a color value for a given pixel in a texture
 /// @remarks When filtered == false, pass in the integer coordinates, otherwise pass in a 0.0f->1.0f coefficient
 struct color textureGetPixel(const struct texture *t, float x, float y, bool filtered);
 
+/// Bilinearly blend the 2x2 texels starting at integer coordinates x, y, wrapping around the edges
+/// @param fx, fy Weights of the texels at x + 1 and y + 1
+struct color textureFilterTexels(const struct texture *t, size_t x, size_t y, float fx, float fy);
+
+/// Get a trilinearly filtered color value, from the mip levels closest to a given filter width
+/// @param x, y 0.0f->1.0f texture coordinates
+/// @param footprint Filter width in the same units. 0.0f samples the full resolution texture.
+struct color textureGetPixelLod(const struct texture *t, float x, float y, float footprint);
+
 /// Convert texture from sRGB to linear color space
-/// @remarks The texture data will be modified directly.
+/// @remarks The texture data will be modified directly. 8 bits aren't enough for linear darks,
+/// so byte textures are better left in sRGB, lookups decode those anyway.
 /// @param t Texture to convert
 void textureFromSRGB(struct texture *t);
 
@@ -0,0 +1,419 @@
+//
+//  texturecache.c
+//  C-Ray
+//
+//  Created by Valtteri Koskivuori on 18/10/2026.
+//  Copyright © 2026 Valtteri Koskivuori. All rights reserved.
+//
+
+#include "../../includes.h"
+
+#include <stdio.h>
+#include <string.h>
+#ifndef WINDOWS
+#include <unistd.h>
+#endif
+
+#include "texturecache.h"
+#include "texture.h"
+#include "../../utils/logging.h"
+#include "../../utils/fileio.h"
+#include "../../utils/mempool.h"
+#include "../../utils/platform/mutex.h"
+
+#define TILE_SIZE 64
+#define SHARD_COUNT 64
+
+#define TILED_MAGIC 0x58545243 // "CRTX"
+#define TILED_VERSION 2
+
+// Written as is, these files are a local cache and never leave the machine that made them
+struct tiledHeader {
+	uint32_t magic;
+	uint32_t version;
+	uint64_t stamp;
+	uint32_t width;
+	uint32_t height;
+	uint32_t channels;
+	uint32_t precision;
+	uint32_t hasAlpha;
+	uint32_t colorspace;
+	uint32_t levelCount;
+	uint32_t tileSize;
+};
+
+struct tiledLevel {
+	size_t width;
+	size_t height;
+	size_t tilesX;
+	size_t tilesY;
+	size_t firstTile; // Index of the first tile of this level
+};
+
+struct cachedTile {
+	// Texels of the tile, plus the next column and row over, so bilinear lookups never need a second tile
+	struct texture texels;
+	struct tiledTexture *owner;
+	size_t index;
+	struct cachedTile *newer;
+	struct cachedTile *older;
+};
+
+struct tiledTexture {
+	struct textureCache *cache;
+	enum colorspace colorspace;
+	enum precision precision;
+	size_t channels;
+	bool hasAlpha;
+	struct tiledLevel *levels;
+	size_t levelCount;
+	uint64_t *offsets; // File offset of each tile, and the end of the last one
+	// Resident tiles, NULL for the ones not loaded. A slot is only touched with the lock of the shard it maps to.
+	struct cachedTile **tiles;
+	size_t tileCount;
+	FILE *file;
+	struct crMutex *fileLock; // pread() doesn't need this, Windows does
+	uint32_t id;
+	struct tiledTexture *next;
+};
+
+struct cacheShard {
+	struct crMutex *lock;
+	struct cachedTile *newest;
+	struct cachedTile *oldest;
+	size_t bytes;
+	uint64_t hits;
+	uint64_t misses;
+	uint64_t evictions;
+};
+
+struct textureCache {
+	struct cacheShard shards[SHARD_COUNT];
+	size_t budget;
+	size_t shardBudget;
+	uint32_t textureCount;
+	struct tiledTexture *textures;
+};
+
+static inline size_t unitSize(enum precision p) {
+	return p == float_p ? sizeof(float) : sizeof(unsigned char);
+}
+
+// Each level is half the size of the previous one, like generateMipmaps() makes them
+static size_t levelSize(size_t size, size_t level) {
+	for (size_t i = 0; i < level; ++i) size = max(size / 2, 1);
+	return size;
+}
+
+static inline size_t tileExtent(size_t size, size_t tile) {
+	return min(TILE_SIZE, size - tile * TILE_SIZE);
+}
+
+struct textureCache *newTextureCache(size_t budget) {
+	struct textureCache *cache = calloc(1, sizeof(*cache));
+	cache->budget = budget;
+	cache->shardBudget = budget / SHARD_COUNT;
+	for (size_t i = 0; i < SHARD_COUNT; ++i) {
+		cache->shards[i].lock = createMutex();
+	}
+	return cache;
+}
+
+bool writeTiledTexture(const struct texture *t, const char *path, uint64_t stamp) {
+	if (t->precision == none || t->compression != uncompressed || !t->data.byte_p) return false;
+	FILE *file = fopen(path, "wb");
+	if (!file) return false;
+	const struct tiledHeader header = {
+		.magic = TILED_MAGIC,
+		.version = TILED_VERSION,
+		.stamp = stamp,
+		.width = (uint32_t)t->width,
+		.height = (uint32_t)t->height,
+		.channels = (uint32_t)t->channels,
+		.precision = t->precision,
+		.hasAlpha = t->hasAlpha,
+		.colorspace = t->colorspace,
+		.levelCount = (uint32_t)(t->mipCount + 1),
+		.tileSize = TILE_SIZE
+	};
+	bool success = fwrite(&header, sizeof(header), 1, file) == 1;
+
+	const size_t texelBytes = t->channels * unitSize(t->precision);
+	unsigned char *buffer = malloc((TILE_SIZE + 1) * (TILE_SIZE + 1) * texelBytes);
+	for (size_t i = 0; success && i < header.levelCount; ++i) {
+		const struct texture *level = i ? &t->mips[i - 1] : t;
+		const size_t tilesX = (level->width + TILE_SIZE - 1) / TILE_SIZE;
+		const size_t tilesY = (level->height + TILE_SIZE - 1) / TILE_SIZE;
+		for (size_t ty = 0; success && ty < tilesY; ++ty) {
+			for (size_t tx = 0; success && tx < tilesX; ++tx) {
+				const size_t width = tileExtent(level->width, tx) + 1;
+				const size_t height = tileExtent(level->height, ty) + 1;
+				// Rows are flipped like in any other texture, and the border wraps around like lookups do
+				for (size_t y = 0; y < height; ++y) {
+					const size_t srcY = (ty * TILE_SIZE + y) % level->height;
+					for (size_t x = 0; x < width; ++x) {
+						const size_t srcX = (tx * TILE_SIZE + x) % level->width;
+						const size_t src = srcX + (level->height - 1 - srcY) * level->width;
+						const size_t dst = x + (height - 1 - y) * width;
+						memcpy(&buffer[dst * texelBytes], &level->data.byte_p[src * texelBytes], texelBytes);
+					}
+				}
+				success = fwrite(buffer, texelBytes, width * height, file) == width * height;
+			}
+		}
+	}
+	free(buffer);
+	success = fclose(file) == 0 && success;
+	if (!success) remove(path);
+	return success;
+}
+
+struct texture *openTiledTexture(struct textureCache *cache, const char *path, uint64_t stamp, struct block **pool) {
+	FILE *file = fopen(path, "rb");
+	if (!file) return NULL;
+	struct tiledHeader header;
+	if (fread(&header, sizeof(header), 1, file) != 1 || header.magic != TILED_MAGIC || header.version != TILED_VERSION ||
+		header.stamp != stamp || header.tileSize != TILE_SIZE || !header.levelCount || header.precision >= none) {
+		fclose(file);
+		return NULL;
+	}
+
+	struct tiledTexture *t = calloc(1, sizeof(*t));
+	t->cache = cache;
+	t->colorspace = header.colorspace;
+	t->precision = header.precision;
+	t->channels = header.channels;
+	t->hasAlpha = header.hasAlpha;
+	t->levelCount = header.levelCount;
+	t->levels = calloc(t->levelCount, sizeof(*t->levels));
+	for (size_t i = 0; i < t->levelCount; ++i) {
+		struct tiledLevel *level = &t->levels[i];
+		level->width = levelSize(header.width, i);
+		level->height = levelSize(header.height, i);
+		level->tilesX = (level->width + TILE_SIZE - 1) / TILE_SIZE;
+		level->tilesY = (level->height + TILE_SIZE - 1) / TILE_SIZE;
+		level->firstTile = t->tileCount;
+		t->tileCount += level->tilesX * level->tilesY;
+	}
+	const size_t texelBytes = t->channels * unitSize(t->precision);
+	t->offsets = malloc((t->tileCount + 1) * sizeof(*t->offsets));
+	t->offsets[0] = sizeof(header);
+	for (size_t i = 0; i < t->levelCount; ++i) {
+		const struct tiledLevel *level = &t->levels[i];
+		for (size_t ty = 0; ty < level->tilesY; ++ty) {
+			for (size_t tx = 0; tx < level->tilesX; ++tx) {
+				const size_t index = level->firstTile + ty * level->tilesX + tx;
+				const size_t texels = (tileExtent(level->width, tx) + 1) * (tileExtent(level->height, ty) + 1);
+				t->offsets[index + 1] = t->offsets[index] + texels * texelBytes;
+			}
+		}
+	}
+	// An interrupted conversion leaves a truncated file behind
+	if (getFileSize(path) != t->offsets[t->tileCount]) {
+		logr(warning, "Tiled texture %s is truncated, converting it again.\n", path);
+		fclose(file);
+		free(t->offsets);
+		free(t->levels);
+		free(t);
+		return NULL;
+	}
+	t->tiles = calloc(t->tileCount, sizeof(*t->tiles));
+	t->file = file;
+	t->fileLock = createMutex();
+	t->id = cache->textureCount++;
+	t->next = cache->textures;
+	cache->textures = t;
+
+	struct texture *tex = pool ? allocBlock(pool, sizeof(*tex)) : calloc(1, sizeof(*tex));
+	*tex = (struct texture){
+		.hasAlpha = t->hasAlpha,
+		.colorspace = t->colorspace,
+		.precision = t->precision,
+		.channels = t->channels,
+		.width = header.width,
+		.height = header.height,
+		.mipCount = t->levelCount - 1,
+		.tiles = t
+	};
+	return tex;
+}
+
+static bool readAt(struct tiledTexture *t, void *dst, size_t bytes, uint64_t offset) {
+#ifdef WINDOWS
+	lockMutex(t->fileLock);
+	const bool success = _fseeki64(t->file, (__int64)offset, SEEK_SET) == 0 && fread(dst, 1, bytes, t->file) == bytes;
+	releaseMutex(t->fileLock);
+	return success;
+#else
+	return pread(fileno(t->file), dst, bytes, (off_t)offset) == (ssize_t)bytes;
+#endif
+}
+
+static struct cachedTile *readTile(struct tiledTexture *t, const struct tiledLevel *level, size_t tx, size_t ty) {
+	const size_t index = level->firstTile + ty * level->tilesX + tx;
+	const size_t bytes = t->offsets[index + 1] - t->offsets[index];
+	struct cachedTile *tile = malloc(sizeof(*tile) + bytes);
+	*tile = (struct cachedTile){
+		.texels = {
+			.hasAlpha = t->hasAlpha,
+			.colorspace = t->colorspace,
+			.precision = t->precision,
+			.data.byte_p = (unsigned char *)(tile + 1),
+			.channels = t->channels,
+			.width = tileExtent(level->width, tx) + 1,
+			.height = tileExtent(level->height, ty) + 1
+		},
+		.owner = t,
+		.index = index
+	};
+	textureSelectFetch(&tile->texels);
+	if (!readAt(t, tile->texels.data.byte_p, bytes, t->offsets[index])) {
+		logr(warning, "Failed to read a texture tile, the file may have changed on disk.\n");
+		memset(tile->texels.data.byte_p, 0, bytes);
+	}
+	return tile;
+}
+
+static inline size_t tileBytes(const struct cachedTile *tile) {
+	return tile->owner->offsets[tile->index + 1] - tile->owner->offsets[tile->index];
+}
+
+static void unlinkTile(struct cacheShard *shard, struct cachedTile *tile) {
+	if (tile->newer) tile->newer->older = tile->older; else shard->newest = tile->older;
+	if (tile->older) tile->older->newer = tile->newer; else shard->oldest = tile->newer;
+	tile->newer = tile->older = NULL;
+}
+
+static void pushTile(struct cacheShard *shard, struct cachedTile *tile) {
+	tile->older = shard->newest;
+	tile->newer = NULL;
+	if (shard->newest) shard->newest->newer = tile; else shard->oldest = tile;
+	shard->newest = tile;
+}
+
+// Tiles always map to the same shard, so its lock guards their slots in tiledTexture.tiles too
+static inline struct cacheShard *shardFor(struct tiledTexture *t, size_t index) {
+	const uint32_t hash = ((uint32_t)index * 0x9E3779B1u) ^ (t->id * 0x85EBCA77u);
+	return &t->cache->shards[(hash >> 16) % SHARD_COUNT];
+}
+
+// Called with the shard locked. The tile stays valid until it's released.
+static const struct texture *fetchTile(struct tiledTexture *t, struct cacheShard *shard, const struct tiledLevel *level, size_t tx, size_t ty) {
+	const size_t index = level->firstTile + ty * level->tilesX + tx;
+	struct cachedTile *tile = t->tiles[index];
+	if (tile) {
+		shard->hits++;
+		if (shard->newest != tile) {
+			unlinkTile(shard, tile);
+			pushTile(shard, tile);
+		}
+		return &tile->texels;
+	}
+	shard->misses++;
+	tile = readTile(t, level, tx, ty);
+	t->tiles[index] = tile;
+	pushTile(shard, tile);
+	shard->bytes += tileBytes(tile);
+	while (shard->bytes > t->cache->shardBudget && shard->oldest != tile) {
+		struct cachedTile *victim = shard->oldest;
+		unlinkTile(shard, victim);
+		victim->owner->tiles[victim->index] = NULL;
+		shard->bytes -= tileBytes(victim);
+		shard->evictions++;
+		free(victim);
+	}
+	return &tile->texels;
+}
+
+struct color tiledTextureGetPixel(struct tiledTexture *t, size_t level, float x, float y, bool filtered) {
+	const struct tiledLevel *l = &t->levels[min(level, t->levelCount - 1)];
+	size_t px, py;
+	float fx = 0.0f;
+	float fy = 0.0f;
+	if (filtered) {
+		// Same texel centers as textureGetPixel()
+		const float xcopy = x * l->width - 0.5f;
+		const float ycopy = y * l->height - 0.5f;
+		const int xint = (int)xcopy;
+		const int yint = (int)ycopy;
+		fx = xcopy - xint;
+		fy = ycopy - yint;
+		px = (size_t)xint % l->width;
+		py = (size_t)yint % l->height;
+	} else {
+		px = (size_t)x % l->width;
+		py = (size_t)y % l->height;
+	}
+	const size_t tx = px / TILE_SIZE;
+	const size_t ty = py / TILE_SIZE;
+	px -= tx * TILE_SIZE;
+	py -= ty * TILE_SIZE;
+
+	struct cacheShard *shard = shardFor(t, l->firstTile + ty * l->tilesX + tx);
+	lockMutex(shard->lock);
+	const struct texture *tile = fetchTile(t, shard, l, tx, ty);
+	struct color output;
+	if (filtered) {
+		// The border texels of the tile hold the right and bottom neighbours
+		output = textureFilterTexels(tile, px, py, fx, fy);
+	} else {
+		output = textureGetPixel(tile, px, py, false);
+	}
+	releaseMutex(shard->lock);
+	return output;
+}
+
+struct textureCacheStats getTextureCacheStats(struct textureCache *cache) {
+	struct textureCacheStats stats = { 0 };
+	for (size_t i = 0; i < SHARD_COUNT; ++i) {
+		struct cacheShard *shard = &cache->shards[i];
+		lockMutex(shard->lock);
+		stats.hits += shard->hits;
+		stats.misses += shard->misses;
+		stats.evictions += shard->evictions;
+		stats.resident += shard->bytes;
+		releaseMutex(shard->lock);
+	}
+	return stats;
+}
+
+void printTextureCacheStats(struct textureCache *cache) {
+	const struct textureCacheStats stats = getTextureCacheStats(cache);
+	const uint64_t lookups = stats.hits + stats.misses;
+	char *resident = humanFileSize(stats.resident);
+	char *budget = humanFileSize(cache->budget);
+	logr(info, "Texture cache: %lu lookups, %.2f%% hits, %lu tiles read, %lu evicted, %s of %s in use\n",
+		 (unsigned long)lookups,
+		 lookups ? 100.0 * stats.hits / lookups : 0.0,
+		 (unsigned long)stats.misses,
+		 (unsigned long)stats.evictions,
+		 resident,
+		 budget);
+	free(resident);
+	free(budget);
+}
+
+void destroyTextureCache(struct textureCache *cache) {
+	if (!cache) return;
+	for (size_t i = 0; i < SHARD_COUNT; ++i) {
+		struct cachedTile *tile = cache->shards[i].newest;
+		while (tile) {
+			struct cachedTile *next = tile->older;
+			free(tile);
+			tile = next;
+		}
+		free(cache->shards[i].lock);
+	}
+	struct tiledTexture *t = cache->textures;
+	while (t) {
+		struct tiledTexture *next = t->next;
+		fclose(t->file);
+		free(t->fileLock);
+		free(t->tiles);
+		free(t->offsets);
+		free(t->levels);
+		free(t);
+		t = next;
+	}
+	free(cache);
+}
@@ -0,0 +1,56 @@
+//
+//  texturecache.h
+//  C-Ray
+//
+//  Created by Valtteri Koskivuori on 18/10/2026.
+//  Copyright © 2026 Valtteri Koskivuori. All rights reserved.
+//
+
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "../color.h"
+
+struct texture;
+struct block;
+
+// Textures are converted once into a tiled, mipmapped file, and render threads page tiles of it in
+// on first access. The least recently used tiles are evicted to keep the cache under a memory budget.
+// Tiles are spread over independently locked shards, so threads rarely wait on each other.
+
+struct textureCache;
+struct tiledTexture;
+
+struct textureCacheStats {
+	uint64_t hits;
+	uint64_t misses; // Tiles read from disk
+	uint64_t evictions;
+	size_t resident; // Bytes of tile data in memory
+};
+
+/// @param budget Memory budget for resident tiles, in bytes
+struct textureCache *newTextureCache(size_t budget);
+
+/// Write a texture and its mips out as a tiled file, to be paged in with openTiledTexture()
+/// @param stamp Identifies the source image, so stale files can be detected
+/// @return true if the whole file was written
+bool writeTiledTexture(const struct texture *t, const char *path, uint64_t stamp);
+
+/// Open a file written by writeTiledTexture(). Texels are read as lookups need them.
+/// @param stamp Has to match the one the file was written with
+/// @param pool Optional, memory pool to allocate the texture from
+/// @return Texture without any data of its own, or NULL if the file is missing, stale or truncated
+struct texture *openTiledTexture(struct textureCache *cache, const char *path, uint64_t stamp, struct block **pool);
+
+/// Look up a tiled texture, with the same semantics as textureGetPixel()
+/// @param level Mip level, clamped to the smallest one
+struct color tiledTextureGetPixel(struct tiledTexture *t, size_t level, float x, float y, bool filtered);
+
+struct textureCacheStats getTextureCacheStats(struct textureCache *cache);
+
+void printTextureCacheStats(struct textureCache *cache);
+
+/// Close all textures opened through cache. Textures returned by openTiledTexture() can't be used after this.
+void destroyTextureCache(struct textureCache *cache);
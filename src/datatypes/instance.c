@@ -15,10 +15,10 @@
 #include "bbox.h"
 #include "mesh.h"
 #include "sphere.h"
+#include "poly.h"
 #include "scene.h"
 #include "../utils/logging.h"
 #include "../utils/args.h"
-#include "../datatypes/vertexbuffer.h"
 
 static inline struct coord getTexMapSphere(const struct hitRecord *isect) {
 	struct vector ud = isect->surfaceNormal;
@@ -32,21 +32,41 @@ static inline struct coord getTexMapSphere(const struct hitRecord *isect) {
 	return (struct coord){ u, v };
 }
 
-static bool intersectSphere(const struct instance *instance, const struct lightRay *ray, struct hitRecord *isect) {
+// Both intersection and resolving have to see the exact same ray
+static inline struct lightRay objectSpaceRay(const struct instance *instance, const struct lightRay *ray, float offset) {
 	struct lightRay copy = *ray;
 	transformRay(&copy, &instance->composite.Ainv);
-	struct sphere *sphere = (struct sphere*)instance->object;
-	float offset = sphere->rayOffset;
 	copy.start = vecAdd(copy.start, vecScale(copy.direction, offset));
-	if (rayIntersectsWithSphere(&copy, sphere, isect)) {
-		isect->uv = getTexMapSphere(isect);
-		isect->polygon = NULL;
-		isect->material = sphere->material;
-		transformPoint(&isect->hitPoint, &instance->composite.A);
-		transformVectorWithTranspose(&isect->surfaceNormal, &instance->composite.Ainv);
-		return true;
-	}
-	return false;
+	return copy;
+}
+
+// Texture space width of a unit wide ray footprint, given how many texture coordinates map onto a unit of area.
+// Ray cones are isotropic, so grazing hits get the width of the cone along the surface.
+static inline float footprintScale(const struct hitRecord *isect, float texelDensity) {
+	const float cosine = fabsf(vecDot(isect->surfaceNormal, isect->incident.direction)) / vecLength(isect->incident.direction);
+	return cosine > 0.0f ? texelDensity / cosine : 0.0f;
+}
+
+static bool intersectSphere(const struct instance *instance, const struct lightRay *ray, struct hitRecord *isect) {
+	struct sphere *sphere = (struct sphere*)instance->object;
+	struct lightRay copy = objectSpaceRay(instance, ray, sphere->rayOffset);
+	return rayIntersectsWithSphere(&copy, sphere, isect);
+}
+
+static void resolveSphereHit(const struct instance *instance, struct hitRecord *isect) {
+	struct sphere *sphere = (struct sphere*)instance->object;
+	struct lightRay copy = objectSpaceRay(instance, &isect->incident, sphere->rayOffset);
+	isect->hitPoint = alongRay(&copy, isect->distance);
+	isect->surfaceNormal = vecNormalize(isect->hitPoint);
+	isect->uv = getTexMapSphere(isect);
+	isect->material = &sphere->material;
+	transformPoint(&isect->hitPoint, &instance->composite.A);
+	transformVectorWithTranspose(&isect->surfaceNormal, &instance->composite.Ainv);
+	isect->surfaceNormal = vecNormalize(isect->surfaceNormal);
+	// The mapping stretches u over the circumference and v over half of it
+	struct vector radius = { sphere->radius, 0.0f, 0.0f };
+	transformVector(&radius, &instance->composite.A);
+	isect->footprint = footprintScale(isect, 1.0f / (sqrtf(2.0f) * PI * vecLength(radius)));
 }
 
 static void getSphereBBoxAndCenter(const struct instance *instance, struct boundingBox *bbox, struct vector *center) {
@@ -71,6 +91,7 @@ struct instance newSphereInstance(struct sphere *sphere) {
 		.object = sphere,
 		.composite = newTransform(),
 		.intersectFn = intersectSphere,
+		.resolveHitFn = resolveSphereHit,
 		.getBBoxAndCenterFn = getSphereBBoxAndCenter
 	};
 }
@@ -78,7 +99,7 @@ struct instance newSphereInstance(struct sphere *sphere) {
 static struct coord getTexMapMesh(const struct mesh *mesh, const struct hitRecord *isect) {
 	if (mesh->textureCoordCount == 0) return (struct coord){-1.0f, -1.0f};
 	struct poly *p = isect->polygon;
-	if (p->textureIndex[0] == -1) return (struct coord){-1.0f, -1.0f};
+	if (!p->hasTexCoords) return (struct coord){-1.0f, -1.0f};
 	
 	//barycentric coordinates for this polygon
 	const float u = isect->uv.x;
@@ -86,30 +107,47 @@ static struct coord getTexMapMesh(const struct mesh *mesh, const struct hitRecor
 	const float w = 1.0f - u - v;
 	
 	//Weighted texture coordinates
-	const struct coord ucomponent = coordScale(u, g_textureCoords[p->textureIndex[1]]);
-	const struct coord vcomponent = coordScale(v, g_textureCoords[p->textureIndex[2]]);
-	const struct coord wcomponent = coordScale(w, g_textureCoords[p->textureIndex[0]]);
+	const struct coord ucomponent = coordScale(u, meshTexCoord(mesh, p, 1));
+	const struct coord vcomponent = coordScale(v, meshTexCoord(mesh, p, 2));
+	const struct coord wcomponent = coordScale(w, meshTexCoord(mesh, p, 0));
 	
 	// textureXY = u * v1tex + v * v2tex + w * v3tex
 	return addCoords(addCoords(ucomponent, vcomponent), wcomponent);
 }
 
+// Texture coordinates per unit of world space area, spread evenly over the polygon
+static float polygonTexelDensity(const struct instance *instance, const struct mesh *mesh, const struct poly *p) {
+	const struct coord t0 = meshTexCoord(mesh, p, 0);
+	const struct coord t1 = meshTexCoord(mesh, p, 1);
+	const struct coord t2 = meshTexCoord(mesh, p, 2);
+	const float uvArea = fabsf((t1.x - t0.x) * (t2.y - t0.y) - (t2.x - t0.x) * (t1.y - t0.y));
+	struct vector e1 = vecSub(mesh->vertices[p->vertexIndex[1]], mesh->vertices[p->vertexIndex[0]]);
+	struct vector e2 = vecSub(mesh->vertices[p->vertexIndex[2]], mesh->vertices[p->vertexIndex[0]]);
+	transformVector(&e1, &instance->composite.A);
+	transformVector(&e2, &instance->composite.A);
+	const float area = vecLength(vecCross(e1, e2));
+	return area > 0.0f ? sqrtf(uvArea / area) : 0.0f;
+}
+
 static bool intersectMesh(const struct instance *instance, const struct lightRay *ray, struct hitRecord *isect) {
-	struct lightRay copy = *ray;
-	transformRay(&copy, &instance->composite.Ainv);
 	struct mesh *mesh = (struct mesh *)instance->object;
-	float offset = mesh->rayOffset;
-	copy.start = vecAdd(copy.start, vecScale(copy.direction, offset));
-	if (traverseBottomLevelBvh(mesh, &copy, isect)) {
-		// Repopulate uv with actual texture mapping
-		isect->uv = getTexMapMesh(mesh, isect);
-		isect->material = mesh->materials[isect->polygon->materialIndex];
-		transformPoint(&isect->hitPoint, &instance->composite.A);
-		transformVectorWithTranspose(&isect->surfaceNormal, &instance->composite.Ainv);
-		isect->surfaceNormal = vecNormalize(isect->surfaceNormal);
-		return true;
-	}
-	return false;
+	struct lightRay copy = objectSpaceRay(instance, ray, mesh->rayOffset);
+	return traverseBottomLevelBvh(mesh, &copy, isect);
+}
+
+static void resolveMeshHit(const struct instance *instance, struct hitRecord *isect) {
+	struct mesh *mesh = (struct mesh *)instance->object;
+	struct lightRay copy = objectSpaceRay(instance, &isect->incident, mesh->rayOffset);
+	isect->hitPoint = alongRay(&copy, isect->distance);
+	isect->surfaceNormal = polygonNormal(mesh, isect->polygon, isect->uv);
+	// Replace barycentrics with actual texture mapping
+	isect->uv = getTexMapMesh(mesh, isect);
+	isect->material = &mesh->materials[isect->polygon->materialIndex];
+	transformPoint(&isect->hitPoint, &instance->composite.A);
+	transformVectorWithTranspose(&isect->surfaceNormal, &instance->composite.Ainv);
+	isect->surfaceNormal = vecNormalize(isect->surfaceNormal);
+	const bool textured = mesh->textureCoordCount && isect->polygon->hasTexCoords;
+	isect->footprint = textured ? footprintScale(isect, polygonTexelDensity(instance, mesh, isect->polygon)) : 0.0f;
 }
 
 bool isMesh(const struct instance *instance) {
@@ -131,6 +169,7 @@ struct instance newMeshInstance(struct mesh *mesh) {
 		.object = mesh,
 		.composite = newTransform(),
 		.intersectFn = intersectMesh,
+		.resolveHitFn = resolveMeshHit,
 		.getBBoxAndCenterFn = getMeshBBoxAndCenter
 	};
 }
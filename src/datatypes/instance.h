@@ -22,6 +22,10 @@ struct mesh;
 struct instance {
 	struct transform composite;
 	bool (*intersectFn)(const struct instance *, const struct lightRay *, struct hitRecord *);
+	// intersectFn only finds the distance and primitive. This fills in the hit point, normal,
+	// texture coordinates and material, so that's only done once for the closest hit.
+	// The footprint is left as the texture space width of a unit wide footprint, for the caller to scale.
+	void (*resolveHitFn)(const struct instance *, struct hitRecord *);
 	void (*getBBoxAndCenterFn)(const struct instance *, struct boundingBox *, struct vector *);
 	void *object;
 };
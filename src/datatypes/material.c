@@ -11,7 +11,6 @@
 #include "material.h"
 
 #include "../renderer/pathtrace.h"
-#include "vertexbuffer.h"
 #include "image/texture.h"
 #include "poly.h"
 #include "../utils/assert.h"
@@ -66,7 +65,7 @@ const struct bsdfNode *appendAlpha(struct world *w, const struct bsdfNode *base,
 
 void assignBSDF(struct world *w, struct material *mat) {
 	const struct valueNode *roughness = mat->specularMap ? newGrayscaleConverter(w, newImageTexture(w, mat->specularMap, NO_BILINEAR)) : newConstantValue(w, mat->roughness);
-	const struct colorNode *color = mat->texture ? newImageTexture(w, mat->texture, SRGB_TRANSFORM) : newConstantTexture(w, mat->diffuse);
+	const struct colorNode *color = mat->texture ? newImageTexture(w, mat->texture, 0) : newConstantTexture(w, mat->diffuse);
 	logr(debug, "name: %s, illum: %i\n", mat->name, mat->illum);
 	mat->bsdf = NULL;
 	
@@ -113,8 +112,8 @@ void assignBSDF(struct world *w, struct material *mat) {
 void destroyMaterial(struct material *mat) {
 	if (mat) {
 		free(mat->name);
-		if (mat->texture) destroyTexture(mat->texture);
-		if (mat->normalMap) destroyTexture(mat->normalMap);
-		if (mat->specularMap) destroyTexture(mat->specularMap);
+		if (mat->texture && !mat->texture->shared) destroyTexture(mat->texture);
+		if (mat->normalMap && !mat->normalMap->shared) destroyTexture(mat->normalMap);
+		if (mat->specularMap && !mat->specularMap->shared) destroyTexture(mat->specularMap);
 	}
 }
@@ -9,19 +9,188 @@
 #include "../includes.h"
 #include "mesh.h"
 
+#include <string.h>
 #include "../accelerators/bvh.h"
-#include "vertexbuffer.h"
 #include "transforms.h"
 #include "poly.h"
 #include "material.h"
 #include "vector.h"
 
+static uint16_t toSnorm16(float v) {
+	return (uint16_t)(int16_t)roundf(fminf(fmaxf(v, -1.0f), 1.0f) * 32767.0f);
+}
+
+static float fromSnorm16(uint16_t v) {
+	return fmaxf((float)(int16_t)v / 32767.0f, -1.0f);
+}
+
+static float signNotZero(float v) {
+	return v >= 0.0f ? 1.0f : -1.0f;
+}
+
+// Project onto the octahedron |x| + |y| + |z| = 1, and fold the lower half over the upper one
+static uint32_t encodeNormal(struct vector n) {
+	const float l1 = fabsf(n.x) + fabsf(n.y) + fabsf(n.z);
+	if (l1 == 0.0f) return 0;
+	float x = n.x / l1;
+	float y = n.y / l1;
+	if (n.z < 0.0f) {
+		const float foldedX = (1.0f - fabsf(y)) * signNotZero(x);
+		y = (1.0f - fabsf(x)) * signNotZero(y);
+		x = foldedX;
+	}
+	return (uint32_t)toSnorm16(x) | (uint32_t)toSnorm16(y) << 16;
+}
+
+static struct vector decodeNormal(uint32_t packed) {
+	float x = fromSnorm16(packed & 0xFFFF);
+	float y = fromSnorm16(packed >> 16);
+	const float z = 1.0f - fabsf(x) - fabsf(y);
+	const float t = fmaxf(-z, 0.0f);
+	x += x >= 0.0f ? -t : t;
+	y += y >= 0.0f ? -t : t;
+	return vecNormalize((struct vector){ x, y, z });
+}
+
+// IEEE 754 binary16, rounded to nearest even
+static uint16_t floatToHalf(float f) {
+	uint32_t bits;
+	memcpy(&bits, &f, sizeof(bits));
+	const uint32_t sign = (bits >> 16) & 0x8000;
+	const uint32_t exponent = (bits >> 23) & 0xFF;
+	uint32_t mantissa = bits & 0x7FFFFF;
+	if (exponent == 0xFF) return (uint16_t)(sign | 0x7C00 | (mantissa ? 0x200 : 0));
+	const int biased = (int)exponent - 127 + 15;
+	if (biased >= 31) return (uint16_t)(sign | 0x7C00);
+	if (biased <= 0) {
+		if (biased < -10) return (uint16_t)sign;
+		mantissa |= 0x800000;
+		const uint32_t shift = (uint32_t)(14 - biased);
+		uint32_t half = mantissa >> shift;
+		const uint32_t rest = mantissa & ((1u << shift) - 1);
+		const uint32_t halfway = 1u << (shift - 1);
+		if (rest > halfway || (rest == halfway && (half & 1))) half++;
+		return (uint16_t)(sign | half);
+	}
+	uint32_t half = sign | (uint32_t)biased << 10 | mantissa >> 13;
+	const uint32_t rest = mantissa & 0x1FFF;
+	// Carries into the exponent as needed
+	if (rest > 0x1000 || (rest == 0x1000 && (half & 1))) half++;
+	return (uint16_t)half;
+}
+
+static float halfToFloat(uint16_t half) {
+	const uint32_t sign = (uint32_t)(half & 0x8000) << 16;
+	uint32_t exponent = (half >> 10) & 0x1F;
+	uint32_t mantissa = half & 0x3FF;
+	uint32_t bits;
+	if (exponent == 0x1F) {
+		bits = sign | 0x7F800000 | mantissa << 13;
+	} else if (exponent) {
+		bits = sign | (exponent + 127 - 15) << 23 | mantissa << 13;
+	} else if (mantissa) {
+		// Subnormal, normalized for the wider exponent
+		exponent = 127 - 15 + 1;
+		while (!(mantissa & 0x400)) {
+			mantissa <<= 1;
+			exponent--;
+		}
+		bits = sign | exponent << 23 | (mantissa & 0x3FF) << 13;
+	} else {
+		bits = sign;
+	}
+	float f;
+	memcpy(&f, &bits, sizeof(f));
+	return f;
+}
+
+struct vector meshNormal(const struct mesh *mesh, const struct poly *poly, int corner) {
+	const int index = mesh->attributes ? mesh->attributes[poly - mesh->polygons].normalIndex[corner] : poly->vertexIndex[corner];
+	return mesh->packedNormals ? decodeNormal(mesh->packedNormals[index]) : mesh->normals[index];
+}
+
+struct coord meshTexCoord(const struct mesh *mesh, const struct poly *poly, int corner) {
+	const int index = mesh->attributes ? mesh->attributes[poly - mesh->polygons].textureIndex[corner] : poly->vertexIndex[corner];
+	if (!mesh->packedTexCoords) return mesh->texCoords[index];
+	const uint32_t packed = mesh->packedTexCoords[index];
+	return (struct coord){ halfToFloat(packed & 0xFFFF), halfToFloat(packed >> 16) };
+}
+
+// Whether every corner uses its vertex index for its normal and texture coordinate too
+static bool sharesIndices(const struct mesh *mesh) {
+	for (int i = 0; i < mesh->polyCount; ++i) {
+		const struct poly *p = &mesh->polygons[i];
+		const struct polyAttributes *a = &mesh->attributes[i];
+		for (int c = 0; c < MAX_CRAY_VERTEX_COUNT; ++c) {
+			if (p->hasNormals && a->normalIndex[c] != p->vertexIndex[c]) return false;
+			if (p->hasTexCoords && a->textureIndex[c] != p->vertexIndex[c]) return false;
+		}
+	}
+	return true;
+}
+
+void compactMeshes(struct mesh *meshes, size_t meshCount) {
+	for (size_t i = 0; i < meshCount; ++i) {
+		struct mesh *mesh = &meshes[i];
+		if (mesh->attributes && sharesIndices(mesh)) {
+			free(mesh->attributes);
+			mesh->attributes = NULL;
+		}
+		// Packed once, through the mesh that owns them
+		if (mesh->sharedVertices) continue;
+		if (mesh->normals) {
+			mesh->packedNormals = malloc(mesh->normalCount * sizeof(*mesh->packedNormals));
+			for (int n = 0; n < mesh->normalCount; ++n) mesh->packedNormals[n] = encodeNormal(mesh->normals[n]);
+			free(mesh->normals);
+			mesh->normals = NULL;
+		}
+		if (mesh->texCoords) {
+			mesh->packedTexCoords = malloc(mesh->textureCoordCount * sizeof(*mesh->packedTexCoords));
+			for (int t = 0; t < mesh->textureCoordCount; ++t) {
+				mesh->packedTexCoords[t] = (uint32_t)floatToHalf(mesh->texCoords[t].x) | (uint32_t)floatToHalf(mesh->texCoords[t].y) << 16;
+			}
+			free(mesh->texCoords);
+			mesh->texCoords = NULL;
+		}
+		for (size_t j = i + 1; j < meshCount; ++j) {
+			if (!meshes[j].sharedVertices || meshes[j].vertices != mesh->vertices) continue;
+			meshes[j].normals = mesh->normals;
+			meshes[j].packedNormals = mesh->packedNormals;
+			meshes[j].texCoords = mesh->texCoords;
+			meshes[j].packedTexCoords = mesh->packedTexCoords;
+		}
+	}
+}
+
+size_t meshBytes(const struct mesh *mesh, size_t *uncompactBytes) {
+	const size_t polygons = mesh->polyCount * sizeof(struct poly);
+	size_t bytes = polygons + (mesh->attributes ? mesh->polyCount * sizeof(struct polyAttributes) : 0);
+	size_t uncompact = polygons + mesh->polyCount * sizeof(struct polyAttributes);
+	if (!mesh->sharedVertices) {
+		const size_t vertices = mesh->vertexCount * sizeof(struct vector);
+		bytes += vertices;
+		bytes += mesh->normalCount * (mesh->packedNormals ? sizeof(*mesh->packedNormals) : sizeof(struct vector));
+		bytes += mesh->textureCoordCount * (mesh->packedTexCoords ? sizeof(*mesh->packedTexCoords) : sizeof(struct coord));
+		uncompact += vertices + mesh->normalCount * sizeof(struct vector) + mesh->textureCoordCount * sizeof(struct coord);
+	}
+	if (uncompactBytes) *uncompactBytes = uncompact;
+	return bytes;
+}
+
 void destroyMesh(struct mesh *mesh) {
 	if (mesh) {
 		free(mesh->name);
 		free(mesh->polygons);
+		free(mesh->attributes);
+		if (!mesh->sharedVertices) {
+			free(mesh->vertices);
+			free(mesh->normals);
+			free(mesh->packedNormals);
+			free(mesh->texCoords);
+			free(mesh->packedTexCoords);
+		}
 		destroyBvh(mesh->bvh);
-		if (mesh->materials) {
+		if (mesh->materials && !mesh->sharedMaterials) {
 			for (int i = 0; i < mesh->materialCount; ++i) {
 				destroyMaterial(&mesh->materials[i]);
 			}
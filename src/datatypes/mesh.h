@@ -8,35 +8,48 @@
 
 #pragma once
 
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
 /*
- C-Ray stores all vectors and polygons in shared arrays, so these
- data structures just keep track of 'first-index offsets'
- These offsets are the element index of the first vector/polygon for this mesh
- The 'count' values are then used to keep track of where the vectors/polygons stop.
+ Each mesh keeps its vertex data in arrays allocated once at their final size,
+ and polygons index into those. Meshes loaded from the same file may share them,
+ since faces in one group of an OBJ can use vertices from any other.
+ 
+ Compact meshes store normals octahedral encoded in 2x16 bits and texture coordinates
+ as half floats instead, in packedNormals and packedTexCoords. Read them through
+ meshNormal() and meshTexCoord(), which work for both.
  
  Materials are stored within the mesh struct in *materials
  */
 
 struct mesh {
 	//Vertices
+	struct vector *vertices;
 	int vertexCount;
-	int firstVectorIndex;
 	
 	//Normals
+	struct vector *normals;
+	uint32_t *packedNormals;
 	int normalCount;
-	int firstNormalIndex;
 	
 	//Texture coordinates
+	struct coord *texCoords;
+	uint32_t *packedTexCoords;
 	int textureCoordCount;
-	int firstTextureCoordIndex;
+	
+	bool sharedVertices; // Owned by another mesh loaded from the same file
 	
 	//Faces
 	struct poly *polygons;
+	struct polyAttributes *attributes; // One per polygon. NULL if normals and texture coordinates use the vertex indices.
 	int polyCount;
 	
 	//Materials
 	int materialCount;
 	struct material *materials;
+	bool sharedMaterials; // Owned by another mesh loaded from the same file
 	
 	struct bvh *bvh;
 	
@@ -45,6 +58,19 @@ struct mesh {
 	char *name;
 };
 
-void transformMesh(struct mesh *mesh);
+/// Normal at a corner of a polygon, which has to have normals
+struct vector meshNormal(const struct mesh *mesh, const struct poly *poly, int corner);
+
+/// Texture coordinate at a corner of a polygon, which has to have them
+struct coord meshTexCoord(const struct mesh *mesh, const struct poly *poly, int corner);
+
+/// Switch meshes loaded from one file to compact vertex attributes. Normals lose their length,
+/// and texture coordinates get about three decimal digits of precision.
+/// Meshes that use the same index for all attributes of every corner drop their polyAttributes.
+void compactMeshes(struct mesh *meshes, size_t meshCount);
+
+/// Bytes taken by the vertex data and polygons of a mesh, not counting vertex data owned by another one
+/// @param uncompactBytes Set to what they would take without compact attributes
+size_t meshBytes(const struct mesh *mesh, size_t *uncompactBytes);
 
 void destroyMesh(struct mesh *mesh);
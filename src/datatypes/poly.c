@@ -8,26 +8,25 @@
 
 #include "../includes.h"
 #include "poly.h"
-#include "vertexbuffer.h"
+#include "mesh.h"
 
 #include "vector.h"
 #include "lightray.h"
 #include "../renderer/pathtrace.h"
 
-bool rayIntersectsWithPolygon(const struct lightRay *ray, const struct poly *poly, struct hitRecord *isect) {
+bool rayIntersectsWithPolygon(const struct lightRay *ray, const struct poly *poly, const struct vector *vertices, struct hitRecord *isect) {
 	// Möller-Trumbore ray-triangle intersection routine
 	// (see "Fast, Minimum Storage Ray-Triangle Intersection", by T. Moeller and B. Trumbore)
-	struct vector e1 = vecSub(g_vertices[poly->vertexIndex[0]], g_vertices[poly->vertexIndex[1]]);
-	struct vector e2 = vecSub(g_vertices[poly->vertexIndex[2]], g_vertices[poly->vertexIndex[0]]);
+	struct vector e1 = vecSub(vertices[poly->vertexIndex[0]], vertices[poly->vertexIndex[1]]);
+	struct vector e2 = vecSub(vertices[poly->vertexIndex[2]], vertices[poly->vertexIndex[0]]);
 	struct vector n = vecCross(e1, e2);
 
-	struct vector c = vecSub(g_vertices[poly->vertexIndex[0]], ray->start);
+	struct vector c = vecSub(vertices[poly->vertexIndex[0]], ray->start);
 	struct vector r = vecCross(ray->direction, c);
 	float invDet = 1.0f / vecDot(n, ray->direction);
 
 	float u = vecDot(r, e2) * invDet;
 	float v = vecDot(r, e1) * invDet;
-	float w = 1.0f - u - v;
 
 	// This order of comparisons guarantees that none of u, v, or t, are NaNs:
 	// IEEE-754 mandates that they compare to false if the left hand side is a NaN.
@@ -36,18 +35,20 @@ bool rayIntersectsWithPolygon(const struct lightRay *ray, const struct poly *pol
 		if (t >= 0.0f && t < isect->distance) {
 			isect->uv = (struct coord) { u, v };
 			isect->distance = t;
-			if (likely(poly->hasNormals)) {
-				struct vector upcomp = vecScale(g_normals[poly->normalIndex[1]], u);
-				struct vector vpcomp = vecScale(g_normals[poly->normalIndex[2]], v);
-				struct vector wpcomp = vecScale(g_normals[poly->normalIndex[0]], w);
-				
-				isect->surfaceNormal = vecAdd(vecAdd(upcomp, vpcomp), wpcomp);
-			} else {
-				isect->surfaceNormal = n;
-			}
-			isect->hitPoint = alongRay(ray, t);
 			return true;
 		}
 	}
 	return false;
 }
+
+struct vector polygonNormal(const struct mesh *mesh, const struct poly *poly, struct coord uv) {
+	if (likely(poly->hasNormals)) {
+		struct vector upcomp = vecScale(meshNormal(mesh, poly, 1), uv.x);
+		struct vector vpcomp = vecScale(meshNormal(mesh, poly, 2), uv.y);
+		struct vector wpcomp = vecScale(meshNormal(mesh, poly, 0), 1.0f - uv.x - uv.y);
+		return vecAdd(vecAdd(upcomp, vpcomp), wpcomp);
+	}
+	struct vector e1 = vecSub(mesh->vertices[poly->vertexIndex[0]], mesh->vertices[poly->vertexIndex[1]]);
+	struct vector e2 = vecSub(mesh->vertices[poly->vertexIndex[2]], mesh->vertices[poly->vertexIndex[0]]);
+	return vecCross(e1, e2);
+}
@@ -8,17 +8,32 @@
 
 #pragma once
 
+// Only what traversal needs, the rest is in struct polyAttributes
 struct poly {
 	int vertexIndex[MAX_CRAY_VERTEX_COUNT];
-	int normalIndex[MAX_CRAY_VERTEX_COUNT];
-	int textureIndex[MAX_CRAY_VERTEX_COUNT];
 	unsigned int materialIndex: 16;
 	unsigned int vertexCount: 3;
-	bool hasNormals;
+	unsigned int hasNormals: 1;
+	unsigned int hasTexCoords: 1;
+};
+
+// Normal and texture coordinate indices of a polygon, -1 if it doesn't have them.
+// Kept apart from the polygons, since they're only read once the closest hit is known.
+struct polyAttributes {
+	int normalIndex[MAX_CRAY_VERTEX_COUNT];
+	int textureIndex[MAX_CRAY_VERTEX_COUNT];
 };
 
 struct lightRay;
 struct hitRecord;
+struct vector;
+struct coord;
+struct mesh;
 
 //Calculates intersection between a light ray and a polygon object. Returns true if intersection has happened.
-bool rayIntersectsWithPolygon(const struct lightRay *ray, const struct poly *poly, struct hitRecord *isect);
+//Only the distance and barycentric coordinates are stored to isect.
+//vertices is the vertex array of the mesh the polygon belongs to.
+bool rayIntersectsWithPolygon(const struct lightRay *ray, const struct poly *poly, const struct vector *vertices, struct hitRecord *isect);
+
+//Unnormalized surface normal at barycentric coordinates uv, interpolated from vertex normals if poly has them
+struct vector polygonNormal(const struct mesh *mesh, const struct poly *poly, struct coord uv);
@@ -16,10 +16,10 @@
 #include "../renderer/renderer.h"
 #include "image/texture.h"
 #include "camera.h"
-#include "vertexbuffer.h"
 #include "../accelerators/bvh.h"
 #include "tile.h"
 #include "mesh.h"
+#include "sphere.h"
 #include "poly.h"
 #include "../utils/platform/thread.h"
 #include "../utils/ui.h"
@@ -28,54 +28,17 @@
 #include "../utils/mempool.h"
 #include "../utils/hashtable.h"
 #include "../nodes/bsdfnode.h"
+#include "../nodes/compiler.h"
 #include "../utils/hashtable.h"
 #include "../utils/string.h"
 #include "../utils/args.h"
 #include "../utils/fileio.h"
 #include "../utils/base64.h"
 #include "../utils/textbuffer.h"
-
-struct bvhBuildTask {
-	struct bvh *bvh;
-	struct poly *polygons;
-	int polyCount;
-};
-
-void *bvhBuildThread(void *arg) {
-	struct bvhBuildTask *task = (struct bvhBuildTask*)threadUserData(arg);
-	task->bvh = buildBottomLevelBvh(task->polygons, task->polyCount);
-	return NULL;
-}
-
-static void computeAccels(struct mesh *meshes, int meshCount) {
-	logr(info, "Computing BVHs: ");
-	struct timeval timer = {0};
-	startTimer(&timer);
-	struct bvhBuildTask *tasks = calloc(meshCount, sizeof(*tasks));
-	struct crThread *buildThreads = calloc(meshCount, sizeof(*buildThreads));
-	for (int t = 0; t < meshCount; ++t) {
-		tasks[t] = (struct bvhBuildTask){
-			.polygons = meshes[t].polygons,
-			.polyCount = meshes[t].polyCount
-		};
-		buildThreads[t] = (struct crThread){
-			.threadFunc = bvhBuildThread,
-			.userData = &tasks[t]
-		};
-		if (threadStart(&buildThreads[t])) {
-			logr(error, "Failed to create a bvhBuildTask\n");
-		}
-	}
-	
-	for (int t = 0; t < meshCount; ++t) {
-		threadWait(&buildThreads[t]);
-		meshes[t].bvh = tasks[t].bvh;
-	}
-	printSmartTime(getMs(timer));
-	free(tasks);
-	free(buildThreads);
-	logr(plain, "\n");
-}
+#include "../utils/loaders/textureloader.h"
+#include "../utils/loaders/bakedscene.h"
+#include "image/texturecache.h"
+#include "../renderer/lights.h"
 
 struct bvh *computeTopLevelBvh(struct instance *instances, int instanceCount) {
 	logr(info, "Computing top-level BVH: ");
@@ -94,30 +57,87 @@ static void printSceneStats(struct world *scene, unsigned long long ms) {
 	for (int i = 0; i < scene->instanceCount; ++i) {
 		if (isMesh(&scene->instances[i])) polys += ((struct mesh*)scene->instances[i].object)->polyCount;
 	}
+	int vertices = 0, normals = 0, texCoords = 0;
+	size_t meshMemory = 0, uncompactMemory = 0;
+	for (int i = 0; i < scene->meshCount; ++i) {
+		size_t uncompact = 0;
+		meshMemory += meshBytes(&scene->meshes[i], &uncompact);
+		uncompactMemory += uncompact;
+		if (scene->meshes[i].sharedVertices) continue;
+		vertices += scene->meshes[i].vertexCount;
+		normals += scene->meshes[i].normalCount;
+		texCoords += scene->meshes[i].textureCoordCount;
+	}
 	logr(plain, "\n");
 	logr(info, "Totals: %iV, %iN, %iT, %iP, %iS, %iM\n",
-		   vertexCount,
-		   normalCount,
-		   textureCount,
+		   vertices,
+		   normals,
+		   texCoords,
 		   polys,
 		   scene->sphereCount,
 		   scene->meshCount);
+	char *memory = humanFileSize(meshMemory);
+	if (uncompactMemory > meshMemory) {
+		char *saved = humanFileSize(uncompactMemory - meshMemory);
+		logr(info, "Mesh data: %s, %s saved by compact attributes\n", memory, saved);
+		free(saved);
+	} else {
+		logr(info, "Mesh data: %s\n", memory);
+	}
+	free(memory);
+	const struct textureRegistryStats registry = textureRegistryStats(scene->textureRegistry);
+	if (registry.hits) {
+		char *saved = humanFileSize(registry.bytesSaved);
+		logr(info, "Textures: %zu decoded, %zu loads shared them, %s saved\n", registry.textures, registry.hits, saved);
+		free(saved);
+	}
+	const struct loadTimes *times = &scene->loadTimes;
+	char parse[64], textures[64], bvh[64], meshes[64];
+	smartTime(times->parse / 1000, parse);
+	smartTime(times->textures / 1000, textures);
+	smartTime(times->bvh / 1000, bvh);
+	smartTime(times->meshes / 1000, meshes);
+	logr(info, "Time spent parsing: %s, loading textures: %s, building BVHs: %s. Mesh files and textures took %s\n", parse, textures, bvh, meshes);
+}
+
+// Lower every node graph into compiled programs, now that all materials are known
+static void compileMaterials(struct world *scene) {
+	for (int i = 0; i < scene->meshCount; ++i) {
+		struct mesh *mesh = &scene->meshes[i];
+		if (mesh->sharedMaterials) continue;
+		for (int j = 0; j < mesh->materialCount; ++j) {
+			mesh->materials[j].bsdf = compileBsdf(scene, mesh->materials[j].bsdf);
+		}
+	}
+	for (int i = 0; i < scene->sphereCount; ++i) {
+		scene->spheres[i].material.bsdf = compileBsdf(scene, scene->spheres[i].material.bsdf);
+	}
+	scene->background = compileBsdf(scene, scene->background);
 }
 
 #include "../utils/filecache.h"
 //Split scene loading and prefs?
 //Load the scene, allocate buffers, etc
 //FIXME: Rename this func and take parseJSON out to a separate call.
-int loadScene(struct renderer *r, char *input) {
+static int buildScene(struct renderer *r, char *input, struct bakedScene *baked) {
 	
 	struct timeval timer = {0};
 	startTimer(&timer);
+	struct timeval phaseTimer = {0};
+	startTimer(&phaseTimer);
+	long textureTimeBefore = textureLoadTime();
 	
 	r->scene = calloc(1, sizeof(*r->scene));
 	
 	r->scene->nodePool = newBlock(NULL, 1024);
 	r->scene->nodeTable = newHashtable(compareNodes, &r->scene->nodePool);
 	
+	if (baked) {
+		r->scene->baked = baked;
+	} else if (isSet("bake")) {
+		r->scene->bakeLog = newBakeLog(input);
+	}
+	
 	//Load configuration and assets
 	switch (parseJSON(r, input)) {
 		case -1:
@@ -132,6 +152,15 @@ int loadScene(struct renderer *r, char *input) {
 		default:
 			break;
 	}
+	compileMaterials(r->scene);
+	r->scene->loadTimes.textures = textureLoadTime() - textureTimeBefore;
+	// Mesh files were timed on each thread that loaded them, textures included
+	r->scene->loadTimes.parse += getUs(phaseTimer) - r->scene->loadTimes.meshes - r->scene->loadTimes.textures;
+	
+	if (isSet("use_clustering") && baked) {
+		logr(warning, "Baked scenes can't be sent to workers, render the scene they were baked from instead.\n");
+		return -1;
+	}
 	
 	if (isSet("use_clustering")) {
 		// Stash a cache of scene data here
@@ -177,11 +206,13 @@ int loadScene(struct renderer *r, char *input) {
 		r->sceneCache = cJSON_PrintUnformatted(cache);
 	}
 	
-	// Do some pre-render preparations
-	// Compute BVH acceleration structures for all objects in the scene
-	computeAccels(r->scene->meshes, r->scene->meshCount);
-	// And then compute a single top-level BVH that contains all the objects
+	// Meshes got their BVHs as they loaded, so all that's left is a single top-level BVH that contains all the objects
+	startTimer(&phaseTimer);
 	r->scene->topLevel = computeTopLevelBvh(r->scene->instances, r->scene->instanceCount);
+	r->scene->loadTimes.bvh += getUs(phaseTimer);
+	r->scene->lights = newLightList(r->scene);
+	logr(debug, "Found %zu light%s\n", lightCount(r->scene->lights), lightCount(r->scene->lights) == 1 ? "" : "s");
+	r->scene->loadTimes.total = getUs(timer);
 	printSceneStats(r->scene, getMs(timer));
 	
 	//Quantize image into renderTiles
@@ -212,16 +243,36 @@ int loadScene(struct renderer *r, char *input) {
 	return 0;
 }
 
+int loadScene(struct renderer *r, char *input) {
+	return buildScene(r, input, NULL);
+}
+
+int loadBakedScene(struct renderer *r, const char *path) {
+	struct bakedScene *baked = openBakedScene(path, r->prefs.assetPath);
+	if (!baked) return -1;
+	char *input = stringCopy(bakedSceneJSON(baked));
+	const int result = buildScene(r, input, baked);
+	free(input);
+	return result;
+}
+
 //Free scene data
 void destroyScene(struct world *scene) {
 	if (scene) {
 		destroyCamera(scene->camera);
 		for (int i = 0; i < scene->meshCount; ++i) {
-			destroyMesh(&scene->meshes[i]);
+			// Baked meshes point into the file, and are released along with it
+			if (!scene->baked) destroyMesh(&scene->meshes[i]);
 		}
+		closeBakedScene(scene->baked);
+		destroyBakeLog(scene->bakeLog);
 		destroyBvh(scene->topLevel);
+		destroyLightList(scene->lights);
 		destroyHashtable(scene->nodeTable);
 		destroyBlocks(scene->nodePool);
+		// Materials check whether their textures are shared, so this goes after the meshes
+		destroyTextureRegistry(scene->textureRegistry);
+		destroyTextureCache(scene->textureCache);
 		free(scene->instances);
 		free(scene->meshes);
 		free(scene->spheres);
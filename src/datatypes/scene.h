@@ -10,6 +10,22 @@
 
 struct renderer;
 struct hashtable;
+struct lightList;
+struct textureCache;
+struct textureRegistry;
+struct bakedScene;
+struct bakeLog;
+
+// Scene load phase durations, in microseconds
+// Mesh files load on several threads, and the time each phase takes on them is added up,
+// so the phases can add up to more than the total.
+struct loadTimes {
+	long parse; // JSON and mesh parsing, excluding textures
+	long textures;
+	long bvh; // Bottom-level and top-level BVH builds
+	long meshes; // Loading mesh files, building their BVHs and decoding scene textures, start to finish
+	long total;
+};
 
 struct world {
 	//Optional environment map / ambient color
@@ -28,6 +44,9 @@ struct world {
 	struct sphere *spheres;
 	int sphereCount;
 	
+	// Emitters for direct light sampling. NULL if nothing emits.
+	struct lightList *lights;
+	
 	//Currently only one camera supported
 	struct camera *camera;
 	int cameraCount;
@@ -36,8 +55,23 @@ struct world {
 	struct block *nodePool;
 	// Used for hash consing. (preventing duplicate nodes)
 	struct hashtable *nodeTable;
+	
+	// Pages in tiled textures on demand, NULL if textures are loaded whole
+	struct textureCache *textureCache;
+	// Owns the textures materials load from files, so each one is decoded once
+	struct textureRegistry *textureRegistry;
+	
+	// Set if the scene was loaded from a baked scene file, which its meshes point into
+	struct bakedScene *baked;
+	// Set if the scene is going to be baked, see bakedscene.h
+	struct bakeLog *bakeLog;
+	
+	struct loadTimes loadTimes;
 };
 
 int loadScene(struct renderer *r, char *input);
 
+/// Load a scene from a file written by bakeScene()
+int loadBakedScene(struct renderer *r, const char *path);
+
 void destroyScene(struct world *scene);
@@ -51,9 +51,6 @@ bool intersect(const struct lightRay *ray, const struct sphere *sphere, float *t
 
 bool rayIntersectsWithSphere(const struct lightRay *ray, const struct sphere *sphere, struct hitRecord *isect) {
 	if (intersect(ray, sphere, &isect->distance)) {
-		//Compute normal and store it to isect
-		isect->hitPoint = alongRay(ray, isect->distance);
-		isect->surfaceNormal = vecNormalize(isect->hitPoint);
 		isect->polygon = NULL;
 		return true;
 	}
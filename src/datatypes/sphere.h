@@ -20,5 +20,5 @@ struct sphere {
 
 struct sphere defaultSphere(void);
 
-//Calculates intersection between a light ray and a sphere
+//Calculates intersection between a light ray and a sphere. Only the distance is stored to isect.
 bool rayIntersectsWithSphere(const struct lightRay *ray, const struct sphere *sphere, struct hitRecord *isect);
@@ -49,7 +49,7 @@ struct renderTile nextTileInteractive(struct renderer *r) {
 	memset(&tile, 0, sizeof(tile));
 	tile.tileNum = -1;
 	lockMutex(r->state.tileMutex);
-	if (r->state.finishedPasses < r->prefs.sampleCount) {
+	if (r->state.finishedPasses <= r->prefs.sampleCount) {
 		if (r->state.finishedTileCount < r->state.tileCount) {
 			tile = r->state.renderTiles[r->state.finishedTileCount];
 			r->state.renderTiles[r->state.finishedTileCount].isRendering = true;
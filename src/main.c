@@ -8,26 +8,61 @@
 
 #include <stdlib.h>
 #include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
 
 #include "c-ray.h"
 
+// Options aren't parsed yet when the banner is printed, and --tcount and --test print and exit while parsing them
+static bool benchmarkRequested(int argc, char *argv[]) {
+	for (int i = 1; i < argc; ++i) {
+		if (strcmp(argv[i], "--benchmark") == 0) return true;
+	}
+	return false;
+}
+
 int main(int argc, char *argv[]) {
-	crLog("C-ray v%s%s [%.8s], © 2015-2021 Valtteri Koskivuori\n", crGetVersion(), isDebug() ? "D" : "", crGitHash());
+	if (benchmarkRequested(argc, argv)) {
+		// Benchmark mode reserves stdout for the JSON report
+		fprintf(stderr, "C-ray v%s%s [%.8s], © 2015-2021 Valtteri Koskivuori\n", crGetVersion(), isDebug() ? "D" : "", crGitHash());
+	} else {
+		crLog("C-ray v%s%s [%.8s], © 2015-2021 Valtteri Koskivuori\n", crGetVersion(), isDebug() ? "D" : "", crGitHash());
+	}
 	crInitialize();
 	crParseArgs(argc, argv);
+	if (crOptionIsSet("benchmark")) {
+		int ret = crRunBenchmark();
+		crDestroyOptions();
+		return ret;
+	}
 	crInitRenderer();
 	if (!crOptionIsSet("is_worker")) {
-		size_t bytes = 0;
-		char *input = crOptionIsSet("inputFile") ? crReadFile(&bytes) : crReadStdin(&bytes);
-		if (!input) {
-			crLog("No input provided, exiting.\n");
+		if (crOptionIsSet("inputFile") && crIsBakedScene(crPathArg())) {
+			if (crLoadBakedScene(crPathArg())) {
+				crDestroyRenderer();
+				crDestroyOptions();
+				return -1;
+			}
+		} else {
+			size_t bytes = 0;
+			char *input = crOptionIsSet("inputFile") ? crReadFile(&bytes) : crReadStdin(&bytes);
+			if (!input) {
+				crLog("No input provided, exiting.\n");
+				crDestroyRenderer();
+				crDestroyOptions();
+				return -1;
+			}
+			crLog("%zi bytes of input JSON loaded from %s, parsing.\n", bytes, crOptionIsSet("inputFile") ? "file" : "stdin");
+			crLoadSceneFromBuf(input);
+			free(input);
+		}
+		
+		if (crOptionIsSet("bake")) {
+			int ret = crBakeScene();
 			crDestroyRenderer();
 			crDestroyOptions();
-			return -1;
+			return ret;
 		}
-		crLog("%zi bytes of input JSON loaded from %s, parsing.\n", bytes, crOptionIsSet("inputFile") ? "file" : "stdin");
-		crLoadSceneFromBuf(input);
-		free(input);
 		
 		crStartRenderer();
 		crWriteImage();
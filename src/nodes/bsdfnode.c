@@ -19,3 +19,17 @@ const struct bsdfNode *warningBsdf(const struct world *world) {
 				  newDiffuse(world, newConstantTexture(world, (struct color){0.2f, 0.2f, 0.2f, 1.0f})),
 				  newGrayscaleConverter(world, newCheckerBoardTexture(world, NULL, NULL, newConstantValue(world, 500.0f))));
 }
+
+struct color evalNone(const struct bsdfNode *bsdf, const struct hitRecord *record, const struct vector out) {
+	(void)bsdf;
+	(void)record;
+	(void)out;
+	return blackColor;
+}
+
+float pdfNone(const struct bsdfNode *bsdf, const struct hitRecord *record, const struct vector out) {
+	(void)bsdf;
+	(void)record;
+	(void)out;
+	return 0.0f;
+}
@@ -18,16 +18,26 @@
 
 struct bsdfSample {
 	struct vector out;
-	float pdf;
-	struct color color;
+	float pdf; // Solid angle pdf of out, or 0 if it came from a lobe eval() can't represent (specular, fuzzed)
+	struct color color; // Path weight, bsdf * cos / pdf
 };
 
-//TODO: Expand and refactor to match a standard bsdf signature with eval, sample and pdf
 struct bsdfNode {
 	struct nodeBase base;
 	struct bsdfSample (*sample)(const struct bsdfNode *bsdf, sampler *sampler, const struct hitRecord *record);
+	// bsdf * cos for a given outgoing direction. Only covers the lobes that sample() reports a pdf for.
+	struct color (*eval)(const struct bsdfNode *bsdf, const struct hitRecord *record, const struct vector out);
+	float (*pdf)(const struct bsdfNode *bsdf, const struct hitRecord *record, const struct vector out);
+	// Radiance emitted towards the incident ray. NULL if this graph never emits.
+	struct color (*emission)(const struct bsdfNode *bsdf, const struct hitRecord *record);
+	// Rebuild this bsdf with compiled inputs, see compileBsdf()
+	const struct bsdfNode *(*compile)(const struct bsdfNode *bsdf, struct world *world);
 };
 
+static inline struct color bsdfEmission(const struct bsdfNode *bsdf, const struct hitRecord *record) {
+	return bsdf->emission ? bsdf->emission(bsdf, record) : blackColor;
+}
+
 #include "shaders/diffuse.h"
 #include "shaders/glass.h"
 #include "shaders/metal.h"
@@ -39,3 +49,7 @@ struct bsdfNode {
 #include "shaders/emission.h"
 
 const struct bsdfNode *warningBsdf(const struct world *world);
+
+// For lobes sample() handles on its own, like perfect or fuzzed reflections
+struct color evalNone(const struct bsdfNode *bsdf, const struct hitRecord *record, const struct vector out);
+float pdfNone(const struct bsdfNode *bsdf, const struct hitRecord *record, const struct vector out);
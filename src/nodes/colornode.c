@@ -12,7 +12,6 @@
 #include "../datatypes/vector.h"
 #include "../datatypes/material.h"
 #include "../datatypes/image/texture.h"
-#include "../datatypes/vertexbuffer.h"
 #include "../datatypes/poly.h"
 #include "bsdfnode.h"
 
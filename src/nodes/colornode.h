@@ -19,6 +19,8 @@ enum textureType {
 struct colorNode {
 	struct nodeBase base;
 	struct color (*eval)(const struct colorNode *node, const struct hitRecord *record);
+	// Emit instructions computing this node, returning the result register. NULL if it can only be called through eval().
+	uint8_t (*compile)(const struct colorNode *node, struct nodeCompiler *compiler);
 };
 
 #include "textures/checker.h"
@@ -0,0 +1,384 @@
+//
+//  compiler.c
+//  C-Ray
+//
+//  Created by Valtteri Koskivuori on 18/10/2026.
+//  Copyright © 2026 Valtteri Koskivuori. All rights reserved.
+//
+
+#include "../includes.h"
+#include "../datatypes/color.h"
+#include "../datatypes/vector.h"
+#include "../datatypes/hitrecord.h"
+#include "../datatypes/scene.h"
+#include "../utils/hashtable.h"
+#include "../utils/mempool.h"
+#include "bsdfnode.h"
+
+#include "compiler.h"
+
+// Plenty for anything the scene format can describe. Larger graphs are left as they are.
+#define MAX_PROGRAM_REGISTERS 32
+
+struct nodeProgram {
+	const struct nodeOp *ops;
+	const union nodeRegister *constants; // Preloaded into the first constantCount registers
+	uint8_t opCount;
+	uint8_t constantCount;
+	uint8_t output;
+};
+
+struct nodeCompiler {
+	struct nodeOp ops[MAX_PROGRAM_REGISTERS];
+	union nodeRegister values[MAX_PROGRAM_REGISTERS]; // Only valid for constant registers
+	bool constant[MAX_PROGRAM_REGISTERS];
+	const void *emitted[MAX_PROGRAM_REGISTERS]; // Nodes emitted so far, and where their results are
+	uint8_t emittedRegister[MAX_PROGRAM_REGISTERS];
+	unsigned emittedCount;
+	unsigned opCount;
+	unsigned registerCount;
+	bool failed;
+};
+
+static const uint8_t opInputs[] = {
+	[OpCallValue] = 0,
+	[OpCallColor] = 0,
+	[OpCallVector] = 0,
+	[OpMath] = 2,
+	[OpVecMath] = 2,
+	[OpGrayscale] = 1,
+	[OpAlpha] = 1,
+	[OpCombine] = 1,
+	[OpCombineRGB] = 3,
+	[OpVecToColor] = 1,
+	[OpBlackbody] = 1,
+	[OpImage] = 0,
+	[OpChecker] = 3,
+	[OpNormal] = 0,
+	[OpRayLength] = 0,
+	[OpFresnel] = 1,
+};
+
+// These can't be folded, even with constant inputs
+static const bool opReadsRecord[] = {
+	[OpCallValue] = true,
+	[OpCallColor] = true,
+	[OpCallVector] = true,
+	[OpImage] = true,
+	[OpChecker] = true,
+	[OpNormal] = true,
+	[OpRayLength] = true,
+	[OpFresnel] = true,
+};
+
+static inline uint8_t *opInput(struct nodeOp *op, unsigned i) {
+	return i == 0 ? &op->a : i == 1 ? &op->b : &op->c;
+}
+
+// Results are stored straight into the fields of the destination register that hold them.
+// Copying whole registers around would reload them with wide loads over narrower stores, which stalls.
+static inline void execute(const struct nodeOp *op, union nodeRegister *r, const struct hitRecord *record) {
+	union nodeRegister *dst = &r[op->dst];
+	switch ((enum nodeOpcode)op->code) {
+		case OpCallValue: {
+			const struct valueNode *node = op->data;
+			dst->f = node->eval(node, record);
+			return;
+		}
+		case OpCallColor: {
+			const struct colorNode *node = op->data;
+			dst->c = node->eval(node, record);
+			return;
+		}
+		case OpCallVector: {
+			const struct vectorNode *node = op->data;
+			const struct vectorValue value = node->eval(node, record);
+			dst->v.v = value.v;
+			dst->v.f = value.f;
+			return;
+		}
+		case OpMath:
+			dst->f = evalMathOp(op->aux, r[op->a].f, r[op->b].f);
+			return;
+		case OpVecMath: {
+			const struct vectorValue value = evalVecMathOp(op->aux, r[op->a].v.v, r[op->b].v.v);
+			dst->v.v = value.v;
+			dst->v.f = value.f;
+			return;
+		}
+		case OpGrayscale:
+			dst->f = grayscale(r[op->a].c).red;
+			return;
+		case OpAlpha:
+			dst->f = r[op->a].c.alpha;
+			return;
+		case OpCombine:
+			dst->c = (struct color){ r[op->a].f, r[op->a].f, r[op->a].f, 1.0f };
+			return;
+		case OpCombineRGB:
+			dst->c = (struct color){ r[op->a].f, r[op->b].f, r[op->c].f, 1.0f };
+			return;
+		case OpVecToColor:
+			dst->c = (struct color){ r[op->a].v.v.x, r[op->a].v.v.y, r[op->a].v.v.z, 0.0f };
+			return;
+		case OpBlackbody:
+			dst->c = colorForKelvin(r[op->a].f);
+			return;
+		case OpImage:
+			dst->c = internalColor(op->data, record, op->aux);
+			return;
+		case OpChecker:
+			// Only colors flow into the checkerboard, so that's all that needs copying
+			dst->c = checkerPattern(record, r[op->a].f) ? r[op->b].c : r[op->c].c;
+			return;
+		case OpNormal:
+			dst->v.v = record->surfaceNormal;
+			return;
+		case OpRayLength:
+			dst->f = record->distance;
+			return;
+		case OpFresnel:
+			dst->f = fresnelFactor(record, r[op->a].f);
+			return;
+	}
+	ASSERT_NOT_REACHED();
+}
+
+// Registers below constantCount are preloaded with the program constants
+static void run(const struct nodeProgram *program, union nodeRegister *r, const struct hitRecord *record) {
+	for (unsigned i = 0; i < program->constantCount; ++i) r[i] = program->constants[i];
+	for (unsigned i = 0; i < program->opCount; ++i) {
+		execute(&program->ops[i], r, record);
+	}
+}
+
+static uint8_t newRegister(struct nodeCompiler *compiler) {
+	if (compiler->registerCount == MAX_PROGRAM_REGISTERS) {
+		compiler->failed = true;
+		return 0;
+	}
+	compiler->constant[compiler->registerCount] = false;
+	return compiler->registerCount++;
+}
+
+uint8_t emitConstant(struct nodeCompiler *compiler, union nodeRegister value) {
+	const uint8_t reg = newRegister(compiler);
+	if (compiler->failed) return 0;
+	compiler->constant[reg] = true;
+	compiler->values[reg] = value;
+	return reg;
+}
+
+bool isConstantRegister(const struct nodeCompiler *compiler, uint8_t reg) {
+	return !compiler->failed && compiler->constant[reg];
+}
+
+uint8_t emitOp(struct nodeCompiler *compiler, struct nodeOp op) {
+	if (compiler->failed) return 0;
+	bool fold = !opReadsRecord[op.code];
+	for (unsigned i = 0; i < opInputs[op.code]; ++i) {
+		fold = fold && compiler->constant[*opInput(&op, i)];
+	}
+	op.dst = newRegister(compiler);
+	if (compiler->failed) return 0;
+	if (fold) {
+		run(&(struct nodeProgram){ .ops = &op, .opCount = 1 }, compiler->values, NULL);
+		compiler->constant[op.dst] = true;
+		return op.dst;
+	}
+	compiler->ops[compiler->opCount++] = op;
+	return op.dst;
+}
+
+static bool findEmitted(const struct nodeCompiler *compiler, const void *node, uint8_t *reg) {
+	// Nodes are hash consed, so identical subgraphs are the same pointer
+	for (unsigned i = 0; i < compiler->emittedCount; ++i) {
+		if (compiler->emitted[i] == node) {
+			*reg = compiler->emittedRegister[i];
+			return true;
+		}
+	}
+	return false;
+}
+
+static uint8_t addEmitted(struct nodeCompiler *compiler, const void *node, uint8_t reg) {
+	if (compiler->emittedCount < MAX_PROGRAM_REGISTERS) {
+		compiler->emitted[compiler->emittedCount] = node;
+		compiler->emittedRegister[compiler->emittedCount++] = reg;
+	}
+	return reg;
+}
+
+uint8_t emitValue(struct nodeCompiler *compiler, const struct valueNode *node) {
+	uint8_t reg = 0;
+	if (!node) compiler->failed = true;
+	if (compiler->failed) return 0;
+	if (findEmitted(compiler, node, &reg)) return reg;
+	reg = node->compile ? node->compile(node, compiler) : emitOp(compiler, (struct nodeOp){ .code = OpCallValue, .data = node });
+	return addEmitted(compiler, node, reg);
+}
+
+uint8_t emitColor(struct nodeCompiler *compiler, const struct colorNode *node) {
+	uint8_t reg = 0;
+	if (!node) compiler->failed = true;
+	if (compiler->failed) return 0;
+	if (findEmitted(compiler, node, &reg)) return reg;
+	reg = node->compile ? node->compile(node, compiler) : emitOp(compiler, (struct nodeOp){ .code = OpCallColor, .data = node });
+	return addEmitted(compiler, node, reg);
+}
+
+uint8_t emitVector(struct nodeCompiler *compiler, const struct vectorNode *node) {
+	uint8_t reg = 0;
+	if (!node) compiler->failed = true;
+	if (compiler->failed) return 0;
+	if (findEmitted(compiler, node, &reg)) return reg;
+	reg = node->compile ? node->compile(node, compiler) : emitOp(compiler, (struct nodeOp){ .code = OpCallVector, .data = node });
+	return addEmitted(compiler, node, reg);
+}
+
+// Drops instructions the output doesn't depend on, and packs the constants the rest need into the first registers.
+// Returns false if that leaves nothing worth running as a program.
+static bool linkProgram(struct nodeCompiler *compiler, uint8_t output, struct block **pool, struct nodeProgram *program) {
+	bool live[MAX_PROGRAM_REGISTERS] = { false };
+	live[output] = true;
+	unsigned liveOps = 0;
+	for (int i = (int)compiler->opCount - 1; i >= 0; --i) {
+		struct nodeOp *op = &compiler->ops[i];
+		if (!live[op->dst]) continue;
+		liveOps++;
+		for (unsigned j = 0; j < opInputs[op->code]; ++j) live[*opInput(op, j)] = true;
+	}
+	// A single instruction is no better than calling the node directly
+	if (liveOps < 2) return false;
+
+	uint8_t remap[MAX_PROGRAM_REGISTERS];
+	union nodeRegister *constants = NULL;
+	unsigned constantCount = 0;
+	for (unsigned reg = 0; reg < compiler->registerCount; ++reg) {
+		if (live[reg] && compiler->constant[reg]) constantCount++;
+	}
+	if (constantCount) constants = allocBlock(pool, constantCount * sizeof(*constants));
+	unsigned next = 0;
+	for (unsigned reg = 0; reg < compiler->registerCount; ++reg) {
+		if (!live[reg] || !compiler->constant[reg]) continue;
+		constants[next] = compiler->values[reg];
+		remap[reg] = next++;
+	}
+
+	struct nodeOp *ops = allocBlock(pool, liveOps * sizeof(*ops));
+	unsigned opCount = 0;
+	for (unsigned i = 0; i < compiler->opCount; ++i) {
+		struct nodeOp op = compiler->ops[i];
+		if (!live[op.dst]) continue;
+		for (unsigned j = 0; j < opInputs[op.code]; ++j) *opInput(&op, j) = remap[*opInput(&op, j)];
+		remap[op.dst] = next++;
+		op.dst = remap[op.dst];
+		ops[opCount++] = op;
+	}
+
+	*program = (struct nodeProgram){
+		.ops = ops,
+		.constants = constants,
+		.opCount = opCount,
+		.constantCount = constantCount,
+		.output = remap[output]
+	};
+	return true;
+}
+
+struct valueProgram {
+	struct valueNode node;
+	const struct valueNode *root;
+	struct nodeProgram program;
+};
+
+struct colorProgram {
+	struct colorNode node;
+	const struct colorNode *root;
+	struct nodeProgram program;
+};
+
+// Both program types are keyed on the graph they were compiled from
+static bool compareValueProgram(const void *A, const void *B) {
+	return ((const struct valueProgram *)A)->root == ((const struct valueProgram *)B)->root;
+}
+
+static bool compareColorProgram(const void *A, const void *B) {
+	return ((const struct colorProgram *)A)->root == ((const struct colorProgram *)B)->root;
+}
+
+static uint32_t hashValueProgram(const void *p) {
+	const struct valueProgram *this = p;
+	uint32_t h = hashInit();
+	h = hashBytes(h, &this->root, sizeof(this->root));
+	return h;
+}
+
+static uint32_t hashColorProgram(const void *p) {
+	const struct colorProgram *this = p;
+	uint32_t h = hashInit();
+	h = hashBytes(h, &this->root, sizeof(this->root));
+	return h;
+}
+
+static float evalValueProgram(const struct valueNode *node, const struct hitRecord *record) {
+	const struct nodeProgram *program = &((const struct valueProgram *)node)->program;
+	union nodeRegister r[MAX_PROGRAM_REGISTERS];
+	run(program, r, record);
+	return r[program->output].f;
+}
+
+static struct color evalColorProgram(const struct colorNode *node, const struct hitRecord *record) {
+	const struct nodeProgram *program = &((const struct colorProgram *)node)->program;
+	union nodeRegister r[MAX_PROGRAM_REGISTERS];
+	run(program, r, record);
+	return r[program->output].c;
+}
+
+static const struct valueNode *newValueProgram(const struct world *world, const struct valueNode *root, struct nodeProgram program) {
+	HASH_CONS(world->nodeTable, hashValueProgram, struct valueProgram, {
+		.root = root,
+		.program = program,
+		.node = {
+			.eval = evalValueProgram,
+			.base = { .compare = compareValueProgram }
+		}
+	});
+}
+
+static const struct colorNode *newColorProgram(const struct world *world, const struct colorNode *root, struct nodeProgram program) {
+	HASH_CONS(world->nodeTable, hashColorProgram, struct colorProgram, {
+		.root = root,
+		.program = program,
+		.node = {
+			.eval = evalColorProgram,
+			.base = { .compare = compareColorProgram }
+		}
+	});
+}
+
+const struct valueNode *compileValue(struct world *world, const struct valueNode *node) {
+	if (!node || node->eval == evalValueProgram) return node;
+	struct nodeCompiler compiler = { 0 };
+	const uint8_t output = emitValue(&compiler, node);
+	if (compiler.failed) return node;
+	if (compiler.constant[output]) return newConstantValue(world, compiler.values[output].f);
+	struct nodeProgram program;
+	if (!linkProgram(&compiler, output, &world->nodePool, &program)) return node;
+	return newValueProgram(world, node, program);
+}
+
+const struct colorNode *compileColor(struct world *world, const struct colorNode *node) {
+	if (!node || node->eval == evalColorProgram) return node;
+	struct nodeCompiler compiler = { 0 };
+	const uint8_t output = emitColor(&compiler, node);
+	if (compiler.failed) return node;
+	if (compiler.constant[output]) return newConstantTexture(world, compiler.values[output].c);
+	struct nodeProgram program;
+	if (!linkProgram(&compiler, output, &world->nodePool, &program)) return node;
+	return newColorProgram(world, node, program);
+}
+
+const struct bsdfNode *compileBsdf(struct world *world, const struct bsdfNode *bsdf) {
+	return bsdf && bsdf->compile ? bsdf->compile(bsdf, world) : bsdf;
+}
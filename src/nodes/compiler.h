@@ -0,0 +1,85 @@
+//
+//  compiler.h
+//  C-Ray
+//
+//  Created by Valtteri Koskivuori on 18/10/2026.
+//  Copyright © 2026 Valtteri Koskivuori. All rights reserved.
+//
+
+#pragma once
+
+#include "../datatypes/color.h"
+#include "vectornode.h"
+
+struct world;
+struct bsdfNode;
+struct colorNode;
+struct valueNode;
+struct hitRecord;
+
+// Input graphs (colors, values and vectors) are lowered into a flat list of instructions
+// operating on a small register file, so evaluating them is a single loop instead of
+// a chain of eval() calls through node structs scattered around the node pool.
+
+union nodeRegister {
+	float f;
+	struct color c;
+	struct vectorValue v;
+};
+
+enum nodeOpcode {
+	OpCallValue, // dst.f = node->eval(), for nodes that don't lower themselves
+	OpCallColor, // dst.c = node->eval()
+	OpCallVector, // dst.v = node->eval()
+	OpMath, // dst.f = aux(a.f, b.f)
+	OpVecMath, // dst.v = aux(a.v, b.v)
+	OpGrayscale, // dst.f = grayscale(a.c)
+	OpAlpha, // dst.f = a.c.alpha
+	OpCombine, // dst.c = (a.f, a.f, a.f, 1)
+	OpCombineRGB, // dst.c = (a.f, b.f, c.f, 1)
+	OpVecToColor, // dst.c = (a.v, 0)
+	OpBlackbody, // dst.c = colorForKelvin(a.f)
+	OpImage, // dst.c = texture at uv, data = texture, aux = options
+	OpChecker, // dst.c = checker pattern scaled by a.f picks b.c or c.c, both constant
+	OpNormal, // dst.v = surface normal
+	OpRayLength, // dst.f = hit distance
+	OpFresnel, // dst.f = schlick, with IOR a.f
+};
+
+struct nodeOp {
+	uint8_t code;
+	uint8_t aux;
+	uint8_t dst;
+	uint8_t a, b, c;
+	const void *data;
+};
+
+// Program being built, passed to the compile() callback of each node
+struct nodeCompiler;
+
+/// Emit the instructions for an input node. Nodes shared within a graph are only emitted once.
+/// Nodes without a compile() callback are called through eval() from the program.
+/// @return Register holding the result of node
+uint8_t emitValue(struct nodeCompiler *compiler, const struct valueNode *node);
+uint8_t emitColor(struct nodeCompiler *compiler, const struct colorNode *node);
+uint8_t emitVector(struct nodeCompiler *compiler, const struct vectorNode *node);
+
+/// Append an instruction to the program. If it only depends on constants, it's evaluated now and becomes a constant.
+/// @param op Instruction, its dst is assigned here
+/// @return Register holding the result of op
+uint8_t emitOp(struct nodeCompiler *compiler, struct nodeOp op);
+
+/// @return Register holding value
+uint8_t emitConstant(struct nodeCompiler *compiler, union nodeRegister value);
+
+/// @return true if reg holds a value known at compile time
+bool isConstantRegister(const struct nodeCompiler *compiler, uint8_t reg);
+
+/// Lower an input graph into a program node. Constant graphs are folded into newConstantValue()/newConstantTexture().
+/// @return Equivalent node, or node itself if there was nothing to gain
+const struct colorNode *compileColor(struct world *world, const struct colorNode *node);
+const struct valueNode *compileValue(struct world *world, const struct valueNode *node);
+
+/// Rebuild a material with all of its inputs compiled, pruning mixes that always pick the same side
+/// @return Equivalent bsdf, or bsdf itself if it has no compile() callback
+const struct bsdfNode *compileBsdf(struct world *world, const struct bsdfNode *bsdf);
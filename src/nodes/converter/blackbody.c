@@ -15,6 +15,8 @@
 #include "../colornode.h"
 #include "../valuenode.h"
 
+#include "../compiler.h"
+
 #include "blackbody.h"
 
 struct blackbodyNode {
@@ -41,11 +43,17 @@ static struct color eval(const struct colorNode *node, const struct hitRecord *r
 	return colorForKelvin(this->temperature->eval(this->temperature, record));
 }
 
+static uint8_t compile(const struct colorNode *node, struct nodeCompiler *compiler) {
+	struct blackbodyNode *this = (struct blackbodyNode *)node;
+	return emitOp(compiler, (struct nodeOp){ .code = OpBlackbody, .a = emitValue(compiler, this->temperature) });
+}
+
 const struct colorNode *newBlackbody(const struct world *world, const struct valueNode *temperature) {
 	HASH_CONS(world->nodeTable, hash, struct blackbodyNode, {
 		.temperature = temperature ? temperature : newConstantValue(world, 4000.0f),
 		.node = {
 			.eval = eval,
+			.compile = compile,
 			.base = { .compare = compare }
 		}
 	});
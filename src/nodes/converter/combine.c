@@ -15,6 +15,8 @@
 #include "../../datatypes/scene.h"
 #include "../valuenode.h"
 
+#include "../compiler.h"
+
 #include "combine.h"
 
 struct combineValue {
@@ -42,11 +44,17 @@ static struct color eval(const struct colorNode *node, const struct hitRecord *r
 	return (struct color){val, val, val, 1.0f};
 }
 
+static uint8_t compile(const struct colorNode *node, struct nodeCompiler *compiler) {
+	const struct combineValue *this = (struct combineValue *)node;
+	return emitOp(compiler, (struct nodeOp){ .code = OpCombine, .a = emitValue(compiler, this->original) });
+}
+
 const struct colorNode *newCombineValue(const struct world *world, const struct valueNode *node) {
 	HASH_CONS(world->nodeTable, hash, struct combineValue, {
 		.original = node ? node : newConstantValue(world, 0.0f),
 		.node = {
 			.eval = eval,
+			.compile = compile,
 			.base = { .compare = compare }
 		}
 	});
@@ -15,6 +15,8 @@
 #include "../../datatypes/scene.h"
 #include "../valuenode.h"
 
+#include "../compiler.h"
+
 #include "combinergb.h"
 
 struct combineRGB {
@@ -50,6 +52,16 @@ static struct color eval(const struct colorNode *node, const struct hitRecord *r
 	};
 }
 
+static uint8_t compile(const struct colorNode *node, struct nodeCompiler *compiler) {
+	const struct combineRGB *this = (struct combineRGB *)node;
+	return emitOp(compiler, (struct nodeOp){
+		.code = OpCombineRGB,
+		.a = emitValue(compiler, this->R),
+		.b = emitValue(compiler, this->G),
+		.c = emitValue(compiler, this->B)
+	});
+}
+
 const struct colorNode *newCombineRGB(const struct world *world, const struct valueNode *R, const struct valueNode *G, const struct valueNode *B) {
 	HASH_CONS(world->nodeTable, hash, struct combineRGB, {
 		.R = R ? R : newConstantValue(world, 0.0f),
@@ -57,6 +69,7 @@ const struct colorNode *newCombineRGB(const struct world *world, const struct va
 		.B = B ? B : newConstantValue(world, 0.0f),
 		.node = {
 			.eval = eval,
+			.compile = compile,
 			.base = { .compare = compare }
 		}
 	});
@@ -17,6 +17,8 @@
 #include "../valuenode.h"
 #include "../colornode.h"
 
+#include "../compiler.h"
+
 #include "grayscale.h"
 
 struct grayscale {
@@ -42,11 +44,17 @@ static float eval(const struct valueNode *node, const struct hitRecord *record)
 	return grayscale(this->original->eval(this->original, record)).red;
 }
 
+static uint8_t compile(const struct valueNode *node, struct nodeCompiler *compiler) {
+	const struct grayscale *this = (struct grayscale *)node;
+	return emitOp(compiler, (struct nodeOp){ .code = OpGrayscale, .a = emitColor(compiler, this->original) });
+}
+
 const struct valueNode *newGrayscaleConverter(const struct world *world, const struct colorNode *node) {
 	HASH_CONS(world->nodeTable, hash, struct grayscale, {
 		.original = node ? node : newConstantTexture(world, blackColor),
 		.node = {
 			.eval = eval,
+			.compile = compile,
 			.base = { .compare = compare }
 		}
 	});
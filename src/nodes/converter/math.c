@@ -15,6 +15,8 @@
 #include "../vectornode.h"
 #include "../../datatypes/transforms.h"
 
+#include "../compiler.h"
+
 #include "math.h"
 
 struct mathNode {
@@ -39,11 +41,8 @@ static uint32_t hash(const void *p) {
 	return h;
 }
 
-static float eval(const struct valueNode *node, const struct hitRecord *record) {
-	struct mathNode *this = (struct mathNode *)node;
-	const float a = this->A->eval(this->A, record);
-	const float b = this->B->eval(this->B, record);
-	switch (this->op) {
+float evalMathOp(const enum mathOp op, const float a, const float b) {
+	switch (op) {
 		case Add:
 			return a + b;
 			break;
@@ -94,6 +93,16 @@ static float eval(const struct valueNode *node, const struct hitRecord *record)
 	return 0.0f;
 }
 
+static float eval(const struct valueNode *node, const struct hitRecord *record) {
+	struct mathNode *this = (struct mathNode *)node;
+	return evalMathOp(this->op, this->A->eval(this->A, record), this->B->eval(this->B, record));
+}
+
+static uint8_t compile(const struct valueNode *node, struct nodeCompiler *compiler) {
+	struct mathNode *this = (struct mathNode *)node;
+	return emitOp(compiler, (struct nodeOp){ .code = OpMath, .aux = this->op, .a = emitValue(compiler, this->A), .b = emitValue(compiler, this->B) });
+}
+
 const struct valueNode *newMath(const struct world *world, const struct valueNode *A, const struct valueNode *B, const enum mathOp op) {
 	HASH_CONS(world->nodeTable, hash, struct mathNode, {
 		.A = A ? A : newConstantValue(world, 0.0f),
@@ -101,6 +110,7 @@ const struct valueNode *newMath(const struct world *world, const struct valueNod
 		.op = op,
 		.node = {
 			.eval = eval,
+			.compile = compile,
 			.base = { .compare = compare }
 		}
 	});
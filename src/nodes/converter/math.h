@@ -26,5 +26,8 @@ enum mathOp {
 	ToDegrees,
 };
 
+/// The operation a math node applies, shared with compiled programs
+float evalMathOp(const enum mathOp op, const float a, const float b);
+
 const struct valueNode *newMath(const struct world *world, const struct valueNode *A, const struct valueNode *B, const enum mathOp op);
 
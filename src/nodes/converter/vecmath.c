@@ -14,6 +14,8 @@
 #include "../../datatypes/hitrecord.h"
 #include "../vectornode.h"
 
+#include "../compiler.h"
+
 #include "vecmath.h"
 
 struct vecMathNode {
@@ -38,13 +40,8 @@ static uint32_t hash(const void *p) {
 	return h;
 }
  
-static struct vectorValue eval(const struct vectorNode *node, const struct hitRecord *record) {
-	struct vecMathNode *this = (struct vecMathNode *)node;
-	
-	const struct vector a = this->A->eval(this->A, record).v;
-	const struct vector b = this->B->eval(this->B, record).v;
-	
-	switch (this->op) {
+struct vectorValue evalVecMathOp(const enum vecOp op, const struct vector a, const struct vector b) {
+	switch (op) {
 		case VecAdd:
 			return (struct vectorValue){ .v = vecAdd(a, b) };
 			break;
@@ -80,6 +77,16 @@ static struct vectorValue eval(const struct vectorNode *node, const struct hitRe
 	return (struct vectorValue){ .v = { 0 }, .c = { 0 }, .f = 0.0f };
 }
 
+static struct vectorValue eval(const struct vectorNode *node, const struct hitRecord *record) {
+	struct vecMathNode *this = (struct vecMathNode *)node;
+	return evalVecMathOp(this->op, this->A->eval(this->A, record).v, this->B->eval(this->B, record).v);
+}
+
+static uint8_t compile(const struct vectorNode *node, struct nodeCompiler *compiler) {
+	struct vecMathNode *this = (struct vecMathNode *)node;
+	return emitOp(compiler, (struct nodeOp){ .code = OpVecMath, .aux = this->op, .a = emitVector(compiler, this->A), .b = emitVector(compiler, this->B) });
+}
+
 const struct vectorNode *newVecMath(const struct world *world, const struct vectorNode *A, const struct vectorNode *B, const enum vecOp op) {
 	HASH_CONS(world->nodeTable, hash, struct vecMathNode, {
 		.A = A ? A : newConstantVector(world, vecZero()),
@@ -87,6 +94,7 @@ const struct vectorNode *newVecMath(const struct world *world, const struct vect
 		.op = op,
 		.node = {
 			.eval = eval,
+			.compile = compile,
 			.base = { .compare = compare }
 		}
 	});
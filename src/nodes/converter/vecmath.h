@@ -21,4 +21,7 @@ enum vecOp {
 	VecAbs,
 };
 
+/// The operation a vector math node applies, shared with compiled programs
+struct vectorValue evalVecMathOp(const enum vecOp op, const struct vector a, const struct vector b);
+
 const struct vectorNode *newVecMath(const struct world *world, const struct vectorNode *A, const struct vectorNode *B, const enum vecOp op);
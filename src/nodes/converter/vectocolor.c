@@ -15,6 +15,8 @@
 #include "../colornode.h"
 #include "../vectornode.h"
 
+#include "../compiler.h"
+
 #include "vectocolor.h"
 
 struct vecToColorNode {
@@ -42,11 +44,17 @@ static struct color eval(const struct colorNode *node, const struct hitRecord *r
 	return (struct color){ vec.x, vec.y, vec.z, 0.0f };
 }
 
+static uint8_t compile(const struct colorNode *node, struct nodeCompiler *compiler) {
+	struct vecToColorNode *this = (struct vecToColorNode *)node;
+	return emitOp(compiler, (struct nodeOp){ .code = OpVecToColor, .a = emitVector(compiler, this->vec) });
+}
+
 const struct colorNode *newVecToColor(const struct world *world, const struct vectorNode *vec) {
 	HASH_CONS(world->nodeTable, hash, struct vecToColorNode, {
 		.vec = vec ? vec : newConstantVector(world, vecZero()),
 		.node = {
 			.eval = eval,
+			.compile = compile,
 			.base = { .compare = compare }
 		}
 	});
@@ -14,6 +14,8 @@
 #include "../valuenode.h"
 #include "../vectornode.h"
 
+#include "../compiler.h"
+
 #include "fresnel.h"
 
 struct fresnelNode {
@@ -36,18 +38,24 @@ static uint32_t hash(const void *p) {
 	return h;
 }
 
-static float eval(const struct valueNode *node, const struct hitRecord *record) {
-	struct fresnelNode *this = (struct fresnelNode *)node;
-	
-	float IOR = this->IOR->eval(this->IOR, record);
+float fresnelFactor(const struct hitRecord *record, float IOR) {
 	float cosine = 0.0f;
 	if (vecDot(record->incident.direction, record->surfaceNormal) > 0.0f) {
 		cosine = IOR * vecDot(record->incident.direction, record->surfaceNormal) / vecLength(record->incident.direction);
 	} else {
 		cosine = -(vecDot(record->incident.direction, record->surfaceNormal) / vecLength(record->incident.direction));
 	}
-	
-	return schlick(cosine, this->IOR->eval(this->IOR, record));
+	return schlick(cosine, IOR);
+}
+
+static float eval(const struct valueNode *node, const struct hitRecord *record) {
+	struct fresnelNode *this = (struct fresnelNode *)node;
+	return fresnelFactor(record, this->IOR->eval(this->IOR, record));
+}
+
+static uint8_t compile(const struct valueNode *node, struct nodeCompiler *compiler) {
+	struct fresnelNode *this = (struct fresnelNode *)node;
+	return emitOp(compiler, (struct nodeOp){ .code = OpFresnel, .a = emitValue(compiler, this->IOR) });
 }
 
 const struct valueNode *newFresnel(const struct world *world, const struct valueNode *IOR, const struct vectorNode *normal) {
@@ -56,6 +64,7 @@ const struct valueNode *newFresnel(const struct world *world, const struct value
 		.normal = normal,
 		.node = {
 			.eval = eval,
+			.compile = compile,
 			.base = { .compare = compare }
 		}
 	});
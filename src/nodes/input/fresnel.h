@@ -9,5 +9,9 @@
 #pragma once
 
 struct vectorNode;
+struct hitRecord;
+
+/// Schlick approximation of the fresnel factor for the incident ray at this hit
+float fresnelFactor(const struct hitRecord *record, float IOR);
 
 const struct valueNode *newFresnel(const struct world *world, const struct valueNode *IOR, const struct vectorNode *normal);
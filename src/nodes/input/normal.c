@@ -15,6 +15,8 @@
 #include "../../utils/hashtable.h"
 #include "../bsdfnode.h"
 
+#include "../compiler.h"
+
 #include "normal.h"
 
 struct normalNode {
@@ -40,10 +42,16 @@ static struct vectorValue eval(const struct vectorNode *node, const struct hitRe
 	return (struct vectorValue){ .v = record->surfaceNormal, .c = coordZero() };
 }
 
+static uint8_t compile(const struct vectorNode *node, struct nodeCompiler *compiler) {
+	(void)node;
+	return emitOp(compiler, (struct nodeOp){ .code = OpNormal });
+}
+
 const struct vectorNode *newNormal(const struct world *world) {
 	HASH_CONS(world->nodeTable, hash, struct normalNode, {
 		.node = {
 			.eval = eval,
+			.compile = compile,
 			.base = { .compare = compare }
 		}
 	});
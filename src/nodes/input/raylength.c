@@ -14,6 +14,8 @@
 #include "../../utils/hashtable.h"
 #include "../bsdfnode.h"
 
+#include "../compiler.h"
+
 #include "raylength.h"
 
 struct rayLengthNode {
@@ -39,10 +41,16 @@ static float eval(const struct valueNode *node, const struct hitRecord *record)
 	return record->distance;
 }
 
+static uint8_t compile(const struct valueNode *node, struct nodeCompiler *compiler) {
+	(void)node;
+	return emitOp(compiler, (struct nodeOp){ .code = OpRayLength });
+}
+
 const struct valueNode *newRayLength(const struct world *world) {
 	HASH_CONS(world->nodeTable, hash, struct rayLengthNode, {
 		.node = {
 			.eval = eval,
+			.compile = compile,
 			.base = { .compare = compare }
 		}
 	});
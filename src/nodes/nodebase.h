@@ -12,6 +12,9 @@
 
 // Magic for comparing two nodes
 
+// Lowers input graphs into programs, see compiler.h
+struct nodeCompiler;
+
 struct nodeBase {
 	bool (*compare)(const void *, const void *);
 };
@@ -17,6 +17,8 @@
 #include "../../utils/logging.h"
 #include "../bsdfnode.h"
 
+#include "../compiler.h"
+
 #include "add.h"
 
 struct addBsdf {
@@ -48,16 +50,33 @@ static struct bsdfSample sample(const struct bsdfNode *bsdf, sampler *sampler, c
 	return (struct bsdfSample){.out = vecAdd(A.out, B.out), .color = addColors(A.color, B.color)};
 }
 
+static struct color emitted(const struct bsdfNode *bsdf, const struct hitRecord *record) {
+	struct addBsdf *addBsdf = (struct addBsdf *)bsdf;
+	return addColors(bsdfEmission(addBsdf->A, record), bsdfEmission(addBsdf->B, record));
+}
+
+static const struct bsdfNode *compile(const struct bsdfNode *bsdf, struct world *world) {
+	const struct addBsdf *this = (struct addBsdf *)bsdf;
+	return newAdd(world, compileBsdf(world, this->A), compileBsdf(world, this->B));
+}
+
 const struct bsdfNode *newAdd(const struct world *world, const struct bsdfNode *A, const struct bsdfNode *B) {
 	if (A == B) {
 		logr(debug, "A == B, pruning add node.\n");
 		return A;
 	}
+	A = A ? A : newDiffuse(world, newConstantTexture(world, blackColor));
+	B = B ? B : newDiffuse(world, newConstantTexture(world, blackColor));
 	HASH_CONS(world->nodeTable, hash, struct addBsdf, {
-		.A = A ? A : newDiffuse(world, newConstantTexture(world, blackColor)),
-		.B = B ? B : newDiffuse(world, newConstantTexture(world, blackColor)),
+		.A = A,
+		.B = B,
 		.bsdf = {
 			.sample = sample,
+			// The summed sample direction has no meaningful density, so leave this to sample()
+			.eval = evalNone,
+			.pdf = pdfNone,
+			.compile = compile,
+			.emission = A->emission || B->emission ? emitted : NULL,
 			.base = { .compare = compare }
 		}
 	});
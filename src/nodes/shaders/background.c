@@ -7,13 +7,17 @@
 //
 
 #include "../../includes.h"
+#include <float.h>
 #include "../../datatypes/color.h"
 #include "../../datatypes/vector.h"
 #include "../../datatypes/hitrecord.h"
 #include "../../utils/hashtable.h"
 #include "../../datatypes/scene.h"
+#include "../../datatypes/image/texture.h"
 #include "../bsdfnode.h"
 
+#include "../compiler.h"
+
 #include "background.h"
 
 struct backgroundBsdf {
@@ -36,6 +40,33 @@ static uint32_t hash(const void *p) {
 	return h;
 }
 
+// atan2f() to within 2e-6 radians, which is well under a texel of any environment map
+static inline float fastAtan2(float y, float x) {
+	const float ax = fabsf(x);
+	const float ay = fabsf(y);
+	const float a = min(ax, ay) / max(max(ax, ay), FLT_MIN);
+	const float s = a * a;
+	float r = a * (0.99997726f + s * (-0.33262347f + s * (0.19354346f + s * (-0.11643287f + s * (0.05265332f + s * -0.01172120f)))));
+	if (ay > ax) r = 0.5f * PI - r;
+	if (x < 0.0f) r = PI - r;
+	return y < 0.0f ? -r : r;
+}
+
+// Equirectangular mapping. The direction doesn't need to be normalized.
+static inline struct coord directionToUV(struct vector direction, float offset) {
+	float u = fastAtan2(direction.z, direction.x) * (0.5f / PI) + offset * (2.0f / PI);
+	u -= floorf(u);
+	const float v = fastAtan2(sqrtf(direction.x * direction.x + direction.z * direction.z), -direction.y) * (1.0f / PI);
+	return (struct coord){ u, v };
+}
+
+static inline struct vector uvToDirection(struct coord uv, float offset) {
+	const float phi = 2.0f * PI * uv.x - 4.0f * offset;
+	const float theta = PI * uv.y;
+	const float sinTheta = sinf(theta);
+	return (struct vector){ sinTheta * cosf(phi), -cosf(theta), sinTheta * sinf(phi) };
+}
+
 static struct bsdfSample sample(const struct bsdfNode *bsdf, sampler *sampler, const struct hitRecord *record) {
 	(void)sampler;
 	struct backgroundBsdf *background = (struct backgroundBsdf *)bsdf;
@@ -43,19 +74,7 @@ static struct bsdfSample sample(const struct bsdfNode *bsdf, sampler *sampler, c
 	//TODO: Find a better way to do this.
 	//Ideally it would be populated by the renderer before we eval bsdfs.
 	struct hitRecord *copy = (struct hitRecord *)record; // Oof owie, my const...
-	struct vector ud = vecNormalize(copy->incident.direction);
-	//To polar from cartesian
-	float r = 1.0f; //Normalized above
-	float phi = (atan2f(ud.z, ud.x) / 4.0f) + background->offset->eval(background->offset, record);
-	float theta = acosf((-ud.y / r));
-	
-	float u = theta / PI;
-	float v = (phi / (PI / 2.0f));
-	
-	u = wrapMinMax(u, 0.0f, 1.0f);
-	v = wrapMinMax(v, 0.0f, 1.0f);
-	
-	copy->uv = (struct coord){ v, u };
+	copy->uv = directionToUV(copy->incident.direction, background->offset->eval(background->offset, record));
 	
 	float strength = background->strength->eval(background->strength, record);
 	
@@ -65,6 +84,11 @@ static struct bsdfSample sample(const struct bsdfNode *bsdf, sampler *sampler, c
 	};
 }
 
+static const struct bsdfNode *compile(const struct bsdfNode *bsdf, struct world *world) {
+	const struct backgroundBsdf *this = (struct backgroundBsdf *)bsdf;
+	return newBackground(world, compileColor(world, this->color), compileValue(world, this->strength), compileValue(world, this->offset));
+}
+
 const struct bsdfNode *newBackground(const struct world *world, const struct colorNode *tex, const struct valueNode *strength, const struct valueNode *offset) {
 	HASH_CONS(world->nodeTable, hash, struct backgroundBsdf, {
 		.color = tex ? tex : newConstantTexture(world, grayColor),
@@ -72,7 +96,142 @@ const struct bsdfNode *newBackground(const struct world *world, const struct col
 		.offset = offset ? offset : newConstantValue(world, 0.0f),
 		.bsdf = {
 			.sample = sample,
+			.eval = evalNone,
+			.pdf = pdfNone,
+			.compile = compile,
 			.base = { .compare = compare }
 		}
 	});
 }
+
+// Piecewise-constant distribution over the equirectangular map, proportional to luminance times the
+// solid angle each cell covers. Rows are picked from the marginal CDF, then columns from that row's conditional CDF.
+struct environmentMap {
+	unsigned width, height;
+	float offset;
+	float *values; // Per cell, row-major
+	float *conditional; // width + 1 entries per row
+	float *marginal; // height + 1 entries
+	float average; // Mean of values, normalizes them into a pdf over uv
+};
+
+// Enough to resolve the sun in most HDRs, larger maps are averaged down to this
+#define MAX_MAP_WIDTH 2048
+#define MAX_MAP_HEIGHT 1024
+
+// Builds a CDF with count + 1 entries, returns the sum of the input
+static float buildCDF(const float *values, unsigned count, float *cdf) {
+	double sum = 0.0;
+	cdf[0] = 0.0f;
+	for (unsigned i = 0; i < count; ++i) {
+		sum += values[i];
+		cdf[i + 1] = (float)sum;
+	}
+	for (unsigned i = 1; i <= count; ++i) {
+		cdf[i] = sum > 0.0 ? (float)(cdf[i] / sum) : (float)i / count;
+	}
+	cdf[count] = 1.0f;
+	return (float)sum;
+}
+
+// Largest i with cdf[i] <= u, so empty intervals are never picked
+static unsigned findInterval(const float *cdf, unsigned count, float u) {
+	unsigned lo = 0;
+	unsigned hi = count;
+	while (lo + 1 < hi) {
+		const unsigned mid = (lo + hi) / 2;
+		if (cdf[mid] <= u) {
+			lo = mid;
+		} else {
+			hi = mid;
+		}
+	}
+	return lo;
+}
+
+struct environmentMap *newEnvironmentMap(const struct bsdfNode *node) {
+	if (!node || node->sample != sample) return NULL;
+	const struct backgroundBsdf *background = (const struct backgroundBsdf *)node;
+	// Gradients and constant colors are smooth, a coarse grid does fine for those
+	unsigned width = 64;
+	unsigned height = 32;
+	unsigned texelsX = 1;
+	unsigned texelsY = 1;
+	const struct texture *texture = getImageTexture(background->color);
+	if (texture) {
+		width = min(texture->width, MAX_MAP_WIDTH);
+		height = min(texture->height, MAX_MAP_HEIGHT);
+		texelsX = (texture->width + width - 1) / width;
+		texelsY = (texture->height + height - 1) / height;
+	}
+	struct hitRecord record = { .instIndex = -1 };
+	const float offset = background->offset->eval(background->offset, &record);
+	
+	struct environmentMap *map = calloc(1, sizeof(*map));
+	map->width = width;
+	map->height = height;
+	map->offset = offset;
+	map->values = malloc(width * height * sizeof(*map->values));
+	map->conditional = malloc((width + 1) * height * sizeof(*map->conditional));
+	map->marginal = malloc((height + 1) * sizeof(*map->marginal));
+	float *rowSums = malloc(height * sizeof(*rowSums));
+	for (unsigned y = 0; y < height; ++y) {
+		const float sinTheta = sinf(PI * (y + 0.5f) / height);
+		for (unsigned x = 0; x < width; ++x) {
+			float sum = 0.0f;
+			for (unsigned ty = 0; ty < texelsY; ++ty) {
+				for (unsigned tx = 0; tx < texelsX; ++tx) {
+					const struct coord uv = { (x + (tx + 0.5f) / texelsX) / width, (y + (ty + 0.5f) / texelsY) / height };
+					record.incident.direction = uvToDirection(uv, offset);
+					sum += luminance(sample(node, NULL, &record).color);
+				}
+			}
+			map->values[y * width + x] = max(sum, 0.0f) / (texelsX * texelsY) * sinTheta;
+		}
+		rowSums[y] = buildCDF(&map->values[y * width], width, &map->conditional[y * (width + 1)]);
+	}
+	const float total = buildCDF(rowSums, height, map->marginal);
+	free(rowSums);
+	map->average = total / (width * height);
+	if (map->average <= 0.0f) {
+		destroyEnvironmentMap(map);
+		return NULL;
+	}
+	return map;
+}
+
+struct vector sampleEnvironmentMap(const struct environmentMap *map, float u0, float u1, float *pdf) {
+	const unsigned y = findInterval(map->marginal, map->height, u1);
+	const float *row = &map->conditional[y * (map->width + 1)];
+	const unsigned x = findInterval(row, map->width, u0);
+	const float dv = (u1 - map->marginal[y]) / max(map->marginal[y + 1] - map->marginal[y], FLT_MIN);
+	const float du = (u0 - row[x]) / max(row[x + 1] - row[x], FLT_MIN);
+	const struct coord uv = { (x + min(du, 1.0f)) / map->width, (y + min(dv, 1.0f)) / map->height };
+	const float sinTheta = sinf(PI * uv.y);
+	// Jacobian of the mapping: d(omega) = 2 pi^2 sin(theta) du dv
+	*pdf = sinTheta > 0.0f ? map->values[y * map->width + x] / (map->average * 2.0f * PI * PI * sinTheta) : 0.0f;
+	return uvToDirection(uv, map->offset);
+}
+
+float environmentMapPdf(const struct environmentMap *map, struct vector direction) {
+	const struct coord uv = directionToUV(direction, map->offset);
+	const unsigned x = min((unsigned)(uv.x * map->width), map->width - 1);
+	const unsigned y = min((unsigned)(uv.y * map->height), map->height - 1);
+	const float sinTheta = sqrtf(direction.x * direction.x + direction.z * direction.z) / vecLength(direction);
+	if (sinTheta <= 0.0f) return 0.0f;
+	return map->values[y * map->width + x] / (map->average * 2.0f * PI * PI * sinTheta);
+}
+
+float environmentMapPower(const struct environmentMap *map) {
+	// Cells span 2 pi / width by pi / height radians, and values already include sin(theta)
+	return map->average * 2.0f * PI * PI;
+}
+
+void destroyEnvironmentMap(struct environmentMap *map) {
+	if (map) {
+		free(map->values);
+		free(map->conditional);
+		free(map->marginal);
+		free(map);
+	}
+}
@@ -9,3 +9,26 @@
 #pragma once
 
 const struct bsdfNode *newBackground(const struct world *world, const struct colorNode *tex, const struct valueNode *strength, const struct valueNode *offset);
+
+struct environmentMap;
+
+/// Tabulate a background so it can be importance sampled. Image backgrounds get one cell per texel, up to a limit.
+/// @param background Background node, from newBackground()
+/// @return NULL if background isn't a background node, or it's entirely black
+struct environmentMap *newEnvironmentMap(const struct bsdfNode *background);
+
+/// Pick a direction proportionally to the luminance of the background
+/// @param map Environment map to sample
+/// @param u0 Uniform sample for the horizontal angle
+/// @param u1 Uniform sample for the vertical angle
+/// @param pdf Populated with the solid angle pdf of the returned direction
+/// @return Normalized direction
+struct vector sampleEnvironmentMap(const struct environmentMap *map, float u0, float u1, float *pdf);
+
+/// The solid angle pdf sampleEnvironmentMap() has for a given direction
+float environmentMapPdf(const struct environmentMap *map, struct vector direction);
+
+/// Luminance of the background, integrated over the sphere
+float environmentMapPower(const struct environmentMap *map);
+
+void destroyEnvironmentMap(struct environmentMap *map);
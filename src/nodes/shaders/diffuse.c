@@ -17,6 +17,8 @@
 #include "../../utils/logging.h"
 #include "../bsdfnode.h"
 
+#include "../compiler.h"
+
 #include "diffuse.h"
 
 struct diffuseBsdf {
@@ -37,20 +39,43 @@ static uint32_t hash(const void *p) {
 	return h;
 }
 
+// Normal + a point on the unit sphere gives a cosine-weighted direction
+static float pdf(const struct bsdfNode *bsdf, const struct hitRecord *record, const struct vector out) {
+	(void)bsdf;
+	const float cosine = vecDot(record->surfaceNormal, out);
+	return cosine > 0.0f ? cosine / PI : 0.0f;
+}
+
+static struct color eval(const struct bsdfNode *bsdf, const struct hitRecord *record, const struct vector out) {
+	struct diffuseBsdf *diffBsdf = (struct diffuseBsdf *)bsdf;
+	const float cosine = vecDot(record->surfaceNormal, out);
+	if (cosine <= 0.0f) return blackColor;
+	return colorCoef(cosine / PI, diffBsdf->color->eval(diffBsdf->color, record));
+}
+
 static struct bsdfSample sample(const struct bsdfNode *bsdf, sampler *sampler, const struct hitRecord *record) {
 	struct diffuseBsdf *diffBsdf = (struct diffuseBsdf *)bsdf;
 	const struct vector scatterDir = vecNormalize(vecAdd(record->surfaceNormal, randomOnUnitSphere(sampler)));
 	return (struct bsdfSample){
 		.out = scatterDir,
+		.pdf = pdf(bsdf, record, scatterDir),
 		.color = diffBsdf->color->eval(diffBsdf->color, record)
 	};
 }
 
+static const struct bsdfNode *compile(const struct bsdfNode *bsdf, struct world *world) {
+	const struct diffuseBsdf *this = (struct diffuseBsdf *)bsdf;
+	return newDiffuse(world, compileColor(world, this->color));
+}
+
 const struct bsdfNode *newDiffuse(const struct world *world, const struct colorNode *color) {
 	HASH_CONS(world->nodeTable, hash, struct diffuseBsdf, {
 		.color = color ? color : newConstantTexture(world, blackColor),
 		.bsdf = {
 			.sample = sample,
+			.eval = eval,
+			.pdf = pdf,
+			.compile = compile,
 			.base = { .compare = compare }
 		}
 	});
@@ -17,6 +17,8 @@
 #include "../../utils/logging.h"
 #include "../bsdfnode.h"
 
+#include "../compiler.h"
+
 #include "emission.h"
 
 struct emissiveBsdf {
@@ -39,21 +41,36 @@ static uint32_t hash(const void *p) {
 	return h;
 }
 
+// Pure emitter, nothing gets scattered
 static struct bsdfSample sample(const struct bsdfNode *bsdf, sampler *sampler, const struct hitRecord *record) {
-	struct emissiveBsdf *emitBsdf = (struct emissiveBsdf *)bsdf;
-	const struct vector scatterDir = vecNormalize(vecAdd(record->surfaceNormal, randomOnUnitSphere(sampler)));
+	(void)bsdf;
+	(void)sampler;
 	return (struct bsdfSample){
-		.out = scatterDir,
-		.color = colorCoef(emitBsdf->strength->eval(emitBsdf->strength, record), emitBsdf->color->eval(emitBsdf->color, record))
+		.out = record->surfaceNormal,
+		.color = blackColor
 	};
 }
 
+static struct color emitted(const struct bsdfNode *bsdf, const struct hitRecord *record) {
+	struct emissiveBsdf *emitBsdf = (struct emissiveBsdf *)bsdf;
+	return colorCoef(emitBsdf->strength->eval(emitBsdf->strength, record), emitBsdf->color->eval(emitBsdf->color, record));
+}
+
+static const struct bsdfNode *compile(const struct bsdfNode *bsdf, struct world *world) {
+	const struct emissiveBsdf *this = (struct emissiveBsdf *)bsdf;
+	return newEmission(world, compileColor(world, this->color), compileValue(world, this->strength));
+}
+
 const struct bsdfNode *newEmission(const struct world *world, const struct colorNode *color, const struct valueNode *strength) {
 	HASH_CONS(world->nodeTable, hash, struct emissiveBsdf, {
 		.color = color ? color : newConstantTexture(world, blackColor),
 		.strength = strength ? strength : newConstantValue(world, 1.0f),
 		.bsdf = {
 			.sample = sample,
+			.eval = evalNone,
+			.pdf = pdfNone,
+			.compile = compile,
+			.emission = emitted,
 			.base = { .compare = compare }
 		}
 	});
@@ -15,6 +15,8 @@
 #include "../../datatypes/scene.h"
 #include "../bsdfnode.h"
 
+#include "../compiler.h"
+
 #include "glass.h"
 
 struct glassBsdf {
@@ -86,6 +88,11 @@ static struct bsdfSample sample(const struct bsdfNode *bsdf, sampler *sampler, c
 	};
 }
 
+static const struct bsdfNode *compile(const struct bsdfNode *bsdf, struct world *world) {
+	const struct glassBsdf *this = (struct glassBsdf *)bsdf;
+	return newGlass(world, compileColor(world, this->color), compileValue(world, this->roughness), compileValue(world, this->IOR));
+}
+
 const struct bsdfNode *newGlass(const struct world *world, const struct colorNode *color, const struct valueNode *roughness, const struct valueNode *IOR) {
 	HASH_CONS(world->nodeTable, hash, struct glassBsdf, {
 		.color = color ? color : newConstantTexture(world, blackColor),
@@ -93,6 +100,9 @@ const struct bsdfNode *newGlass(const struct world *world, const struct colorNod
 		.IOR = IOR ? IOR : newConstantValue(world, 1.45f),
 		.bsdf = {
 			.sample = sample,
+			.eval = evalNone,
+			.pdf = pdfNone,
+			.compile = compile,
 			.base = { .compare = compare }
 		}
 	});
@@ -15,6 +15,8 @@
 #include "../../datatypes/scene.h"
 #include "../bsdfnode.h"
 
+#include "../compiler.h"
+
 #include "metal.h"
 
 struct metalBsdf {
@@ -54,12 +56,20 @@ static struct bsdfSample sample(const struct bsdfNode *bsdf, sampler *sampler, c
 	};
 }
 
+static const struct bsdfNode *compile(const struct bsdfNode *bsdf, struct world *world) {
+	const struct metalBsdf *this = (struct metalBsdf *)bsdf;
+	return newMetal(world, compileColor(world, this->color), compileValue(world, this->roughness));
+}
+
 const struct bsdfNode *newMetal(const struct world *world, const struct colorNode *color, const struct valueNode *roughness) {
 	HASH_CONS(world->nodeTable, hash, struct metalBsdf, {
 		.color = color ? color : newConstantTexture(world, blackColor),
 		.roughness = roughness ? roughness : newConstantValue(world, 0.0f),
 		.bsdf = {
 			.sample = sample,
+			.eval = evalNone,
+			.pdf = pdfNone,
+			.compile = compile,
 			.base = { .compare = compare }
 		}
 	});
@@ -15,6 +15,8 @@
 #include "../../datatypes/scene.h"
 #include "../bsdfnode.h"
 
+#include "../compiler.h"
+
 #include "mix.h"
 
 struct mixBsdf {
@@ -39,14 +41,52 @@ static uint32_t hashMix(const void *p) {
 	return h;
 }
 
+static struct color eval(const struct bsdfNode *bsdf, const struct hitRecord *record, const struct vector out) {
+	struct mixBsdf *mixBsdf = (struct mixBsdf *)bsdf;
+	const float lerp = mixBsdf->factor->eval(mixBsdf->factor, record);
+	const struct color A = lerp < 1.0f ? mixBsdf->A->eval(mixBsdf->A, record, out) : blackColor;
+	const struct color B = lerp > 0.0f ? mixBsdf->B->eval(mixBsdf->B, record, out) : blackColor;
+	return mixColors(A, B, lerp);
+}
+
+static float pdf(const struct bsdfNode *bsdf, const struct hitRecord *record, const struct vector out) {
+	struct mixBsdf *mixBsdf = (struct mixBsdf *)bsdf;
+	const float lerp = mixBsdf->factor->eval(mixBsdf->factor, record);
+	const float A = lerp < 1.0f ? mixBsdf->A->pdf(mixBsdf->A, record, out) : 0.0f;
+	const float B = lerp > 0.0f ? mixBsdf->B->pdf(mixBsdf->B, record, out) : 0.0f;
+	return (1.0f - lerp) * A + lerp * B;
+}
+
+static struct color emitted(const struct bsdfNode *bsdf, const struct hitRecord *record) {
+	struct mixBsdf *mixBsdf = (struct mixBsdf *)bsdf;
+	const float lerp = mixBsdf->factor->eval(mixBsdf->factor, record);
+	return mixColors(bsdfEmission(mixBsdf->A, record), bsdfEmission(mixBsdf->B, record), lerp);
+}
+
 static struct bsdfSample sample(const struct bsdfNode *bsdf, sampler *sampler, const struct hitRecord *record) {
 	struct mixBsdf *mixBsdf = (struct mixBsdf *)bsdf;
 	const float lerp = mixBsdf->factor->eval(mixBsdf->factor, record);
+	struct bsdfSample sample;
 	if (getDimension(sampler) > lerp) {
-		return mixBsdf->A->sample(mixBsdf->A, sampler, record);
+		sample = mixBsdf->A->sample(mixBsdf->A, sampler, record);
 	} else {
-		return mixBsdf->B->sample(mixBsdf->B, sampler, record);
+		sample = mixBsdf->B->sample(mixBsdf->B, sampler, record);
+	}
+	// The weight from the picked lobe is fine as is, but MIS needs the density of the whole mix.
+	if (sample.pdf > 0.0f) sample.pdf = pdf(bsdf, record, sample.out);
+	return sample;
+}
+
+static const struct bsdfNode *compileMix(const struct bsdfNode *bsdf, struct world *world) {
+	const struct mixBsdf *this = (struct mixBsdf *)bsdf;
+	const struct valueNode *factor = compileValue(world, this->factor);
+	float lerp = 0.0f;
+	if (getConstantValue(factor, &lerp)) {
+		// sample() and eval() never look at the other side with these
+		if (lerp == 0.0f) return compileBsdf(world, this->A);
+		if (lerp == 1.0f) return compileBsdf(world, this->B);
 	}
+	return newMix(world, compileBsdf(world, this->A), compileBsdf(world, this->B), factor);
 }
 
 const struct bsdfNode *newMix(const struct world *world, const struct bsdfNode *A, const struct bsdfNode *B, const struct valueNode *factor) {
@@ -54,12 +94,18 @@ const struct bsdfNode *newMix(const struct world *world, const struct bsdfNode *
 		logr(debug, "A == B, pruning mix node.\n");
 		return A;
 	}
+	A = A ? A : newDiffuse(world, newConstantTexture(world, blackColor));
+	B = B ? B : newDiffuse(world, newConstantTexture(world, blackColor));
 	HASH_CONS(world->nodeTable, hashMix, struct mixBsdf, {
-		.A = A ? A : newDiffuse(world, newConstantTexture(world, blackColor)),
-		.B = B ? B : newDiffuse(world, newConstantTexture(world, blackColor)),
+		.A = A,
+		.B = B,
 		.factor = factor ? factor : newConstantValue(world, 0.5f),
 		.bsdf = {
 			.sample = sample,
+			.eval = eval,
+			.pdf = pdf,
+			.compile = compileMix,
+			.emission = A->emission || B->emission ? emitted : NULL,
 			.base = { .compare = compareMix }
 		}
 	});
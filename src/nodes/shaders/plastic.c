@@ -16,6 +16,8 @@
 #include "../../datatypes/scene.h"
 #include "../bsdfnode.h"
 
+#include "../compiler.h"
+
 #include "plastic.h"
 
 struct plasticBsdf {
@@ -54,38 +56,57 @@ static struct bsdfSample sampleShiny(const struct bsdfNode *bsdf, sampler *sampl
 	};
 }
 
-static struct bsdfSample sample(const struct bsdfNode *bsdf, sampler *sampler, const struct hitRecord *record) {
+static float reflectionProbability(const struct hitRecord *record) {
 	struct vector outwardNormal;
 	float niOverNt;
 	struct vector refracted;
-	float reflectionProbability;
 	float cosine;
 	
-	struct plasticBsdf *this = (struct plasticBsdf *)bsdf;
-	
 	if (vecDot(record->incident.direction, record->surfaceNormal) > 0.0f) {
 		outwardNormal = vecNegate(record->surfaceNormal);
-		niOverNt = record->material.IOR;
-		cosine = record->material.IOR * vecDot(record->incident.direction, record->surfaceNormal) / vecLength(record->incident.direction);
+		niOverNt = record->material->IOR;
+		cosine = record->material->IOR * vecDot(record->incident.direction, record->surfaceNormal) / vecLength(record->incident.direction);
 	} else {
 		outwardNormal = record->surfaceNormal;
-		niOverNt = 1.0f / record->material.IOR;
+		niOverNt = 1.0f / record->material->IOR;
 		cosine = -(vecDot(record->incident.direction, record->surfaceNormal) / vecLength(record->incident.direction));
 	}
 	
 	if (refract(&record->incident.direction, outwardNormal, niOverNt, &refracted)) {
-		reflectionProbability = schlick(cosine, record->material.IOR);
+		return schlick(cosine, record->material->IOR);
 	} else {
-		reflectionProbability = 1.0f;
+		return 1.0f;
 	}
-	
-	if (getDimension(sampler) < reflectionProbability) {
+}
+
+// Only the diffuse base can be evaluated, weighted by how often it gets picked
+static struct color eval(const struct bsdfNode *bsdf, const struct hitRecord *record, const struct vector out) {
+	struct plasticBsdf *this = (struct plasticBsdf *)bsdf;
+	return colorCoef(1.0f - reflectionProbability(record), this->diffuse->eval(this->diffuse, record, out));
+}
+
+static float pdf(const struct bsdfNode *bsdf, const struct hitRecord *record, const struct vector out) {
+	struct plasticBsdf *this = (struct plasticBsdf *)bsdf;
+	return (1.0f - reflectionProbability(record)) * this->diffuse->pdf(this->diffuse, record, out);
+}
+
+static struct bsdfSample sample(const struct bsdfNode *bsdf, sampler *sampler, const struct hitRecord *record) {
+	struct plasticBsdf *this = (struct plasticBsdf *)bsdf;
+	const float probability = reflectionProbability(record);
+	if (getDimension(sampler) < probability) {
 		return sampleShiny(bsdf, sampler, record);
 	} else {
-		return this->diffuse->sample(this->diffuse, sampler, record);
+		struct bsdfSample diffuse = this->diffuse->sample(this->diffuse, sampler, record);
+		diffuse.pdf *= 1.0f - probability;
+		return diffuse;
 	}
 }
 
+static const struct bsdfNode *compile(const struct bsdfNode *bsdf, struct world *world) {
+	const struct plasticBsdf *this = (struct plasticBsdf *)bsdf;
+	return newPlastic(world, compileColor(world, this->color));
+}
+
 const struct bsdfNode *newPlastic(const struct world *world, const struct colorNode *color) {
 	HASH_CONS(world->nodeTable, hash, struct plasticBsdf, {
 		.color = color ? color : newConstantTexture(world, blackColor),
@@ -93,6 +114,9 @@ const struct bsdfNode *newPlastic(const struct world *world, const struct colorN
 		.diffuse = newDiffuse(world, color),
 		.bsdf = {
 			.sample = sample,
+			.eval = eval,
+			.pdf = pdf,
+			.compile = compile,
 			.base = { .compare = compare }
 		}
 	});
@@ -17,6 +17,8 @@
 #include "../../utils/logging.h"
 #include "../bsdfnode.h"
 
+#include "../compiler.h"
+
 #include "transparent.h"
 
 struct transparent {
@@ -43,11 +45,19 @@ static struct bsdfSample sample(const struct bsdfNode *bsdf, sampler *sampler, c
 	return (struct bsdfSample){ .out = record->incident.direction, .color = this->color->eval(this->color, record) };
 }
 
+static const struct bsdfNode *compile(const struct bsdfNode *bsdf, struct world *world) {
+	const struct transparent *this = (struct transparent *)bsdf;
+	return newTransparent(world, compileColor(world, this->color));
+}
+
 const struct bsdfNode *newTransparent(const struct world *world, const struct colorNode *color) {
 	HASH_CONS(world->nodeTable, hash, struct transparent, {
 		.color = color ? color : newConstantTexture(world, whiteColor),
 		.bsdf = {
 			.sample = sample,
+			.eval = evalNone,
+			.pdf = pdfNone,
+			.compile = compile,
 			.base = { .compare = compare }
 		}
 	});
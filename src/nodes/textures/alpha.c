@@ -8,13 +8,14 @@
 
 #include "../../includes.h"
 #include "../../datatypes/color.h"
-#include "../../datatypes/vertexbuffer.h"
 #include "../../utils/assert.h"
 #include "../../datatypes/hitrecord.h"
 #include "../../utils/hashtable.h"
 #include "../../datatypes/scene.h"
 #include "../colornode.h"
 
+#include "../compiler.h"
+
 #include "alpha.h"
 
 struct alphaNode {
@@ -40,11 +41,17 @@ static float eval(const struct valueNode *node, const struct hitRecord *record)
 	return this->color->eval(this->color, record).alpha;
 }
 
+static uint8_t compile(const struct valueNode *node, struct nodeCompiler *compiler) {
+	struct alphaNode *this = (struct alphaNode *)node;
+	return emitOp(compiler, (struct nodeOp){ .code = OpAlpha, .a = emitColor(compiler, this->color) });
+}
+
 const struct valueNode *newAlpha(const struct world *world, const struct colorNode *color) {
 	HASH_CONS(world->nodeTable, hash, struct alphaNode, {
 		.color = color ? color : newConstantTexture(world, whiteColor),
 		.node = {
 			.eval = eval,
+			.compile = compile,
 			.base = { .compare = compare }
 		}
 	});
@@ -9,7 +9,6 @@
 #include "../../includes.h"
 #include "../../datatypes/color.h"
 #include "../../datatypes/poly.h"
-#include "../../datatypes/vertexbuffer.h"
 #include "../../utils/assert.h"
 #include "../../datatypes/image/texture.h"
 #include "../../utils/mempool.h"
@@ -18,6 +17,8 @@
 #include "../../datatypes/scene.h"
 #include "../colornode.h"
 
+#include "../compiler.h"
+
 #include "checker.h"
 
 struct checkerTexture {
@@ -27,30 +28,20 @@ struct checkerTexture {
 	const struct valueNode *scale;
 };
 
-// UV-mapped variant
-static struct color mappedCheckerBoard(const struct hitRecord *isect, const struct colorNode *A, const struct colorNode *B, const struct valueNode *scale) {
-	const float coef = scale->eval(scale, isect);
-	const float sines = sinf(coef * isect->uv.x) * sinf(coef * isect->uv.y);
-	if (sines < 0.0f) {
-		return A->eval(A, isect);
-	} else {
-		return B->eval(B, isect);
-	}
-}
-
-// Fallback axis-aligned checkerboard
-static struct color unmappedCheckerBoard(const struct hitRecord *isect, const struct colorNode *A, const struct colorNode *B, const struct valueNode *scale) {
-	const float coef = scale->eval(scale, isect);
-	const float sines = sinf(coef*isect->hitPoint.x) * sinf(coef*isect->hitPoint.y) * sinf(coef*isect->hitPoint.z);
-	if (sines < 0.0f) {
-		return A->eval(A, isect);
+bool checkerPattern(const struct hitRecord *isect, float scale) {
+	float sines;
+	if (isect->uv.x >= 0) {
+		// UV-mapped variant
+		sines = sinf(scale * isect->uv.x) * sinf(scale * isect->uv.y);
 	} else {
-		return B->eval(B, isect);
+		// Fallback axis-aligned checkerboard
+		sines = sinf(scale * isect->hitPoint.x) * sinf(scale * isect->hitPoint.y) * sinf(scale * isect->hitPoint.z);
 	}
+	return sines < 0.0f;
 }
 
 static struct color checkerBoard(const struct hitRecord *isect, const struct colorNode *A, const struct colorNode *B, const struct valueNode *scale) {
-	return isect->uv.x >= 0 ? mappedCheckerBoard(isect, A, B, scale) : unmappedCheckerBoard(isect, A, B, scale);
+	return checkerPattern(isect, scale->eval(scale, isect)) ? A->eval(A, isect) : B->eval(B, isect);
 }
 
 static bool compare(const void *A, const void *B) {
@@ -73,6 +64,23 @@ static struct color eval(const struct colorNode *node, const struct hitRecord *r
 	return checkerBoard(record, checker->A, checker->B, checker->scale);
 }
 
+static uint8_t compile(const struct colorNode *node, struct nodeCompiler *compiler) {
+	struct checkerTexture *checker = (struct checkerTexture *)node;
+	const uint8_t A = emitColor(compiler, checker->A);
+	const uint8_t B = emitColor(compiler, checker->B);
+	// Programs run every instruction, so picking between two computed colors would pay for both sides.
+	// The interpreted checkerboard only evaluates the side it picks. Unused instructions for A and B are dropped when linking.
+	if (!isConstantRegister(compiler, A) || !isConstantRegister(compiler, B)) {
+		return emitOp(compiler, (struct nodeOp){ .code = OpCallColor, .data = node });
+	}
+	return emitOp(compiler, (struct nodeOp){
+		.code = OpChecker,
+		.a = emitValue(compiler, checker->scale),
+		.b = A,
+		.c = B
+	});
+}
+
 const struct colorNode *newCheckerBoardTexture(const struct world *world, const struct colorNode *A, const struct colorNode *B, const struct valueNode *scale) {
 	HASH_CONS(world->nodeTable, hash, struct checkerTexture, {
 		.A = A ? A : newConstantTexture(world, blackColor),
@@ -80,6 +88,7 @@ const struct colorNode *newCheckerBoardTexture(const struct world *world, const
 		.scale = scale ? scale : newConstantValue(world, 5.0f),
 		.node = {
 			.eval = eval,
+			.compile = compile,
 			.base = { .compare = compare }
 		}
 	});
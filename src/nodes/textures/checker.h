@@ -9,5 +9,9 @@
 #pragma once
 
 struct world;
+struct hitRecord;
+
+/// @return true where a checkerboard of this scale shows its first color
+bool checkerPattern(const struct hitRecord *isect, float scale);
 
 const struct colorNode *newCheckerBoardTexture(const struct world *world, const struct colorNode *A, const struct colorNode *B, const struct valueNode *scale);
@@ -16,6 +16,8 @@
 #include "../../datatypes/scene.h"
 #include "../colornode.h"
 
+#include "../compiler.h"
+
 #include "constant.h"
 
 struct constantTexture {
@@ -41,11 +43,16 @@ static struct color eval(const struct colorNode *node, const struct hitRecord *r
 	return ((struct constantTexture *)node)->color;
 }
 
+static uint8_t compile(const struct colorNode *node, struct nodeCompiler *compiler) {
+	return emitConstant(compiler, (union nodeRegister){ .c = ((struct constantTexture *)node)->color });
+}
+
 const struct colorNode *newConstantTexture(const struct world *world, const struct color color) {
 	HASH_CONS(world->nodeTable, hash, struct constantTexture, {
 		.color = color,
 		.node = {
 			.eval = eval,
+			.compile = compile,
 			.base = { .compare = compare }
 		}
 	});
@@ -9,7 +9,6 @@
 #include "../../includes.h"
 #include "../../datatypes/color.h"
 #include "../../datatypes/poly.h"
-#include "../../datatypes/vertexbuffer.h"
 #include "../../utils/assert.h"
 #include "../../datatypes/image/texture.h"
 #include "../../utils/mempool.h"
@@ -18,6 +17,8 @@
 #include "../../datatypes/scene.h"
 #include "../colornode.h"
 
+#include "../compiler.h"
+
 #include "image.h"
 
 struct imageTexture {
@@ -38,12 +39,8 @@ struct color internalColor(const struct texture *tex, const struct hitRecord *is
 		float y = isect->uv.y * tex->height;
 		output = textureGetPixel(tex, x, y, false);
 	} else {
-		output = textureGetPixel(tex, isect->uv.x, isect->uv.y, true);
+		output = textureGetPixelLod(tex, isect->uv.x, isect->uv.y, isect->footprint);
 	}
-	
-	//Since the texture is probably srgb, transform it back to linear colorspace for rendering
-	//FIXME: Why is this done during rendering?
-	if (options & SRGB_TRANSFORM) output = fromSRGB(output);
 	return output;
 }
 
@@ -62,11 +59,15 @@ static uint32_t hash(const void *p) {
 }
 
 static struct color eval(const struct colorNode *node, const struct hitRecord *record) {
-	// TODO: Consider transforming image textures while loading textures.
 	struct imageTexture *image = (struct imageTexture *)node;
 	return internalColor(image->tex, record, image->options);
 }
 
+static uint8_t compile(const struct colorNode *node, struct nodeCompiler *compiler) {
+	struct imageTexture *image = (struct imageTexture *)node;
+	return emitOp(compiler, (struct nodeOp){ .code = OpImage, .aux = image->options, .data = image->tex });
+}
+
 const struct colorNode *newImageTexture(const struct world *world, const struct texture *texture, uint8_t options) {
 	if (!texture) return NULL;
 	HASH_CONS(world->nodeTable, hash, struct imageTexture, {
@@ -74,7 +75,12 @@ const struct colorNode *newImageTexture(const struct world *world, const struct
 		.options = options,
 		.node = {
 			.eval = eval,
+			.compile = compile,
 			.base = { .compare = compare }
 		}
 	});
 }
+
+const struct texture *getImageTexture(const struct colorNode *node) {
+	return node && node->eval == eval ? ((const struct imageTexture *)node)->tex : NULL;
+}
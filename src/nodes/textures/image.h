@@ -8,8 +8,12 @@
 
 #pragma once
 
-//FIXME: These are opposite states, which is kinda confusing.
-#define SRGB_TRANSFORM 0x01
 #define NO_BILINEAR    0x02
 
+/// Look up a texture at the hit uv, like an image texture node with these options
+struct color internalColor(const struct texture *tex, const struct hitRecord *isect, uint8_t options);
+
 const struct colorNode *newImageTexture(const struct world *world, const struct texture *texture, uint8_t options);
+
+/// @return The texture an image texture node samples from, or NULL if node is some other kind of node
+const struct texture *getImageTexture(const struct colorNode *node);
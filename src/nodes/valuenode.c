@@ -13,6 +13,8 @@
 #include "../datatypes/scene.h"
 #include "../utils/hashtable.h"
 
+#include "compiler.h"
+
 #include "valuenode.h"
 
 struct constantValue {
@@ -39,12 +41,23 @@ static float eval(const struct valueNode *node, const struct hitRecord *record)
 	return this->value;
 }
 
+static uint8_t compile(const struct valueNode *node, struct nodeCompiler *compiler) {
+	return emitConstant(compiler, (union nodeRegister){ .f = ((struct constantValue *)node)->value });
+}
+
 const struct valueNode *newConstantValue(const struct world *world, float value) {
 	HASH_CONS(world->nodeTable, hash, struct constantValue, {
 		.value = value,
 		.node = {
 			.eval = eval,
+			.compile = compile,
 			.base = { .compare = compare }
 		}
 	});
 }
+
+bool getConstantValue(const struct valueNode *node, float *value) {
+	if (!node || node->eval != eval) return false;
+	*value = ((const struct constantValue *)node)->value;
+	return true;
+}
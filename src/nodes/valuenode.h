@@ -13,6 +13,8 @@
 struct valueNode {
 	struct nodeBase base;
 	float (*eval)(const struct valueNode *node, const struct hitRecord *record);
+	// Emit instructions computing this node, returning the result register. NULL if it can only be called through eval().
+	uint8_t (*compile)(const struct valueNode *node, struct nodeCompiler *compiler);
 };
 
 #include "input/fresnel.h"
@@ -21,3 +23,6 @@ struct valueNode {
 #include "converter/math.h"
 
 const struct valueNode *newConstantValue(const struct world *world, float value);
+
+/// @return true if node is a constant value, and populates value with it
+bool getConstantValue(const struct valueNode *node, float *value);
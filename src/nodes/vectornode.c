@@ -15,6 +15,8 @@
 #include "../utils/hashtable.h"
 #include "bsdfnode.h"
 
+#include "compiler.h"
+
 #include "vectornode.h"
 
 struct constantVector {
@@ -41,11 +43,16 @@ static struct vectorValue eval(const struct vectorNode *node, const struct hitRe
 	return (struct vectorValue){ .v = this->vector };
 }
 
+static uint8_t compile(const struct vectorNode *node, struct nodeCompiler *compiler) {
+	return emitConstant(compiler, (union nodeRegister){ .v = { .v = ((struct constantVector *)node)->vector } });
+}
+
 const struct vectorNode *newConstantVector(const struct world *world, const struct vector vector) {
 	HASH_CONS(world->nodeTable, hash, struct constantVector, {
 		.vector = vector,
 		.node = {
 			.eval = eval,
+			.compile = compile,
 			.base = { .compare = compare }
 		}
 	});
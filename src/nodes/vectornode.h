@@ -19,6 +19,8 @@ struct vectorValue {
 struct vectorNode {
 	struct nodeBase base;
 	struct vectorValue (*eval)(const struct vectorNode *node, const struct hitRecord *record);
+	// Emit instructions computing this node, returning the result register. NULL if it can only be called through eval().
+	uint8_t (*compile)(const struct vectorNode *node, struct nodeCompiler *compiler);
 };
 
 #include "input/normal.h"
@@ -0,0 +1,612 @@
+//
+//  lights.c
+//  C-ray
+//
+//  Created by Valtteri Koskivuori on 18/10/2026.
+//  Copyright © 2026 Valtteri Koskivuori. All rights reserved.
+//
+
+#include "../includes.h"
+#include "lights.h"
+
+#include <float.h>
+#include "../datatypes/scene.h"
+#include "../datatypes/instance.h"
+#include "../datatypes/mesh.h"
+#include "../datatypes/poly.h"
+#include "../datatypes/sphere.h"
+#include "../datatypes/bbox.h"
+#include "../datatypes/hitrecord.h"
+#include "../datatypes/transforms.h"
+#include "../accelerators/bvh.h"
+#include "../nodes/bsdfnode.h"
+#include "../nodes/shaders/background.h"
+#include "../utils/logging.h"
+
+enum lightType {
+	lightTypeTriangle,
+	lightTypeSphere,
+	lightTypeEnvironment
+};
+
+// Bounds the normals of a set of emitters: every normal is within theta of axis, or of -axis,
+// since emitters in c-ray are two-sided.
+struct cone {
+	struct vector axis;
+	float cosTheta, sinTheta;
+};
+
+static const struct cone fullCone = { .axis = { 0.0f, 1.0f, 0.0f }, .cosTheta = 0.0f, .sinTheta = 1.0f };
+
+// Largest float below 1, so remapped samples stay in [0, 1)
+static const float oneMinusEpsilon = 0.99999994f;
+
+struct light {
+	enum lightType type;
+	int instIndex;
+	const struct poly *polygon;
+	// Triangles, in world space
+	struct vector v0, e1, e2;
+	struct vector normal;
+	float area;
+	// Spheres, in world space
+	struct vector center;
+	float radius;
+	// For the light tree
+	struct boundingBox bounds;
+	struct cone cone;
+	float power;
+	// Path from the root of the tree to the leaf this light is in, one bit per level, set for right children
+	uint64_t path;
+};
+
+// Mirrors the BVH built over the light bounds, with the power and orientation of each subtree
+struct lightNode {
+	struct boundingBox bounds;
+	struct cone cone;
+	float power;
+	unsigned first; // First child for inner nodes, first entry in leafLights for leaves
+	unsigned count; // Lights in a leaf, 0 for inner nodes
+};
+
+struct instanceLights {
+	const struct poly *polygons; // NULL for spheres
+	int *lights; // Light index per polygon, -1 if it doesn't emit. NULL for instances without lights.
+};
+
+struct lightList {
+	struct light *lights;
+	size_t count;
+	int environment; // Index of the environment light, or -1. Always the last light.
+	float environmentProbability;
+	struct environmentMap *environmentMap;
+	// Tree over all the other lights
+	struct lightNode *nodes;
+	int *leafLights;
+	// Per instance, to find the light a path hit
+	struct instanceLights *instances;
+	int instanceCount;
+};
+
+static struct color emittedRadiance(const struct hitRecord *record) {
+	return addColors(record->material->emission, bsdfEmission(record->material->bsdf, record));
+}
+
+static bool isEmissive(const struct material *material) {
+	return luminance(material->emission) > 0.0f || material->bsdf->emission;
+}
+
+static void appendLight(struct lightList *list, size_t *capacity, struct light light) {
+	if (list->count == *capacity) {
+		*capacity = *capacity ? *capacity * 2 : 16;
+		list->lights = realloc(list->lights, *capacity * sizeof(*list->lights));
+	}
+	list->lights[list->count++] = light;
+}
+
+// Textures may vary across a light, so its radiance is averaged over a few points spread out over it.
+// Ones that look black at every point still get a little power, in case the points missed the parts that emit.
+static const float minEmitterRadiance = 1e-3f;
+
+// Barycentric coordinates along e1 and e2: the centroid, and points towards each corner and edge
+static const struct coord triangleSamples[] = {
+	{ 1.0f / 3.0f, 1.0f / 3.0f },
+	{ 1.0f / 6.0f, 1.0f / 6.0f }, { 2.0f / 3.0f, 1.0f / 6.0f }, { 1.0f / 6.0f, 2.0f / 3.0f },
+	{ 5.0f / 12.0f, 1.0f / 6.0f }, { 1.0f / 6.0f, 5.0f / 12.0f }, { 5.0f / 12.0f, 5.0f / 12.0f }
+};
+
+static float estimateTrianglePower(const struct mesh *mesh, const struct poly *p, const struct light *light) {
+	const size_t sampleCount = sizeof(triangleSamples) / sizeof(*triangleSamples);
+	const bool mapped = mesh->textureCoordCount && p->hasTexCoords;
+	float sum = 0.0f;
+	for (size_t i = 0; i < sampleCount; ++i) {
+		const struct coord b = triangleSamples[i];
+		struct hitRecord record = {
+			.material = &mesh->materials[p->materialIndex],
+			.hitPoint = vecAdd(light->v0, vecAdd(vecScale(light->e1, b.x), vecScale(light->e2, b.y))),
+			.surfaceNormal = light->normal,
+			.polygon = (struct poly *)p,
+			.uv = { 0.5f, 0.5f }
+		};
+		if (mapped) {
+			record.uv = addCoords(addCoords(coordScale(1.0f - b.x - b.y, meshTexCoord(mesh, p, 0)), coordScale(b.x, meshTexCoord(mesh, p, 1))), coordScale(b.y, meshTexCoord(mesh, p, 2)));
+		}
+		record.incident = (struct lightRay){ .start = vecAdd(record.hitPoint, light->normal), .direction = vecNegate(light->normal) };
+		sum += luminance(emittedRadiance(&record));
+	}
+	return max(sum / sampleCount, minEmitterRadiance) * light->area * PI;
+}
+
+static void collectTriangles(struct lightList *list, size_t *capacity, const struct instance *instance, int instIndex) {
+	const struct mesh *mesh = instance->object;
+	for (int i = 0; i < mesh->polyCount; ++i) {
+		const struct poly *p = &mesh->polygons[i];
+		if (!isEmissive(&mesh->materials[p->materialIndex])) continue;
+		struct vector v[3];
+		for (int j = 0; j < 3; ++j) {
+			v[j] = mesh->vertices[p->vertexIndex[j]];
+			transformPoint(&v[j], &instance->composite.A);
+		}
+		struct light light = {
+			.type = lightTypeTriangle,
+			.instIndex = instIndex,
+			.polygon = p,
+			.v0 = v[0],
+			.e1 = vecSub(v[1], v[0]),
+			.e2 = vecSub(v[2], v[0])
+		};
+		const struct vector n = vecCross(light.e1, light.e2);
+		const float length = vecLength(n);
+		if (length <= 0.0f) continue;
+		light.area = 0.5f * length;
+		light.normal = vecScale(n, 1.0f / length);
+		light.power = estimateTrianglePower(mesh, p, &light);
+		light.bounds = emptyBBox;
+		for (int j = 0; j < 3; ++j) {
+			light.bounds.min = vecMin(light.bounds.min, v[j]);
+			light.bounds.max = vecMax(light.bounds.max, v[j]);
+		}
+		light.cone = (struct cone){ .axis = light.normal, .cosTheta = 1.0f, .sinTheta = 0.0f };
+		struct instanceLights *lookup = &list->instances[instIndex];
+		if (!lookup->lights) {
+			lookup->polygons = mesh->polygons;
+			lookup->lights = malloc(mesh->polyCount * sizeof(*lookup->lights));
+			for (int j = 0; j < mesh->polyCount; ++j) lookup->lights[j] = -1;
+		}
+		lookup->lights[i] = (int)list->count;
+		appendLight(list, capacity, light);
+	}
+}
+
+static float axisScale(const struct matrix4x4 *m, int axis) {
+	return sqrtf(m->mtx[0][axis] * m->mtx[0][axis] + m->mtx[1][axis] * m->mtx[1][axis] + m->mtx[2][axis] * m->mtx[2][axis]);
+}
+
+// The axes and the diagonals between them
+static const struct vector sphereSamples[] = {
+	{ 1.0f, 0.0f, 0.0f }, { -1.0f, 0.0f, 0.0f }, { 0.0f, 1.0f, 0.0f }, { 0.0f, -1.0f, 0.0f }, { 0.0f, 0.0f, 1.0f }, { 0.0f, 0.0f, -1.0f },
+	{ 1.0f, 1.0f, 1.0f }, { 1.0f, 1.0f, -1.0f }, { 1.0f, -1.0f, 1.0f }, { 1.0f, -1.0f, -1.0f },
+	{ -1.0f, 1.0f, 1.0f }, { -1.0f, 1.0f, -1.0f }, { -1.0f, -1.0f, 1.0f }, { -1.0f, -1.0f, -1.0f }
+};
+
+static float estimateSpherePower(const struct material *material, const struct light *light) {
+	const size_t sampleCount = sizeof(sphereSamples) / sizeof(*sphereSamples);
+	float sum = 0.0f;
+	for (size_t i = 0; i < sampleCount; ++i) {
+		const struct vector normal = vecNormalize(sphereSamples[i]);
+		// Same mapping as sphere hits get
+		const float phi = atan2f(normal.z, normal.x);
+		const float theta = asinf(normal.y);
+		struct hitRecord record = {
+			.material = material,
+			.hitPoint = vecAdd(light->center, vecScale(normal, light->radius)),
+			.surfaceNormal = normal,
+			.uv = { 1.0f - (phi + PI) / (2.0f * PI), (theta + PI / 2.0f) / PI },
+			.incident = { .start = vecAdd(light->center, vecScale(normal, 2.0f * light->radius)), .direction = vecNegate(normal) }
+		};
+		sum += luminance(emittedRadiance(&record));
+	}
+	return max(sum / sampleCount, minEmitterRadiance) * 4.0f * PI * light->radius * light->radius * PI;
+}
+
+static void collectSphere(struct lightList *list, size_t *capacity, const struct instance *instance, int instIndex) {
+	const struct sphere *sphere = instance->object;
+	if (!isEmissive(&sphere->material)) return;
+	// Sampling is done in world space, which only works out if the sphere stays a sphere.
+	// Non-uniformly scaled ones are still found by BSDF sampling.
+	const float sx = axisScale(&instance->composite.A, 0);
+	const float sy = axisScale(&instance->composite.A, 1);
+	const float sz = axisScale(&instance->composite.A, 2);
+	if (fabsf(sx - sy) > 1e-4f * sx || fabsf(sx - sz) > 1e-4f * sx) {
+		logr(debug, "Skipping non-uniformly scaled emissive sphere %i\n", instIndex);
+		return;
+	}
+	struct light light = {
+		.type = lightTypeSphere,
+		.instIndex = instIndex,
+		.center = vecZero(),
+		.radius = sphere->radius * sx
+	};
+	transformPoint(&light.center, &instance->composite.A);
+	light.power = estimateSpherePower(&sphere->material, &light);
+	const struct vector extent = { light.radius, light.radius, light.radius };
+	light.bounds = (struct boundingBox){ vecSub(light.center, extent), vecAdd(light.center, extent) };
+	light.cone = fullCone;
+	list->instances[instIndex].lights = malloc(sizeof(*list->instances[instIndex].lights));
+	list->instances[instIndex].lights[0] = (int)list->count;
+	appendLight(list, capacity, light);
+}
+
+// The environment is importance sampled from a tabulated copy. Its power is scaled by the
+// cross section of the scene, so it's roughly comparable to the local lights.
+static void collectEnvironment(struct lightList *list, size_t *capacity, const struct world *scene) {
+	list->environmentMap = newEnvironmentMap(scene->background);
+	if (!list->environmentMap) return;
+	float radius = 1.0f;
+	if (scene->topLevel && scene->instanceCount) {
+		const struct boundingBox bounds = getRootBoundingBox(scene->topLevel);
+		radius = max(0.5f * vecLength(vecSub(bounds.max, bounds.min)), 1e-3f);
+	}
+	const float average = environmentMapPower(list->environmentMap) / (4.0f * PI);
+	list->environment = (int)list->count;
+	appendLight(list, capacity, (struct light){ .type = lightTypeEnvironment, .instIndex = -1, .power = average * PI * PI * radius * radius });
+}
+
+// Smallest cone that contains both a and b
+static struct cone coneUnion(const struct cone *a, const struct cone *b) {
+	if (a->cosTheta <= 0.0f || b->cosTheta <= 0.0f) return fullCone;
+	// Normals point both ways, so b can be flipped to face a
+	const struct vector bAxis = vecDot(a->axis, b->axis) < 0.0f ? vecNegate(b->axis) : b->axis;
+	const float thetaA = acosf(a->cosTheta);
+	const float thetaB = acosf(b->cosTheta);
+	const float thetaD = acosf(min(vecDot(a->axis, bAxis), 1.0f));
+	if (thetaD + thetaB <= thetaA) return *a;
+	if (thetaD + thetaA <= thetaB) return (struct cone){ bAxis, b->cosTheta, b->sinTheta };
+	const float theta = 0.5f * (thetaA + thetaD + thetaB);
+	if (theta >= 0.5f * PI) return fullCone;
+	// Rotate a's axis towards b's, so the new cone just touches the far edges of both
+	const struct vector perpendicular = vecSub(bAxis, vecScale(a->axis, vecDot(a->axis, bAxis)));
+	const float length = vecLength(perpendicular);
+	if (length < 1e-6f) return fullCone;
+	const float rotation = theta - thetaA;
+	const struct vector axis = vecAdd(vecScale(a->axis, cosf(rotation)), vecScale(perpendicular, sinf(rotation) / length));
+	return (struct cone){ vecNormalize(axis), cosf(theta), sinf(theta) };
+}
+
+static void getLightBBoxAndCenter(void *userData, unsigned i, struct boundingBox *bbox, struct vector *center) {
+	const struct light *lights = userData;
+	*bbox = lights[i].bounds;
+	*center = bboxCenter(bbox);
+}
+
+static void assignPaths(struct lightList *list, unsigned nodeIndex, uint64_t path, unsigned depth) {
+	const struct lightNode *node = &list->nodes[nodeIndex];
+	if (node->count) {
+		for (unsigned i = 0; i < node->count; ++i) list->lights[list->leafLights[node->first + i]].path = path;
+		return;
+	}
+	assignPaths(list, node->first, path, depth + 1);
+	assignPaths(list, node->first + 1, path | (1ull << depth), depth + 1);
+}
+
+// Importance is bounded with the bounding sphere of a node, so it's the sphere that should stay small.
+// Surface area can't tell split axes apart for flat sets of lights, and ends up slicing them into long strips.
+static float boundingSphereCost(const struct boundingBox *bbox) {
+	return vecLengthSquared(vecSub(bbox->max, bbox->min));
+}
+
+// The spatial split comes from the regular binned BVH builder. Power and orientation are then summed up the tree.
+static void buildLightTree(struct lightList *list, size_t localCount) {
+	if (!localCount) return;
+	struct bvh *bvh = buildBvhGeneric(list->lights, getLightBBoxAndCenter, boundingSphereCost, (unsigned)localCount);
+	const unsigned nodeCount = getBvhNodeCount(bvh);
+	list->nodes = malloc(nodeCount * sizeof(*list->nodes));
+	list->leafLights = malloc(localCount * sizeof(*list->leafLights));
+	for (unsigned i = 0; i < localCount; ++i) list->leafLights[i] = getBvhPrimIndex(bvh, i);
+	// Children are always stored after their parents, so walking backwards visits them first
+	for (unsigned i = nodeCount; i-- > 0;) {
+		struct lightNode *node = &list->nodes[i];
+		unsigned primCount = 0;
+		const bool isLeaf = getBvhNode(bvh, i, &node->bounds, &node->first, &primCount);
+		node->count = isLeaf ? primCount : 0;
+		if (isLeaf) {
+			node->cone = list->lights[list->leafLights[node->first]].cone;
+			node->power = 0.0f;
+			for (unsigned j = 0; j < node->count; ++j) {
+				const struct light *light = &list->lights[list->leafLights[node->first + j]];
+				node->cone = coneUnion(&node->cone, &light->cone);
+				node->power += light->power;
+			}
+		} else {
+			const struct lightNode *left = &list->nodes[node->first];
+			const struct lightNode *right = &list->nodes[node->first + 1];
+			node->cone = coneUnion(&left->cone, &right->cone);
+			node->power = left->power + right->power;
+		}
+	}
+	destroyBvh(bvh);
+	assignPaths(list, 0, 0, 0);
+}
+
+struct lightList *newLightList(const struct world *scene) {
+	struct lightList *list = calloc(1, sizeof(*list));
+	list->environment = -1;
+	list->instanceCount = scene->instanceCount;
+	list->instances = calloc(scene->instanceCount ? scene->instanceCount : 1, sizeof(*list->instances));
+	size_t capacity = 0;
+	for (int i = 0; i < scene->instanceCount; ++i) {
+		if (isMesh(&scene->instances[i])) {
+			collectTriangles(list, &capacity, &scene->instances[i], i);
+		} else {
+			collectSphere(list, &capacity, &scene->instances[i], i);
+		}
+	}
+	collectEnvironment(list, &capacity, scene);
+
+	if (!list->count) {
+		destroyLightList(list);
+		return NULL;
+	}
+
+	const size_t localCount = list->environment < 0 ? list->count : list->count - 1;
+	double total = 0.0;
+	for (size_t i = 0; i < localCount; ++i) total += list->lights[i].power;
+	if (list->environment >= 0) {
+		const float environmentPower = list->lights[list->environment].power;
+		list->environmentProbability = (float)(environmentPower / (environmentPower + total));
+	}
+	buildLightTree(list, localCount);
+	return list;
+}
+
+// cos(max(0, a - b)) and sin(max(0, a - b)), for angles in [0, pi]
+static inline float cosSubClamped(float sinA, float cosA, float sinB, float cosB) {
+	return cosA > cosB ? 1.0f : cosA * cosB + sinA * sinB;
+}
+
+static inline float sinSubClamped(float sinA, float cosA, float sinB, float cosB) {
+	return cosA > cosB ? 0.0f : sinA * cosB - cosA * sinB;
+}
+
+// Conservative estimate of how much a cluster of lights contributes to a shading point, from
+// Conty Estevez & Kulla 2018, "Importance Sampling of Many Lights with Adaptive Tree Splitting".
+// The cosine at the receiver is bounded too, since every BSDF that light sampling can evaluate
+// only reflects into the hemisphere around the surface normal.
+static float importance(const struct boundingBox *bounds, const struct cone *cone, float power, struct vector point, struct vector normal) {
+	const struct vector toPoint = vecSub(point, bboxCenter(bounds));
+	const float distanceSquared = vecLengthSquared(toPoint);
+	const float radiusSquared = 0.25f * vecLengthSquared(vecSub(bounds->max, bounds->min));
+	// Inside the bounding sphere, so no angle can be bounded. The distance is clamped so lights right next to a point don't blow up.
+	if (distanceSquared <= radiusSquared) return power / max(distanceSquared, 0.25f * radiusSquared);
+	const struct vector toPointDir = vecScale(toPoint, 1.0f / sqrtf(distanceSquared));
+	// Half-angle the bounds subtend
+	const float sinU = sqrtf(radiusSquared / distanceSquared);
+	const float cosU = sqrtf(1.0f - sinU * sinU);
+	
+	// Emitter: angle from the cone to the point, minus the spread of the cone and the bounds. Cosine falloff past that.
+	const float cosTheta = fabsf(vecDot(cone->axis, toPointDir));
+	const float sinTheta = sqrtf(max(0.0f, 1.0f - cosTheta * cosTheta));
+	const float cosOutside = cosSubClamped(sinTheta, cosTheta, cone->sinTheta, cone->cosTheta);
+	const float sinOutside = sinSubClamped(sinTheta, cosTheta, cone->sinTheta, cone->cosTheta);
+	const float cosEmitter = cosSubClamped(sinOutside, cosOutside, sinU, cosU);
+	if (cosEmitter <= 0.0f) return 0.0f;
+	
+	// Receiver: same for the surface normal, nothing below the horizon counts
+	const float cosI = -vecDot(normal, toPointDir);
+	const float sinI = sqrtf(max(0.0f, 1.0f - cosI * cosI));
+	const float cosReceiver = cosSubClamped(sinI, cosI, sinU, cosU);
+	if (cosReceiver <= 0.0f) return 0.0f;
+	
+	return power * cosEmitter * cosReceiver / distanceSquared;
+}
+
+static inline float nodeImportance(const struct lightNode *node, struct vector point, struct vector normal) {
+	return importance(&node->bounds, &node->cone, node->power, point, normal);
+}
+
+static inline float lightImportance(const struct light *light, struct vector point, struct vector normal) {
+	return importance(&light->bounds, &light->cone, light->power, point, normal);
+}
+
+static float leafImportance(const struct lightList *list, const struct lightNode *leaf, struct vector point, struct vector normal) {
+	float total = 0.0f;
+	for (unsigned i = 0; i < leaf->count; ++i) total += lightImportance(&list->lights[list->leafLights[leaf->first + i]], point, normal);
+	return total;
+}
+
+// Walk down the tree, picking children proportionally to their importance and reusing u at each step
+// @return Index of the picked light, or -1 if nothing can reach this point
+static int pickLight(const struct lightList *list, struct vector point, struct vector normal, float u, float *pmf) {
+	const struct lightNode *node = &list->nodes[0];
+	while (!node->count) {
+		const struct lightNode *left = &list->nodes[node->first];
+		const float leftImportance = nodeImportance(left, point, normal);
+		const float rightImportance = nodeImportance(left + 1, point, normal);
+		if (leftImportance + rightImportance <= 0.0f) return -1;
+		const float leftProbability = leftImportance / (leftImportance + rightImportance);
+		if (u < leftProbability) {
+			u = min(u / leftProbability, oneMinusEpsilon);
+			*pmf *= leftProbability;
+			node = left;
+		} else {
+			u = min((u - leftProbability) / (1.0f - leftProbability), oneMinusEpsilon);
+			*pmf *= 1.0f - leftProbability;
+			node = left + 1;
+		}
+	}
+	const float total = leafImportance(list, node, point, normal);
+	if (total <= 0.0f) return -1;
+	const float target = u * total;
+	float running = 0.0f;
+	int picked = -1;
+	float pickedImportance = 0.0f;
+	for (unsigned i = 0; i < node->count && running <= target; ++i) {
+		const int idx = list->leafLights[node->first + i];
+		const float importance = lightImportance(&list->lights[idx], point, normal);
+		if (importance <= 0.0f) continue;
+		picked = idx;
+		pickedImportance = importance;
+		running += importance;
+	}
+	*pmf *= pickedImportance / total;
+	return picked;
+}
+
+// The probability of pickLight() returning a given light, found by retracing its path down the tree
+static float pickProbability(const struct lightList *list, const struct light *light, struct vector point, struct vector normal) {
+	const struct lightNode *node = &list->nodes[0];
+	uint64_t path = light->path;
+	float pmf = 1.0f;
+	while (!node->count) {
+		const struct lightNode *left = &list->nodes[node->first];
+		const float leftImportance = nodeImportance(left, point, normal);
+		const float rightImportance = nodeImportance(left + 1, point, normal);
+		if (leftImportance + rightImportance <= 0.0f) return 0.0f;
+		const bool right = path & 1;
+		pmf *= (right ? rightImportance : leftImportance) / (leftImportance + rightImportance);
+		node = right ? left + 1 : left;
+		path >>= 1;
+	}
+	const float total = leafImportance(list, node, point, normal);
+	if (total <= 0.0f) return 0.0f;
+	return pmf * lightImportance(light, point, normal) / total;
+}
+
+// Duff et al. 2017, "Building an Orthonormal Basis, Revisited"
+static inline struct base orthonormalBase(struct vector n) {
+	const float sign = copysignf(1.0f, n.z);
+	const float a = -1.0f / (sign + n.z);
+	const float b = n.x * n.y * a;
+	return (struct base){
+		.i = { 1.0f + sign * n.x * n.x * a, sign * b, -sign * n.x },
+		.j = { b, sign + n.y * n.y * a, -n.y },
+		.k = n
+	};
+}
+
+static inline float sphereConePdf(const struct light *light, struct vector point) {
+	const float distanceSquared = vecLengthSquared(vecSub(light->center, point));
+	const float radiusSquared = light->radius * light->radius;
+	if (distanceSquared <= radiusSquared) return 0.0f;
+	const float cosMax = sqrtf(max(0.0f, 1.0f - radiusSquared / distanceSquared));
+	return 1.0f / (2.0f * PI * (1.0f - cosMax));
+}
+
+bool sampleLight(const struct lightList *lights, struct vector point, struct vector normal, float u0, float u1, float u2, struct lightSample *sample) {
+	if (!lights) return false;
+	float pmf = 1.0f;
+	int idx = lights->environment;
+	if (u0 < lights->environmentProbability) {
+		pmf = lights->environmentProbability;
+	} else {
+		if (!lights->nodes) return false;
+		pmf = 1.0f - lights->environmentProbability;
+		u0 = min((u0 - lights->environmentProbability) / pmf, oneMinusEpsilon);
+		idx = pickLight(lights, point, normal, u0, &pmf);
+		if (idx < 0) return false;
+	}
+	const struct light *light = &lights->lights[idx];
+	sample->light = idx;
+	switch (light->type) {
+		case lightTypeTriangle: {
+			const float su = sqrtf(u1);
+			const struct vector onLight = vecAdd(light->v0, vecAdd(vecScale(light->e1, 1.0f - su), vecScale(light->e2, u2 * su)));
+			const struct vector toLight = vecSub(onLight, point);
+			const float distanceSquared = vecLengthSquared(toLight);
+			if (distanceSquared <= 0.0f) return false;
+			sample->distance = sqrtf(distanceSquared);
+			sample->direction = vecScale(toLight, 1.0f / sample->distance);
+			sample->distance *= 1.001f;
+			const float cosine = fabsf(vecDot(light->normal, sample->direction));
+			if (cosine < 1e-6f) return false;
+			sample->pdf = pmf * distanceSquared / (light->area * cosine);
+			return true;
+		}
+		case lightTypeSphere: {
+			// Sample the cone of directions the sphere covers
+			const struct vector toCenter = vecSub(light->center, point);
+			const float distanceSquared = vecLengthSquared(toCenter);
+			const float radiusSquared = light->radius * light->radius;
+			if (distanceSquared <= radiusSquared) return false;
+			const float cosMax = sqrtf(1.0f - radiusSquared / distanceSquared);
+			const float cosTheta = 1.0f - u1 * (1.0f - cosMax);
+			const float sinTheta = sqrtf(max(0.0f, 1.0f - cosTheta * cosTheta));
+			const float phi = 2.0f * PI * u2;
+			sample->distance = sqrtf(distanceSquared); // The near side is always closer than the center
+			const struct base base = orthonormalBase(vecScale(toCenter, 1.0f / sample->distance));
+			sample->direction = vecAdd(vecScale(base.k, cosTheta), vecAdd(vecScale(base.i, sinTheta * cosf(phi)), vecScale(base.j, sinTheta * sinf(phi))));
+			sample->pdf = pmf / (2.0f * PI * (1.0f - cosMax));
+			return true;
+		}
+		case lightTypeEnvironment: {
+			float pdf = 0.0f;
+			sample->direction = sampleEnvironmentMap(lights->environmentMap, u1, u2, &pdf);
+			if (pdf <= 0.0f) return false;
+			sample->pdf = pmf * pdf;
+			sample->distance = FLT_MAX;
+			return true;
+		}
+	}
+	return false;
+}
+
+bool lightHit(const struct lightList *lights, const struct lightSample *sample, const struct hitRecord *isect) {
+	const struct light *light = &lights->lights[sample->light];
+	switch (light->type) {
+		case lightTypeTriangle:
+			return isect->instIndex == light->instIndex && isect->polygon == light->polygon;
+		case lightTypeSphere:
+			return isect->instIndex == light->instIndex;
+		case lightTypeEnvironment:
+			return isect->instIndex < 0;
+	}
+	return false;
+}
+
+float lightPdf(const struct lightList *lights, struct vector point, struct vector normal, const struct hitRecord *isect) {
+	if (!lights || isect->instIndex < 0) return 0.0f;
+	const struct instanceLights *lookup = &lights->instances[isect->instIndex];
+	if (!lookup->lights) return 0.0f;
+	const int idx = isect->polygon ? lookup->lights[isect->polygon - lookup->polygons] : lookup->lights[0];
+	if (idx < 0) return 0.0f;
+	const struct light *light = &lights->lights[idx];
+	const float pmf = (1.0f - lights->environmentProbability) * pickProbability(lights, light, point, normal);
+	if (pmf <= 0.0f) return 0.0f;
+	switch (light->type) {
+		case lightTypeTriangle: {
+			const struct vector toLight = vecSub(isect->hitPoint, point);
+			const float distanceSquared = vecLengthSquared(toLight);
+			const float cosine = fabsf(vecDot(light->normal, toLight)) / sqrtf(distanceSquared);
+			if (cosine < 1e-6f) return 0.0f;
+			return pmf * distanceSquared / (light->area * cosine);
+		}
+		case lightTypeSphere:
+			return pmf * sphereConePdf(light, point);
+		case lightTypeEnvironment:
+			break;
+	}
+	return 0.0f;
+}
+
+float environmentPdf(const struct lightList *lights, struct vector direction) {
+	if (!lights || lights->environment < 0) return 0.0f;
+	return lights->environmentProbability * environmentMapPdf(lights->environmentMap, direction);
+}
+
+size_t lightCount(const struct lightList *lights) {
+	return lights ? lights->count : 0;
+}
+
+void destroyLightList(struct lightList *lights) {
+	if (lights) {
+		for (int i = 0; i < lights->instanceCount; ++i) {
+			free(lights->instances[i].lights);
+		}
+		free(lights->instances);
+		free(lights->lights);
+		free(lights->nodes);
+		free(lights->leafLights);
+		destroyEnvironmentMap(lights->environmentMap);
+		free(lights);
+	}
+}
@@ -0,0 +1,62 @@
+//
+//  lights.h
+//  C-ray
+//
+//  Created by Valtteri Koskivuori on 18/10/2026.
+//  Copyright © 2026 Valtteri Koskivuori. All rights reserved.
+//
+
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include "../datatypes/vector.h"
+
+struct world;
+struct hitRecord;
+struct lightList;
+
+struct lightSample {
+	struct vector direction; // Normalized, from the shading point towards the light
+	float pdf; // Solid angle pdf, including the probability of picking this light
+	float distance; // How far a shadow ray has to go to reach the light
+	int light;
+};
+
+/// Collect every emitter in a scene: emissive triangles, emissive spheres and the environment.
+/// Local lights are organized into a light tree, so the ones that matter at a given point can be found quickly.
+/// Needs the top-level BVH, since that's where the scene bounds come from.
+/// @param scene Scene to collect lights from
+/// @return A new light list, or NULL if nothing in the scene emits light
+struct lightList *newLightList(const struct world *scene);
+
+/// Pick a light proportionally to its estimated contribution at a point, and a direction towards it
+/// @param lights Light list, may be NULL
+/// @param point Shading point the direction is sampled for
+/// @param normal Surface normal at point. Lights below its horizon are never picked.
+/// @param u0 Uniform sample used to pick the light
+/// @param u1 Uniform sample for the position on the light
+/// @param u2 Uniform sample for the position on the light
+/// @param sample Populated with the sampled direction
+/// @return false if nothing could be sampled
+bool sampleLight(const struct lightList *lights, struct vector point, struct vector normal, float u0, float u1, float u2, struct lightSample *sample);
+
+/// Check whether a shadow ray cast for a light sample reached the light it was aimed at
+bool lightHit(const struct lightList *lights, const struct lightSample *sample, const struct hitRecord *isect);
+
+/// The pdf sampleLight() would have had for the direction from point to an emitter a path hit
+/// @param lights Light list, may be NULL
+/// @param point Shading point the path left from
+/// @param normal Surface normal at point
+/// @param isect Intersection with the emitter
+/// @return Solid angle pdf, or 0 if the emitter is not in the list
+float lightPdf(const struct lightList *lights, struct vector point, struct vector normal, const struct hitRecord *isect);
+
+/// Same as lightPdf(), for a path that escaped into the environment
+/// @param lights Light list, may be NULL
+/// @param direction Direction the path escaped in
+float environmentPdf(const struct lightList *lights, struct vector direction);
+
+size_t lightCount(const struct lightList *lights);
+
+void destroyLightList(struct lightList *lights);
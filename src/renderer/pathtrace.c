@@ -14,7 +14,6 @@
 #include "../datatypes/camera.h"
 #include "../accelerators/bvh.h"
 #include "../datatypes/image/texture.h"
-#include "../datatypes/vertexbuffer.h"
 #include "../datatypes/sphere.h"
 #include "../datatypes/poly.h"
 #include "../datatypes/mesh.h"
@@ -22,35 +21,111 @@
 #include "sky.h"
 #include "../datatypes/transforms.h"
 #include "../datatypes/instance.h"
+#include "lights.h"
 
-static inline struct hitRecord getClosestIsect(struct lightRay *incidentRay, const struct world *scene) {
-	struct hitRecord isect = { .incident = *incidentRay, .instIndex = -1, .distance = FLT_MAX, .polygon = NULL };
+static inline struct hitRecord getClosestIsect(struct lightRay *incidentRay, const struct world *scene, float maxDistance) {
+	struct hitRecord isect = { .incident = *incidentRay, .instIndex = -1, .distance = maxDistance, .polygon = NULL };
 	traverseTopLevelBvh(scene->instances, scene->topLevel, incidentRay, &isect);
 	return isect;
 }
 
-struct color pathTrace(const struct lightRay *incidentRay, const struct world *scene, int maxDepth, sampler *sampler) {
+// Fill in the closest hit, and scale its texture footprint to the ray cone that found it
+// @return Width of the ray cone at the hit
+static inline float resolveHit(const struct world *scene, struct hitRecord *isect, float spread, float width) {
+	const struct instance *instance = &scene->instances[isect->instIndex];
+	instance->resolveHitFn(instance, isect);
+	width += spread * vecLength(vecSub(isect->hitPoint, isect->incident.start));
+	isect->footprint *= width;
+	return width;
+}
+
+// Power heuristic with beta = 2, from Veach's thesis
+static inline float powerHeuristic(float pdf, float otherPdf) {
+	const float a = pdf * pdf;
+	const float b = otherPdf * otherPdf;
+	return a > 0.0f ? a / (a + b) : 0.0f;
+}
+
+static inline struct color emittedRadiance(const struct world *scene, const struct hitRecord *isect, sampler *sampler) {
+	if (isect->instIndex < 0) return scene->background->sample(scene->background, sampler, isect).color;
+	return addColors(isect->material->emission, bsdfEmission(isect->material->bsdf, isect));
+}
+
+// Ray cones only follow specular bounces exactly. Rough ones scatter paths over the whole lobe, so
+// widen the cone to roughly the angle a sample of it covers, and textures seen through them get blurred.
+static inline float scatteredSpread(float spread, float pdf) {
+	return pdf > 0.0f ? max(spread, 0.25f / sqrtf(pdf)) : spread;
+}
+
+// Next-event estimation: sample a light directly, and weight it against the odds of BSDF sampling finding it
+static inline struct color sampleDirect(const struct hitRecord *isect, const struct world *scene, sampler *sampler, uint64_t *rayCount, const enum samplerType type) {
+	const float u0 = getDimensionOf(sampler, type);
+	const float u1 = getDimensionOf(sampler, type);
+	const float u2 = getDimensionOf(sampler, type);
+	struct lightSample light;
+	if (!sampleLight(scene->lights, isect->hitPoint, isect->surfaceNormal, u0, u1, u2, &light)) return blackColor;
+	
+	const struct bsdfNode *bsdf = isect->material->bsdf;
+	const struct color f = bsdf->eval(bsdf, isect, light.direction);
+	if (luminance(f) <= 0.0f) return blackColor;
+	
+	struct lightRay shadowRay = { .start = isect->hitPoint, .direction = light.direction };
+	struct hitRecord shadow = getClosestIsect(&shadowRay, scene, light.distance);
+	(*rayCount)++;
+	if (!lightHit(scene->lights, &light, &shadow)) return blackColor;
+	if (shadow.instIndex >= 0) resolveHit(scene, &shadow, 0.0f, 0.0f);
+	
+	const float weight = powerHeuristic(light.pdf, bsdf->pdf(bsdf, isect, light.direction));
+	return colorCoef(weight / light.pdf, multiplyColors(f, emittedRadiance(scene, &shadow, sampler)));
+}
+
+// type is always a compile-time constant here, so each instantiation below gets its own sampler inlined.
+static inline struct color pathTraceWith(const struct lightRay *incidentRay, const struct world *scene, int maxDepth, sampler *sampler, uint64_t *rayCount, const enum samplerType type) {
 	struct color weight = whiteColor; // Current path weight
 	struct color finalColor = blackColor; // Final path contribution
 	struct lightRay currentRay = *incidentRay;
+	// BSDF pdf of the previous bounce. 0 for camera rays and specular bounces, since light sampling can't find those paths.
+	float lastPdf = 0.0f;
+	struct vector lastPoint = currentRay.start;
+	struct vector lastNormal = vecZero();
+	// Ray cone of the current ray, for picking texture mip levels. The lightRay itself is kept at 28 bytes,
+	// since past that GCC copies it with 256-bit moves that stall the SSE code in libm.
+	float spread = cameraPixelSpread(scene->camera);
+	float width = 0.0f;
 	
 	for (int depth = 0; depth < maxDepth; ++depth) {
-		const struct hitRecord isect = getClosestIsect(&currentRay, scene);
+		struct hitRecord isect = getClosestIsect(&currentRay, scene, FLT_MAX);
+		(*rayCount)++;
 		if (isect.instIndex < 0) {
-			finalColor = addColors(finalColor, multiplyColors(weight, scene->background->sample(scene->background, sampler, &isect).color));
+			const float misWeight = lastPdf > 0.0f ? powerHeuristic(lastPdf, environmentPdf(scene->lights, currentRay.direction)) : 1.0f;
+			finalColor = addColors(finalColor, colorCoef(misWeight, multiplyColors(weight, emittedRadiance(scene, &isect, sampler))));
 			break;
 		}
+		width = resolveHit(scene, &isect, spread, width);
+		
+		const struct color emission = emittedRadiance(scene, &isect, sampler);
+		if (luminance(emission) > 0.0f) {
+			const float misWeight = lastPdf > 0.0f ? powerHeuristic(lastPdf, lightPdf(scene->lights, lastPoint, lastNormal, &isect)) : 1.0f;
+			finalColor = addColors(finalColor, colorCoef(misWeight, multiplyColors(weight, emission)));
+		}
 		
-		finalColor = addColors(finalColor, multiplyColors(weight, isect.material.emission));
+		if (scene->lights) {
+			finalColor = addColors(finalColor, multiplyColors(weight, sampleDirect(&isect, scene, sampler, rayCount, type)));
+		}
 		
-		struct bsdfSample sample = isect.material.bsdf->sample(isect.material.bsdf, sampler, &isect);
+		struct bsdfSample sample = isect.material->bsdf->sample(isect.material->bsdf, sampler, &isect);
 		currentRay = (struct lightRay){ .start = isect.hitPoint, .direction = sample.out };
+		spread = scatteredSpread(spread, sample.pdf);
 		struct color attenuation = sample.color;
+		lastPdf = sample.pdf;
+		lastPoint = isect.hitPoint;
+		lastNormal = isect.surfaceNormal;
+		if (luminance(attenuation) <= 0.0f) break;
 		
 		float probability = 1.0f;
 		if (depth >= 4) {
 			probability = max(attenuation.red, max(attenuation.green, attenuation.blue));
-			if (getDimension(sampler) > probability)
+			if (getDimensionOf(sampler, type) > probability)
 				break;
 		}
 		
@@ -58,3 +133,31 @@ struct color pathTrace(const struct lightRay *incidentRay, const struct world *s
 	}
 	return finalColor;
 }
+
+#define PATHTRACER(type) \
+	static struct color pathTrace##type(const struct lightRay *incidentRay, const struct world *scene, int maxDepth, sampler *sampler, uint64_t *rayCount) { \
+		return pathTraceWith(incidentRay, scene, maxDepth, sampler, rayCount, type); \
+	}
+
+PATHTRACER(Halton)
+PATHTRACER(Hammersley)
+PATHTRACER(Random)
+PATHTRACER(Sobol)
+
+pathTracer getPathTracer(enum samplerType type) {
+	switch (type) {
+		case Halton:
+			return pathTraceHalton;
+		case Hammersley:
+			return pathTraceHammersley;
+		case Random:
+			return pathTraceRandom;
+		case Sobol:
+			return pathTraceSobol;
+	}
+	return pathTraceRandom;
+}
+
+struct color pathTrace(const struct lightRay *incidentRay, const struct world *scene, int maxDepth, sampler *sampler, uint64_t *rayCount) {
+	return getPathTracer(sampler->type)(incidentRay, scene, maxDepth, sampler, rayCount);
+}
@@ -21,4 +21,12 @@ struct world;
 /// @param scene Scene to cast the ray into
 /// @param maxDepth Maximum depth of path
 /// @param rng A random number generator. One per execution thread.
-struct color pathTrace(const struct lightRay *incidentRay, const struct world *scene, int maxDepth, sampler *sampler);
+/// @param rayCount Incremented by the amount of rays cast for this path
+struct color pathTrace(const struct lightRay *incidentRay, const struct world *scene, int maxDepth, sampler *sampler, uint64_t *rayCount);
+
+typedef struct color (*pathTracer)(const struct lightRay *incidentRay, const struct world *scene, int maxDepth, sampler *sampler, uint64_t *rayCount);
+
+/// Get pathTrace() specialized for a given sampler type. Render threads should look this up
+/// once instead of dispatching on the sampler type for every sample.
+/// @param type Sampler type the returned function will be called with
+pathTracer getPathTracer(enum samplerType type);
@@ -7,6 +7,7 @@
 //
 
 #include "../includes.h"
+#include <limits.h>
 
 #include "../datatypes/image/imagefile.h"
 #include "renderer.h"
@@ -20,7 +21,6 @@
 #include "../datatypes/image/texture.h"
 #include "../datatypes/mesh.h"
 #include "../datatypes/sphere.h"
-#include "../datatypes/vertexbuffer.h"
 #include "../utils/platform/thread.h"
 #include "../utils/platform/mutex.h"
 #include "samplers/sampler.h"
@@ -45,7 +45,18 @@ struct texture *renderFrame(struct renderer *r) {
 	bool threadsReduced = getSysCores() > r->prefs.threadCount;
 	
 	logr(info, "Rendering at %s%i%s x %s%i%s\n", KWHT, r->prefs.imageWidth, KNRM, KWHT, r->prefs.imageHeight, KNRM);
-	logr(info, "Rendering %s%i%s samples with %s%i%s bounces.\n", KBLU, r->prefs.sampleCount, KNRM, KGRN, r->prefs.bounces, KNRM);
+	bool timeLimited = r->prefs.timeLimit > 0;
+	if (timeLimited) {
+		char budget[64];
+		smartTime(r->prefs.timeLimit, budget);
+		if (r->prefs.sampleCount == INT_MAX) {
+			logr(info, "Rendering for %s%s%s with %s%i%s bounces.\n", KBLU, budget, KNRM, KGRN, r->prefs.bounces, KNRM);
+		} else {
+			logr(info, "Rendering for %s%s%s (up to %s%i%s samples) with %s%i%s bounces.\n", KBLU, budget, KNRM, KBLU, r->prefs.sampleCount, KNRM, KGRN, r->prefs.bounces, KNRM);
+		}
+	} else {
+		logr(info, "Rendering %s%i%s samples with %s%i%s bounces.\n", KBLU, r->prefs.sampleCount, KNRM, KGRN, r->prefs.bounces, KNRM);
+	}
 	logr(info, "Rendering with %s%d%s%s thread%s",
 		 KRED,
 		 r->prefs.fromSystem && !threadsReduced ? r->prefs.threadCount - 2 : r->prefs.threadCount,
@@ -53,7 +64,7 @@ struct texture *renderFrame(struct renderer *r) {
 		 KNRM,
 		 r->prefs.threadCount > 1 ? "s.\n" : ".\n");
 	
-	logr(info, "Pathtracing%s...\n", isSet("interactive") ? " iteratively" : "");
+	logr(info, "Pathtracing%s...\n", isSet("interactive") || timeLimited ? " iteratively" : "");
 	
 	r->state.isRendering = true;
 	r->state.renderAborted = false;
@@ -65,6 +76,7 @@ struct texture *renderFrame(struct renderer *r) {
 	int pauser = 0;
 	int ctr = 1;
 	bool interactive = isSet("interactive");
+	bool outOfTime = false;
 	
 	size_t remoteThreads = 0;
 	for (size_t i = 0; i < r->state.clientCount; ++i) {
@@ -85,7 +97,8 @@ struct texture *renderFrame(struct renderer *r) {
 	// Select the appropriate renderer type for local use
 	void *(*localRenderThread)(void *) = renderThread;
 	// Iterative mode is incompatible with network rendering at the moment
-	if (interactive && !r->state.clients) localRenderThread = renderThreadInteractive;
+	// Time-limited renders also run pass-wise, so the image converges evenly until the deadline.
+	if ((interactive || timeLimited) && !r->state.clients) localRenderThread = renderThreadInteractive;
 	
 	//Create render threads (Nonblocking)
 	for (int t = 0; t < r->prefs.threadCount; ++t) {
@@ -133,15 +146,24 @@ struct texture *renderFrame(struct renderer *r) {
 			for (int t = 0; t < localThreadCount; ++t) {
 				completedSamples += r->state.threadStates[t].totalSamples;
 			}
-			uint64_t remainingTileSamples = (r->state.tileCount * r->prefs.sampleCount) - completedSamples;
+			uint64_t totalTileSamples = (uint64_t)r->state.tileCount * (uint64_t)r->prefs.sampleCount;
+			uint64_t remainingTileSamples = totalTileSamples > completedSamples ? totalTileSamples - completedSamples : 0;
 			uint64_t msecTillFinished = 0.001f * (avgTimePerTilePass * remainingTileSamples);
 			float sps = (1000000.0f / usPerRay) * (r->prefs.threadCount + remoteThreads);
 			char rem[64];
-			smartTime((msecTillFinished) / (r->prefs.threadCount + remoteThreads), rem);
+			float progress = 0.0f;
+			if (timeLimited) {
+				unsigned long elapsed = (unsigned long)getMs(*r->state.timer);
+				smartTime(elapsed < r->prefs.timeLimit ? r->prefs.timeLimit - elapsed : 0, rem);
+				progress = ((float)elapsed / (float)r->prefs.timeLimit) * 100.0f;
+			} else {
+				smartTime((msecTillFinished) / (r->prefs.threadCount + remoteThreads), rem);
+				progress = interactive ? ((float)r->state.finishedPasses / (float)r->prefs.sampleCount) * 100.0f :
+										 ((float)r->state.finishedTileCount / (float)r->state.tileCount) * 100.0f;
+			}
 			logr(info, "[%s%.0f%%%s] μs/path: %.02f, etf: %s, %.02lfMs/s %s        \r",
 				 KBLU,
-				 interactive ? ((float)r->state.finishedPasses / (float)r->prefs.sampleCount) * 100.0f :
-							   ((float)r->state.finishedTileCount / (float)r->state.tileCount) * 100.0f,
+				 progress > 100.0f ? 100.0f : progress,
 				 KNRM,
 				 usPerRay,
 				 rem,
@@ -162,6 +184,12 @@ struct texture *renderFrame(struct renderer *r) {
 				r->state.isRendering = false;
 			}
 		}
+		
+		//Out of time. Threads finish the tile they're on and exit.
+		if (timeLimited && (unsigned long)getMs(*r->state.timer) >= r->prefs.timeLimit) {
+			r->state.isRendering = false;
+			outOfTime = true;
+		}
 		sleepMSec(r->state.threadStates[0].paused ? paused_msec : active_msec);
 	}
 	
@@ -170,6 +198,21 @@ struct texture *renderFrame(struct renderer *r) {
 		threadWait(&r->state.threads[t]);
 	}
 	free(checkedThreads);
+	
+	// Pass-wise rendering hands out a pass at a time, so every pass before the
+	// current one has been fully rendered. Tiles of the pass that was in flight
+	// when we stopped may have one extra sample.
+	if (localRenderThread == renderThreadInteractive) {
+		r->state.completedSamples = r->state.finishedPasses - 1;
+	} else {
+		r->state.completedSamples = r->prefs.sampleCount;
+	}
+	if (outOfTime) {
+		logr(info, "Time limit reached, rendered %s%i%s samples.\n", KBLU, r->state.completedSamples, KNRM);
+		if (!r->state.completedSamples) {
+			logr(warning, "Time limit was too short to render a full pass, image is incomplete.\n");
+		}
+	}
 	return output;
 }
 
@@ -179,7 +222,8 @@ void *renderThreadInteractive(void *arg) {
 	struct renderThreadState *threadState = (struct renderThreadState*)threadUserData(arg);
 	struct renderer *r = threadState->renderer;
 	struct texture *image = threadState->output;
-	sampler *sampler = newSampler();
+	sampler sampler = {0};
+	const pathTracer trace = getPathTracer(r->prefs.sampler);
 	
 	//First time setup for each thread
 	struct renderTile tile = nextTile(r);
@@ -189,7 +233,7 @@ void *renderThreadInteractive(void *arg) {
 	
 	threadState->completedSamples = 1;
 	
-	while (r->state.finishedPasses < r->prefs.sampleCount && r->state.isRendering) {
+	while (r->state.finishedPasses <= r->prefs.sampleCount && r->state.isRendering) {
 		long totalUsec = 0;
 		
 		startTimer(&timer);
@@ -197,11 +241,11 @@ void *renderThreadInteractive(void *arg) {
 			for (int x = tile.begin.x; x < tile.end.x; ++x) {
 				if (r->state.renderAborted) return 0;
 				uint32_t pixIdx = (uint32_t)(y * image->width + x);
-				initSampler(sampler, Halton, r->state.finishedPasses, r->prefs.sampleCount, pixIdx);
+				initSampler(&sampler, r->prefs.sampler, r->state.finishedPasses - 1, r->prefs.sampleCount, pixIdx);
 				
 				struct color output = textureGetPixel(r->state.renderBuffer, x, y, false);
-				struct lightRay incidentRay = getCameraRay(r->scene->camera, x, y, sampler);
-				struct color sample = pathTrace(&incidentRay, r->scene, r->prefs.bounces, sampler);
+				struct lightRay incidentRay = getCameraRay(r->scene->camera, x, y, &sampler);
+				struct color sample = trace(&incidentRay, r->scene, r->prefs.bounces, &sampler, &threadState->totalRays);
 				
 				//And process the running average
 				output = colorCoef((float)(r->state.finishedPasses - 1), output);
@@ -236,7 +280,6 @@ void *renderThreadInteractive(void *arg) {
 		tile = nextTileInteractive(r);
 		threadState->currentTileNum = tile.tileNum;
 	}
-	destroySampler(sampler);
 	//No more tiles to render, exit thread. (render done)
 	threadState->threadComplete = true;
 	threadState->currentTileNum = -1;
@@ -253,7 +296,8 @@ void *renderThread(void *arg) {
 	struct renderThreadState *threadState = (struct renderThreadState*)threadUserData(arg);
 	struct renderer *r = threadState->renderer;
 	struct texture *image = threadState->output;
-	sampler *sampler = newSampler();
+	sampler sampler = {0};
+	const pathTracer trace = getPathTracer(r->prefs.sampler);
 	
 	//First time setup for each thread
 	struct renderTile tile = nextTile(r);
@@ -272,11 +316,11 @@ void *renderThread(void *arg) {
 				for (int x = tile.begin.x; x < tile.end.x; ++x) {
 					if (r->state.renderAborted) return 0;
 					uint32_t pixIdx = (uint32_t)(y * image->width + x);
-					initSampler(sampler, Random, threadState->completedSamples - 1, r->prefs.sampleCount, pixIdx);
+					initSampler(&sampler, r->prefs.sampler, threadState->completedSamples - 1, r->prefs.sampleCount, pixIdx);
 					
 					struct color output = textureGetPixel(r->state.renderBuffer, x, y, false);
-					struct lightRay incidentRay = getCameraRay(r->scene->camera, x, y, sampler);
-					struct color sample = pathTrace(&incidentRay, r->scene, r->prefs.bounces, sampler);
+					struct lightRay incidentRay = getCameraRay(r->scene->camera, x, y, &sampler);
+					struct color sample = trace(&incidentRay, r->scene, r->prefs.bounces, &sampler, &threadState->totalRays);
 					
 					//And process the running average
 					output = colorCoef((float)(threadState->completedSamples - 1), output);
@@ -313,7 +357,6 @@ void *renderThread(void *arg) {
 		tile = nextTile(r);
 		threadState->currentTileNum = tile.tileNum;
 	}
-	destroySampler(sampler);
 	//No more tiles to render, exit thread. (render done)
 	threadState->threadComplete = true;
 	threadState->currentTileNum = -1;
@@ -328,10 +371,6 @@ struct renderer *newRenderer() {
 	
 	r->state.timer = calloc(1, sizeof(*r->state.timer));
 	
-	if (!g_vertices) {
-		allocVertexBuffers();
-	}
-	
 	//Mutex
 	r->state.tileMutex = createMutex();
 	return r;
@@ -342,7 +381,6 @@ void destroyRenderer(struct renderer *r) {
 		destroyScene(r->scene);
 		destroyTexture(r->state.renderBuffer);
 		destroyTexture(r->state.uiBuffer);
-		destroyVertexBuffers();
 		free(r->state.timer);
 		free(r->state.renderTiles);
 		free(r->state.threads);
@@ -10,6 +10,7 @@
 
 #include "../datatypes/tile.h" // For renderOrder
 #include "../datatypes/image/imagefile.h"
+#include "samplers/sampler.h" // For samplerType
 
 struct renderThreadState {
 	int thread_num;
@@ -22,6 +23,7 @@ struct renderThreadState {
 	int completedSamples;
 	
 	uint64_t totalSamples;
+	uint64_t totalRays;
 	
 	long avgSampleTime; //Single tile pass
 	
@@ -36,6 +38,7 @@ struct state {
 	int tileCount; //Total amount of render tiles
 	int finishedTileCount;
 	int finishedPasses; // For interactive mode
+	int completedSamples; // Samples every pixel received, set once the render finishes
 	struct texture *renderBuffer; //float-precision buffer for multisampling
 	struct texture *uiBuffer; //UI element buffer
 	int activeThreads; //Amount of threads currently rendering
@@ -61,9 +64,12 @@ struct prefs {
 	int threadCount; //Amount of threads to render with
 	bool fromSystem; //Did we ask the system for thread count
 	int sampleCount;
+	enum samplerType sampler;
+	unsigned long timeLimit; // Render time budget in milliseconds, 0 for no limit
 	int bounces;
 	unsigned tileWidth;
 	unsigned tileHeight;
+	size_t textureCacheSize; // Memory budget for paging in tiled textures in bytes, 0 loads textures whole
 	
 	//Output prefs
 	unsigned imageWidth;
@@ -11,7 +11,7 @@
 #include "../../includes.h"
 
 // Hash function by Thomas Wang: https://burtleburtle.net/bob/hash/integer.html
-static inline uint32_t hash(uint32_t x) {
+static inline uint32_t hash32(uint32_t x) {
 	x  = (x ^ 12345391) * 2654435769;
 	x ^= (x << 6) ^ (x >> 26);
 	x *= 2654435769;
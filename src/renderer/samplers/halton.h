@@ -8,6 +8,9 @@
 
 #pragma once
 
+#include "common.h"
+#include "../../utils/assert.h"
+
 struct haltonSampler {
 	float rndOffset;
 	unsigned currPrime;
@@ -16,5 +19,19 @@ struct haltonSampler {
 
 typedef struct haltonSampler haltonSampler;
 
-void initHalton(haltonSampler *s, int pass, uint32_t seed);
-float getHalton(haltonSampler *s);
+static const unsigned int haltonPrimes[] = {2, 3, 5, 7, 11, 13};
+static const unsigned int haltonPrimesCount = 6;
+
+static inline void initHalton(haltonSampler *s, int pass, uint32_t seed) {
+	s->rndOffset = uintToUnitReal(seed);
+	s->currPass = pass;
+	s->currPrime = 0;
+}
+
+static inline float getHalton(haltonSampler *s) {
+	// Wrapping around trick by @lycium
+	float v = wrapAdd(radicalInverse(s->currPass, haltonPrimes[s->currPrime++ % haltonPrimesCount]), s->rndOffset);
+	ASSERT(v >= 0);
+	ASSERT(v < 1);
+	return v;
+}
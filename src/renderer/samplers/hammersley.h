@@ -9,6 +9,8 @@
 #pragma once
 
 #include <stddef.h>
+#include "common.h"
+#include "../../utils/assert.h"
 
 struct hammersleySampler {
 	float rndOffset;
@@ -19,5 +21,27 @@ struct hammersleySampler {
 
 typedef struct hammersleySampler hammersleySampler;
 
-void initHammersley(hammersleySampler *s, int pass, int maxPasses, uint32_t seed);
-float getHammersley(hammersleySampler *s);
+static const unsigned int hammersleyPrimes[] = {2, 3, 5, 7, 11, 13};
+static const unsigned int hammersleyPrimesCount = 6;
+
+static inline void initHammersley(hammersleySampler *s, int pass, int maxPasses, uint32_t seed) {
+	s->rndOffset = uintToUnitReal(seed);
+	s->currPass = pass;
+	s->maxPasses = maxPasses;
+	s->currPrime = 0;
+}
+
+// Wrong
+static inline float getHammersley(hammersleySampler *s) {
+	// Wrapping around trick by Thomas Ludwig (@lycium)
+	float u;
+	if (s->currPass > 0) {
+		u = radicalInverse(s->currPass, hammersleyPrimes[s->currPrime++ % hammersleyPrimesCount]);
+	} else {
+		u = s->currPass / s->maxPasses;
+	}
+	const float v = wrapAdd(u, s->rndOffset);
+	ASSERT(v >= 0);
+	ASSERT(v <= 1);
+	return v;
+}
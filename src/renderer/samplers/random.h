@@ -9,6 +9,7 @@
 #pragma once
 
 #include "../../libraries/pcg_basic.h"
+#include "../../utils/assert.h"
 
 struct randomSampler {
 	pcg32_random_t rng;
@@ -16,6 +17,26 @@ struct randomSampler {
 
 typedef struct randomSampler randomSampler;
 
-void initRandom(randomSampler *s, uint64_t seed);
+// Same as pcg32_random_r(), but inlined into the render loop
+static inline uint32_t randomNext(pcg32_random_t *rng) {
+	const uint64_t oldstate = rng->state;
+	rng->state = oldstate * 6364136223846793005ULL + rng->inc;
+	const uint32_t xorshifted = (uint32_t)(((oldstate >> 18u) ^ oldstate) >> 27u);
+	const uint32_t rot = oldstate >> 59u;
+	return (xorshifted >> rot) | (xorshifted << ((-rot) & 31));
+}
 
-float getRandom(randomSampler *s);
+static inline void initRandom(randomSampler *s, uint64_t seed) {
+	s->rng.state = 0U;
+	s->rng.inc = 1u;
+	randomNext(&s->rng);
+	s->rng.state += seed;
+	randomNext(&s->rng);
+}
+
+static inline float getRandom(randomSampler *s) {
+	const float v = (1.0f / (1ull << 32)) * randomNext(&s->rng);
+	ASSERT(v >= 0);
+	ASSERT(v <= 1);
+	return v;
+}
@@ -9,20 +9,71 @@
 #pragma once
 
 #include <stdint.h>
-
-struct sampler;
-typedef struct sampler sampler;
+#include "halton.h"
+#include "hammersley.h"
+#include "random.h"
+#include "sobol.h"
+#include "common.h"
 
 enum samplerType {
 	Halton = 0,
 	Hammersley,
-	Random
+	Random,
+	Sobol
+};
+
+// The full definition is exposed so render threads can keep their sampler on the stack,
+// and so the per-sampler calls below can be inlined into the integrator.
+struct sampler {
+	enum samplerType type;
+	union {
+		hammersleySampler hammersley;
+		haltonSampler halton;
+		randomSampler random;
+		sobolSampler sobol;
+	} sampler;
 };
 
+typedef struct sampler sampler;
+
 struct sampler *newSampler(void);
 
-void initSampler(struct sampler *sampler, enum samplerType type, int pass, int maxPasses, uint32_t pixelIndex);
+static inline void initSampler(struct sampler *sampler, enum samplerType type, int pass, int maxPasses, uint32_t pixelIndex) {
+	sampler->type = type;
+	switch (type) {
+		case Halton:
+			initHalton(&sampler->sampler.halton, pass, hash32(pixelIndex));
+			break;
+		case Hammersley:
+			initHammersley(&sampler->sampler.hammersley, pass, maxPasses, hash32(pixelIndex));
+			break;
+		case Random:
+			// Both go into the seed as they are. maxPasses is INT_MAX in time-limited mode, so scaling by it would wrap.
+			initRandom(&sampler->sampler.random, hash64(((uint64_t)pixelIndex << 32) | (uint32_t)pass));
+			break;
+		case Sobol:
+			initSobol(&sampler->sampler.sobol, pass, hash32(pixelIndex));
+			break;
+	}
+}
+
+// When type is a compile-time constant, this folds down to a direct call to one sampler.
+static inline float getDimensionOf(struct sampler *sampler, const enum samplerType type) {
+	switch (type) {
+		case Hammersley:
+			return getHammersley(&sampler->sampler.hammersley);
+		case Halton:
+			return getHalton(&sampler->sampler.halton);
+		case Random:
+			return getRandom(&sampler->sampler.random);
+		case Sobol:
+			return getSobol(&sampler->sampler.sobol);
+	}
+	return 0;
+}
 
-float getDimension(struct sampler *sampler);
+static inline float getDimension(struct sampler *sampler) {
+	return getDimensionOf(sampler, sampler->type);
+}
 
 void destroySampler(struct sampler *sampler);
@@ -0,0 +1,106 @@
+//
+//  sobol.c
+//  C-ray
+//
+//  Created by Valtteri Koskivuori on 18/10/2026.
+//  Copyright © 2026 Valtteri Koskivuori. All rights reserved.
+//
+
+#include "../../includes.h"
+#include "sobol.h"
+
+#include "common.h"
+#include "../../utils/assert.h"
+
+/*
+ Owen-scrambled Sobol sequence, as described in "Practical Hash-based Owen
+ Scrambling" by Brent Burley (JCGT 2020).
+ Dimensions past the table are padded: each group of sobolDimensions gets its
+ own shuffled sample index and scramble seed, which decorrelates the groups.
+ A whole group is generated at once when it's first needed, so a single
+ dimension only costs a scramble.
+ */
+
+// Generator matrices for the first 16 dimensions, from the Joe & Kuo direction
+// numbers (new-joe-kuo-6.21201). Stored bit-reversed, indexed [bit][dimension],
+// so a group can be computed in one pass over the index bits.
+static const uint32_t sobolMatrices[32][sobolDimensions] = {
+	{ 0x00000001, 0x00000001, 0x00000001, 0x00000001, 0x00000001, 0x00000001, 0x00000001, 0x00000001,
+	  0x00000001, 0x00000001, 0x00000001, 0x00000001, 0x00000001, 0x00000001, 0x00000001, 0x00000001 },
+	{ 0x00000002, 0x00000003, 0x00000003, 0x00000003, 0x00000002, 0x00000002, 0x00000003, 0x00000002,
+	  0x00000002, 0x00000002, 0x00000002, 0x00000002, 0x00000003, 0x00000003, 0x00000002, 0x00000003 },
+	{ 0x00000004, 0x00000005, 0x00000006, 0x00000004, 0x00000004, 0x00000006, 0x00000005, 0x00000005,
+	  0x00000005, 0x00000007, 0x00000005, 0x00000004, 0x00000005, 0x00000006, 0x00000004, 0x00000004 },
+	{ 0x00000008, 0x0000000f, 0x00000009, 0x0000000a, 0x0000000d, 0x0000000c, 0x0000000b, 0x0000000a,
+	  0x0000000a, 0x0000000d, 0x00000008, 0x0000000c, 0x0000000a, 0x00000009, 0x0000000f, 0x0000000b },
+	{ 0x00000010, 0x00000011, 0x00000017, 0x0000001f, 0x0000001f, 0x00000013, 0x0000001a, 0x00000011,
+	  0x00000014, 0x00000019, 0x00000010, 0x0000001a, 0x0000001f, 0x0000001c, 0x00000015, 0x0000001b },
+	{ 0x00000020, 0x00000033, 0x0000003a, 0x0000002e, 0x0000003b, 0x00000024, 0x00000029, 0x00000024,
+	  0x0000002b, 0x00000029, 0x00000036, 0x00000035, 0x00000031, 0x00000023, 0x0000002a, 0x00000023 },
+	{ 0x00000040, 0x00000055, 0x00000071, 0x00000045, 0x0000005e, 0x0000006a, 0x0000007c, 0x00000048,
+	  0x00000056, 0x00000051, 0x00000079, 0x00000069, 0x00000047, 0x00000042, 0x00000059, 0x00000062 },
+	{ 0x00000080, 0x000000ff, 0x000000a3, 0x000000c9, 0x000000b9, 0x000000df, 0x000000c7, 0x000000b4,
+	  0x0000008e, 0x000000da, 0x000000c4, 0x000000d4, 0x000000cc, 0x000000c5, 0x000000b9, 0x000000a1 },
+	{ 0x00000100, 0x00000101, 0x00000116, 0x0000011b, 0x0000015a, 0x00000107, 0x0000017d, 0x0000016e,
+	  0x0000011c, 0x000001cc, 0x000001ea, 0x0000012b, 0x000001f0, 0x0000018f, 0x00000178, 0x000001a5 },
+	{ 0x00000200, 0x00000303, 0x00000339, 0x000002a4, 0x000003f4, 0x0000020e, 0x000003c4, 0x00000279,
+	  0x0000021a, 0x0000039b, 0x000003b5, 0x00000290, 0x00000284, 0x00000255, 0x0000033a, 0x0000036e },
+	{ 0x00000400, 0x00000505, 0x00000677, 0x0000079a, 0x00000685, 0x00000615, 0x00000478, 0x00000410,
+	  0x00000457, 0x0000044e, 0x000005fe, 0x00000547, 0x000005a9, 0x0000073f, 0x000004be, 0x000005b5 },
+	{ 0x00000800, 0x00000f0f, 0x000009aa, 0x00000b67, 0x00000d0f, 0x00000c28, 0x000008cf, 0x00000826,
+	  0x0000088c, 0x000008fc, 0x00000b89, 0x00000a4a, 0x00000e7a, 0x000008a1, 0x000008b1, 0x00000d56 },
+	{ 0x00001000, 0x00001111, 0x00001601, 0x0000101e, 0x0000115b, 0x00001379, 0x00001e62, 0x0000144d,
+	  0x00001519, 0x00001d83, 0x00001192, 0x00001472, 0x0000101b, 0x00001007, 0x00001124, 0x000015b4 },
+	{ 0x00002000, 0x00003333, 0x00003903, 0x0000302d, 0x000023f6, 0x000024fb, 0x000021e6, 0x000028be,
+	  0x00002a10, 0x00003765, 0x00002b73, 0x000038e3, 0x00002438, 0x0000300a, 0x0000238e, 0x00003d55 },
+	{ 0x00004000, 0x00005555, 0x00007706, 0x00004041, 0x00004681, 0x00006b6d, 0x0000621e, 0x0000457f,
+	  0x00005443, 0x000061ca, 0x00005011, 0x00007946, 0x0000685d, 0x0000601a, 0x000045d7, 0x000055b0 },
+	{ 0x00008000, 0x0000ffff, 0x0000aa09, 0x0000a0c3, 0x0000dd02, 0x0000ddd1, 0x0000e621, 0x0000925d,
+	  0x0000a4a7, 0x0000af94, 0x0000f034, 0x0000e648, 0x0000ecf7, 0x0000902a, 0x0000fbae, 0x00008d5e },
+	{ 0x00010000, 0x00010001, 0x00010117, 0x0001f104, 0x0001e144, 0x00010012, 0x00011e63, 0x00012458,
+	  0x00014d4f, 0x00015c50, 0x0001b07c, 0x0001c876, 0x000161a8, 0x0001c05e, 0x000145d6, 0x0001e5ab },
+	{ 0x00020000, 0x00030003, 0x0003033a, 0x0002e28a, 0x000393cd, 0x00020026, 0x000321e5, 0x0002d892,
+	  0x0002129e, 0x000354d8, 0x0003e8cc, 0x00038cef, 0x0003f679, 0x000230e6, 0x00028bac, 0x0002bd7d },
+	{ 0x00040000, 0x00050005, 0x00060671, 0x000457df, 0x0005a6df, 0x0006006c, 0x0005621b, 0x0005ad23,
+	  0x0004255f, 0x000749cb, 0x00060dfa, 0x0005195c, 0x0006d81e, 0x000421cd, 0x0005c5d2, 0x0007c5c9 },
+	{ 0x00080000, 0x000f000f, 0x000909a3, 0x000c9bae, 0x000b4dbb, 0x000c00d3, 0x000be62a, 0x0009cec7,
+	  0x0008cebd, 0x000eff96, 0x000d1f83, 0x0009227d, 0x00092c32, 0x000c5290, 0x000b4ba3, 0x0008addc },
+	{ 0x00100000, 0x00110011, 0x00171616, 0x0011a105, 0x0014401e, 0x00130114, 0x001b1e79, 0x0010016f,
+	  0x00101518, 0x00101c57, 0x0011b187, 0x0011dc1f, 0x00117042, 0x0018f6b0, 0x001685c7, 0x001d946c },
+	{ 0x00200000, 0x00330033, 0x003a3939, 0x002a7289, 0x003cd039, 0x0024022a, 0x002a21cc, 0x0020027b,
+	  0x00202a12, 0x002034d5, 0x0023eb4d, 0x0023b43b, 0x0033d0c6, 0x00255af4, 0x0031db89, 0x003e4eb2 },
+	{ 0x00400000, 0x00550055, 0x00717777, 0x0079e7db, 0x006df05a, 0x006a067f, 0x00796267, 0x00500415,
+	  0x00505446, 0x007065d2, 0x00560878, 0x00456077, 0x0056b5ef, 0x0073e738, 0x004f759e, 0x0046c1d9 },
+	{ 0x00800000, 0x00ff00ff, 0x00a3aaaa, 0x00b6dba4, 0x00dbb0b4, 0x00df0cf7, 0x00cce6ed, 0x00a0082c,
+	  0x00a0a4ad, 0x00d0a7bf, 0x008d14c6, 0x00c9c4ed, 0x00a9ceb5, 0x008a28ab, 0x0082fb30, 0x00eb23e4 },
+	{ 0x01000000, 0x01010101, 0x01170001, 0x0100011a, 0x0101e145, 0x0107127e, 0x01661f04, 0x0110145c,
+	  0x01414d5b, 0x01914006, 0x0111a1ef, 0x01b01558, 0x01e001ee, 0x0100001d, 0x010154e6, 0x011d946d },
+	{ 0x02000000, 0x03030303, 0x033a0003, 0x030002a7, 0x020393cf, 0x020e26f5, 0x03ee2208, 0x0240289a,
+	  0x02b212b5, 0x0293600f, 0x0343c3bd, 0x03703a71, 0x032002b6, 0x03000020, 0x0202a80a, 0x033e4eb1 },
+	{ 0x04000000, 0x05050505, 0x06710006, 0x0400079e, 0x0405a6db, 0x06156d78, 0x0401661f, 0x04804537,
+	  0x05642509, 0x05172c1e, 0x07c65dee, 0x06d07c05, 0x042005eb, 0x06000044, 0x04058058, 0x0446c1dd },
+	{ 0x08000000, 0x0f0f0f0f, 0x09a30009, 0x0a000b6d, 0x0d0b4db6, 0x0c28d1f9, 0x0803ee22, 0x0b4092e9,
+	  0x08e8ce33, 0x0dae5824, 0x0ccdefbf, 0x0d80ec0e, 0x0c600ebc, 0x090000cc, 0x0f0bb0bb, 0x0beb23ef },
+	{ 0x10000000, 0x11111111, 0x16160017, 0x1f001001, 0x1f144001, 0x1378136b, 0x1f040166, 0x16e12536,
+	  0x11d01404, 0x1cd15c48, 0x1fb001eb, 0x1311dc1e, 0x1ef011f4, 0x1c000193, 0x1517c17c, 0x1a1d9476 },
+	{ 0x20000000, 0x33333333, 0x3939003a, 0x2e003003, 0x3b3cd002, 0x24f924dd, 0x220803ee, 0x2792daeb,
+	  0x21802808, 0x399354f3, 0x381003b7, 0x2a53b439, 0x2b50268d, 0x23000276, 0x2a335335, 0x203e4e92 },
+	{ 0x40000000, 0x55555555, 0x77770071, 0x45004004, 0x5e6df004, 0x6b6b6b01, 0x661f0401, 0x4105a933,
+	  0x45205011, 0x4497499d, 0x582005fb, 0x52e56073, 0x5ee06db3, 0x4200077d, 0x594ab4ab, 0x6646c1bf },
+	{ 0x80000000, 0xffffffff, 0xaaaa00a3, 0xc900a00a, 0xb9dbb00d, 0xdddddd02, 0xee220803, 0x8269c6e1,
+	  0x8860ac21, 0x8f1eff41, 0xb4500b81, 0xa9e9c4e1, 0xeb60e241, 0xc5000864, 0xb989b89b, 0xaaeb234e }
+};
+
+// Shuffling the index keeps any aligned power-of-two block of samples a (t,m,s)-net
+void sobolStartGroup(sobolSampler *s, uint32_t group) {
+	s->groupSeed = hash32(s->seed ^ hash32(group));
+	// Shuffled index, still bit-reversed. Bit 31 is the least significant bit of the index.
+	const uint32_t index = laineKarrasPermutation(reverseBits(s->index), s->groupSeed);
+	for (int d = 0; d < sobolDimensions; ++d) s->group[d] = 0;
+	for (int bit = 0; bit < 32; ++bit) {
+		const uint32_t mask = 0u - ((index >> (31 - bit)) & 1u);
+		for (int d = 0; d < sobolDimensions; ++d) {
+			s->group[d] ^= sobolMatrices[bit][d] & mask;
+		}
+	}
+}
@@ -0,0 +1,64 @@
+//
+//  sobol.h
+//  C-ray
+//
+//  Created by Valtteri Koskivuori on 18/10/2026.
+//  Copyright © 2026 Valtteri Koskivuori. All rights reserved.
+//
+
+#pragma once
+
+#include <stdint.h>
+#include "common.h"
+#include "../../utils/assert.h"
+
+#define sobolDimensions 16
+
+struct sobolSampler {
+	uint32_t index;
+	uint32_t seed;
+	uint32_t dimension;
+	uint32_t groupSeed;
+	uint32_t group[sobolDimensions]; // Unscrambled, bit-reversed values for the current group of dimensions
+};
+
+typedef struct sobolSampler sobolSampler;
+
+static inline uint32_t reverseBits(uint32_t x) {
+	x = ((x >> 1) & 0x55555555u) | ((x & 0x55555555u) << 1);
+	x = ((x >> 2) & 0x33333333u) | ((x & 0x33333333u) << 2);
+	x = ((x >> 4) & 0x0f0f0f0fu) | ((x & 0x0f0f0f0fu) << 4);
+	x = ((x >> 8) & 0x00ff00ffu) | ((x & 0x00ff00ffu) << 8);
+	return (x >> 16) | (x << 16);
+}
+
+// Laine-Karras style permutation. Operating on bit-reversed values, this is an Owen scramble.
+static inline uint32_t laineKarrasPermutation(uint32_t x, uint32_t seed) {
+	x += seed;
+	x ^= x * 0x6c50b47cu;
+	x ^= x * 0xb82f1e52u;
+	x ^= x * 0xc7afe638u;
+	x ^= x * 0x8d22f6e6u;
+	return x;
+}
+
+// Compute the next group of sobolDimensions dimensions
+void sobolStartGroup(sobolSampler *s, uint32_t group);
+
+static inline void initSobol(sobolSampler *s, int pass, uint32_t seed) {
+	s->index = (uint32_t)pass;
+	s->seed = seed;
+	s->dimension = 0;
+	sobolStartGroup(s, 0);
+}
+
+static inline float getSobol(sobolSampler *s) {
+	const uint32_t dimension = s->dimension % sobolDimensions;
+	if (s->dimension && !dimension) sobolStartGroup(s, s->dimension / sobolDimensions);
+	s->dimension++;
+	const uint32_t x = reverseBits(laineKarrasPermutation(s->group[dimension], s->groupSeed ^ (dimension * 0x9e3779b9u)));
+	const float v = uintToUnitReal(x);
+	ASSERT(v >= 0);
+	ASSERT(v < 1);
+	return v;
+}
@@ -12,6 +12,8 @@
 #include "../datatypes/vector.h"
 #include "../datatypes/color.h"
 #include "../datatypes/lightray.h"
+#include "../datatypes/image/texture.h"
+#include "../utils/mempool.h"
 
 /*
  This implementation here is adapted from the CUDA implementation found at this URL:
@@ -98,3 +100,33 @@ struct color sky(struct lightRay incidentRay) {
 	return colorCoef(skyFactor * 0.01f, sky);
 	
 }
+
+struct texture *newSkyTexture(size_t width, size_t height, struct block **pool) {
+	if (!width || !height) return NULL;
+	struct texture *tex = pool ? allocBlock(pool, sizeof(*tex)) : calloc(1, sizeof(*tex));
+	*tex = (struct texture){
+		.colorspace = linear,
+		.precision = float_p,
+		.channels = 3,
+		.width = width,
+		.height = height
+	};
+	textureSelectFetch(tex);
+	const size_t bytes = width * height * tex->channels * sizeof(float);
+	tex->data.float_p = pool ? allocBlock(pool, bytes) : malloc(bytes);
+	// Texel centers, in the same equirectangular mapping the background shader uses to look them back up
+	for (size_t y = 0; y < height; ++y) {
+		const float theta = PI * (y + 0.5f) / height;
+		const float sinTheta = sinf(theta);
+		const float cosTheta = cosf(theta);
+		for (size_t x = 0; x < width; ++x) {
+			const float phi = 2.0f * PI * (x + 0.5f) / width;
+			const struct lightRay ray = { .direction = { sinTheta * cosf(phi), -cosTheta, sinTheta * sinf(phi) } };
+			struct color c = sky(ray);
+			// Below the horizon the optical length goes to infinity, which can leave NaNs behind
+			if (!isfinite(c.red) || !isfinite(c.green) || !isfinite(c.blue)) c = (struct color){ 0.0f, 0.0f, 0.0f, 1.0f };
+			setPixel(tex, c, x, y);
+		}
+	}
+	return tex;
+}
@@ -8,14 +8,25 @@
 
 #pragma once
 
+#include <stddef.h>
+
 struct color;
 struct lightRay;
+struct texture;
+struct block;
 
 // This models atmospheric rayleigh scattering to produce
 // a realistic looking sky up in the +Y direction.
-// This is not very useful at the moment, since our
-// path tracer does not do any kind of direct sampling,
-// meaning our render will have a ton of noise.
+// It's fairly expensive, so the renderer doesn't call this
+// per ray. Instead it's baked with newSkyTexture() once.
 // A lot of the physical parameters are tweakable in the
 // start of the implementation file.
 struct color sky(struct lightRay incidentRay);
+
+/// Bake sky() into an equirectangular float texture, laid out so it can be used directly as a background.
+/// As an image background it's bilinearly filtered and importance sampled like any HDR.
+/// @param width Horizontal resolution of the lookup table
+/// @param height Vertical resolution of the lookup table
+/// @param pool Optional, memory pool to store the texture in
+/// @return Texture, or NULL if the resolution was zero
+struct texture *newSkyTexture(size_t width, size_t height, struct block **pool);
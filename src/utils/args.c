@@ -18,6 +18,7 @@
 #include "platform/terminal.h"
 #include "platform/capabilities.h"
 #include <stdlib.h>
+#include <limits.h>
 #include "textbuffer.h"
 #include "testrunner.h"
 #include "string.h"
@@ -33,12 +34,15 @@ static void printUsage(const char *progname) {
 	printf("    [-s <n>]         -> Override sample count to n\n");
 	printf("    [-d <w>x<h>]     -> Override image dimensions to <w>x<h>\n");
 	printf("    [-t <w>x<h>]     -> Override tile  dimensions to <w>x<h>\n");
+	printf("    [--time <t>]     -> Render progressively until time budget t runs out (e.g. 500ms, 90s, 5m, 1h)\n");
 	printf("    [-v]             -> Enable verbose mode\n");
 	printf("    [--iterative]    -> Start in iterative mode (Experimental)\n");
 	printf("    [--worker]       -> Start up as a network render worker (Experimental)\n");
 	printf("    [--nodes <list>] -> Use worker nodes in comma-separated ip:port list for a faster render (Experimental)\n");
 	printf("    [--shutdown]     -> Use in conjunction with a node list to send a shutdown command to a list of clients\n");
+	printf("    [--bake <path>]  -> Write the loaded scene, with its meshes, BVHs and textures, to a file that loads near instantly\n");
 	printf("    [--test]         -> Run the test suite\n");
+	printf("    [--benchmark [n]]-> Render the given scene or the standard suite n times, print results as JSON\n");
 	restoreTerminal();
 	exit(0);
 }
@@ -66,6 +70,29 @@ bool parseDims(const char *dimStr, int *widthOut, int *heightOut) {
 	return true;
 }
 
+// Parse a duration like "90s", "1.5m" or "250ms" into milliseconds.
+// A plain number is treated as seconds. Returns 0 on invalid input.
+unsigned long parseDuration(const char *durationStr) {
+	if (!durationStr) return 0;
+	char *unit = NULL;
+	double value = strtod(durationStr, &unit);
+	if (unit == durationStr || value <= 0.0) return 0;
+	double multiplier = 1000.0;
+	if (stringEquals(unit, "ms")) {
+		multiplier = 1.0;
+	} else if (stringEquals(unit, "s") || stringEquals(unit, "")) {
+		multiplier = 1000.0;
+	} else if (stringEquals(unit, "m")) {
+		multiplier = 60.0 * 1000.0;
+	} else if (stringEquals(unit, "h")) {
+		multiplier = 60.0 * 60.0 * 1000.0;
+	} else {
+		return 0;
+	}
+	double ms = value * multiplier;
+	return ms < 1.0 ? 1 : (unsigned long)ms;
+}
+
 void parseArgs(int argc, char **argv) {
 	g_options = newConstantsDatabase();
 	static bool inputFileSet = false;
@@ -141,6 +168,16 @@ void parseArgs(int argc, char **argv) {
 			}
 		}
 		
+		if (stringEquals(argv[i], "--time")) {
+			unsigned long ms = parseDuration(argv[i + 1]);
+			if (ms) {
+				setDatabaseTag(g_options, "time_override");
+				setDatabaseInt(g_options, "time_limit", ms > INT_MAX ? INT_MAX : (int)ms);
+			} else {
+				logr(warning, "Invalid --time parameter given!\n");
+			}
+		}
+		
 		if (stringEquals(argv[i], "--test")) {
 			setDatabaseTag(g_options, "runTests");
 			char *testIdxStr = argv[i + 1];
@@ -171,6 +208,25 @@ void parseArgs(int argc, char **argv) {
 			testIdx = -3;
 		}
 		
+		if (stringEquals(argv[i], "--benchmark")) {
+			setDatabaseTag(g_options, "benchmark");
+			char *runStr = argv[i + 1];
+			if (runStr && runStr[0] != '-' && atoi(runStr) > 0) {
+				setDatabaseInt(g_options, "benchmark_runs", atoi(runStr));
+			}
+		}
+		
+		if (stringEquals(argv[i], "--bake")) {
+			char *bakePath = argv[i + 1];
+			if (bakePath && bakePath[0] != '-') {
+				setDatabaseString(g_options, "bake", bakePath);
+				// Don't mistake an existing baked scene for the input file
+				++i;
+				continue;
+			}
+			logr(warning, "Invalid --bake parameter given!\n");
+		}
+		
 		if (stringEquals(argv[i], "--iterative")) {
 			setDatabaseTag(g_options, "interactive");
 		}
@@ -242,6 +298,7 @@ void parseArgs(int argc, char **argv) {
 }
 
 bool isSet(char *key) {
+	if (!g_options) return false;
 	return existsInDatabase(g_options, key);
 }
 
@@ -261,4 +318,5 @@ char *pathArg() {
 
 void destroyOptions() {
 	freeConstantsDatabase(g_options);
+	g_options = NULL;
 }
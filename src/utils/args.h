@@ -10,6 +10,8 @@
 
 void parseArgs(int argc, char **argv);
 
+unsigned long parseDuration(const char *durationStr);
+
 bool isSet(char *key);
 
 int intPref(char *key);
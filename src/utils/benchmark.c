@@ -0,0 +1,233 @@
+//
+//  benchmark.c
+//  C-ray
+//
+//  Created by Valtteri Koskivuori on 18/10/2026.
+//  Copyright © 2026 Valtteri Koskivuori. All rights reserved.
+//
+
+#include "../includes.h"
+#include "benchmark.h"
+
+#include <stdio.h>
+#include "../renderer/renderer.h"
+#include "../datatypes/scene.h"
+#include "../datatypes/image/texture.h"
+#include "../libraries/cJSON.h"
+#include "../c-ray.h"
+#include "logging.h"
+#include "fileio.h"
+#include "timer.h"
+#include "args.h"
+#include "gitsha1.h"
+#include "platform/capabilities.h"
+
+#define defaultRuns 3
+#define warmupRuns 1
+
+struct benchmarkScene {
+	const char *path;
+	// Fixed workload, so results are comparable between builds. 0 to use the scene's own value.
+	int width;
+	int height;
+	int samples;
+};
+
+// Bundled reference scenes, paths relative to the repository root.
+static const struct benchmarkScene standardSuite[] = {
+	{"input/scene.json", 640, 400, 8},
+	{"input/refraction.json", 640, 400, 8},
+	{"input/glowmetal.json", 400, 400, 16},
+	{"input/alphanode.json", 400, 400, 16},
+	{"input/uvsphere.json", 400, 400, 16},
+};
+
+struct benchmarkRun {
+	struct loadTimes loadTimes;
+	long renderUs;
+	uint64_t samples; // Pixel samples
+	uint64_t rays;
+	int threadCount;
+	unsigned width;
+	unsigned height;
+	int samplesPerPixel;
+};
+
+// Apply the fixed workload to the scene. CLI overrides still take precedence in parsePrefs()
+static char *applyWorkload(const char *input, const struct benchmarkScene *scene) {
+	cJSON *json = cJSON_Parse(input);
+	if (!json) return NULL;
+	cJSON *renderer = cJSON_GetObjectItem(json, "renderer");
+	if (cJSON_IsObject(renderer)) {
+		if (scene->width && scene->height) {
+			cJSON_ReplaceItemInObject(renderer, "width", cJSON_CreateNumber(scene->width));
+			cJSON_ReplaceItemInObject(renderer, "height", cJSON_CreateNumber(scene->height));
+		}
+		if (scene->samples) {
+			cJSON_ReplaceItemInObject(renderer, "samples", cJSON_CreateNumber(scene->samples));
+		}
+	}
+	char *out = cJSON_PrintUnformatted(json);
+	cJSON_Delete(json);
+	return out;
+}
+
+static bool benchmarkOnce(const char *input, const char *path, struct benchmarkRun *run) {
+	struct renderer *r = newRenderer();
+	r->prefs.assetPath = getFilePath(path);
+	if (loadScene(r, (char *)input) != 0) {
+		destroyRenderer(r);
+		return false;
+	}
+	
+	startTimer(r->state.timer);
+	struct texture *output = renderFrame(r);
+	run->renderUs = getUs(*r->state.timer);
+	logr(plain, "\n");
+	
+	run->loadTimes = r->scene->loadTimes;
+	run->threadCount = r->prefs.threadCount;
+	run->width = r->prefs.imageWidth;
+	run->height = r->prefs.imageHeight;
+	run->samplesPerPixel = r->state.completedSamples;
+	run->samples = (uint64_t)r->prefs.imageWidth * (uint64_t)r->prefs.imageHeight * (uint64_t)r->state.completedSamples;
+	run->rays = 0;
+	for (int t = 0; t < r->prefs.threadCount; ++t) {
+		run->rays += r->state.threadStates[t].totalRays;
+	}
+	
+	destroyTexture(output);
+	destroyRenderer(r);
+	return true;
+}
+
+static double toMs(long us) {
+	return (double)us / 1000.0;
+}
+
+static cJSON *benchmarkScene(const struct benchmarkScene *scene, int runs) {
+	size_t bytes = 0;
+	char *file = loadFile((char *)scene->path, &bytes);
+	if (!file) {
+		logr(warning, "Benchmark scene %s not found, skipping\n", scene->path);
+		return NULL;
+	}
+	char *input = applyWorkload(file, scene);
+	free(file);
+	if (!input) {
+		logr(warning, "Failed to parse benchmark scene %s, skipping\n", scene->path);
+		return NULL;
+	}
+	
+	logr(info, "Benchmarking %s (%i warm-up, %i timed runs)\n", scene->path, warmupRuns, runs);
+	struct benchmarkRun *results = calloc(runs, sizeof(*results));
+	bool success = true;
+	for (int i = 0; i < warmupRuns + runs && success; ++i) {
+		struct benchmarkRun run = { 0 };
+		success = benchmarkOnce(input, scene->path, &run);
+		if (i >= warmupRuns) results[i - warmupRuns] = run;
+	}
+	free(input);
+	if (!success) {
+		logr(warning, "Benchmark scene %s failed to load\n", scene->path);
+		free(results);
+		return NULL;
+	}
+	
+	long totalRenderUs = 0;
+	long bestRenderUs = results[0].renderUs;
+	long worstRenderUs = results[0].renderUs;
+	uint64_t totalSamples = 0;
+	uint64_t totalRays = 0;
+	struct loadTimes load = { 0 };
+	cJSON *runArray = cJSON_CreateArray();
+	for (int i = 0; i < runs; ++i) {
+		totalRenderUs += results[i].renderUs;
+		bestRenderUs = min(bestRenderUs, results[i].renderUs);
+		worstRenderUs = max(worstRenderUs, results[i].renderUs);
+		totalSamples += results[i].samples;
+		totalRays += results[i].rays;
+		load.parse += results[i].loadTimes.parse;
+		load.textures += results[i].loadTimes.textures;
+		load.bvh += results[i].loadTimes.bvh;
+		load.meshes += results[i].loadTimes.meshes;
+		load.total += results[i].loadTimes.total;
+		
+		double seconds = (double)results[i].renderUs / 1000000.0;
+		cJSON *run = cJSON_CreateObject();
+		cJSON_AddNumberToObject(run, "renderMs", toMs(results[i].renderUs));
+		cJSON_AddNumberToObject(run, "samplesPerSecond", (double)results[i].samples / seconds);
+		cJSON_AddNumberToObject(run, "raysPerSecond", (double)results[i].rays / seconds);
+		cJSON_AddItemToArray(runArray, run);
+	}
+	
+	double totalSeconds = (double)totalRenderUs / 1000000.0;
+	cJSON *result = cJSON_CreateObject();
+	cJSON_AddStringToObject(result, "scene", scene->path);
+	cJSON_AddNumberToObject(result, "width", results[0].width);
+	cJSON_AddNumberToObject(result, "height", results[0].height);
+	cJSON_AddNumberToObject(result, "samplesPerPixel", results[0].samplesPerPixel);
+	cJSON_AddNumberToObject(result, "threads", results[0].threadCount);
+	cJSON_AddNumberToObject(result, "samplesPerSecond", (double)totalSamples / totalSeconds);
+	cJSON_AddNumberToObject(result, "raysPerSecond", (double)totalRays / totalSeconds);
+	cJSON *renderTime = cJSON_CreateObject();
+	cJSON_AddNumberToObject(renderTime, "mean", toMs(totalRenderUs / runs));
+	cJSON_AddNumberToObject(renderTime, "min", toMs(bestRenderUs));
+	cJSON_AddNumberToObject(renderTime, "max", toMs(worstRenderUs));
+	cJSON_AddItemToObject(result, "renderMs", renderTime);
+	cJSON *loadTime = cJSON_CreateObject();
+	cJSON_AddNumberToObject(loadTime, "parse", toMs(load.parse / runs));
+	cJSON_AddNumberToObject(loadTime, "textures", toMs(load.textures / runs));
+	cJSON_AddNumberToObject(loadTime, "bvh", toMs(load.bvh / runs));
+	cJSON_AddNumberToObject(loadTime, "meshes", toMs(load.meshes / runs));
+	cJSON_AddNumberToObject(loadTime, "total", toMs(load.total / runs));
+	cJSON_AddItemToObject(result, "loadMs", loadTime);
+	cJSON_AddItemToObject(result, "runs", runArray);
+	free(results);
+	return result;
+}
+
+int runBenchmark() {
+	int runs = isSet("benchmark_runs") ? intPref("benchmark_runs") : defaultRuns;
+	if (isSet("use_clustering")) {
+		logr(warning, "Network rendering is not supported in benchmark mode, rendering locally\n");
+	}
+	
+	const struct benchmarkScene *scenes = standardSuite;
+	size_t sceneCount = sizeof(standardSuite) / sizeof(standardSuite[0]);
+	struct benchmarkScene userScene = { 0 };
+	if (isSet("inputFile")) {
+		userScene.path = pathArg();
+		scenes = &userScene;
+		sceneCount = 1;
+	}
+	
+	cJSON *sceneResults = cJSON_CreateArray();
+	int ret = 0;
+	for (size_t i = 0; i < sceneCount; ++i) {
+		cJSON *result = benchmarkScene(&scenes[i], runs);
+		if (result) {
+			cJSON_AddItemToArray(sceneResults, result);
+		} else {
+			ret = -1;
+		}
+	}
+	
+	char *cpu = getCPUModel();
+	cJSON *report = cJSON_CreateObject();
+	cJSON_AddStringToObject(report, "version", crGetVersion());
+	cJSON_AddStringToObject(report, "gitHash", gitHash());
+	cJSON_AddStringToObject(report, "cpu", cpu);
+	cJSON_AddNumberToObject(report, "cores", getSysCores());
+	cJSON_AddNumberToObject(report, "warmupRuns", warmupRuns);
+	cJSON_AddNumberToObject(report, "runs", runs);
+	cJSON_AddNumberToObject(report, "peakRSS", (double)getPeakRSS());
+	cJSON_AddItemToObject(report, "scenes", sceneResults);
+	free(cpu);
+	
+	char *out = cJSON_Print(report);
+	printf("%s\n", out);
+	free(out);
+	cJSON_Delete(report);
+	return ret;
+}
@@ -0,0 +1,14 @@
+//
+//  benchmark.h
+//  C-ray
+//
+//  Created by Valtteri Koskivuori on 18/10/2026.
+//  Copyright © 2026 Valtteri Koskivuori. All rights reserved.
+//
+
+#pragma once
+
+/// Run the headless benchmark, either on the scene given on the command line,
+/// or on the standard suite of scenes in input/. Results are printed to stdout as JSON.
+/// @return 0 on success, -1 if any of the scenes failed to load
+int runBenchmark(void);
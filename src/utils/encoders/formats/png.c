@@ -34,6 +34,8 @@ void encodePNGFromArray(const char *filename, unsigned char *imgData, size_t wid
 	sprintf(bounces, "%i", imginfo.bounces);
 	char renderTime[64];
 	smartTime(imginfo.renderTime, renderTime);
+	char timeLimit[64];
+	if (imginfo.timeLimit) smartTime(imginfo.timeLimit, timeLimit);
 	char threads[16];
 	sprintf(threads, "%i", imginfo.threadCount);
 #ifndef WINDOWS
@@ -48,6 +50,7 @@ void encodePNGFromArray(const char *filename, unsigned char *imgData, size_t wid
 	lodepng_add_text(&info, "C-ray Samples", samples);
 	lodepng_add_text(&info, "C-ray Bounces", bounces);
 	lodepng_add_text(&info, "C-ray RenderTime", renderTime);
+	if (imginfo.timeLimit) lodepng_add_text(&info, "C-ray TimeLimit", timeLimit);
 	lodepng_add_text(&info, "C-ray Threads", threads);
 #ifndef WINDOWS
 	lodepng_add_text(&info, "C-ray SysInfo", sysinfo);
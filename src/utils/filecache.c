@@ -13,11 +13,11 @@
 #include "string.h"
 #include <string.h>
 #include "logging.h"
+#include "fileio.h"
 
 struct file {
 	char *path;
-	size_t size;
-	void *data;
+	struct fileView view;
 };
 
 size_t fileCount = 0;
@@ -32,27 +32,33 @@ bool cacheContains(const char *path) {
 	return false;
 }
 
-void cacheFile(const char *path, const void *data, size_t length) {
+void cacheFileView(const char *path, struct fileView view) {
 	if (cacheContains(path)) {
 		logr(debug, "File %s already cached, skipping.\n", path);
+		unmapFile(&view);
 		return;
 	}
 	cachedFiles = realloc(cachedFiles, ++fileCount * sizeof(*cachedFiles));
-	struct file file;
-	file.path = stringCopy(path);
-	file.data = malloc(length);
-	file.size = length;
-	memcpy(file.data, data, length);
-	cachedFiles[fileCount - 1] = file;
+	cachedFiles[fileCount - 1] = (struct file){ .path = stringCopy(path), .view = view };
 	logr(debug, "Cached file %s\n", path);
 }
 
+void cacheFile(const char *path, const void *data, size_t length) {
+	if (cacheContains(path)) {
+		logr(debug, "File %s already cached, skipping.\n", path);
+		return;
+	}
+	void *copy = malloc(length);
+	memcpy(copy, data, length);
+	cacheFileView(path, (struct fileView){ .data = copy, .size = length });
+}
+
 void *loadFromCache(const char *path, size_t *length) {
 	for (size_t i = 0; i < fileCount; ++i) {
 		if (stringEquals(path, cachedFiles[i].path)) {
-			if (length) *length = cachedFiles[i].size;
-			char *ret = malloc(cachedFiles[i].size);
-			memcpy(ret, cachedFiles[i].data, cachedFiles[i].size);
+			if (length) *length = cachedFiles[i].view.size;
+			char *ret = malloc(cachedFiles[i].view.size);
+			memcpy(ret, cachedFiles[i].view.data, cachedFiles[i].view.size);
 			logr(debug, "Retrieving file %s\n", path);
 			return ret;
 		}
@@ -65,7 +71,7 @@ char *encodeFileCache(void) {
 	cJSON *fileCache = cJSON_CreateArray();
 	for (size_t i = 0; i < fileCount; ++i) {
 		cJSON *record = cJSON_CreateObject();
-		char *encoded = b64encode(cachedFiles[i].data, cachedFiles[i].size);
+		char *encoded = b64encode(cachedFiles[i].view.data, cachedFiles[i].view.size);
 		cJSON_AddStringToObject(record, "path", cachedFiles[i].path);
 		cJSON_AddStringToObject(record, "data", encoded);
 		free(encoded);
@@ -84,15 +90,14 @@ void decodeFileCache(const char *data) {
 		cJSON *data = cJSON_GetObjectItem(record, "data");
 		size_t datalen = 0;
 		void *decoded = b64decode(data->valuestring, strlen(data->valuestring), &datalen);
-		cacheFile(path->valuestring, decoded, datalen);
-		free(decoded);
+		cacheFileView(path->valuestring, (struct fileView){ .data = decoded, .size = datalen });
 	}
 	cJSON_Delete(receivedCache);
 }
 
 void destroyFileCache() {
 	for (size_t i = 0; i < fileCount; ++i) {
-		if (cachedFiles[i].data) free(cachedFiles[i].data);
+		if (cachedFiles[i].view.data) unmapFile(&cachedFiles[i].view);
 		if (cachedFiles[i].path) free(cachedFiles[i].path);
 	}
 	free(cachedFiles);
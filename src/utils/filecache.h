@@ -10,8 +10,13 @@
 
 #include <sys/types.h>
 
+struct fileView;
+
 void cacheFile(const char *path, const void *data, size_t length);
 
+/// Cache a file without copying it. The cache takes over the view, and releases it with unmapFile().
+void cacheFileView(const char *path, struct fileView view);
+
 void *loadFromCache(const char *path, size_t *length);
 
 char *encodeFileCache(void);
@@ -13,6 +13,10 @@
 #include <limits.h> //For SSIZE_MAX
 #ifndef WINDOWS
 #include <libgen.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 #endif
 #include "string.h"
 #include <errno.h>
@@ -47,6 +51,51 @@ char *loadFile(const char *filePath, size_t *bytes) {
 	return buf;
 }
 
+struct fileView mapFile(const char *filePath) {
+	struct fileView view = { 0 };
+#ifndef WINDOWS
+	if (!isSet("is_worker")) {
+		const int fd = open(filePath, O_RDONLY);
+		if (fd < 0) {
+			logr(warning, "Can't access '%.*s': %s\n", (int)strlen(filePath), filePath, strerror(errno));
+			return view;
+		}
+		struct stat info;
+		if (fstat(fd, &info) == 0 && info.st_size > 0) {
+			void *data = mmap(NULL, (size_t)info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+			if (data != MAP_FAILED) {
+				view = (struct fileView){ .data = data, .size = (size_t)info.st_size, .mapped = true };
+			}
+		}
+		if (view.mapped && isSet("use_clustering")) {
+			// The cache gets a mapping of its own, which shares its pages with this one instead of copying them
+			void *data = mmap(NULL, view.size, PROT_READ, MAP_PRIVATE, fd, 0);
+			if (data != MAP_FAILED) {
+				cacheFileView(filePath, (struct fileView){ .data = data, .size = view.size, .mapped = true });
+			} else {
+				cacheFile(filePath, view.data, view.size);
+			}
+		}
+		close(fd);
+		if (view.mapped) return view;
+	}
+#endif
+	view.data = loadFile(filePath, &view.size);
+	return view;
+}
+
+void unmapFile(struct fileView *view) {
+#ifndef WINDOWS
+	if (view->mapped) {
+		munmap((void *)view->data, view->size);
+		*view = (struct fileView){ 0 };
+		return;
+	}
+#endif
+	free((void *)view->data);
+	*view = (struct fileView){ 0 };
+}
+
 void writeFile(const unsigned char *buf, size_t bufsize, const char *filePath) {
 	FILE *file = fopen(filePath, "wb" );
 	char *backupPath = NULL;
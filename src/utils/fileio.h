@@ -8,6 +8,9 @@
 
 #pragma once
 
+#include <stdbool.h>
+#include <stddef.h>
+
 /// Returns a string containing `bytes` converted into a more human readable format.
 /// @param bytes How many bytes you have
 /// @return A human readable file size string.
@@ -18,6 +21,23 @@ char *humanFileSize(unsigned long bytes);
 /// @param bytes Will be set to amount of bytes read, if provided.
 char *loadFile(const char *filePath, size_t *bytes);
 
+/// Read-only view of a whole file. Note that the contents aren't null terminated.
+struct fileView {
+	const char *data;
+	size_t size;
+	bool mapped; // Otherwise data is a copy on the heap
+};
+
+/// Map a file into memory, so its pages are read in as they are touched instead of copied up front.
+/// Falls back to loadFile() where mapping isn't available, e.g. on workers that get their files over the network.
+/// Prefer this over loadFile() for anything big that's only read, like meshes and images.
+/// @param filePath Path to file
+/// @return View of the file, with data set to NULL if it couldn't be read
+struct fileView mapFile(const char *filePath);
+
+/// Release a view returned by mapFile()
+void unmapFile(struct fileView *view);
+
 // This is a more robust file writing function, that will seek alternate directories
 // if the specified one wasn't writeable.
 void writeFile(const unsigned char *buf, size_t bufsize, const char *filePath);
@@ -0,0 +1,679 @@
+//
+//  bakedscene.c
+//  C-ray
+//
+//  Created by Valtteri Koskivuori on 18/10/2026.
+//  Copyright © 2026 Valtteri Koskivuori. All rights reserved.
+//
+
+#include "../../includes.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#include "bakedscene.h"
+#include "meshloader.h"
+#include "../logging.h"
+#include "../fileio.h"
+#include "../string.h"
+#include "../mempool.h"
+#include "../../datatypes/scene.h"
+#include "../../datatypes/mesh.h"
+#include "../../datatypes/poly.h"
+#include "../../datatypes/vector.h"
+#include "../../datatypes/material.h"
+#include "../../datatypes/image/texture.h"
+#include "../../accelerators/bvh.h"
+#include "../../renderer/renderer.h"
+
+#define BAKED_MAGIC 0x43535243 // "CRSC"
+#define BAKED_VERSION 3
+// Sections and arrays start on a cache line
+#define BAKED_ALIGNMENT 64
+
+enum bakedSection {
+	sectionJSON,
+	sectionStrings,
+	sectionEntries,
+	sectionMeshes,
+	sectionPlacements,
+	sectionMaterials,
+	sectionTextures,
+	sectionLevels,
+	sectionCount
+};
+
+struct bakedRange {
+	uint64_t offset;
+	uint64_t size;
+};
+
+struct bakedHeader {
+	uint32_t magic;
+	uint32_t version;
+	// Sizes of the structs written as is. A file is only loaded by a build that agrees on all of them.
+	uint32_t pointerSize;
+	uint32_t polySize;
+	uint32_t bvhNodeSize;
+	uint32_t materialSize;
+	uint32_t textureSize;
+	uint32_t placementSize;
+	struct bakedRange sections[sectionCount];
+};
+
+struct bakedEntry {
+	uint32_t firstMesh;
+	uint32_t meshCount;
+	uint32_t firstPlacement;
+	uint32_t placementCount;
+};
+
+struct bakedMesh {
+	uint64_t name; // Offset into the string section
+	// File offsets, 0 for arrays the mesh doesn't have. Meshes sharing vertex data have the same ones.
+	uint64_t vertices;
+	uint64_t normals;
+	uint64_t packedNormals;
+	uint64_t texCoords;
+	uint64_t packedTexCoords;
+	uint64_t polygons;
+	uint64_t attributes;
+	uint64_t bvhNodes;
+	uint64_t bvhPrimIndices;
+	int32_t vertexCount;
+	int32_t normalCount;
+	int32_t textureCoordCount;
+	int32_t polyCount;
+	int32_t materialCount;
+	uint32_t firstMaterial; // Meshes sharing materials have the same one
+	uint32_t sharedMaterials;
+	uint32_t sharedVertices;
+	uint32_t bvhNodeCount;
+	uint32_t bvhPrimCount;
+	float rayOffset;
+};
+
+struct bakedMaterial {
+	struct material material; // With its pointers cleared
+	uint64_t name;
+	// Index into the texture section, -1 for none
+	int32_t texture;
+	int32_t normalMap;
+	int32_t specularMap;
+};
+
+struct bakedTexture {
+	// Offsets into the string section, 0 for textures that weren't loaded from a file.
+	// Paths under the scene directory are kept relative to it too, so the file can be moved along with the scene.
+	uint64_t path; // As loadTexture() got it
+	uint64_t scenePath; // 0 if it wasn't under the scene directory
+	// What loadTexture() was asked for
+	uint32_t colorspace;
+	uint32_t compress;
+	// Full size texture first, then its mips
+	uint32_t firstLevel;
+	uint32_t levelCount;
+};
+
+struct bakedLevel {
+	struct texture texture; // With its pointers cleared
+	uint64_t data; // File offset
+};
+
+struct bakedTextureLoad {
+	char *path;
+	enum colorspace colorspace;
+	bool compress;
+	const struct texture *texture;
+};
+
+struct bakedEntryLoad {
+	size_t meshCount;
+	struct meshPlacement *placements;
+	size_t placementCount;
+};
+
+struct bakedScene {
+	struct fileView file;
+	const struct bakedHeader *header;
+	char *assetPath;
+	// Headers of everything that points into the file
+	struct block *pool;
+	struct texture **textures;
+	size_t textureCount;
+	struct material *materials;
+	size_t materialCount;
+};
+
+struct bakeLog *newBakeLog(const char *json) {
+	struct bakeLog *log = calloc(1, sizeof(*log));
+	log->json = stringCopy(json);
+	return log;
+}
+
+void bakeLogTexture(struct bakeLog *log, const char *path, enum colorspace colorspace, bool compress, const struct texture *texture) {
+	log->textures = realloc(log->textures, (log->textureCount + 1) * sizeof(*log->textures));
+	log->textures[log->textureCount++] = (struct bakedTextureLoad){
+		.path = stringCopy(path),
+		.colorspace = colorspace,
+		.compress = compress,
+		.texture = texture
+	};
+}
+
+void bakeLogMeshEntry(struct bakeLog *log, size_t meshCount, const struct meshPlacement *placements, size_t placementCount) {
+	log->entries = realloc(log->entries, (log->entryCount + 1) * sizeof(*log->entries));
+	struct bakedEntryLoad *entry = &log->entries[log->entryCount++];
+	*entry = (struct bakedEntryLoad){ .meshCount = meshCount, .placementCount = placementCount };
+	if (placementCount) {
+		entry->placements = malloc(placementCount * sizeof(*placements));
+		memcpy(entry->placements, placements, placementCount * sizeof(*placements));
+	}
+}
+
+void destroyBakeLog(struct bakeLog *log) {
+	if (!log) return;
+	for (size_t i = 0; i < log->textureCount; ++i) free(log->textures[i].path);
+	for (size_t i = 0; i < log->entryCount; ++i) free(log->entries[i].placements);
+	free(log->textures);
+	free(log->entries);
+	free(log->json);
+	free(log);
+}
+
+struct bakeWriter {
+	FILE *file;
+	uint64_t offset;
+	bool failed;
+};
+
+// Write bytes at the next aligned offset
+static struct bakedRange writeAligned(struct bakeWriter *w, const void *data, size_t bytes) {
+	static const char zeros[BAKED_ALIGNMENT] = { 0 };
+	const size_t padding = (BAKED_ALIGNMENT - w->offset % BAKED_ALIGNMENT) % BAKED_ALIGNMENT;
+	if (padding && fwrite(zeros, 1, padding, w->file) != padding) w->failed = true;
+	w->offset += padding;
+	const struct bakedRange range = { .offset = w->offset, .size = bytes };
+	if (bytes && fwrite(data, 1, bytes, w->file) != bytes) w->failed = true;
+	w->offset += bytes;
+	return range;
+}
+
+// Offset of an array that may be missing, 0 if it is
+static uint64_t writeArray(struct bakeWriter *w, const void *data, size_t count, size_t size) {
+	return data ? writeAligned(w, data, count * size).offset : 0;
+}
+
+// Every string in the file, one after another. Offset 0 is an empty string.
+struct stringTable {
+	char *data;
+	size_t size;
+};
+
+static uint64_t addString(struct stringTable *table, const char *string) {
+	if (!string || !*string) return 0;
+	const size_t length = strlen(string) + 1;
+	table->data = realloc(table->data, table->size + length);
+	memcpy(table->data + table->size, string, length);
+	table->size += length;
+	return table->size - length;
+}
+
+struct textureTable {
+	struct bakedTexture *records;
+	const struct texture **textures;
+	size_t count;
+};
+
+// Textures loaded from a file get a record for each path they were loaded from, the others one for the materials using them
+static int32_t addTexture(struct textureTable *table, const struct texture *t, uint64_t path, uint64_t scenePath, enum colorspace colorspace, bool compress) {
+	if (!t) return -1;
+	// Tiled textures have no texels to write out
+	if (!t->data.byte_p) return -1;
+	for (size_t i = 0; i < table->count && !path; ++i) {
+		if (table->textures[i] == t) return (int32_t)i;
+	}
+	table->records = realloc(table->records, (table->count + 1) * sizeof(*table->records));
+	table->textures = realloc(table->textures, (table->count + 1) * sizeof(*table->textures));
+	table->records[table->count] = (struct bakedTexture){ .path = path, .scenePath = scenePath, .colorspace = colorspace, .compress = compress };
+	table->textures[table->count] = t;
+	return (int32_t)table->count++;
+}
+
+// NULL if path isn't under assetPath
+static const char *relativePath(const char *path, const char *assetPath) {
+	return assetPath && stringStartsWith(assetPath, path) ? path + strlen(assetPath) : NULL;
+}
+
+static struct texture clearPointers(const struct texture *t) {
+	struct texture copy = *t;
+	copy.data.byte_p = NULL;
+	copy.mips = NULL;
+	copy.tiles = NULL;
+	copy.fetch = NULL;
+	copy.shared = false;
+	return copy;
+}
+
+bool bakeScene(const struct renderer *r, const char *path) {
+	const struct world *scene = r->scene;
+	const struct bakeLog *log = scene->bakeLog;
+	if (!log) {
+		logr(warning, "Only scenes loaded from a scene description can be baked\n");
+		return false;
+	}
+	size_t loggedMeshes = 0;
+	for (size_t i = 0; i < log->entryCount; ++i) loggedMeshes += log->entries[i].meshCount;
+	if (loggedMeshes != (size_t)scene->meshCount) {
+		logr(warning, "Scene has %i meshes, but %zu were loaded from its mesh entries. Can't bake it.\n", scene->meshCount, loggedMeshes);
+		return false;
+	}
+	FILE *file = fopen(path, "wb");
+	if (!file) {
+		logr(warning, "Can't write baked scene to %s\n", path);
+		return false;
+	}
+	struct bakeWriter w = { .file = file };
+	struct bakedHeader header = {
+		.magic = BAKED_MAGIC,
+		.version = BAKED_VERSION,
+		.pointerSize = sizeof(void *),
+		.polySize = sizeof(struct poly),
+		.bvhNodeSize = (uint32_t)bvhNodeSize(),
+		.materialSize = sizeof(struct material),
+		.textureSize = sizeof(struct texture),
+		.placementSize = sizeof(struct meshPlacement)
+	};
+	// Filled in once everything else is written
+	writeAligned(&w, &header, sizeof(header));
+
+	struct stringTable strings = { .data = calloc(1, 1), .size = 1 };
+
+	struct textureTable textures = { 0 };
+	for (size_t i = 0; i < log->textureCount; ++i) {
+		const struct bakedTextureLoad *load = &log->textures[i];
+		const char *scenePath = relativePath(load->path, r->prefs.assetPath);
+		addTexture(&textures, load->texture, addString(&strings, load->path), scenePath ? addString(&strings, scenePath) : 0, load->colorspace, load->compress);
+	}
+
+	struct bakedMesh *meshes = calloc(max(scene->meshCount, 1), sizeof(*meshes));
+	struct bakedMaterial *materials = NULL;
+	size_t materialCount = 0;
+	for (int i = 0; i < scene->meshCount; ++i) {
+		const struct mesh *mesh = &scene->meshes[i];
+		struct bakedMesh *baked = &meshes[i];
+		baked->name = addString(&strings, mesh->name);
+		baked->vertexCount = mesh->vertexCount;
+		baked->normalCount = mesh->normalCount;
+		baked->textureCoordCount = mesh->textureCoordCount;
+		baked->sharedVertices = mesh->sharedVertices;
+		baked->polyCount = mesh->polyCount;
+		baked->materialCount = mesh->materialCount;
+		baked->sharedMaterials = mesh->sharedMaterials;
+		baked->rayOffset = mesh->rayOffset;
+		// Vertex data is written once, along with the mesh that owns it
+		int owner = i;
+		for (int j = i - 1; j >= 0 && mesh->sharedVertices; --j) {
+			if (scene->meshes[j].vertices == mesh->vertices) {
+				owner = j;
+				break;
+			}
+		}
+		if (owner != i) {
+			baked->vertices = meshes[owner].vertices;
+			baked->normals = meshes[owner].normals;
+			baked->packedNormals = meshes[owner].packedNormals;
+			baked->texCoords = meshes[owner].texCoords;
+			baked->packedTexCoords = meshes[owner].packedTexCoords;
+		} else {
+			baked->vertices = writeArray(&w, mesh->vertices, mesh->vertexCount, sizeof(*mesh->vertices));
+			baked->normals = writeArray(&w, mesh->normals, mesh->normalCount, sizeof(*mesh->normals));
+			baked->packedNormals = writeArray(&w, mesh->packedNormals, mesh->normalCount, sizeof(*mesh->packedNormals));
+			baked->texCoords = writeArray(&w, mesh->texCoords, mesh->textureCoordCount, sizeof(*mesh->texCoords));
+			baked->packedTexCoords = writeArray(&w, mesh->packedTexCoords, mesh->textureCoordCount, sizeof(*mesh->packedTexCoords));
+		}
+		baked->polygons = writeAligned(&w, mesh->polygons, mesh->polyCount * sizeof(*mesh->polygons)).offset;
+		baked->attributes = writeArray(&w, mesh->attributes, mesh->polyCount, sizeof(*mesh->attributes));
+		if (mesh->bvh) {
+			const void *nodes = NULL;
+			const int *primIndices = NULL;
+			getBvhData(mesh->bvh, &nodes, &baked->bvhNodeCount, &primIndices, &baked->bvhPrimCount);
+			baked->bvhNodes = writeAligned(&w, nodes, baked->bvhNodeCount * bvhNodeSize()).offset;
+			baked->bvhPrimIndices = writeAligned(&w, primIndices, baked->bvhPrimCount * sizeof(*primIndices)).offset;
+		}
+
+		// Meshes from the same file share their materials with the one that owns them
+		baked->firstMaterial = (uint32_t)materialCount;
+		for (int j = i - 1; j >= 0 && mesh->sharedMaterials; --j) {
+			if (scene->meshes[j].materials == mesh->materials) {
+				baked->firstMaterial = meshes[j].firstMaterial;
+				break;
+			}
+		}
+		if (baked->firstMaterial != materialCount) continue;
+		materials = realloc(materials, (materialCount + mesh->materialCount) * sizeof(*materials));
+		for (int j = 0; j < mesh->materialCount; ++j) {
+			const struct material *m = &mesh->materials[j];
+			struct bakedMaterial *record = &materials[materialCount++];
+			memset(record, 0, sizeof(*record));
+			record->material = *m;
+			record->material.name = NULL;
+			record->material.texture = NULL;
+			record->material.normalMap = NULL;
+			record->material.specularMap = NULL;
+			record->material.bsdf = NULL;
+			record->name = addString(&strings, m->name);
+			record->texture = addTexture(&textures, m->texture, 0, 0, sRGB, false);
+			record->normalMap = addTexture(&textures, m->normalMap, 0, 0, linear, false);
+			record->specularMap = addTexture(&textures, m->specularMap, 0, 0, linear, false);
+		}
+	}
+
+	struct bakedEntry *entries = calloc(max(log->entryCount, (size_t)1), sizeof(*entries));
+	struct meshPlacement *placements = NULL;
+	size_t meshIndex = 0, placementCount = 0;
+	for (size_t i = 0; i < log->entryCount; ++i) {
+		const struct bakedEntryLoad *load = &log->entries[i];
+		entries[i] = (struct bakedEntry){
+			.firstMesh = (uint32_t)meshIndex,
+			.meshCount = (uint32_t)load->meshCount,
+			.firstPlacement = (uint32_t)placementCount,
+			.placementCount = (uint32_t)load->placementCount
+		};
+		meshIndex += load->meshCount;
+		if (!load->placementCount) continue;
+		placements = realloc(placements, (placementCount + load->placementCount) * sizeof(*placements));
+		memcpy(placements + placementCount, load->placements, load->placementCount * sizeof(*placements));
+		placementCount += load->placementCount;
+	}
+
+	struct bakedLevel *levels = NULL;
+	size_t levelCount = 0;
+	for (size_t i = 0; i < textures.count; ++i) {
+		const struct texture *t = textures.textures[i];
+		// Texels are written once, even if the texture was loaded from more than one path
+		size_t first = 0;
+		while (first < i && textures.textures[first] != t) first++;
+		if (first < i) {
+			textures.records[i].firstLevel = textures.records[first].firstLevel;
+			textures.records[i].levelCount = textures.records[first].levelCount;
+			continue;
+		}
+		textures.records[i].firstLevel = (uint32_t)levelCount;
+		textures.records[i].levelCount = (uint32_t)(t->mipCount + 1);
+		levels = realloc(levels, (levelCount + t->mipCount + 1) * sizeof(*levels));
+		for (size_t level = 0; level <= t->mipCount; ++level) {
+			const struct texture *l = level ? &t->mips[level - 1] : t;
+			struct bakedLevel *record = &levels[levelCount++];
+			memset(record, 0, sizeof(*record));
+			record->texture = clearPointers(l);
+			record->data = writeAligned(&w, l->data.byte_p, textureLevelBytes(l)).offset;
+		}
+	}
+
+	header.sections[sectionEntries] = writeAligned(&w, entries, log->entryCount * sizeof(*entries));
+	header.sections[sectionMeshes] = writeAligned(&w, meshes, scene->meshCount * sizeof(*meshes));
+	header.sections[sectionPlacements] = writeAligned(&w, placements, placementCount * sizeof(*placements));
+	header.sections[sectionMaterials] = writeAligned(&w, materials, materialCount * sizeof(*materials));
+	header.sections[sectionTextures] = writeAligned(&w, textures.records, textures.count * sizeof(*textures.records));
+	header.sections[sectionLevels] = writeAligned(&w, levels, levelCount * sizeof(*levels));
+	header.sections[sectionStrings] = writeAligned(&w, strings.data, strings.size);
+	header.sections[sectionJSON] = writeAligned(&w, log->json, strlen(log->json) + 1);
+	const uint64_t fileSize = w.offset;
+
+	if (fseek(file, 0, SEEK_SET) != 0 || fwrite(&header, sizeof(header), 1, file) != 1) w.failed = true;
+	if (fclose(file) != 0) w.failed = true;
+
+	free(levels);
+	free(textures.records);
+	free(textures.textures);
+	free(placements);
+	free(entries);
+	free(materials);
+	free(meshes);
+	free(strings.data);
+	if (w.failed) {
+		logr(warning, "Failed to write baked scene to %s\n", path);
+		remove(path);
+		return false;
+	}
+	char *size = humanFileSize(fileSize);
+	logr(info, "Baked scene to %s (%s)\n", path, size);
+	free(size);
+	return true;
+}
+
+bool isBakedScene(const char *path) {
+	FILE *file = fopen(path, "rb");
+	if (!file) return false;
+	uint32_t magic = 0;
+	const bool read = fread(&magic, sizeof(magic), 1, file) == 1;
+	fclose(file);
+	return read && magic == BAKED_MAGIC;
+}
+
+// Whether count elements of size bytes at offset are all within the file
+static bool inFile(const struct bakedScene *scene, uint64_t offset, uint64_t count, uint64_t size) {
+	if (offset > scene->file.size) return false;
+	return !size || count <= (scene->file.size - offset) / size;
+}
+
+static const void *at(const struct bakedScene *scene, uint64_t offset) {
+	return scene->file.data + offset;
+}
+
+static const void *optionalAt(const struct bakedScene *scene, uint64_t offset) {
+	return offset ? at(scene, offset) : NULL;
+}
+
+static const void *section(const struct bakedScene *scene, enum bakedSection section, size_t *count, size_t size) {
+	const struct bakedRange range = scene->header->sections[section];
+	*count = (size_t)(range.size / size);
+	return at(scene, range.offset);
+}
+
+static const char *stringAt(const struct bakedScene *scene, uint64_t offset) {
+	const struct bakedRange strings = scene->header->sections[sectionStrings];
+	if (offset >= strings.size) return NULL;
+	const char *string = at(scene, strings.offset + offset);
+	// Has to end before the section does
+	return memchr(string, 0, (size_t)(strings.size - offset)) ? string : NULL;
+}
+
+static char *copyString(struct bakedScene *scene, const char *string) {
+	if (!string) return NULL;
+	const size_t length = strlen(string) + 1;
+	char *copy = allocBlock(&scene->pool, length);
+	memcpy(copy, string, length);
+	return copy;
+}
+
+static bool validHeader(const struct bakedScene *scene, const char *path) {
+	const struct bakedHeader *header = scene->header;
+	if (scene->file.size < sizeof(*header) || header->magic != BAKED_MAGIC) {
+		logr(warning, "%s isn't a baked scene\n", path);
+		return false;
+	}
+	if (header->version != BAKED_VERSION
+		|| header->pointerSize != sizeof(void *)
+		|| header->polySize != sizeof(struct poly)
+		|| header->bvhNodeSize != bvhNodeSize()
+		|| header->materialSize != sizeof(struct material)
+		|| header->textureSize != sizeof(struct texture)
+		|| header->placementSize != sizeof(struct meshPlacement)) {
+		logr(warning, "%s was baked by an incompatible version of C-ray, bake it again\n", path);
+		return false;
+	}
+	for (int i = 0; i < sectionCount; ++i) {
+		if (!inFile(scene, header->sections[i].offset, header->sections[i].size, 1)) {
+			logr(warning, "Baked scene %s is truncated\n", path);
+			return false;
+		}
+	}
+	const struct bakedRange json = header->sections[sectionJSON];
+	if (!json.size || ((const char *)at(scene, json.offset))[json.size - 1] != 0) return false;
+	return true;
+}
+
+// Headers for each texture and its mips, pointing at texels in the file
+static bool openTextures(struct bakedScene *scene) {
+	size_t levelCount = 0;
+	const struct bakedTexture *records = section(scene, sectionTextures, &scene->textureCount, sizeof(*records));
+	const struct bakedLevel *levels = section(scene, sectionLevels, &levelCount, sizeof(*levels));
+	scene->textures = allocBlock(&scene->pool, max(scene->textureCount, (size_t)1) * sizeof(*scene->textures));
+	for (size_t i = 0; i < scene->textureCount; ++i) {
+		const struct bakedTexture *record = &records[i];
+		if (!record->levelCount || record->firstLevel > levelCount || record->levelCount > levelCount - record->firstLevel) return false;
+		// Records sharing texels share a texture too
+		size_t first = 0;
+		while (first < i && records[first].firstLevel != record->firstLevel) first++;
+		if (first < i) {
+			scene->textures[i] = scene->textures[first];
+			continue;
+		}
+		struct texture *t = allocBlock(&scene->pool, record->levelCount * sizeof(*t));
+		for (size_t level = 0; level < record->levelCount; ++level) {
+			const struct bakedLevel *baked = &levels[record->firstLevel + level];
+			t[level] = baked->texture;
+			if (!inFile(scene, baked->data, textureLevelBytes(&t[level]), 1)) return false;
+			t[level].data.byte_p = (unsigned char *)at(scene, baked->data);
+			textureSelectFetch(&t[level]);
+		}
+		t->mips = record->levelCount > 1 ? t + 1 : NULL;
+		t->mipCount = record->levelCount - 1;
+		t->shared = true;
+		scene->textures[i] = t;
+	}
+	return true;
+}
+
+static struct texture *bakedTexture(const struct bakedScene *scene, int32_t index) {
+	return index >= 0 && (size_t)index < scene->textureCount ? scene->textures[index] : NULL;
+}
+
+static bool openMaterials(struct bakedScene *scene) {
+	const struct bakedMaterial *records = section(scene, sectionMaterials, &scene->materialCount, sizeof(*records));
+	scene->materials = allocBlock(&scene->pool, max(scene->materialCount, (size_t)1) * sizeof(*scene->materials));
+	for (size_t i = 0; i < scene->materialCount; ++i) {
+		struct material *m = &scene->materials[i];
+		*m = records[i].material;
+		m->name = copyString(scene, stringAt(scene, records[i].name));
+		m->texture = bakedTexture(scene, records[i].texture);
+		m->normalMap = bakedTexture(scene, records[i].normalMap);
+		m->specularMap = bakedTexture(scene, records[i].specularMap);
+		m->bsdf = NULL;
+	}
+	return true;
+}
+
+struct bakedScene *openBakedScene(const char *path, const char *assetPath) {
+	struct bakedScene *scene = calloc(1, sizeof(*scene));
+	scene->file = mapFile(path);
+	scene->header = (const struct bakedHeader *)scene->file.data;
+	scene->assetPath = stringCopy(assetPath);
+	scene->pool = newBlock(NULL, 1024);
+	if (!scene->file.data || !validHeader(scene, path) || !openTextures(scene) || !openMaterials(scene)) {
+		logr(warning, "Failed to open baked scene %s\n", path);
+		closeBakedScene(scene);
+		return NULL;
+	}
+	char *size = humanFileSize(scene->file.size);
+	logr(info, "Mapped baked scene %s (%s)\n", path, size);
+	free(size);
+	return scene;
+}
+
+const char *bakedSceneJSON(const struct bakedScene *scene) {
+	return at(scene, scene->header->sections[sectionJSON].offset);
+}
+
+// Arrays are checked to be within the file, but the polygon indices into them aren't
+static bool validMesh(const struct bakedScene *scene, const struct bakedMesh *mesh) {
+	return mesh->vertexCount >= 0 && inFile(scene, mesh->vertices, (uint64_t)mesh->vertexCount, sizeof(struct vector))
+		&& mesh->normalCount >= 0 && inFile(scene, mesh->normals, (uint64_t)mesh->normalCount, sizeof(struct vector))
+		&& inFile(scene, mesh->packedNormals, (uint64_t)mesh->normalCount, sizeof(uint32_t))
+		&& mesh->textureCoordCount >= 0 && inFile(scene, mesh->texCoords, (uint64_t)mesh->textureCoordCount, sizeof(struct coord))
+		&& inFile(scene, mesh->packedTexCoords, (uint64_t)mesh->textureCoordCount, sizeof(uint32_t))
+		&& mesh->polyCount >= 0 && inFile(scene, mesh->polygons, (uint64_t)mesh->polyCount, sizeof(struct poly))
+		&& inFile(scene, mesh->attributes, (uint64_t)mesh->polyCount, sizeof(struct polyAttributes))
+		&& inFile(scene, mesh->bvhNodes, mesh->bvhNodeCount, bvhNodeSize())
+		&& inFile(scene, mesh->bvhPrimIndices, mesh->bvhPrimCount, sizeof(int))
+		&& mesh->bvhPrimCount <= (uint32_t)mesh->polyCount
+		&& mesh->materialCount >= 0 && mesh->firstMaterial <= scene->materialCount
+		&& (size_t)mesh->materialCount <= scene->materialCount - mesh->firstMaterial;
+}
+
+struct mesh *loadBakedMeshes(struct bakedScene *scene, size_t entry, size_t *meshCount, struct meshPlacement **placements, size_t *placementCount) {
+	*meshCount = 0;
+	*placements = NULL;
+	*placementCount = 0;
+	size_t entryCount = 0, bakedMeshCount = 0, bakedPlacementCount = 0;
+	const struct bakedEntry *entries = section(scene, sectionEntries, &entryCount, sizeof(*entries));
+	const struct bakedMesh *meshes = section(scene, sectionMeshes, &bakedMeshCount, sizeof(*meshes));
+	const struct meshPlacement *bakedPlacements = section(scene, sectionPlacements, &bakedPlacementCount, sizeof(*bakedPlacements));
+	if (entry >= entryCount) return NULL;
+	const struct bakedEntry *e = &entries[entry];
+	if (!e->meshCount || e->firstMesh > bakedMeshCount || e->meshCount > bakedMeshCount - e->firstMesh) return NULL;
+	if (e->firstPlacement > bakedPlacementCount || e->placementCount > bakedPlacementCount - e->firstPlacement) return NULL;
+
+	struct mesh *new = calloc(e->meshCount, sizeof(*new));
+	for (size_t i = 0; i < e->meshCount; ++i) {
+		const struct bakedMesh *baked = &meshes[e->firstMesh + i];
+		if (!validMesh(scene, baked)) {
+			logr(warning, "Baked mesh %zu is corrupted\n", e->firstMesh + i);
+			free(new);
+			return NULL;
+		}
+		new[i] = (struct mesh){
+			.vertices = (struct vector *)optionalAt(scene, baked->vertices),
+			.vertexCount = baked->vertexCount,
+			.normals = (struct vector *)optionalAt(scene, baked->normals),
+			.packedNormals = (uint32_t *)optionalAt(scene, baked->packedNormals),
+			.normalCount = baked->normalCount,
+			.texCoords = (struct coord *)optionalAt(scene, baked->texCoords),
+			.packedTexCoords = (uint32_t *)optionalAt(scene, baked->packedTexCoords),
+			.textureCoordCount = baked->textureCoordCount,
+			.sharedVertices = baked->sharedVertices,
+			.polygons = (struct poly *)at(scene, baked->polygons),
+			.attributes = (struct polyAttributes *)optionalAt(scene, baked->attributes),
+			.polyCount = baked->polyCount,
+			.materialCount = baked->materialCount,
+			.materials = scene->materials + baked->firstMaterial,
+			.sharedMaterials = baked->sharedMaterials,
+			.rayOffset = baked->rayOffset,
+			.name = copyString(scene, stringAt(scene, baked->name))
+		};
+		if (baked->bvhNodeCount) {
+			new[i].bvh = wrapBvhData(at(scene, baked->bvhNodes), baked->bvhNodeCount, at(scene, baked->bvhPrimIndices), baked->bvhPrimCount, &scene->pool);
+		}
+	}
+	if (e->placementCount) {
+		*placements = malloc(e->placementCount * sizeof(**placements));
+		memcpy(*placements, bakedPlacements + e->firstPlacement, e->placementCount * sizeof(**placements));
+		*placementCount = e->placementCount;
+	}
+	*meshCount = e->meshCount;
+	return new;
+}
+
+struct texture *findBakedTexture(const struct bakedScene *scene, const char *path, enum colorspace colorspace, bool compress) {
+	const char *scenePath = relativePath(path, scene->assetPath);
+	size_t count = 0;
+	const struct bakedTexture *records = section(scene, sectionTextures, &count, sizeof(*records));
+	for (size_t i = 0; i < count; ++i) {
+		if (!records[i].path || records[i].colorspace != colorspace || records[i].compress != compress) continue;
+		const char *bakedPath = stringAt(scene, records[i].path);
+		if (bakedPath && stringEquals(bakedPath, path)) return scene->textures[i];
+		const char *bakedScenePath = records[i].scenePath ? stringAt(scene, records[i].scenePath) : NULL;
+		if (bakedScenePath && scenePath && stringEquals(bakedScenePath, scenePath)) return scene->textures[i];
+	}
+	return NULL;
+}
+
+void closeBakedScene(struct bakedScene *scene) {
+	if (!scene) return;
+	destroyBlocks(scene->pool);
+	if (scene->file.data) unmapFile(&scene->file);
+	free(scene->assetPath);
+	free(scene);
+}
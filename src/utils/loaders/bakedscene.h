@@ -0,0 +1,71 @@
+//
+//  bakedscene.h
+//  C-ray
+//
+//  Created by Valtteri Koskivuori on 18/10/2026.
+//  Copyright © 2026 Valtteri Koskivuori. All rights reserved.
+//
+
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include "../../datatypes/image/texture.h"
+
+// A loaded scene can be baked into a single file, holding its vertex data, polygons, BVHs, materials
+// and decoded textures, along with the scene description it was loaded from. Loading the file maps it,
+// and meshes and textures point straight into the mapping, so there's nothing to parse or build but the
+// scene description itself.
+// Everything is stored as offsets into the file, so it can be mapped anywhere. Structs are written as is,
+// so a file can only be loaded by a build that agrees on their layout.
+
+struct renderer;
+struct mesh;
+struct meshPlacement;
+struct block;
+struct bakedScene;
+
+// Noted down while loading a scene that's going to be baked
+struct bakeLog {
+	char *json;
+	// Textures loadTexture() returned, and what they were loaded from
+	struct bakedTextureLoad *textures;
+	size_t textureCount;
+	// Meshes and placements loaded for each mesh entry in the scene description, in order
+	struct bakedEntryLoad *entries;
+	size_t entryCount;
+};
+
+struct bakeLog *newBakeLog(const char *json);
+
+void bakeLogTexture(struct bakeLog *log, const char *path, enum colorspace colorspace, bool compress, const struct texture *texture);
+
+void bakeLogMeshEntry(struct bakeLog *log, size_t meshCount, const struct meshPlacement *placements, size_t placementCount);
+
+void destroyBakeLog(struct bakeLog *log);
+
+/// Write out a scene loaded with a bakeLog, to be loaded with openBakedScene()
+/// @return true if the whole file was written
+bool bakeScene(const struct renderer *r, const char *path);
+
+/// @return true if path starts like a baked scene file
+bool isBakedScene(const char *path);
+
+/// Map a file written by bakeScene()
+/// @param assetPath Directory of the file, textures are looked up relative to it
+/// @return NULL if the file is truncated, or was baked by an incompatible build
+struct bakedScene *openBakedScene(const char *path, const char *assetPath);
+
+/// @return Scene description the file was baked from
+const char *bakedSceneJSON(const struct bakedScene *scene);
+
+/// Meshes baked from one mesh entry in the scene description, in place of loadMesh().
+/// Their vertices, polygons, BVHs and textures point into the file, so they're released by closeBakedScene(), not destroyMesh().
+/// @param entry Index of the mesh entry
+struct mesh *loadBakedMeshes(struct bakedScene *scene, size_t entry, size_t *meshCount, struct meshPlacement **placements, size_t *placementCount);
+
+/// Find a texture that was loaded from path while baking, in place of decoding it again
+/// @return NULL if it wasn't baked
+struct texture *findBakedTexture(const struct bakedScene *scene, const char *path, enum colorspace colorspace, bool compress);
+
+void closeBakedScene(struct bakedScene *scene);
@@ -0,0 +1,586 @@
+//
+//  gltf.c
+//  C-ray
+//
+//  Created by Valtteri Koskivuori on 18/10/2026.
+//  Copyright © 2026 Valtteri Koskivuori. All rights reserved.
+//
+
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include "../../../../includes.h"
+#include "../../../../datatypes/mesh.h"
+#include "../../../../datatypes/vector.h"
+#include "../../../../datatypes/poly.h"
+#include "../../../../datatypes/material.h"
+#include "../../../../datatypes/transforms.h"
+#include "../../../../datatypes/image/texture.h"
+#include "../../../../libraries/cJSON.h"
+#include "../../../logging.h"
+#include "../../../string.h"
+#include "../../../fileio.h"
+#include "../../../base64.h"
+#include "../../textureloader.h"
+#include "../../meshloader.h"
+
+#include "gltf.h"
+
+// Buffers are mapped, and accessors point straight into them. Vertex data is read from there into the arrays
+// of each mesh, positions with a single copy when their layout matches, and embedded images are decoded
+// from there too. Nothing is copied into an intermediate buffer first.
+// Meshes own their arrays and free them, and compacting attributes replaces them, so they can't point into
+// the mapping itself.
+
+#define GLB_MAGIC 0x46546C67 // "glTF"
+#define GLB_CHUNK_JSON 0x4E4F534A
+#define GLB_CHUNK_BIN 0x004E4942
+
+#define GLTF_BYTE 5120
+#define GLTF_UNSIGNED_BYTE 5121
+#define GLTF_SHORT 5122
+#define GLTF_UNSIGNED_SHORT 5123
+#define GLTF_UNSIGNED_INT 5125
+#define GLTF_FLOAT 5126
+
+#define GLTF_TRIANGLES 4
+
+// Node hierarchies deeper than this are assumed to have a cycle
+#define GLTF_MAX_DEPTH 128
+
+struct gltfBuffer {
+	const char *data;
+	size_t size;
+	struct fileView file; // Set if the buffer is an external file
+	void *decoded; // Set if the buffer is a data URI
+};
+
+struct gltfFile {
+	cJSON *json;
+	struct fileView glb;
+	struct gltfBuffer *buffers;
+	size_t bufferCount;
+	char *assetPath;
+};
+
+struct gltfAccessor {
+	const char *data; // First element
+	size_t count;
+	size_t stride;
+	int componentType;
+	size_t components;
+	bool normalized;
+};
+
+static uint32_t readLE32(const char *p) {
+	const unsigned char *b = (const unsigned char *)p;
+	return (uint32_t)b[0] | (uint32_t)b[1] << 8 | (uint32_t)b[2] << 16 | (uint32_t)b[3] << 24;
+}
+
+static int intItem(const cJSON *object, const char *name, int fallback) {
+	const cJSON *item = cJSON_GetObjectItem(object, name);
+	return cJSON_IsNumber(item) ? item->valueint : fallback;
+}
+
+static float floatItem(const cJSON *object, const char *name, float fallback) {
+	const cJSON *item = cJSON_GetObjectItem(object, name);
+	return cJSON_IsNumber(item) ? (float)item->valuedouble : fallback;
+}
+
+static size_t componentSize(int componentType) {
+	switch (componentType) {
+		case GLTF_BYTE:
+		case GLTF_UNSIGNED_BYTE: return 1;
+		case GLTF_SHORT:
+		case GLTF_UNSIGNED_SHORT: return 2;
+		case GLTF_UNSIGNED_INT:
+		case GLTF_FLOAT: return 4;
+		default: return 0;
+	}
+}
+
+static size_t componentCount(const char *type) {
+	if (!type) return 0;
+	if (stringEquals(type, "SCALAR")) return 1;
+	if (stringEquals(type, "VEC2")) return 2;
+	if (stringEquals(type, "VEC3")) return 3;
+	if (stringEquals(type, "VEC4")) return 4;
+	return 0;
+}
+
+static bool openBuffers(struct gltfFile *file, const char *binChunk, size_t binSize) {
+	const cJSON *buffers = cJSON_GetObjectItem(file->json, "buffers");
+	file->bufferCount = (size_t)cJSON_GetArraySize(buffers);
+	file->buffers = calloc(max(file->bufferCount, (size_t)1), sizeof(*file->buffers));
+	for (size_t i = 0; i < file->bufferCount; ++i) {
+		const cJSON *buffer = cJSON_GetArrayItem(buffers, (int)i);
+		const cJSON *uri = cJSON_GetObjectItem(buffer, "uri");
+		const size_t byteLength = (size_t)floatItem(buffer, "byteLength", 0.0f);
+		struct gltfBuffer *b = &file->buffers[i];
+		if (!cJSON_IsString(uri)) {
+			// The first buffer without a URI is the binary chunk of a GLB
+			if (i != 0 || !binChunk) return false;
+			b->data = binChunk;
+			b->size = binSize;
+		} else if (stringStartsWith("data:", uri->valuestring)) {
+			const char *payload = strstr(uri->valuestring, ";base64,");
+			if (!payload) return false;
+			payload += strlen(";base64,");
+			b->decoded = b64decode(payload, strlen(payload), &b->size);
+			b->data = b->decoded;
+		} else {
+			char *path = stringConcat(file->assetPath, uri->valuestring);
+			windowsFixPath(path);
+			b->file = mapFile(path);
+			free(path);
+			b->data = b->file.data;
+			b->size = b->file.size;
+		}
+		if (!b->data || b->size < byteLength) return false;
+	}
+	return true;
+}
+
+static void closeFile(struct gltfFile *file) {
+	for (size_t i = 0; i < file->bufferCount; ++i) {
+		if (file->buffers[i].file.data) unmapFile(&file->buffers[i].file);
+		free(file->buffers[i].decoded);
+	}
+	free(file->buffers);
+	cJSON_Delete(file->json);
+	if (file->glb.data) unmapFile(&file->glb);
+	free(file->assetPath);
+}
+
+// Range of bytes in a buffer view, after checking it fits in its buffer
+static const char *bufferViewData(const struct gltfFile *file, int index, size_t *size, size_t *stride) {
+	const cJSON *view = cJSON_GetArrayItem(cJSON_GetObjectItem(file->json, "bufferViews"), index);
+	if (!view) return NULL;
+	const int buffer = intItem(view, "buffer", -1);
+	if (buffer < 0 || (size_t)buffer >= file->bufferCount) return NULL;
+	const size_t offset = (size_t)floatItem(view, "byteOffset", 0.0f);
+	const size_t length = (size_t)floatItem(view, "byteLength", 0.0f);
+	if (offset > file->buffers[buffer].size || length > file->buffers[buffer].size - offset) return NULL;
+	*size = length;
+	if (stride) *stride = (size_t)intItem(view, "byteStride", 0);
+	return file->buffers[buffer].data + offset;
+}
+
+static bool getAccessor(const struct gltfFile *file, int index, struct gltfAccessor *out) {
+	const cJSON *accessor = cJSON_GetArrayItem(cJSON_GetObjectItem(file->json, "accessors"), index);
+	if (!accessor) return false;
+	if (cJSON_GetObjectItem(accessor, "sparse")) {
+		logr(warning, "Sparse glTF accessors aren't supported\n");
+		return false;
+	}
+	const cJSON *type = cJSON_GetObjectItem(accessor, "type");
+	*out = (struct gltfAccessor){
+		.count = (size_t)intItem(accessor, "count", 0),
+		.componentType = intItem(accessor, "componentType", 0),
+		.components = componentCount(cJSON_IsString(type) ? type->valuestring : NULL),
+		.normalized = cJSON_IsTrue(cJSON_GetObjectItem(accessor, "normalized")),
+	};
+	const size_t elementSize = componentSize(out->componentType) * out->components;
+	if (!elementSize) return false;
+	size_t viewSize = 0;
+	const char *view = bufferViewData(file, intItem(accessor, "bufferView", -1), &viewSize, &out->stride);
+	if (!view) return false;
+	if (!out->stride) out->stride = elementSize;
+	const size_t offset = (size_t)intItem(accessor, "byteOffset", 0);
+	if (out->count && (offset > viewSize || (out->count - 1) * out->stride + elementSize > viewSize - offset)) return false;
+	out->data = view + offset;
+	return true;
+}
+
+static float readComponent(const struct gltfAccessor *a, const char *p) {
+	switch (a->componentType) {
+		case GLTF_FLOAT: { float v; memcpy(&v, p, 4); return v; }
+		case GLTF_UNSIGNED_BYTE: return a->normalized ? *(const unsigned char *)p / 255.0f : *(const unsigned char *)p;
+		case GLTF_BYTE: return a->normalized ? max(*(const signed char *)p / 127.0f, -1.0f) : *(const signed char *)p;
+		case GLTF_UNSIGNED_SHORT: { uint16_t v; memcpy(&v, p, 2); return a->normalized ? v / 65535.0f : v; }
+		case GLTF_SHORT: { int16_t v; memcpy(&v, p, 2); return a->normalized ? max(v / 32767.0f, -1.0f) : v; }
+		case GLTF_UNSIGNED_INT: { uint32_t v; memcpy(&v, p, 4); return (float)v; }
+		default: return 0.0f;
+	}
+}
+
+static void readVectors(const struct gltfAccessor *a, struct vector *out) {
+	// Tightly packed floats have the same layout as our vectors
+	if (a->componentType == GLTF_FLOAT && a->stride == sizeof(struct vector) && sizeof(struct vector) == 3 * sizeof(float)) {
+		memcpy(out, a->data, a->count * sizeof(struct vector));
+		return;
+	}
+	const size_t size = componentSize(a->componentType);
+	for (size_t i = 0; i < a->count; ++i) {
+		const char *p = a->data + i * a->stride;
+		out[i] = (struct vector){ readComponent(a, p), readComponent(a, p + size), readComponent(a, p + 2 * size) };
+	}
+}
+
+// glTF puts the origin of texture coordinates at the top left of the image, we put it at the bottom left
+static void readCoords(const struct gltfAccessor *a, struct coord *out) {
+	const size_t size = componentSize(a->componentType);
+	for (size_t i = 0; i < a->count; ++i) {
+		const char *p = a->data + i * a->stride;
+		out[i] = (struct coord){ readComponent(a, p), 1.0f - readComponent(a, p + size) };
+	}
+}
+
+static uint32_t readIndex(const struct gltfAccessor *a, size_t i) {
+	const char *p = a->data + i * a->stride;
+	switch (a->componentType) {
+		case GLTF_UNSIGNED_BYTE: return *(const unsigned char *)p;
+		case GLTF_UNSIGNED_SHORT: { uint16_t v; memcpy(&v, p, 2); return v; }
+		case GLTF_UNSIGNED_INT: { uint32_t v; memcpy(&v, p, 4); return v; }
+		default: return UINT32_MAX;
+	}
+}
+
+// Accessors of one triangle list primitive
+struct gltfPrimitive {
+	struct gltfAccessor positions;
+	struct gltfAccessor normals;
+	struct gltfAccessor coords;
+	struct gltfAccessor indices;
+	bool hasNormals, hasCoords, indexed;
+	int material;
+};
+
+static bool getPrimitive(const struct gltfFile *file, const cJSON *primitive, struct gltfPrimitive *out) {
+	*out = (struct gltfPrimitive){ .material = intItem(primitive, "material", -1) };
+	if (intItem(primitive, "mode", GLTF_TRIANGLES) != GLTF_TRIANGLES) return false;
+	const cJSON *attributes = cJSON_GetObjectItem(primitive, "attributes");
+	if (!getAccessor(file, intItem(attributes, "POSITION", -1), &out->positions) || out->positions.components != 3) return false;
+	out->hasNormals = getAccessor(file, intItem(attributes, "NORMAL", -1), &out->normals);
+	out->hasNormals = out->hasNormals && out->normals.components == 3 && out->normals.count == out->positions.count;
+	out->hasCoords = getAccessor(file, intItem(attributes, "TEXCOORD_0", -1), &out->coords);
+	out->hasCoords = out->hasCoords && out->coords.components == 2 && out->coords.count == out->positions.count;
+	if (cJSON_GetObjectItem(primitive, "indices")) {
+		if (!getAccessor(file, intItem(primitive, "indices", -1), &out->indices) || out->indices.components != 1) return false;
+		out->indexed = true;
+	}
+	return true;
+}
+
+static size_t primitiveTriangles(const struct gltfPrimitive *p) {
+	return (p->indexed ? p->indices.count : p->positions.count) / 3;
+}
+
+static struct texture *loadImage(const struct gltfFile *file, const cJSON *textureInfo) {
+	if (!textureInfo) return NULL;
+	const cJSON *texture = cJSON_GetArrayItem(cJSON_GetObjectItem(file->json, "textures"), intItem(textureInfo, "index", -1));
+	const cJSON *image = cJSON_GetArrayItem(cJSON_GetObjectItem(file->json, "images"), intItem(texture, "source", -1));
+	if (!image) return NULL;
+	const cJSON *uri = cJSON_GetObjectItem(image, "uri");
+	if (cJSON_IsString(uri) && !stringStartsWith("data:", uri->valuestring)) {
+		char *path = stringConcat(file->assetPath, uri->valuestring);
+		windowsFixPath(path);
+		struct texture *t = loadTexture(path, sRGB, false, NULL);
+		free(path);
+		return t;
+	}
+	const char *data = NULL;
+	size_t size = 0;
+	void *decoded = NULL;
+	if (cJSON_IsString(uri)) {
+		const char *payload = strstr(uri->valuestring, ";base64,");
+		if (!payload) return NULL;
+		payload += strlen(";base64,");
+		data = decoded = b64decode(payload, strlen(payload), &size);
+	} else {
+		data = bufferViewData(file, intItem(image, "bufferView", -1), &size, NULL);
+	}
+	struct texture *t = data ? loadTextureFromBuffer((const unsigned char *)data, (unsigned int)size, NULL) : NULL;
+	free(decoded);
+	if (!t) return NULL;
+	t->colorspace = sRGB;
+	textureSelectFetch(t);
+	generateMipmaps(t, NULL);
+	return t;
+}
+
+// Metal-roughness materials, as close as our material model gets. The node graphs are built from these
+// by assignBSDF() once the scene is loaded, unless the scene overrides them.
+static struct material parseMaterial(const struct gltfFile *file, const cJSON *data, size_t index) {
+	struct material m = defaultMaterial();
+	const cJSON *name = cJSON_GetObjectItem(data, "name");
+	if (cJSON_IsString(name)) {
+		m.name = stringCopy(name->valuestring);
+	} else {
+		char buffer[32];
+		snprintf(buffer, sizeof(buffer), "material %zu", index);
+		m.name = stringCopy(buffer);
+	}
+	const cJSON *pbr = cJSON_GetObjectItem(data, "pbrMetallicRoughness");
+	const cJSON *baseColor = cJSON_GetObjectItem(pbr, "baseColorFactor");
+	m.diffuse = (struct color){ 1.0f, 1.0f, 1.0f, 1.0f };
+	if (cJSON_GetArraySize(baseColor) == 4) {
+		m.diffuse = (struct color){
+			(float)cJSON_GetArrayItem(baseColor, 0)->valuedouble,
+			(float)cJSON_GetArrayItem(baseColor, 1)->valuedouble,
+			(float)cJSON_GetArrayItem(baseColor, 2)->valuedouble,
+			(float)cJSON_GetArrayItem(baseColor, 3)->valuedouble
+		};
+	}
+	m.texture = loadImage(file, cJSON_GetObjectItem(pbr, "baseColorTexture"));
+	m.roughness = floatItem(pbr, "roughnessFactor", 1.0f);
+	// illum 5 makes assignBSDF() pick a metal
+	if (floatItem(pbr, "metallicFactor", 1.0f) >= 0.5f) m.illum = 5;
+	const cJSON *emissive = cJSON_GetObjectItem(data, "emissiveFactor");
+	if (cJSON_GetArraySize(emissive) == 3) {
+		m.emission = (struct color){
+			(float)cJSON_GetArrayItem(emissive, 0)->valuedouble,
+			(float)cJSON_GetArrayItem(emissive, 1)->valuedouble,
+			(float)cJSON_GetArrayItem(emissive, 2)->valuedouble,
+			1.0f
+		};
+	}
+	return m;
+}
+
+// Either a matrix, or translation, rotation and scale, applied in that order
+static struct matrix4x4 nodeMatrix(const cJSON *node) {
+	struct matrix4x4 m = newTransform().A;
+	const cJSON *matrix = cJSON_GetObjectItem(node, "matrix");
+	if (cJSON_GetArraySize(matrix) == 16) {
+		// Column major
+		for (int i = 0; i < 16; ++i) m.mtx[i % 4][i / 4] = (float)cJSON_GetArrayItem(matrix, i)->valuedouble;
+		return m;
+	}
+	const cJSON *t = cJSON_GetObjectItem(node, "translation");
+	if (cJSON_GetArraySize(t) == 3) {
+		m = newTransformTranslate((float)cJSON_GetArrayItem(t, 0)->valuedouble, (float)cJSON_GetArrayItem(t, 1)->valuedouble, (float)cJSON_GetArrayItem(t, 2)->valuedouble).A;
+	}
+	const cJSON *r = cJSON_GetObjectItem(node, "rotation");
+	if (cJSON_GetArraySize(r) == 4) {
+		const float x = (float)cJSON_GetArrayItem(r, 0)->valuedouble;
+		const float y = (float)cJSON_GetArrayItem(r, 1)->valuedouble;
+		const float z = (float)cJSON_GetArrayItem(r, 2)->valuedouble;
+		const float w = (float)cJSON_GetArrayItem(r, 3)->valuedouble;
+		struct matrix4x4 rotation = newTransform().A;
+		rotation.mtx[0][0] = 1.0f - 2.0f * (y * y + z * z);
+		rotation.mtx[0][1] = 2.0f * (x * y - z * w);
+		rotation.mtx[0][2] = 2.0f * (x * z + y * w);
+		rotation.mtx[1][0] = 2.0f * (x * y + z * w);
+		rotation.mtx[1][1] = 1.0f - 2.0f * (x * x + z * z);
+		rotation.mtx[1][2] = 2.0f * (y * z - x * w);
+		rotation.mtx[2][0] = 2.0f * (x * z - y * w);
+		rotation.mtx[2][1] = 2.0f * (y * z + x * w);
+		rotation.mtx[2][2] = 1.0f - 2.0f * (x * x + y * y);
+		m = multiplyMatrices(&m, &rotation);
+	}
+	const cJSON *s = cJSON_GetObjectItem(node, "scale");
+	if (cJSON_GetArraySize(s) == 3) {
+		const struct matrix4x4 scale = newTransformScale((float)cJSON_GetArrayItem(s, 0)->valuedouble, (float)cJSON_GetArrayItem(s, 1)->valuedouble, (float)cJSON_GetArrayItem(s, 2)->valuedouble).A;
+		m = multiplyMatrices(&m, &scale);
+	}
+	return m;
+}
+
+struct placementList {
+	struct meshPlacement *items;
+	size_t count, capacity;
+};
+
+static void placeNode(const struct gltfFile *file, int index, const struct matrix4x4 *parent, const int *meshMap, size_t gltfMeshCount, struct placementList *list, int depth) {
+	const cJSON *node = cJSON_GetArrayItem(cJSON_GetObjectItem(file->json, "nodes"), index);
+	if (!node || depth > GLTF_MAX_DEPTH) return;
+	const struct matrix4x4 local = nodeMatrix(node);
+	const struct matrix4x4 world = multiplyMatrices(parent, &local);
+	const int mesh = intItem(node, "mesh", -1);
+	if (mesh >= 0 && (size_t)mesh < gltfMeshCount && meshMap[mesh] >= 0) {
+		if (list->count == list->capacity) {
+			list->capacity = list->capacity ? list->capacity * 2 : 16;
+			list->items = realloc(list->items, list->capacity * sizeof(*list->items));
+		}
+		list->items[list->count++] = (struct meshPlacement){
+			.mesh = (size_t)meshMap[mesh],
+			.transform = { .type = transformTypeComposite, .A = world, .Ainv = inverseMatrix(&world) }
+		};
+	}
+	const cJSON *child = NULL;
+	cJSON_ArrayForEach(child, cJSON_GetObjectItem(node, "children")) {
+		if (cJSON_IsNumber(child)) placeNode(file, child->valueint, &world, meshMap, gltfMeshCount, list, depth + 1);
+	}
+}
+
+static bool openFile(const char *filePath, struct gltfFile *file) {
+	file->assetPath = getFilePath(filePath);
+	file->glb = mapFile(filePath);
+	if (!file->glb.data) return false;
+	const char *json = file->glb.data;
+	size_t jsonSize = file->glb.size;
+	const char *bin = NULL;
+	size_t binSize = 0;
+	if (file->glb.size >= 12 && readLE32(file->glb.data) == GLB_MAGIC) {
+		// 12 byte header, then chunks with their length and type up front
+		if (readLE32(file->glb.data + 4) != 2) {
+			logr(warning, "Only glTF 2.0 files are supported\n");
+			return false;
+		}
+		json = NULL;
+		const size_t length = min((size_t)readLE32(file->glb.data + 8), file->glb.size);
+		for (size_t offset = 12; offset + 8 <= length; ) {
+			const size_t chunkLength = readLE32(file->glb.data + offset);
+			const uint32_t chunkType = readLE32(file->glb.data + offset + 4);
+			offset += 8;
+			if (chunkLength > length - offset) return false;
+			if (chunkType == GLB_CHUNK_JSON && !json) {
+				json = file->glb.data + offset;
+				jsonSize = chunkLength;
+			} else if (chunkType == GLB_CHUNK_BIN && !bin) {
+				bin = file->glb.data + offset;
+				binSize = chunkLength;
+			}
+			offset += (chunkLength + 3) & ~(size_t)3;
+		}
+		if (!json) return false;
+	}
+	file->json = cJSON_ParseWithLength(json, jsonSize);
+	if (!file->json) return false;
+	return openBuffers(file, bin, binSize);
+}
+
+struct mesh *parseGltf(const char *filePath, size_t *finalMeshCount, struct meshPlacement **placements, size_t *placementCount) {
+	if (placements) *placements = NULL;
+	if (placementCount) *placementCount = 0;
+	struct gltfFile file = { 0 };
+	if (!openFile(filePath, &file)) {
+		logr(warning, "Failed to open glTF file %s\n", filePath);
+		closeFile(&file);
+		return NULL;
+	}
+	logr(debug, "Loading glTF at %s\n", filePath);
+
+	// Count everything up front, so every array is allocated once at its final size
+	const cJSON *gltfMeshes = cJSON_GetObjectItem(file.json, "meshes");
+	const size_t gltfMeshCount = (size_t)cJSON_GetArraySize(gltfMeshes);
+	int *meshMap = calloc(max(gltfMeshCount, (size_t)1), sizeof(*meshMap));
+	struct mesh *meshes = calloc(max(gltfMeshCount, (size_t)1), sizeof(*meshes));
+	size_t meshCount = 0, skipped = 0;
+	for (size_t i = 0; i < gltfMeshCount; ++i) {
+		const cJSON *primitive = NULL;
+		struct mesh counts = { 0 };
+		cJSON_ArrayForEach(primitive, cJSON_GetObjectItem(cJSON_GetArrayItem(gltfMeshes, (int)i), "primitives")) {
+			struct gltfPrimitive p;
+			if (!getPrimitive(&file, primitive, &p)) {
+				skipped++;
+				continue;
+			}
+			counts.vertexCount += (int)p.positions.count;
+			counts.normalCount += p.hasNormals ? (int)p.normals.count : 0;
+			counts.textureCoordCount += p.hasCoords ? (int)p.coords.count : 0;
+			counts.polyCount += (int)primitiveTriangles(&p);
+		}
+		meshMap[i] = counts.polyCount ? (int)meshCount : -1;
+		if (counts.polyCount) meshes[meshCount++] = counts;
+	}
+	if (skipped) logr(warning, "Skipped %zu glTF primitives that aren't triangle lists, or have invalid accessors\n", skipped);
+	if (!meshCount) {
+		free(meshes);
+		free(meshMap);
+		closeFile(&file);
+		return NULL;
+	}
+
+	// Materials are shared by every mesh in the file, owned by the first one. The last one is for primitives without one.
+	const cJSON *gltfMaterials = cJSON_GetObjectItem(file.json, "materials");
+	const int materialCount = cJSON_GetArraySize(gltfMaterials) + 1;
+	struct material *materials = calloc(materialCount, sizeof(*materials));
+	for (int i = 0; i < materialCount - 1; ++i) {
+		materials[i] = parseMaterial(&file, cJSON_GetArrayItem(gltfMaterials, i), (size_t)i);
+	}
+	materials[materialCount - 1] = defaultMaterial();
+
+	bool valid = true;
+	for (size_t i = 0; i < gltfMeshCount && valid; ++i) {
+		if (meshMap[i] < 0) continue;
+		const cJSON *gltfMesh = cJSON_GetArrayItem(gltfMeshes, (int)i);
+		struct mesh *mesh = &meshes[meshMap[i]];
+		const cJSON *name = cJSON_GetObjectItem(gltfMesh, "name");
+		if (cJSON_IsString(name)) {
+			mesh->name = stringCopy(name->valuestring);
+		} else {
+			char buffer[32];
+			snprintf(buffer, sizeof(buffer), "mesh %zu", i);
+			mesh->name = stringCopy(buffer);
+		}
+		mesh->materials = materials;
+		mesh->materialCount = materialCount;
+		mesh->sharedMaterials = meshMap[i] > 0;
+		mesh->vertices = malloc(mesh->vertexCount * sizeof(*mesh->vertices));
+		if (mesh->normalCount) mesh->normals = malloc(mesh->normalCount * sizeof(*mesh->normals));
+		if (mesh->textureCoordCount) mesh->texCoords = malloc(mesh->textureCoordCount * sizeof(*mesh->texCoords));
+		mesh->polygons = malloc(mesh->polyCount * sizeof(*mesh->polygons));
+		mesh->attributes = malloc(mesh->polyCount * sizeof(*mesh->attributes));
+
+		// Primitives are appended one after another, counted up again as they're read
+		int vertices = 0, normals = 0, coords = 0, polys = 0;
+		const cJSON *primitive = NULL;
+		cJSON_ArrayForEach(primitive, cJSON_GetObjectItem(gltfMesh, "primitives")) {
+			if (!valid) break;
+			struct gltfPrimitive p;
+			if (!getPrimitive(&file, primitive, &p)) continue;
+			const int firstVertex = vertices;
+			const int firstNormal = p.hasNormals ? normals : -1;
+			const int firstCoord = p.hasCoords ? coords : -1;
+			readVectors(&p.positions, mesh->vertices + vertices);
+			vertices += (int)p.positions.count;
+			if (p.hasNormals) {
+				readVectors(&p.normals, mesh->normals + normals);
+				normals += (int)p.normals.count;
+			}
+			if (p.hasCoords) {
+				readCoords(&p.coords, mesh->texCoords + coords);
+				coords += (int)p.coords.count;
+			}
+
+			const size_t triangles = primitiveTriangles(&p);
+			const int material = p.material >= 0 && p.material < materialCount - 1 ? p.material : materialCount - 1;
+			for (size_t t = 0; t < triangles && valid; ++t) {
+				struct polyAttributes *attributes = &mesh->attributes[polys];
+				struct poly *poly = &mesh->polygons[polys++];
+				*poly = (struct poly){ .vertexCount = MAX_CRAY_VERTEX_COUNT, .materialIndex = material, .hasNormals = p.hasNormals, .hasTexCoords = p.hasCoords };
+				for (int c = 0; c < MAX_CRAY_VERTEX_COUNT; ++c) {
+					const uint32_t index = p.indexed ? readIndex(&p.indices, t * 3 + c) : (uint32_t)(t * 3 + c);
+					if (index >= p.positions.count) {
+						valid = false;
+						break;
+					}
+					poly->vertexIndex[c] = firstVertex + (int)index;
+					attributes->normalIndex[c] = p.hasNormals ? firstNormal + (int)index : -1;
+					attributes->textureIndex[c] = p.hasCoords ? firstCoord + (int)index : -1;
+				}
+			}
+		}
+	}
+	if (!valid) {
+		logr(warning, "glTF file %s has indices past the end of its vertices\n", filePath);
+		for (size_t i = 0; i < meshCount; ++i) destroyMesh(&meshes[i]);
+		free(meshes);
+		free(meshMap);
+		closeFile(&file);
+		return NULL;
+	}
+
+	// Meshes are placed where the nodes in the default scene put them
+	struct placementList list = { 0 };
+	const cJSON *scenes = cJSON_GetObjectItem(file.json, "scenes");
+	const cJSON *scene = cJSON_GetArrayItem(scenes, intItem(file.json, "scene", 0));
+	const struct matrix4x4 identity = newTransform().A;
+	const cJSON *root = NULL;
+	cJSON_ArrayForEach(root, cJSON_GetObjectItem(scene, "nodes")) {
+		if (cJSON_IsNumber(root)) placeNode(&file, root->valueint, &identity, meshMap, gltfMeshCount, &list, 0);
+	}
+	if (placements) {
+		*placements = list.items;
+		*placementCount = list.count;
+	} else {
+		free(list.items);
+	}
+
+	free(meshMap);
+	closeFile(&file);
+	if (finalMeshCount) *finalMeshCount = meshCount;
+	return meshes;
+}
@@ -0,0 +1,17 @@
+//
+//  gltf.h
+//  C-ray
+//
+//  Created by Valtteri Koskivuori on 18/10/2026.
+//  Copyright © 2026 Valtteri Koskivuori. All rights reserved.
+//
+
+#pragma once
+
+struct meshPlacement;
+
+/// Load the meshes in a glTF 2.0 file, binary (.glb) or with external buffers (.gltf)
+/// @param meshCount Set to the amount of meshes returned
+/// @param placements Set to where the node hierarchy of the default scene places those meshes, if the file has one
+/// @param placementCount Set to the amount of placements
+struct mesh *parseGltf(const char *filePath, size_t *meshCount, struct meshPlacement **placements, size_t *placementCount);
@@ -0,0 +1,100 @@
+//
+//  parsing.h
+//  C-Ray
+//
+//  Created by Valtteri Koskivuori on 18/10/2026.
+//  Copyright © 2026 Valtteri Koskivuori. All rights reserved.
+//
+
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Number parsing for text formats, straight from a mapped file. Nothing here needs a terminated string.
+
+static inline bool isSpace(char c) {
+	return c == ' ' || c == '\t' || c == '\r';
+}
+
+static inline bool isDigit(char c) {
+	return (unsigned)(c - '0') < 10;
+}
+
+static inline const char *skipSpace(const char *p, const char *end) {
+	while (p < end && isSpace(*p)) p++;
+	return p;
+}
+
+static inline const char *tokenEnd(const char *p, const char *end) {
+	while (p < end && !isSpace(*p)) p++;
+	return p;
+}
+
+static const double powersOf10[] = {
+	1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+	1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+
+// atof() needs a terminated string, and checks the locale on every call. Up to 2^53 and 10^22, both the
+// digits and the power of ten are exact in a double, so the one division or multiplication rounds just like
+// strtod() does. Anything longer or more extreme goes through strtod() instead.
+static inline const char *parseFloat(const char *p, const char *end, float *out) {
+	const char *start = p;
+	const bool negative = p < end && *p == '-';
+	if (p < end && (*p == '-' || *p == '+')) p++;
+	uint64_t mantissa = 0;
+	int exponent = 0;
+	bool exact = true;
+	bool digits = false;
+	for (; p < end && isDigit(*p); ++p, digits = true) {
+		if (mantissa < (1ull << 53) / 10) {
+			mantissa = mantissa * 10 + (uint64_t)(*p - '0');
+		} else {
+			exact = false;
+		}
+	}
+	if (p < end && *p == '.') {
+		for (++p; p < end && isDigit(*p); ++p, digits = true) {
+			if (mantissa < (1ull << 53) / 10) {
+				mantissa = mantissa * 10 + (uint64_t)(*p - '0');
+				exponent--;
+			} else {
+				exact = false;
+			}
+		}
+	}
+	if (digits && p < end && (*p == 'e' || *p == 'E')) {
+		const char *e = p + 1;
+		const bool negativeExponent = e < end && *e == '-';
+		if (e < end && (*e == '-' || *e == '+')) e++;
+		int value = 0;
+		for (; e < end && isDigit(*e); ++e) value = min(value * 10 + (*e - '0'), 1000);
+		exponent += negativeExponent ? -value : value;
+		p = e;
+	}
+	if (digits && exact && exponent >= -22 && exponent <= 22) {
+		const double value = exponent < 0 ? mantissa / powersOf10[-exponent] : mantissa * powersOf10[exponent];
+		*out = (float)(negative ? -value : value);
+		return p;
+	}
+	// Long mantissas, large exponents, infinities and NaNs
+	char buffer[64];
+	const size_t length = min((size_t)(tokenEnd(start, end) - start), sizeof(buffer) - 1);
+	memcpy(buffer, start, length);
+	buffer[length] = '\0';
+	char *parsed = NULL;
+	*out = strtof(buffer, &parsed);
+	return start + (parsed - buffer);
+}
+
+static inline const char *parseInt(const char *p, const char *end, int *out) {
+	const bool negative = p < end && *p == '-';
+	if (p < end && (*p == '-' || *p == '+')) p++;
+	int value = 0;
+	for (; p < end && isDigit(*p); ++p) value = value * 10 + (*p - '0');
+	*out = negative ? -value : value;
+	return p;
+}
@@ -0,0 +1,451 @@
+//
+//  ply.c
+//  C-ray
+//
+//  Created by Valtteri Koskivuori on 18/10/2026.
+//  Copyright © 2026 Valtteri Koskivuori. All rights reserved.
+//
+
+#include <string.h>
+#include "../../../../includes.h"
+#include "../../../../datatypes/mesh.h"
+#include "../../../../datatypes/vector.h"
+#include "../../../../datatypes/poly.h"
+#include "../../../../datatypes/material.h"
+#include "../../../logging.h"
+#include "../../../string.h"
+#include "../../../fileio.h"
+#include "../parsing.h"
+
+#include "ply.h"
+
+// The file is mapped, and the vertex and face elements are read straight from it into the mesh's own
+// arrays and the polygon array, in one pass. Vertex arrays are allocated at the size the header gives.
+// Elements we don't use are skipped over.
+
+#define PLY_MAX_ELEMENTS 16
+#define PLY_MAX_PROPERTIES 32
+#define PLY_MAX_NAME 32
+
+enum plyType {
+	ply_invalid = 0,
+	ply_int8,
+	ply_uint8,
+	ply_int16,
+	ply_uint16,
+	ply_int32,
+	ply_uint32,
+	ply_float32,
+	ply_float64,
+};
+
+static const size_t plyTypeSizes[] = { 0, 1, 1, 2, 2, 4, 4, 4, 8 };
+
+static const struct {
+	const char *name;
+	enum plyType type;
+} plyTypeNames[] = {
+	{ "char", ply_int8 }, { "int8", ply_int8 },
+	{ "uchar", ply_uint8 }, { "uint8", ply_uint8 },
+	{ "short", ply_int16 }, { "int16", ply_int16 },
+	{ "ushort", ply_uint16 }, { "uint16", ply_uint16 },
+	{ "int", ply_int32 }, { "int32", ply_int32 },
+	{ "uint", ply_uint32 }, { "uint32", ply_uint32 },
+	{ "float", ply_float32 }, { "float32", ply_float32 },
+	{ "double", ply_float64 }, { "float64", ply_float64 },
+};
+
+enum plyFormat {
+	ply_ascii,
+	ply_binary_little_endian,
+	ply_binary_big_endian,
+};
+
+// Vertex properties we know what to do with
+enum plyAttribute {
+	ply_x, ply_y, ply_z,
+	ply_nx, ply_ny, ply_nz,
+	ply_u, ply_v,
+	ply_attributeCount
+};
+
+struct plyProperty {
+	char name[PLY_MAX_NAME];
+	enum plyType type;
+	enum plyType countType; // Set for lists only
+};
+
+struct plyElement {
+	char name[PLY_MAX_NAME];
+	size_t count;
+	struct plyProperty properties[PLY_MAX_PROPERTIES];
+	size_t propertyCount;
+};
+
+struct plyHeader {
+	enum plyFormat format;
+	struct plyElement elements[PLY_MAX_ELEMENTS];
+	size_t elementCount;
+	const char *data; // First byte after end_header
+};
+
+struct plyReader {
+	const char *p;
+	const char *end;
+	enum plyFormat format;
+	bool swap; // File and host byte order differ
+	bool failed;
+};
+
+static bool hostIsBigEndian(void) {
+	const uint16_t probe = 1;
+	return *(const unsigned char *)&probe == 0;
+}
+
+static void copyToken(char *target, const char *start, const char *end) {
+	const size_t length = min((size_t)(end - start), (size_t)PLY_MAX_NAME - 1);
+	memcpy(target, start, length);
+	target[length] = '\0';
+}
+
+static bool tokenIs(const char *start, const char *end, const char *expected) {
+	return strlen(expected) == (size_t)(end - start) && !memcmp(start, expected, (size_t)(end - start));
+}
+
+static enum plyType parseType(const char *start, const char *end) {
+	for (size_t i = 0; i < sizeof(plyTypeNames) / sizeof(plyTypeNames[0]); ++i) {
+		if (tokenIs(start, end, plyTypeNames[i].name)) return plyTypeNames[i].type;
+	}
+	return ply_invalid;
+}
+
+static bool parseHeader(const struct fileView *file, struct plyHeader *header) {
+	const char *end = file->data + file->size;
+	const char *p = file->data;
+	if (file->size < 4 || memcmp(p, "ply", 3) || (p[3] != '\n' && p[3] != '\r')) return false;
+	memset(header, 0, sizeof(*header));
+	bool formatFound = false;
+	struct plyElement *element = NULL;
+	for (p = memchr(p, '\n', file->size); p && p < end; ) {
+		const char *line = p + 1;
+		const char *lineEnd = memchr(line, '\n', (size_t)(end - line));
+		if (!lineEnd) return false;
+		p = lineEnd;
+		const char *keyword = skipSpace(line, lineEnd);
+		const char *keywordEnd = tokenEnd(keyword, lineEnd);
+		const char *args = skipSpace(keywordEnd, lineEnd);
+		if (tokenIs(keyword, keywordEnd, "end_header")) {
+			header->data = lineEnd + 1;
+			return formatFound;
+		} else if (tokenIs(keyword, keywordEnd, "format")) {
+			const char *formatEnd = tokenEnd(args, lineEnd);
+			if (tokenIs(args, formatEnd, "ascii")) {
+				header->format = ply_ascii;
+			} else if (tokenIs(args, formatEnd, "binary_little_endian")) {
+				header->format = ply_binary_little_endian;
+			} else if (tokenIs(args, formatEnd, "binary_big_endian")) {
+				header->format = ply_binary_big_endian;
+			} else {
+				return false;
+			}
+			formatFound = true;
+		} else if (tokenIs(keyword, keywordEnd, "element")) {
+			if (header->elementCount == PLY_MAX_ELEMENTS) return false;
+			element = &header->elements[header->elementCount++];
+			const char *nameEnd = tokenEnd(args, lineEnd);
+			copyToken(element->name, args, nameEnd);
+			const char *countStart = skipSpace(nameEnd, lineEnd);
+			int count = -1;
+			if (parseInt(countStart, lineEnd, &count) == countStart || count < 0) return false;
+			element->count = (size_t)count;
+		} else if (tokenIs(keyword, keywordEnd, "property")) {
+			if (!element || element->propertyCount == PLY_MAX_PROPERTIES) return false;
+			struct plyProperty *property = &element->properties[element->propertyCount++];
+			const char *typeEnd = tokenEnd(args, lineEnd);
+			if (tokenIs(args, typeEnd, "list")) {
+				const char *countType = skipSpace(typeEnd, lineEnd);
+				const char *countTypeEnd = tokenEnd(countType, lineEnd);
+				property->countType = parseType(countType, countTypeEnd);
+				args = skipSpace(countTypeEnd, lineEnd);
+				typeEnd = tokenEnd(args, lineEnd);
+				if (!property->countType || property->countType >= ply_float32) return false;
+			}
+			property->type = parseType(args, typeEnd);
+			if (!property->type) return false;
+			const char *name = skipSpace(typeEnd, lineEnd);
+			copyToken(property->name, name, tokenEnd(name, lineEnd));
+		} else if (!tokenIs(keyword, keywordEnd, "comment") && !tokenIs(keyword, keywordEnd, "obj_info") && keyword != keywordEnd) {
+			return false;
+		}
+	}
+	return false;
+}
+
+static inline double decodeBinary(const char *p, enum plyType type, bool swap) {
+	const size_t size = plyTypeSizes[type];
+	unsigned char bytes[8];
+	memcpy(bytes, p, size);
+	if (swap) {
+		for (size_t i = 0; i < size / 2; ++i) {
+			const unsigned char b = bytes[i];
+			bytes[i] = bytes[size - 1 - i];
+			bytes[size - 1 - i] = b;
+		}
+	}
+	switch (type) {
+		case ply_int8: { int8_t v; memcpy(&v, bytes, 1); return v; }
+		case ply_uint8: return bytes[0];
+		case ply_int16: { int16_t v; memcpy(&v, bytes, 2); return v; }
+		case ply_uint16: { uint16_t v; memcpy(&v, bytes, 2); return v; }
+		case ply_int32: { int32_t v; memcpy(&v, bytes, 4); return v; }
+		case ply_uint32: { uint32_t v; memcpy(&v, bytes, 4); return v; }
+		case ply_float32: { float v; memcpy(&v, bytes, 4); return v; }
+		case ply_float64: { double v; memcpy(&v, bytes, 8); return v; }
+		default: return 0.0;
+	}
+}
+
+static double readBinary(struct plyReader *r, enum plyType type) {
+	const size_t size = plyTypeSizes[type];
+	if ((size_t)(r->end - r->p) < size) {
+		r->failed = true;
+		return 0.0;
+	}
+	const double value = decodeBinary(r->p, type, r->swap);
+	r->p += size;
+	return value;
+}
+
+static double readAscii(struct plyReader *r, enum plyType type) {
+	const char *p = r->p;
+	while (p < r->end && (isSpace(*p) || *p == '\n')) p++;
+	const char *next = p;
+	double value = 0.0;
+	if (type >= ply_float32) {
+		float f = 0.0f;
+		next = parseFloat(p, r->end, &f);
+		value = f;
+	} else {
+		int i = 0;
+		next = parseInt(p, r->end, &i);
+		value = i;
+	}
+	if (next == p) r->failed = true;
+	r->p = next;
+	return value;
+}
+
+static inline double readValue(struct plyReader *r, enum plyType type) {
+	return r->format == ply_ascii ? readAscii(r, type) : readBinary(r, type);
+}
+
+// Elements with a fixed size can be skipped over in one go in binary files
+static void skipElement(struct plyReader *r, const struct plyElement *e) {
+	size_t stride = 0;
+	bool fixed = r->format != ply_ascii;
+	for (size_t i = 0; i < e->propertyCount; ++i) {
+		if (e->properties[i].countType) fixed = false;
+		stride += plyTypeSizes[e->properties[i].type];
+	}
+	if (fixed) {
+		if ((size_t)(r->end - r->p) / max(stride, (size_t)1) < e->count) {
+			r->failed = true;
+			return;
+		}
+		r->p += stride * e->count;
+		return;
+	}
+	for (size_t n = 0; n < e->count && !r->failed; ++n) {
+		for (size_t i = 0; i < e->propertyCount; ++i) {
+			const struct plyProperty *property = &e->properties[i];
+			const size_t items = property->countType ? (size_t)readValue(r, property->countType) : 1;
+			for (size_t j = 0; j < items && !r->failed; ++j) readValue(r, property->type);
+		}
+	}
+}
+
+static int attributeFor(const char *name) {
+	static const struct {
+		const char *name;
+		enum plyAttribute attribute;
+	} names[] = {
+		{ "x", ply_x }, { "y", ply_y }, { "z", ply_z },
+		{ "nx", ply_nx }, { "ny", ply_ny }, { "nz", ply_nz },
+		{ "u", ply_u }, { "s", ply_u }, { "texture_u", ply_u }, { "texture_s", ply_u },
+		{ "v", ply_v }, { "t", ply_v }, { "texture_v", ply_v }, { "texture_t", ply_v },
+	};
+	for (size_t i = 0; i < sizeof(names) / sizeof(names[0]); ++i) {
+		if (stringEquals(name, names[i].name)) return names[i].attribute;
+	}
+	return -1;
+}
+
+static void readVertices(struct plyReader *r, const struct plyElement *e, const struct mesh *mesh, bool hasNormals, bool hasTexCoords) {
+	int attributes[PLY_MAX_PROPERTIES];
+	// Binary vertices without lists all have the same size, so attributes can be read at fixed offsets
+	bool fixed = r->format != ply_ascii;
+	size_t stride = 0;
+	size_t offsets[ply_attributeCount] = { 0 };
+	enum plyType types[ply_attributeCount] = { ply_invalid };
+	for (size_t i = 0; i < e->propertyCount; ++i) {
+		attributes[i] = e->properties[i].countType ? -1 : attributeFor(e->properties[i].name);
+		if (e->properties[i].countType) fixed = false;
+		if (attributes[i] >= 0) {
+			offsets[attributes[i]] = stride;
+			types[attributes[i]] = e->properties[i].type;
+		}
+		stride += plyTypeSizes[e->properties[i].type];
+	}
+	struct vector *vertices = mesh->vertices;
+	struct vector *normals = mesh->normals;
+	struct coord *texCoords = mesh->texCoords;
+	if (fixed && (size_t)(r->end - r->p) / max(stride, (size_t)1) < e->count) {
+		r->failed = true;
+		return;
+	}
+	for (size_t n = 0; n < e->count && !r->failed; ++n) {
+		float values[ply_attributeCount] = { 0 };
+		if (fixed) {
+			const char *record = r->p + n * stride;
+			for (int a = 0; a < ply_attributeCount; ++a) {
+				if (types[a]) values[a] = (float)decodeBinary(record + offsets[a], types[a], r->swap);
+			}
+		} else {
+			for (size_t i = 0; i < e->propertyCount; ++i) {
+				const struct plyProperty *property = &e->properties[i];
+				if (property->countType) {
+					const size_t items = (size_t)readValue(r, property->countType);
+					for (size_t j = 0; j < items && !r->failed; ++j) readValue(r, property->type);
+					continue;
+				}
+				const float value = (float)readValue(r, property->type);
+				if (attributes[i] >= 0) values[attributes[i]] = value;
+			}
+		}
+		vertices[n] = (struct vector){ values[ply_x], values[ply_y], values[ply_z] };
+		if (hasNormals) normals[n] = (struct vector){ values[ply_nx], values[ply_ny], values[ply_nz] };
+		if (hasTexCoords) texCoords[n] = (struct coord){ values[ply_u], values[ply_v] };
+	}
+	if (fixed) r->p += stride * e->count;
+}
+
+static int toIndex(struct plyReader *r, double value, size_t vertexCount) {
+	if (value < 0.0 || value >= (double)vertexCount) {
+		r->failed = true;
+		return 0;
+	}
+	return (int)value;
+}
+
+// Faces with more than three corners are split into a fan of triangles
+static void readFaces(struct plyReader *r, const struct plyElement *e, size_t vertexCount, struct mesh *mesh, bool hasNormals, bool hasTexCoords) {
+	size_t capacity = max(e->count, (size_t)1);
+	mesh->polygons = malloc(capacity * sizeof(*mesh->polygons));
+	mesh->attributes = malloc(capacity * sizeof(*mesh->attributes));
+	mesh->polyCount = 0;
+	size_t indexProperty = e->propertyCount;
+	for (size_t i = 0; i < e->propertyCount; ++i) {
+		if (e->properties[i].countType && (stringEquals(e->properties[i].name, "vertex_indices") || stringEquals(e->properties[i].name, "vertex_index"))) indexProperty = i;
+	}
+	for (size_t n = 0; n < e->count && !r->failed; ++n) {
+		for (size_t i = 0; i < e->propertyCount; ++i) {
+			const struct plyProperty *property = &e->properties[i];
+			const bool indices = i == indexProperty;
+			const size_t items = property->countType ? (size_t)readValue(r, property->countType) : 1;
+			if (!indices) {
+				for (size_t j = 0; j < items && !r->failed; ++j) readValue(r, property->type);
+				continue;
+			}
+			int first = 0, previous = 0;
+			for (size_t j = 0; j < items && !r->failed; ++j) {
+				const int current = toIndex(r, readValue(r, property->type), vertexCount);
+				if (j == 0) first = current;
+				if (j >= 2) {
+					if ((size_t)mesh->polyCount == capacity) {
+						capacity *= 2;
+						mesh->polygons = realloc(mesh->polygons, capacity * sizeof(*mesh->polygons));
+						mesh->attributes = realloc(mesh->attributes, capacity * sizeof(*mesh->attributes));
+					}
+					struct poly *p = &mesh->polygons[mesh->polyCount];
+					struct polyAttributes *a = &mesh->attributes[mesh->polyCount++];
+					const int corners[] = { first, previous, current };
+					*p = (struct poly){ .vertexCount = MAX_CRAY_VERTEX_COUNT, .hasNormals = hasNormals, .hasTexCoords = hasTexCoords };
+					for (int c = 0; c < MAX_CRAY_VERTEX_COUNT; ++c) {
+						p->vertexIndex[c] = corners[c];
+						a->normalIndex[c] = hasNormals ? corners[c] : -1;
+						a->textureIndex[c] = hasTexCoords ? corners[c] : -1;
+					}
+				}
+				previous = current;
+			}
+		}
+	}
+}
+
+struct mesh *parsePly(const char *filePath, size_t *finalMeshCount) {
+	struct fileView file = mapFile(filePath);
+	if (!file.data) return NULL;
+	logr(debug, "Loading PLY at %s\n", filePath);
+	struct plyHeader header;
+	if (!parseHeader(&file, &header)) {
+		logr(warning, "Invalid PLY header in %s\n", filePath);
+		unmapFile(&file);
+		return NULL;
+	}
+
+	const struct plyElement *vertexElement = NULL;
+	bool hasNormals = false, hasTexCoords = false;
+	for (size_t i = 0; i < header.elementCount; ++i) {
+		if (!stringEquals(header.elements[i].name, "vertex")) continue;
+		vertexElement = &header.elements[i];
+		bool attributes[ply_attributeCount] = { false };
+		for (size_t j = 0; j < vertexElement->propertyCount; ++j) {
+			const int attribute = attributeFor(vertexElement->properties[j].name);
+			if (attribute >= 0 && !vertexElement->properties[j].countType) attributes[attribute] = true;
+		}
+		hasNormals = attributes[ply_nx] && attributes[ply_ny] && attributes[ply_nz];
+		hasTexCoords = attributes[ply_u] && attributes[ply_v];
+	}
+	const size_t fileVertices = vertexElement ? vertexElement->count : 0;
+
+	struct mesh *mesh = calloc(1, sizeof(*mesh));
+	mesh->name = getFileName(filePath);
+	mesh->vertexCount = (int)fileVertices;
+	mesh->normalCount = hasNormals ? (int)fileVertices : 0;
+	mesh->textureCoordCount = hasTexCoords ? (int)fileVertices : 0;
+	mesh->materials = calloc(1, sizeof(*mesh->materials));
+	mesh->materials[0] = defaultMaterial();
+	mesh->materialCount = 1;
+
+	// The header has the final counts, so vertices go straight into place
+	if (mesh->vertexCount) mesh->vertices = malloc(mesh->vertexCount * sizeof(*mesh->vertices));
+	if (mesh->normalCount) mesh->normals = malloc(mesh->normalCount * sizeof(*mesh->normals));
+	if (mesh->textureCoordCount) mesh->texCoords = malloc(mesh->textureCoordCount * sizeof(*mesh->texCoords));
+
+	struct plyReader reader = {
+		.p = header.data,
+		.end = file.data + file.size,
+		.format = header.format,
+		.swap = header.format != ply_ascii && (header.format == ply_binary_big_endian) != hostIsBigEndian()
+	};
+	for (size_t i = 0; i < header.elementCount && !reader.failed; ++i) {
+		const struct plyElement *e = &header.elements[i];
+		if (e == vertexElement) {
+			readVertices(&reader, e, mesh, hasNormals, hasTexCoords);
+		} else if (stringEquals(e->name, "face") && !mesh->polygons) {
+			readFaces(&reader, e, fileVertices, mesh, hasNormals, hasTexCoords);
+		} else {
+			skipElement(&reader, e);
+		}
+	}
+	unmapFile(&file);
+	if (reader.failed) {
+		logr(warning, "PLY file %s is truncated or has invalid indices\n", filePath);
+		destroyMesh(mesh);
+		free(mesh);
+		return NULL;
+	}
+
+	if (finalMeshCount) *finalMeshCount = 1;
+	return mesh;
+}
@@ -0,0 +1,11 @@
+//
+//  ply.h
+//  C-ray
+//
+//  Created by Valtteri Koskivuori on 18/10/2026.
+//  Copyright © 2026 Valtteri Koskivuori. All rights reserved.
+//
+
+#pragma once
+
+struct mesh *parsePly(const char *filePath, size_t *meshCount);
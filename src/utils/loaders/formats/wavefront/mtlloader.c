@@ -37,12 +37,11 @@ struct color parseColor(lineBuffer *line) {
 }
 
 struct material *parseMTLFile(char *filePath, int *mtlCount) {
-	size_t bytes = 0;
-	char *rawText = loadFile(filePath, &bytes);
-	if (!rawText) return NULL;
+	struct fileView rawText = mapFile(filePath);
+	if (!rawText.data) return NULL;
 	logr(debug, "Loading MTL at %s\n", filePath);
-	textBuffer *file = newTextBuffer(rawText);
-	free(rawText);
+	textBuffer *file = newTextBufferWithLength(rawText.data, rawText.size);
+	unmapFile(&rawText);
 	
 	char *assetPath = getFilePath(filePath);
 	
@@ -94,17 +93,17 @@ struct material *parseMTLFile(char *filePath, int *mtlCount) {
 		} else if (stringEquals(first, "map_Kd")) {
 			char *path = stringConcat(assetPath, nextToken(line));
 			windowsFixPath(path);
-			current->texture = loadTexture(path, NULL);
+			current->texture = loadTexture(path, sRGB, false, NULL);
 			free(path);
 		} else if (stringEquals(first, "norm")) {
 			char *path = stringConcat(assetPath, nextToken(line));
 			windowsFixPath(path);
-			current->normalMap = loadTexture(path, NULL);
+			current->normalMap = loadTexture(path, linear, false, NULL);
 			free(path);
 		} else if (stringEquals(first, "map_Ns")) {
 			char *path = stringConcat(assetPath, nextToken(line));
 			windowsFixPath(path);
-			current->specularMap = loadTexture(path, NULL);
+			current->specularMap = loadTexture(path, linear, false, NULL);
 			free(path);
 		} else {
 			char *fileName = getFileName(filePath);
@@ -12,258 +12,399 @@
 #include "../../../../datatypes/vector.h"
 #include "../../../../datatypes/poly.h"
 #include "../../../../datatypes/material.h"
-#include "../../../../datatypes/vertexbuffer.h"
-#include "../../../../datatypes/vertexbuffer.h"
 #include "../../../logging.h"
 #include "../../../string.h"
 #include "../../../fileio.h"
 #include "../../../assert.h"
-#include "../../../textbuffer.h"
+#include "../../../taskgraph.h"
+#include "../parsing.h"
 #include "mtlloader.h"
 
 #include "wavefront.h"
 
-static int findMaterialIndex(struct material *materialSet, int materialCount, char *mtlName) {
-	for (int i = 0; i < materialCount; ++i) {
-		if (stringEquals(materialSet[i].name, mtlName)) {
-			return i;
+// The file is mapped and split into chunks at line boundaries, and each chunk is parsed on one of the threads
+// running the mesh loads in a single pass. Chunks can't know how many elements came before them, so they are merged afterwards,
+// with every chunk copying its elements into place at offsets summed up from the chunks before it.
+
+// Smaller files aren't worth splitting up
+#define MIN_CHUNK_BYTES (1024 * 1024)
+
+// Statements like usemtl, mtllib, o and g, kept as pointers into the file until the chunks are merged
+struct objName {
+	const char *name;
+	size_t length;
+	size_t firstPoly; // First polygon in the chunk this applies to
+	int materialIndex; // usemtl only, resolved once all material libraries are loaded
+};
+
+// Index relative to the end of the list, which has to be offset by the elements in earlier chunks
+struct objFixup {
+	size_t poly;
+	uint8_t kind; // 0 vertex, 1 texture coordinate, 2 normal
+	uint8_t corner;
+};
+
+struct objChunk {
+	const char *start;
+	const char *end;
+
+	struct vector *vertices;
+	size_t vertexCount, vertexCapacity;
+	struct coord *texCoords;
+	size_t texCoordCount, texCoordCapacity;
+	struct vector *normals;
+	size_t normalCount, normalCapacity;
+	struct poly *polygons;
+	size_t polyCount, polyCapacity;
+	struct polyAttributes *attributes; // One per polygon
+	size_t attributeCapacity;
+	struct objFixup *fixups;
+	size_t fixupCount, fixupCapacity;
+	struct objName *materials;
+	size_t materialCount, materialCapacity;
+	struct objName *libraries;
+	size_t libraryCount, libraryCapacity;
+	struct objName *groups;
+	size_t groupCount, groupCapacity;
+	size_t unknownStatements;
+
+	// Set up for the merge
+	size_t firstVertex, firstTexCoord, firstNormal, firstPoly;
+	int initialMaterial;
+	struct mesh *meshes;
+	const size_t *meshStarts; // First polygon in the file of every mesh
+	size_t meshCount;
+	size_t firstMesh; // Mesh the first polygon in this chunk goes to
+};
+
+static void *grow(void *array, size_t *capacity, size_t count, size_t elementSize) {
+	if (count < *capacity) return array;
+	*capacity = *capacity ? *capacity * 2 : 256;
+	return realloc(array, *capacity * elementSize);
+}
+
+#define PUSH(chunk, array, count, capacity) (*((chunk)->array = grow((chunk)->array, &(chunk)->capacity, (chunk)->count, sizeof(*(chunk)->array)), &(chunk)->array[(chunk)->count++]))
+
+static const char *parseVector(const char *p, const char *end, struct vector *out) {
+	p = parseFloat(skipSpace(p, end), end, &out->x);
+	p = parseFloat(skipSpace(p, end), end, &out->y);
+	return parseFloat(skipSpace(p, end), end, &out->z);
+}
+
+// One corner of a face, as v, v/vt, v//vn or v/vt/vn
+struct objCorner {
+	int index[3]; // Vertex, texture coordinate and normal. 0-based, -1 if unused.
+	bool relative[3];
+};
+
+static const char *parseCorner(const struct objChunk *c, const char *p, const char *end, struct objCorner *corner) {
+	const size_t counts[3] = { c->vertexCount, c->texCoordCount, c->normalCount };
+	for (int kind = 0; kind < 3; ++kind) {
+		corner->index[kind] = -1;
+		corner->relative[kind] = false;
+	}
+	for (int kind = 0; kind < 3; ++kind) {
+		int index = 0;
+		p = parseInt(p, end, &index);
+		if (index > 0) {
+			corner->index[kind] = index - 1;
+		} else if (index < 0) {
+			// Counted back from the latest element, which may be in an earlier chunk
+			corner->index[kind] = (int)counts[kind] + index;
+			corner->relative[kind] = true;
 		}
+		if (p >= end || *p != '/') break;
+		p++;
 	}
-	return 0;
+	return p;
 }
 
-// Count lines starting with thing
-static size_t count(textBuffer *buffer, const char *thing) {
-	size_t thingCount = 0;
-	char *head = firstLine(buffer);
-	while (head) {
-		if (stringStartsWith(thing, head)) thingCount++;
-		head = nextLine(buffer);
+static void emitTriangle(struct objChunk *c, const struct objCorner *a, const struct objCorner *b, const struct objCorner *d) {
+	const struct objCorner *corners[] = { a, b, d };
+	struct poly *p = &PUSH(c, polygons, polyCount, polyCapacity);
+	c->attributes = grow(c->attributes, &c->attributeCapacity, c->polyCount - 1, sizeof(*c->attributes));
+	struct polyAttributes *attributes = &c->attributes[c->polyCount - 1];
+	*p = (struct poly){ .vertexCount = MAX_CRAY_VERTEX_COUNT };
+	for (int i = 0; i < MAX_CRAY_VERTEX_COUNT; ++i) {
+		p->vertexIndex[i] = corners[i]->index[0];
+		attributes->textureIndex[i] = corners[i]->index[1];
+		attributes->normalIndex[i] = corners[i]->index[2];
+		for (uint8_t kind = 0; kind < 3; ++kind) {
+			if (corners[i]->relative[kind]) {
+				PUSH(c, fixups, fixupCount, fixupCapacity) = (struct objFixup){ .poly = c->polyCount - 1, .kind = kind, .corner = (uint8_t)i };
+			}
+		}
 	}
-	head = firstLine(buffer);
-	return thingCount;
 }
 
-static size_t countPolygons(textBuffer *buffer) {
-	size_t thingCount = 0;
-	char *head = firstLine(buffer);
-	lineBuffer *line = newLineBuffer();
-	while (head) {
-		if (head[0] == 'f') {
-			fillLineBuffer(line, head, ' ');
-			if (line->amountOf.tokens > 4) {
-				thingCount += 2;
-			} else {
-				thingCount++;
-			}
+// Faces with more than three corners are split into a fan of triangles
+static void parseFace(struct objChunk *c, const char *p, const char *end) {
+	struct objCorner first, previous, current;
+	size_t corners = 0;
+	for (p = skipSpace(p, end); p < end; p = skipSpace(p, end)) {
+		const char *next = parseCorner(c, p, end, &current);
+		if (next == p) break;
+		p = tokenEnd(next, end);
+		if (corners == 0) {
+			first = current;
+		} else if (corners >= 2) {
+			emitTriangle(c, &first, &previous, &current);
 		}
-		head = nextLine(buffer);
+		previous = current;
+		corners++;
 	}
-	destroyLineBuffer(line);
-	return thingCount;
 }
 
-static struct vector parseVertex(lineBuffer *line) {
-	ASSERT(line->amountOf.tokens == 4);
-	return (struct vector){atof(nextToken(line)), atof(nextToken(line)), atof(nextToken(line))};
+static struct objName parseName(const char *p, const char *end, size_t firstPoly) {
+	p = skipSpace(p, end);
+	return (struct objName){ .name = p, .length = (size_t)(tokenEnd(p, end) - p), .firstPoly = firstPoly };
 }
 
-static struct coord parseCoord(lineBuffer *line) {
-	ASSERT(line->amountOf.tokens == 3);
-	return (struct coord){atof(nextToken(line)), atof(nextToken(line))};
+static inline bool keywordIs(const char *keyword, size_t length, const char *expected) {
+	return strlen(expected) == length && !memcmp(keyword, expected, length);
 }
 
-// Wavefront supports different indexing types like
-// f v1 v2 v3 [v4]
-// f v1/vt1 v2/vt2 v3/vt3
-// f v1/vt1/vn1 v2/vt2/vn2 v3/vt3/vn3
-// f v1//vn1 v2//vn2 v3//vn3
-// Or a quad:
-// f v1//vn1 v2//vn2 v3//vn3 v4//vn4
-size_t parsePolygons(lineBuffer *line, struct poly *buf) {
-	lineBuffer *batch = newLineBuffer();
-	size_t polycount = line->amountOf.tokens - 3;
-	// For now, c-ray will just translate quads to two polygons while parsing
-	// Explode in a ball of fire if we encounter an ngon
-	bool isNgon = polycount > 2;
-	ASSERT(!isNgon);
-	bool skipped = false;
-	for (size_t i = 0; i < polycount; ++i) {
-		firstToken(line);
-		struct poly *p = &buf[i];
-		p->vertexCount = MAX_CRAY_VERTEX_COUNT;
-		for (int j = 0; j < p->vertexCount; ++j) {
-			fillLineBuffer(batch, nextToken(line), '/');
-			p->vertexIndex[j] = atoi(firstToken(batch));
-			p->textureIndex[j] = atoi(nextToken(batch));
-			p->normalIndex[j] = atoi(nextToken(batch));
-			if (i == 1 && !skipped) {
-				nextToken(line);
-				skipped = true;
-			}
+static void parseLine(struct objChunk *c, const char *p, const char *end) {
+	p = skipSpace(p, end);
+	if (p == end || *p == '#') return;
+	const char *keyword = p;
+	p = tokenEnd(p, end);
+	const size_t length = (size_t)(p - keyword);
+	if (keywordIs(keyword, length, "v")) {
+		parseVector(p, end, &PUSH(c, vertices, vertexCount, vertexCapacity));
+	} else if (keywordIs(keyword, length, "vt")) {
+		struct coord *coord = &PUSH(c, texCoords, texCoordCount, texCoordCapacity);
+		p = parseFloat(skipSpace(p, end), end, &coord->x);
+		parseFloat(skipSpace(p, end), end, &coord->y);
+	} else if (keywordIs(keyword, length, "vn")) {
+		parseVector(p, end, &PUSH(c, normals, normalCount, normalCapacity));
+	} else if (keywordIs(keyword, length, "f")) {
+		parseFace(c, p, end);
+	} else if (keywordIs(keyword, length, "usemtl")) {
+		PUSH(c, materials, materialCount, materialCapacity) = parseName(p, end, c->polyCount);
+	} else if (keywordIs(keyword, length, "mtllib")) {
+		PUSH(c, libraries, libraryCount, libraryCapacity) = parseName(p, end, c->polyCount);
+	} else if (keywordIs(keyword, length, "o") || keywordIs(keyword, length, "g")) {
+		// Objects and groups both start a new mesh
+		PUSH(c, groups, groupCount, groupCapacity) = parseName(p, end, c->polyCount);
+	} else {
+		c->unknownStatements++;
+	}
+}
+
+static void parseChunk(void *arg) {
+	struct objChunk *c = arg;
+	for (const char *p = c->start; p < c->end;) {
+		const char *lineEnd = memchr(p, '\n', (size_t)(c->end - p));
+		if (!lineEnd) lineEnd = c->end;
+		parseLine(c, p, lineEnd);
+		p = lineEnd + 1;
+	}
+}
+
+static void mergeChunk(void *arg) {
+	struct objChunk *c = arg;
+	const struct mesh *m = &c->meshes[0];
+	if (c->vertexCount) memcpy(m->vertices + c->firstVertex, c->vertices, c->vertexCount * sizeof(*c->vertices));
+	if (c->texCoordCount) memcpy(m->texCoords + c->firstTexCoord, c->texCoords, c->texCoordCount * sizeof(*c->texCoords));
+	if (c->normalCount) memcpy(m->normals + c->firstNormal, c->normals, c->normalCount * sizeof(*c->normals));
+
+	const size_t firsts[3] = { c->firstVertex, c->firstTexCoord, c->firstNormal };
+	for (size_t i = 0; i < c->fixupCount; ++i) {
+		struct poly *p = &c->polygons[c->fixups[i].poly];
+		struct polyAttributes *a = &c->attributes[c->fixups[i].poly];
+		int *indices[3] = { p->vertexIndex, a->textureIndex, a->normalIndex };
+		indices[c->fixups[i].kind][c->fixups[i].corner] += (int)firsts[c->fixups[i].kind];
+	}
+
+	int material = c->initialMaterial;
+	size_t nextRun = 0;
+	size_t mesh = c->firstMesh;
+	for (size_t i = 0; i < c->polyCount; ++i) {
+		while (nextRun < c->materialCount && c->materials[nextRun].firstPoly <= i) {
+			material = c->materials[nextRun++].materialIndex;
 		}
+		while (mesh + 1 < c->meshCount && c->meshStarts[mesh + 1] <= c->firstPoly + i) mesh++;
+		struct poly p = c->polygons[i];
+		p.materialIndex = material;
+		p.hasNormals = c->attributes[i].normalIndex[0] != -1;
+		p.hasTexCoords = c->attributes[i].textureIndex[0] != -1;
+		const size_t index = c->firstPoly + i - c->meshStarts[mesh];
+		c->meshes[mesh].polygons[index] = p;
+		c->meshes[mesh].attributes[index] = c->attributes[i];
 	}
-	destroyLineBuffer(batch);
-	return polycount;
 }
 
-static int fixIndex(size_t max, int oldIndex) {
-	if (oldIndex == 0) // Unused
-		return -1;
-	
-	if (oldIndex < 0) // Relative to end of list
-		return (int)max + oldIndex;
-	
-	return oldIndex - 1;// Normal indexing
+static char *copyName(const struct objName *name) {
+	char *copy = malloc(name->length + 1);
+	memcpy(copy, name->name, name->length);
+	copy[name->length] = '\0';
+	return copy;
 }
 
-static void fixIndices(struct poly *p, size_t totalVertices, size_t totalTexCoords, size_t totalNormals) {
-	for (int i = 0; i < MAX_CRAY_VERTEX_COUNT; ++i) {
-		p->vertexIndex[i] = vertexCount + (fixIndex(totalVertices, p->vertexIndex[i]));
-		p->textureIndex[i] = textureCount + (fixIndex(totalTexCoords, p->textureIndex[i]));
-		p->normalIndex[i] = normalCount + (fixIndex(totalNormals, p->normalIndex[i]));
+static int findMaterialIndex(struct material *materialSet, int materialCount, const struct objName *name) {
+	for (int i = 0; i < materialCount; ++i) {
+		if (materialSet[i].name && strlen(materialSet[i].name) == name->length && !memcmp(materialSet[i].name, name->name, name->length)) {
+			return i;
+		}
 	}
+	return 0;
 }
 
-struct mesh *parseWavefront(const char *filePath, size_t *finalMeshCount) {
-	size_t bytes = 0;
-	char *rawText = loadFile(filePath, &bytes);
-	if (!rawText) return NULL;
-	logr(debug, "Loading OBJ at %s\n", filePath);
-	textBuffer *file = newTextBuffer(rawText);
-	char *assetPath = getFilePath(filePath);
-	
-	//Start processing line-by-line, state machine style.
-	size_t meshCount = 1;
-	//meshCount += count(file, "o");
-	//meshCount += count(file, "g");
-	//size_t currentMesh = 0;
-	size_t valid_meshes = 0;
-	
-	// Allocate local buffers (memcpy these to global buffers if parsing succeeds)
-	size_t fileVertices = count(file, "v");
-	size_t currentVertex = 0;
-	struct vector *vertices = malloc(fileVertices * sizeof(*vertices));
-	size_t fileTexCoords = count(file, "vt");
-	size_t currentTextureCoord = 0;
-	struct coord *texCoords = malloc(fileTexCoords * sizeof(*texCoords));
-	size_t fileNormals = count(file, "vn");
-	size_t currentNormal = 0;
-	struct vector *normals = malloc(fileNormals * sizeof(*normals));
-	size_t filePolys = countPolygons(file);
-	size_t currentPoly = 0;
-	struct poly *polygons = malloc(filePolys * sizeof(*polygons));
-	
-	struct material *materialSet = NULL;
-	int materialCount = 0;
-	int currentMaterialIndex = 0;
-	
-	//FIXME: Handle more than one mesh
-	struct mesh *meshes = calloc(1, sizeof(*meshes));
-	struct mesh *currentMeshPtr = NULL;
-	
-	currentMeshPtr = meshes;
-	valid_meshes = 1;
-	
-	int currentVertexCount = 0;
-	int currentNormalCount = 0;
-	int currentTextureCount = 0;
-	
-	struct poly polybuf[2];
-
-	char *head = firstLine(file);
-	lineBuffer *line = newLineBuffer();
-	while (head) {
-		fillLineBuffer(line, head, ' ');
-		char *first = firstToken(line);
-		if (first[0] == '#') {
-			head = nextLine(file);
-			continue;
-		} else if (first[0] == '\0') {
-			head = nextLine(file);
-			continue;
-		} else if (first[0] == 'o' || first[0] == 'g') {
-			//FIXME: o and g probably have a distinction for a reason?
-			//currentMeshPtr = &meshes[currentMesh++];
-			currentMeshPtr->name = stringCopy(peekNextToken(line));
-			//valid_meshes++;
-		} else if (stringEquals(first, "v")) {
-			vertices[currentVertex++] = parseVertex(line);
-			currentVertexCount++;
-		} else if (stringEquals(first, "vt")) {
-			texCoords[currentTextureCoord++] = parseCoord(line);
-			currentTextureCount++;
-		} else if (stringEquals(first, "vn")) {
-			normals[currentNormal++] = parseVertex(line);
-			currentNormalCount++;
-		} else if (stringEquals(first, "f")) {
-			size_t count = parsePolygons(line, polybuf);
-			for (size_t i = 0; i < count; ++i) {
-				struct poly p = polybuf[i];
-				fixIndices(&p, fileVertices, fileTexCoords, fileNormals);
-				p.materialIndex = currentMaterialIndex;
-				p.hasNormals = p.normalIndex[0] != -1;
-				polygons[currentPoly++] = p;
-			}
-		} else if (stringEquals(first, "usemtl")) {
-			currentMaterialIndex = findMaterialIndex(materialSet, materialCount, peekNextToken(line));
-		} else if (stringEquals(first, "mtllib")) {
-			char *mtlFilePath = stringConcat(assetPath, peekNextToken(line));
+// Libraries are appended in the order they're referenced
+static void loadLibraries(const struct objChunk *chunks, size_t chunkCount, const char *assetPath, struct material **materialSet, int *materialCount) {
+	for (size_t i = 0; i < chunkCount; ++i) {
+		for (size_t j = 0; j < chunks[i].libraryCount; ++j) {
+			char *name = copyName(&chunks[i].libraries[j]);
+			char *mtlFilePath = stringConcat(assetPath, name);
+			free(name);
 			windowsFixPath(mtlFilePath);
-			materialSet = parseMTLFile(mtlFilePath, &materialCount);
+			int count = 0;
+			struct material *materials = parseMTLFile(mtlFilePath, &count);
 			free(mtlFilePath);
-		} else {
-			char *fileName = getFileName(filePath);
-			logr(debug, "Unknown statement \"%s\" in OBJ \"%s\" on line %zu\n",
-				 first, fileName, file->current.line);
-			free(fileName);
+			if (!materials) continue;
+			*materialSet = realloc(*materialSet, (*materialCount + count) * sizeof(**materialSet));
+			memcpy(*materialSet + *materialCount, materials, count * sizeof(*materials));
+			*materialCount += count;
+			free(materials);
 		}
-		head = nextLine(file);
 	}
-	destroyLineBuffer(line);
-	
-	if (finalMeshCount) *finalMeshCount = valid_meshes;
-	freeTextBuffer(file);
-	free(rawText);
+}
+
+static void destroyChunk(struct objChunk *c) {
+	free(c->vertices);
+	free(c->texCoords);
+	free(c->normals);
+	free(c->polygons);
+	free(c->attributes);
+	free(c->fixups);
+	free(c->materials);
+	free(c->libraries);
+	free(c->groups);
+}
+
+struct mesh *parseWavefront(const char *filePath, size_t *finalMeshCount, struct taskGraph *graph) {
+	struct fileView file = mapFile(filePath);
+	if (!file.data) return NULL;
+	logr(debug, "Loading OBJ at %s\n", filePath);
+	char *assetPath = getFilePath(filePath);
+
+	// Split at line boundaries, a chunk for each thread the graph runs on
+	const size_t chunkCount = max(min(file.size / MIN_CHUNK_BYTES, (size_t)taskGraphThreads(graph)), 1);
+	struct objChunk *chunks = calloc(chunkCount, sizeof(*chunks));
+	const char *fileEnd = file.data + file.size;
+	for (size_t i = 0; i < chunkCount; ++i) {
+		const char *start = i ? chunks[i - 1].end : file.data;
+		const char *end = fileEnd;
+		if (i + 1 < chunkCount) {
+			end = max(file.data + file.size / chunkCount * (i + 1), start);
+			const char *newline = memchr(end, '\n', (size_t)(fileEnd - end));
+			end = newline ? newline + 1 : fileEnd;
+		}
+		chunks[i].start = start;
+		chunks[i].end = end;
+	}
+	runParallel(graph, parseChunk, chunks, sizeof(*chunks), chunkCount);
+
+	struct material *materialSet = NULL;
+	int materialCount = 0;
+	loadLibraries(chunks, chunkCount, assetPath, &materialSet, &materialCount);
 	free(assetPath);
 
-	if (materialSet) {
-		for (size_t i = 0; i < meshCount; ++i) {
-			meshes[i].materials = materialSet;
-			meshes[i].materialCount = materialCount;
+	// Offsets of every chunk, and the material in effect where it starts
+	size_t fileVertices = 0, fileTexCoords = 0, fileNormals = 0, filePolys = 0, unknownStatements = 0;
+	int currentMaterial = 0;
+	for (size_t i = 0; i < chunkCount; ++i) {
+		struct objChunk *c = &chunks[i];
+		c->firstVertex = fileVertices;
+		c->firstTexCoord = fileTexCoords;
+		c->firstNormal = fileNormals;
+		c->firstPoly = filePolys;
+		c->initialMaterial = currentMaterial;
+		for (size_t j = 0; j < c->materialCount; ++j) {
+			c->materials[j].materialIndex = findMaterialIndex(materialSet, materialCount, &c->materials[j]);
+			currentMaterial = c->materials[j].materialIndex;
 		}
-	} else {
-		for (size_t i = 0; i < meshCount; ++i) {
-			meshes[i].materials = calloc(1, sizeof(struct material));
-			meshes[i].materials[0] = warningMaterial();
-			meshes[i].materialCount = 1;
+		fileVertices += c->vertexCount;
+		fileTexCoords += c->texCoordCount;
+		fileNormals += c->normalCount;
+		filePolys += c->polyCount;
+		unknownStatements += c->unknownStatements;
+	}
+	if (unknownStatements) {
+		char *fileName = getFileName(filePath);
+		logr(debug, "Skipped %zu unsupported statements in OBJ \"%s\"\n", unknownStatements, fileName);
+		free(fileName);
+	}
+
+	// Every o and g starts a mesh. Faces before the first one get a mesh of their own, and groups without
+	// any faces, like an object name right before a group, are dropped.
+	size_t groupCount = 1;
+	for (size_t i = 0; i < chunkCount; ++i) groupCount += chunks[i].groupCount;
+	const struct objName **names = calloc(groupCount, sizeof(*names));
+	size_t *meshStarts = calloc(groupCount + 1, sizeof(*meshStarts));
+	size_t meshCount = 0;
+	for (size_t i = 0; i < chunkCount; ++i) {
+		for (size_t j = 0; j < chunks[i].groupCount; ++j) {
+			const size_t start = chunks[i].firstPoly + chunks[i].groups[j].firstPoly;
+			if (start > meshStarts[meshCount]) meshCount++;
+			meshStarts[meshCount] = start;
+			names[meshCount] = &chunks[i].groups[j];
 		}
 	}
-	
-	currentMeshPtr->polygons = polygons;
-	currentMeshPtr->polyCount = (int)filePolys;
-	currentMeshPtr->firstVectorIndex = vertexCount;
-	currentMeshPtr->firstNormalIndex = normalCount;
-	currentMeshPtr->firstTextureCoordIndex = textureCount;
-	currentMeshPtr->vertexCount = currentVertexCount;
-	currentMeshPtr->normalCount = currentNormalCount;
-	currentMeshPtr->textureCoordCount = currentTextureCount;
-	
-	vertexCount += fileVertices;
-	normalCount += fileNormals;
-	textureCount+= fileTexCoords;
-	
-	g_vertices = realloc(g_vertices, vertexCount * sizeof(struct vector));
-	memcpy(g_vertices + currentMeshPtr->firstVectorIndex, vertices, fileVertices * sizeof(*vertices));
-	free(vertices);
-	
-	g_normals = realloc(g_normals, normalCount * sizeof(struct vector));
-	memcpy(g_normals + currentMeshPtr->firstNormalIndex, normals, fileNormals * sizeof(*normals));
-	free(normals);
-	
-	g_textureCoords = realloc(g_textureCoords, textureCount * sizeof(struct coord));
-	memcpy(g_textureCoords + currentMeshPtr->firstTextureCoordIndex, texCoords, fileTexCoords * sizeof(*texCoords));
-	free(texCoords);
-	
+	if (filePolys > meshStarts[meshCount] || !meshCount) meshCount++;
+	meshStarts[meshCount] = filePolys;
+
+	// Faces can use any element in the file, so every mesh shares them, owned by the first one
+	struct vector *vertices = fileVertices ? malloc(fileVertices * sizeof(*vertices)) : NULL;
+	struct vector *normals = fileNormals ? malloc(fileNormals * sizeof(*normals)) : NULL;
+	struct coord *texCoords = fileTexCoords ? malloc(fileTexCoords * sizeof(*texCoords)) : NULL;
+	char *fileName = getFileName(filePath);
+	struct mesh *meshes = calloc(meshCount, sizeof(*meshes));
+	for (size_t i = 0; i < meshCount; ++i) {
+		struct mesh *mesh = &meshes[i];
+		mesh->polyCount = (int)(meshStarts[i + 1] - meshStarts[i]);
+		mesh->polygons = malloc(mesh->polyCount * sizeof(*mesh->polygons));
+		mesh->attributes = malloc(mesh->polyCount * sizeof(*mesh->attributes));
+		mesh->name = names[i] ? copyName(names[i]) : stringCopy(fileName);
+		mesh->vertices = vertices;
+		mesh->vertexCount = (int)fileVertices;
+		mesh->normals = normals;
+		mesh->normalCount = (int)fileNormals;
+		mesh->texCoords = texCoords;
+		mesh->textureCoordCount = (int)fileTexCoords;
+		mesh->sharedVertices = i > 0;
+	}
+	free(fileName);
+	free(names);
+
+	// Material indices are the same for all of them, so they share one set, owned by the first mesh
+	if (!materialSet) {
+		materialSet = calloc(1, sizeof(*materialSet));
+		materialSet[0] = warningMaterial();
+		materialCount = 1;
+	}
+	for (size_t i = 0; i < meshCount; ++i) {
+		meshes[i].materials = materialSet;
+		meshes[i].materialCount = materialCount;
+		meshes[i].sharedMaterials = i > 0;
+	}
+
+	// Chunks copy their elements straight into place
+	size_t mesh = 0;
+	for (size_t i = 0; i < chunkCount; ++i) {
+		while (mesh + 1 < meshCount && meshStarts[mesh + 1] <= chunks[i].firstPoly) mesh++;
+		chunks[i].meshes = meshes;
+		chunks[i].meshStarts = meshStarts;
+		chunks[i].meshCount = meshCount;
+		chunks[i].firstMesh = mesh;
+	}
+	runParallel(graph, mergeChunk, chunks, sizeof(*chunks), chunkCount);
+
+	free(meshStarts);
+	for (size_t i = 0; i < chunkCount; ++i) destroyChunk(&chunks[i]);
+	free(chunks);
+	unmapFile(&file);
+	if (finalMeshCount) *finalMeshCount = meshCount;
 	return meshes;
 }
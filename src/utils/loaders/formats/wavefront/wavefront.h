@@ -8,4 +8,7 @@
 
 #pragma once
 
-struct mesh *parseWavefront(const char *filePath, size_t *meshCount);
+struct taskGraph;
+
+/// @param graph Optional, the task graph this is running on, to parse big files on its threads
+struct mesh *parseWavefront(const char *filePath, size_t *meshCount, struct taskGraph *graph);
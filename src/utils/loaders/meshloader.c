@@ -7,11 +7,28 @@
 //
 
 #include <stddef.h>
+#include <stdlib.h>
+#include <stdbool.h>
 
 #include "meshloader.h"
+#include "../string.h"
 #include "formats/wavefront/wavefront.h"
+#include "formats/ply/ply.h"
+#include "formats/gltf/gltf.h"
 
-//TODO: Detect and support more formats than wavefront
-struct mesh *loadMesh(char *filePath, size_t *meshCount) {
-	return parseWavefront(filePath, meshCount);
+// Picked by file extension, anything unknown is assumed to be wavefront
+struct mesh *loadMesh(char *filePath, size_t *meshCount, struct meshPlacement **placements, size_t *placementCount, struct taskGraph *graph) {
+	char *lowerCase = stringToLower(filePath);
+	struct mesh *meshes = NULL;
+	if (placements) *placements = NULL;
+	if (placementCount) *placementCount = 0;
+	if (stringEndsWith(".gltf", lowerCase) || stringEndsWith(".glb", lowerCase)) {
+		meshes = parseGltf(filePath, meshCount, placements, placementCount);
+	} else if (stringEndsWith(".ply", lowerCase)) {
+		meshes = parsePly(filePath, meshCount);
+	} else {
+		meshes = parseWavefront(filePath, meshCount, graph);
+	}
+	free(lowerCase);
+	return meshes;
 }
@@ -8,4 +8,18 @@
 
 #pragma once
 
-struct mesh *loadMesh(char *filePath, size_t *meshCount);
+#include "../../datatypes/transforms.h"
+
+struct taskGraph;
+
+// Where a mesh file places one of its meshes, for formats that have a scene graph
+struct meshPlacement {
+	size_t mesh; // Index into the meshes returned alongside
+	struct transform transform;
+};
+
+/// Load the meshes in a file, picking the format by extension
+/// @param placements Optional, set to the placements in the file or NULL if it has none
+/// @param placementCount Optional, set to the amount of placements
+/// @param graph Optional, the task graph this is running on, which formats that parse in parallel do so on
+struct mesh *loadMesh(char *filePath, size_t *meshCount, struct meshPlacement **placements, size_t *placementCount, struct taskGraph *graph);
@@ -8,12 +8,13 @@
 
 #include "../../includes.h"
 #include "sceneloader.h"
+#include <limits.h>
+#include <string.h>
 
 //FIXME: We should only need to include c-ray.h here!
 
 #include "../../libraries/cJSON.h"
 #include "../../datatypes/scene.h"
-#include "../../datatypes/vertexbuffer.h"
 #include "../../datatypes/vector.h"
 #include "../../datatypes/camera.h"
 #include "../../datatypes/mesh.h"
@@ -26,6 +27,7 @@
 #include "../string.h"
 #include "../platform/capabilities.h"
 #include "../../datatypes/image/imagefile.h"
+#include "../../datatypes/image/texturecache.h"
 #include "../../renderer/renderer.h"
 #include "textureloader.h"
 #include "../../datatypes/instance.h"
@@ -34,6 +36,10 @@
 #include "../../utils/string.h"
 #include "../../nodes/bsdfnode.h"
 #include "meshloader.h"
+#include "bakedscene.h"
+#include "../../renderer/sky.h"
+#include "../../accelerators/bvh.h"
+#include "../taskgraph.h"
 
 struct transform parseTransformComposite(const cJSON *transforms);
 
@@ -43,34 +49,10 @@ static struct instance *lastInstance(struct renderer *r) {
 	return &r->scene->instances[r->scene->instanceCount - 1];
 }
 
-static struct mesh *lastMesh(struct renderer *r) {
-	return &r->scene->meshes[r->scene->meshCount - 1];
-}
-
 static struct sphere *lastSphere(struct renderer *r) {
 	return &r->scene->spheres[r->scene->sphereCount - 1];
 }
 
-static bool loadMeshNew(struct renderer *r, char *inputFilePath, int idx, int totalMeshes) {
-	logr(plain, "\r");
-	logr(info, "Loading mesh %i/%i%s", idx, totalMeshes, idx == totalMeshes ? "\n" : "\r");
-	bool valid = false;
-	size_t meshCount = 0;
-	struct mesh *newMeshes = loadMesh(inputFilePath, &meshCount);
-	if (meshCount == 0) return false;
-	ASSERT(meshCount == 1); //FIXME: Remove this
-	if (newMeshes) {
-		for (size_t m = 0; m < meshCount; ++m) {
-			r->scene->meshes[r->scene->meshCount + m] = newMeshes[m];
-			free(&newMeshes[m]);
-			valid = true;
-		}
-	}
-	
-	r->scene->meshCount += meshCount;
-	return valid;
-}
-
 static void addSphere(struct world *scene, struct sphere newSphere) {
 	scene->spheres[scene->sphereCount++] = newSphere;
 }
@@ -192,6 +174,7 @@ static struct prefs defaultPrefs() {
 		.tileOrder = renderOrderFromMiddle,
 		.threadCount = getSysCores(), //We run getSysCores() for this
 		.sampleCount = 25,
+		.sampler = Sobol,
 		.bounces = 20,
 		.tileWidth = 32,
 		.tileHeight = 32,
@@ -215,6 +198,8 @@ struct prefs parsePrefs(const cJSON *data) {
 	
 	const cJSON *threads = NULL;
 	const cJSON *samples = NULL;
+	const cJSON *timeLimit = NULL;
+	const cJSON *sampler = NULL;
 	const cJSON *antialiasing = NULL;
 	const cJSON *tileWidth = NULL;
 	const cJSON *tileHeight = NULL;
@@ -226,6 +211,7 @@ struct prefs parsePrefs(const cJSON *data) {
 	const cJSON *width = NULL;
 	const cJSON *height = NULL;
 	const cJSON *fileType = NULL;
+	const cJSON *textureCache = NULL;
 	
 	threads = cJSON_GetObjectItem(data, "threads");
 	if (threads) {
@@ -260,6 +246,38 @@ struct prefs parsePrefs(const cJSON *data) {
 		p.sampleCount = defaultPrefs().sampleCount;
 	}
 	
+	sampler = cJSON_GetObjectItem(data, "sampler");
+	if (sampler) {
+		if (cJSON_IsString(sampler)) {
+			if (stringEquals(sampler->valuestring, "sobol")) {
+				p.sampler = Sobol;
+			} else if (stringEquals(sampler->valuestring, "halton")) {
+				p.sampler = Halton;
+			} else if (stringEquals(sampler->valuestring, "hammersley")) {
+				p.sampler = Hammersley;
+			} else if (stringEquals(sampler->valuestring, "random")) {
+				p.sampler = Random;
+			} else {
+				logr(warning, "Unknown sampler \"%s\", expected sobol, halton, hammersley or random\n", sampler->valuestring);
+				p.sampler = defaultPrefs().sampler;
+			}
+		} else {
+			logr(warning, "Invalid sampler while parsing renderer\n");
+		}
+	} else {
+		p.sampler = defaultPrefs().sampler;
+	}
+	
+	timeLimit = cJSON_GetObjectItem(data, "timeLimit");
+	if (timeLimit) {
+		if (cJSON_IsNumber(timeLimit) && timeLimit->valuedouble > 0.0) {
+			p.timeLimit = (unsigned long)(timeLimit->valuedouble * 1000.0);
+		} else {
+			logr(warning, "Invalid timeLimit while parsing renderer\n");
+		}
+	} else {
+		p.timeLimit = defaultPrefs().timeLimit;
+	}
 	
 	bounces = cJSON_GetObjectItem(data, "bounces");
 	if (bounces) {
@@ -317,6 +335,18 @@ struct prefs parsePrefs(const cJSON *data) {
 		p.tileHeight = defaultPrefs().tileHeight;
 	}
 	
+	textureCache = cJSON_GetObjectItem(data, "textureCache");
+	if (textureCache) {
+		if (cJSON_IsNumber(textureCache) && textureCache->valuedouble >= 0.0) {
+			// Given in megabytes
+			p.textureCacheSize = (size_t)(textureCache->valuedouble * 1000.0 * 1000.0);
+		} else {
+			logr(warning, "Invalid textureCache while parsing renderer\n");
+		}
+	} else {
+		p.textureCacheSize = defaultPrefs().textureCacheSize;
+	}
+	
 	tileOrder = cJSON_GetObjectItem(data, "tileOrder");
 	if (tileOrder) {
 		if (cJSON_IsString(tileOrder)) {
@@ -442,6 +472,31 @@ struct prefs parsePrefs(const cJSON *data) {
 		}
 	}
 	
+	if (isSet("time_override")) {
+		if (isSet("is_worker")) {
+			logr(warning, "Can't override time limit when in worker mode\n");
+		} else {
+			p.timeLimit = (unsigned long)intPref("time_limit");
+			char buf[64];
+			smartTime(p.timeLimit, buf);
+			logr(info, "Overriding time limit to %s\n", buf);
+		}
+	}
+	
+	// Workers render the tiles they're given, the master keeps track of time.
+	if (isSet("is_worker")) p.timeLimit = 0;
+	
+	if (p.timeLimit && isSet("use_clustering")) {
+		logr(warning, "Time limit is not supported with network rendering, rendering %i samples instead\n", p.sampleCount);
+		p.timeLimit = 0;
+	}
+	
+	// In time-limited mode we render until the deadline. A sample count only
+	// acts as an upper bound if one was explicitly given with -s.
+	if (p.timeLimit && !isSet("samples_override")) {
+		p.sampleCount = INT_MAX;
+	}
+	
 	if (isSet("dims_override")) {
 		if (isSet("is_worker")) {
 			logr(warning, "Can't override dimensions when in worker mode\n");
@@ -693,12 +748,26 @@ static int parseAmbientColor(struct renderer *r, const cJSON *data) {
 	down = cJSON_GetObjectItem(data, "down");
 	up = cJSON_GetObjectItem(data, "up");
 	hdr = cJSON_GetObjectItem(data, "hdr");
+	const cJSON *sky = cJSON_GetObjectItem(data, "sky");
+	
+	// The physical sky model is too slow to evaluate per ray, so it's baked into a texture here.
+	// "sky": true uses the default resolution, or "sky": { "width": 1024, "height": 512 } overrides it.
+	if (cJSON_IsTrue(sky) || cJSON_IsObject(sky)) {
+		size_t width = 512;
+		size_t height = 256;
+		const cJSON *skyWidth = cJSON_GetObjectItem(sky, "width");
+		const cJSON *skyHeight = cJSON_GetObjectItem(sky, "height");
+		if (cJSON_IsNumber(skyWidth) && skyWidth->valueint > 0) width = skyWidth->valueint;
+		if (cJSON_IsNumber(skyHeight) && skyHeight->valueint > 0) height = skyHeight->valueint;
+		logr(info, "Baking sky into a %zux%zu lookup table\n", width, height);
+		r->scene->background = newBackground(r->scene, newImageTexture(r->scene, newSkyTexture(width, height, &r->scene->nodePool), 0), NULL, offsetValue);
+		return 0;
+	}
 	
 	if (cJSON_IsString(hdr)) {
 		char *fullPath = stringConcat(r->prefs.assetPath, hdr->valuestring);
-		if (isValidFile(fullPath)) {
-			r->scene->background = newBackground(r->scene, newImageTexture(r->scene, loadTexture(fullPath, &r->scene->nodePool), 0), NULL, offsetValue);
-		}
+		// Baked scenes have it even if the file isn't there. Without either, this falls back to a gray background.
+		r->scene->background = newBackground(r->scene, newImageTexture(r->scene, loadTexture(fullPath, linear, false, &r->scene->nodePool), 0), NULL, offsetValue);
 		free(fullPath);
 		return 0;
 	}
@@ -770,6 +839,34 @@ static const struct valueNode *parseValueNode(struct world *w, const cJSON *node
 	return newGrayscaleConverter(w, parseTextureNode(w, node));
 }
 
+// The file an image texture node loads, and how. Those are a path, or an object with a path and options.
+static bool imageTextureFile(const cJSON *node, char **path, enum colorspace *colorspace, bool *compress) {
+	if (cJSON_IsString(node)) {
+		// No options provided, go with defaults.
+		*path = node->valuestring;
+		*colorspace = linear;
+		*compress = false;
+		return true;
+	}
+	if (!cJSON_IsObject(node) || cJSON_GetObjectItem(node, "r")) return false;
+	const cJSON *type = cJSON_GetObjectItem(node, "type");
+	if (cJSON_IsString(type) && (stringEquals(type->valuestring, "checkerboard") || stringEquals(type->valuestring, "blackbody"))) return false;
+	const cJSON *file = cJSON_GetObjectItem(node, "path");
+	if (!cJSON_IsString(file)) return false;
+	*path = file->valuestring;
+	*colorspace = sRGB; // Enabled by default.
+	// Do we want to do an srgb transform?
+	const cJSON *srgbTransform = cJSON_GetObjectItem(node, "transform");
+	if (srgbTransform) {
+		if (!cJSON_IsTrue(srgbTransform)) {
+			*colorspace = linear;
+		}
+	}
+	// Trade some quality for a quarter to a sixth of the memory?
+	*compress = cJSON_IsTrue(cJSON_GetObjectItem(node, "compress"));
+	return true;
+}
+
 static const struct colorNode *parseTextureNode(struct world *w, const cJSON *node) {
 	if (!node) return NULL;
 	
@@ -777,9 +874,11 @@ static const struct colorNode *parseTextureNode(struct world *w, const cJSON *no
 		return newConstantTexture(w, parseColor(node));
 	}
 	
-	if (cJSON_IsString(node)) {
-		// No options provided, go with defaults.
-		return newImageTexture(w, loadTexture(node->valuestring, &w->nodePool), 0);
+	char *path = NULL;
+	enum colorspace colorspace = linear;
+	bool compress = false;
+	if (cJSON_IsString(node) && imageTextureFile(node, &path, &colorspace, &compress)) {
+		return newImageTexture(w, loadTexture(path, colorspace, compress, &w->nodePool), 0);
 	}
 	
 	// Should be an object, then.
@@ -787,14 +886,6 @@ static const struct colorNode *parseTextureNode(struct world *w, const cJSON *no
 	
 	// Handle options first
 	uint8_t options = 0;
-	options |= SRGB_TRANSFORM; // Enabled by default.
-	// Do we want to do an srgb transform?
-	const cJSON *srgbTransform = cJSON_GetObjectItem(node, "transform");
-	if (srgbTransform) {
-		if (!cJSON_IsTrue(srgbTransform)) {
-			options &= ~SRGB_TRANSFORM;
-		}
-	}
 	
 	// Do we want bilinear interpolation enabled?
 	const cJSON *lerp = cJSON_GetObjectItem(node, "lerp");
@@ -823,9 +914,8 @@ static const struct colorNode *parseTextureNode(struct world *w, const cJSON *no
 		}
 	}
 	
-	const cJSON *path = cJSON_GetObjectItem(node, "path");
-	if (cJSON_IsString(path)) {
-		return newImageTexture(w, loadTexture(path->valuestring, &w->nodePool), options);
+	if (imageTextureFile(node, &path, &colorspace, &compress)) {
+		return newImageTexture(w, loadTexture(path, colorspace, compress, &w->nodePool), options);
 	}
 	
 	logr(warning, "Failed to parse textureNode. Here's a dump:\n");
@@ -874,10 +964,40 @@ static const struct bsdfNode *parseNode(struct world *w, const cJSON *node) {
 	return warningBsdf(w);
 }
 
-//FIXME: Only parse everything else if the mesh is found and is valid
-static void parseMesh(struct renderer *r, const cJSON *data, int idx, int meshCount) {
+// Called from loader threads, so this doesn't touch the scene
+static struct mesh *loadMeshFile(struct renderer *r, struct taskGraph *graph, const cJSON *data, int idx, size_t *meshCount, struct meshPlacement **placements, size_t *placementCount) {
 	const cJSON *fileName = cJSON_GetObjectItem(data, "fileName");
-	
+	if (!cJSON_IsString(fileName)) return NULL;
+	char *fullPath = stringConcat(r->prefs.assetPath, fileName->valuestring);
+	windowsFixPath(fullPath);
+	struct timeval timer;
+	startTimer(&timer);
+	struct mesh *meshes = NULL;
+	if (r->scene->baked) {
+		meshes = loadBakedMeshes(r->scene->baked, (size_t)idx, meshCount, placements, placementCount);
+	} else {
+		meshes = loadMesh(fullPath, meshCount, placements, placementCount, graph);
+		// Baked meshes are stored the way they were loaded
+		if (meshes && cJSON_IsTrue(cJSON_GetObjectItem(data, "compactAttributes"))) compactMeshes(meshes, *meshCount);
+	}
+	long us = getUs(timer);
+	free(fullPath);
+	if (!meshes || !*meshCount) {
+		free(meshes);
+		free(*placements);
+		*placements = NULL;
+		*placementCount = 0;
+		*meshCount = 0;
+		return NULL;
+	}
+	long ms = us / 1000;
+	logr(debug, "Parsing %-35s took %li %s, %zu mesh%s\n", fileName->valuestring, ms > 0 ? ms : us, ms > 0 ? "ms" : "μs", *meshCount, *meshCount == 1 ? "" : "es");
+	return meshes;
+}
+
+// Instances and materials in a mesh entry apply to every mesh loaded from its file.
+// Files with a scene graph get an instance per placement instead, relative to each instance in the entry.
+static void parseMesh(struct renderer *r, const cJSON *data, int firstMesh, int meshCount, const struct meshPlacement *placements, size_t placementCount) {
 	const cJSON *bsdf = cJSON_GetObjectItem(data, "bsdf");
 	const cJSON *intensity = cJSON_GetObjectItem(data, "intensity");
 	const cJSON *roughness = cJSON_GetObjectItem(data, "roughness");
@@ -900,91 +1020,234 @@ static void parseMesh(struct renderer *r, const cJSON *data, int idx, int meshCo
 		logr(warning, "Invalid bsdf while parsing mesh\n");
 	}
 	
-	bool meshValid = false;
-	if (fileName != NULL && cJSON_IsString(fileName)) {
-		char *fullPath = stringConcat(r->prefs.assetPath, fileName->valuestring);
-		windowsFixPath(fullPath);
-		bool success = false;
-		struct timeval timer;
-		startTimer(&timer);
-		success = loadMeshNew(r, fullPath, idx, meshCount);
-		long us = getUs(timer);
-		if (success) {
-			long ms = us / 1000;
-			logr(debug, "Parsing mesh %-35s took %zu %s\n", lastMesh(r)->name, ms > 0 ? ms : us, ms > 0 ? "ms" : "μs");
-		}
-		if (success) {
-			meshValid = true;
-			free(fullPath);
-		} else {
-			free(fullPath);
-			return;
-		}
-	}
-	
-	if (meshValid) {
-		const cJSON *instances = cJSON_GetObjectItem(data, "instances");
-		const cJSON *instance = NULL;
-		if (instances != NULL && cJSON_IsArray(instances)) {
-			cJSON_ArrayForEach(instance, instances) {
-				struct instance new = newMeshInstance(lastMesh(r));
-				new.composite = parseInstanceTransform(instance);
+	const cJSON *instances = cJSON_GetObjectItem(data, "instances");
+	const cJSON *instance = NULL;
+	if (instances != NULL && cJSON_IsArray(instances)) {
+		cJSON_ArrayForEach(instance, instances) {
+			const struct transform composite = parseInstanceTransform(instance);
+			if (placementCount) {
+				for (size_t p = 0; p < placementCount; ++p) {
+					struct instance new = newMeshInstance(&r->scene->meshes[firstMesh + placements[p].mesh]);
+					new.composite.type = transformTypeComposite;
+					new.composite.A = multiplyMatrices(&composite.A, &placements[p].transform.A);
+					new.composite.Ainv = inverseMatrix(&new.composite.A);
+					addInstanceToScene(r->scene, new);
+				}
+				continue;
+			}
+			for (int m = firstMesh; m < firstMesh + meshCount; ++m) {
+				struct instance new = newMeshInstance(&r->scene->meshes[m]);
+				new.composite = composite;
 				addInstanceToScene(r->scene, new);
 			}
 		}
-		
-		const cJSON *materials = cJSON_GetObjectItem(data, "material");
+	}
+	
+	const cJSON *materials = cJSON_GetObjectItem(data, "material");
+	for (int m = firstMesh; m < firstMesh + meshCount; ++m) {
+		struct mesh *mesh = &r->scene->meshes[m];
+		// Assigned once, through the mesh that owns them
+		if (mesh->sharedMaterials) continue;
 		if (materials) {
 			struct cJSON *material = NULL;
 			if (cJSON_IsArray(materials)) {
 				// Array of graphs, so map them to mesh materials.
-				ASSERT(cJSON_GetArraySize(materials) <= lastMesh(r)->materialCount);
+				ASSERT(cJSON_GetArraySize(materials) <= mesh->materialCount);
 				size_t i = 0;
 				cJSON_ArrayForEach(material, materials) {
-					lastMesh(r)->materials[i++].bsdf = parseNode(r->scene, material);
+					mesh->materials[i++].bsdf = parseNode(r->scene, material);
 				}
 			} else {
 				// Single graph, map it to every material in a mesh.
 				const struct bsdfNode *node = parseNode(r->scene, materials);
-				for (int i = 0; i < lastMesh(r)->materialCount; ++i) {
-					lastMesh(r)->materials[i].bsdf = node;
+				for (int i = 0; i < mesh->materialCount; ++i) {
+					mesh->materials[i].bsdf = node;
 				}
 			}
 		} else {
 			// Fallback, this is the old way of assigning materials.
 			//FIXME: Delet this.
-			for (int i = 0; i < lastMesh(r)->materialCount; ++i) {
-				lastMesh(r)->materials[i].type = type;
+			for (int i = 0; i < mesh->materialCount; ++i) {
+				mesh->materials[i].type = type;
 				if (type == emission && intensity) {
-					lastMesh(r)->materials[i].emission = colorCoef(intensity->valuedouble, lastMesh(r)->materials[i].diffuse);
+					mesh->materials[i].emission = colorCoef(intensity->valuedouble, mesh->materials[i].diffuse);
 				}
 				if (type == glass) {
 					const cJSON *IOR = cJSON_GetObjectItem(data, "IOR");
 					if (cJSON_IsNumber(IOR)) {
-						lastMesh(r)->materials[i].IOR = IOR->valuedouble;
+						mesh->materials[i].IOR = IOR->valuedouble;
 					}
 				} else if (type == plastic) {
-					lastMesh(r)->materials[i].IOR = 1.45;
+					mesh->materials[i].IOR = 1.45;
 				}
-				if (cJSON_IsNumber(roughness)) lastMesh(r)->materials[i].roughness = roughness->valuedouble;
-				assignBSDF(r->scene, &lastMesh(r)->materials[i]);
+				if (cJSON_IsNumber(roughness)) mesh->materials[i].roughness = roughness->valuedouble;
+				assignBSDF(r->scene, &mesh->materials[i]);
 			}
 		}
 	}
 }
 
-static void parseMeshes(struct renderer *r, const cJSON *data) {
+struct bvhBuild {
+	struct mesh *mesh;
+	long us;
+};
+
+struct meshFile {
+	struct renderer *r;
+	const cJSON *data;
+	int idx;
+	struct mesh *meshes;
+	size_t meshCount;
+	struct meshPlacement *placements;
+	size_t placementCount;
+	struct bvhBuild *builds; // One for each mesh without a BVH
+	size_t buildCount;
+	long us;
+};
+
+static void buildMeshBvh(struct taskGraph *graph, void *arg) {
+	(void)graph;
+	struct bvhBuild *build = arg;
+	struct timeval timer;
+	startTimer(&timer);
+	build->mesh->bvh = buildBottomLevelBvh(build->mesh);
+	build->us = getUs(timer);
+}
+
+static int compareBuildSize(const void *a, const void *b) {
+	return ((const struct bvhBuild *)a)->mesh->polyCount - ((const struct bvhBuild *)b)->mesh->polyCount;
+}
+
+// BVH builds for the meshes in the file start right away, biggest first. They're queued smallest first, since the latest task runs first.
+static void loadMeshFileTask(struct taskGraph *graph, void *arg) {
+	struct meshFile *file = arg;
+	struct timeval timer;
+	startTimer(&timer);
+	file->meshes = loadMeshFile(file->r, graph, file->data, file->idx, &file->meshCount, &file->placements, &file->placementCount);
+	file->us = getUs(timer);
+	file->builds = calloc(max(file->meshCount, 1), sizeof(*file->builds));
+	// Baked meshes come with theirs
+	for (size_t i = 0; i < file->meshCount; ++i) {
+		if (!file->meshes[i].bvh) file->builds[file->buildCount++].mesh = &file->meshes[i];
+	}
+	qsort(file->builds, file->buildCount, sizeof(*file->builds), compareBuildSize);
+	for (size_t i = 0; i < file->buildCount; ++i) addTask(graph, buildMeshBvh, &file->builds[i]);
+}
+
+// Each mesh gets its BVH built once its file is done
+static struct meshFile *queueMeshFiles(struct renderer *r, struct taskGraph *graph, const cJSON *data, int *fileCount) {
+	*fileCount = cJSON_IsArray(data) ? cJSON_GetArraySize(data) : 0;
+	if (!*fileCount) return NULL;
+	struct meshFile *files = calloc(*fileCount, sizeof(*files));
 	const cJSON *mesh = NULL;
-	int idx = 1;
-	//FIXME: This doesn't account for wavefront files with multiple meshes.
-	int meshCount = cJSON_GetArraySize(data);
-	r->scene->meshes = calloc(meshCount, sizeof(*r->scene->meshes));
-	if (data != NULL && cJSON_IsArray(data)) {
-		cJSON_ArrayForEach(mesh, data) {
-			parseMesh(r, mesh, idx, meshCount);
-			idx++;
+	int idx = 0;
+	cJSON_ArrayForEach(mesh, data) {
+		files[idx] = (struct meshFile){ .r = r, .data = mesh, .idx = idx };
+		idx++;
+	}
+	// The latest task runs first, so these start from the first file
+	for (int i = *fileCount - 1; i >= 0; --i) addTask(graph, loadMeshFileTask, &files[i]);
+	return files;
+}
+
+struct textureLoad {
+	char *path;
+	enum colorspace colorspace;
+	bool compress;
+	long us;
+};
+
+static void preloadTextureTask(struct taskGraph *graph, void *arg) {
+	(void)graph;
+	struct textureLoad *load = arg;
+	struct timeval timer;
+	startTimer(&timer);
+	preloadTexture(load->path, load->colorspace, load->compress);
+	load->us = getUs(timer);
+}
+
+static void addTextureLoad(struct textureLoad **loads, size_t *count, char *path, enum colorspace colorspace, bool compress) {
+	for (size_t i = 0; i < *count; ++i) {
+		if ((*loads)[i].colorspace == colorspace && (*loads)[i].compress == compress && stringEquals((*loads)[i].path, path)) {
+			free(path);
+			return;
+		}
+	}
+	*loads = realloc(*loads, (*count + 1) * sizeof(**loads));
+	(*loads)[(*count)++] = (struct textureLoad){ .path = path, .colorspace = colorspace, .compress = compress };
+}
+
+// Image textures in a node graph, or an array of them, like parseNode() will load them
+static void findTextureLoads(const cJSON *node, struct textureLoad **loads, size_t *count) {
+	if (cJSON_IsArray(node)) {
+		const cJSON *element = NULL;
+		cJSON_ArrayForEach(element, node) findTextureLoads(element, loads, count);
+		return;
+	}
+	if (!cJSON_IsObject(node)) return;
+	const char *inputs[] = { "color", "roughness", "IOR", "strength", "factor" };
+	for (size_t i = 0; i < sizeof(inputs) / sizeof(*inputs); ++i) {
+		char *path = NULL;
+		enum colorspace colorspace = linear;
+		bool compress = false;
+		if (imageTextureFile(cJSON_GetObjectItem(node, inputs[i]), &path, &colorspace, &compress)) {
+			addTextureLoad(loads, count, stringCopy(path), colorspace, compress);
 		}
 	}
+	findTextureLoads(cJSON_GetObjectItem(node, "A"), loads, count);
+	findTextureLoads(cJSON_GetObjectItem(node, "B"), loads, count);
+}
+
+// Textures the background and the materials in the scene description refer to, which would otherwise
+// be decoded one by one as their nodes are parsed
+static struct textureLoad *queueTextureLoads(struct renderer *r, struct taskGraph *graph, const cJSON *data, size_t *count) {
+	struct textureLoad *loads = NULL;
+	*count = 0;
+	const cJSON *ambientColor = cJSON_GetObjectItem(data, "ambientColor");
+	const cJSON *hdr = cJSON_GetObjectItem(ambientColor, "hdr");
+	const cJSON *sky = cJSON_GetObjectItem(ambientColor, "sky");
+	if (cJSON_IsString(hdr) && !cJSON_IsTrue(sky) && !cJSON_IsObject(sky)) {
+		addTextureLoad(&loads, count, stringConcat(r->prefs.assetPath, hdr->valuestring), linear, false);
+	}
+	const char *lists[] = { "primitives", "meshes" };
+	for (size_t i = 0; i < sizeof(lists) / sizeof(*lists); ++i) {
+		const cJSON *entry = NULL;
+		const cJSON *list = cJSON_GetObjectItem(data, lists[i]);
+		if (!cJSON_IsArray(list)) continue;
+		cJSON_ArrayForEach(entry, list) findTextureLoads(cJSON_GetObjectItem(entry, "material"), &loads, count);
+	}
+	for (size_t i = 0; i < *count; ++i) addTask(graph, preloadTextureTask, &loads[i]);
+	return loads;
+}
+
+// Parsing the rest of the entry needs the final mesh array, so this waits for every file to load
+static void parseMeshes(struct renderer *r, const cJSON *data, struct meshFile *files, int fileCount) {
+	const cJSON *mesh = NULL;
+	int idx = 0;
+	size_t totalMeshes = 0;
+	for (int i = 0; i < fileCount; ++i) {
+		struct meshFile *file = &files[i];
+		if (r->scene->bakeLog) bakeLogMeshEntry(r->scene->bakeLog, file->meshCount, file->placements, file->placementCount);
+		totalMeshes += file->meshCount;
+		// Textures in MTL files are counted in with parsing, buildScene() takes them back out
+		r->scene->loadTimes.parse += file->us;
+		for (size_t b = 0; b < file->buildCount; ++b) r->scene->loadTimes.bvh += file->builds[b].us;
+		free(file->builds);
+	}
+
+	// Instances and materials point into the final mesh array
+	r->scene->meshes = calloc(totalMeshes, sizeof(*r->scene->meshes));
+	idx = 0;
+	cJSON_ArrayForEach(mesh, data) {
+		struct meshFile *file = &files[idx++];
+		if (!file->meshCount) continue;
+		memcpy(r->scene->meshes + r->scene->meshCount, file->meshes, file->meshCount * sizeof(*file->meshes));
+		free(file->meshes);
+		parseMesh(r, mesh, r->scene->meshCount, (int)file->meshCount, file->placements, file->placementCount);
+		free(file->placements);
+		r->scene->meshCount += (int)file->meshCount;
+	}
+	free(files);
 }
 
 /*static struct vector parseCoordinate(const cJSON *data) {
@@ -1132,21 +1395,43 @@ static int parseScene(struct renderer *r, const cJSON *data) {
 	const cJSON *meshes = NULL;
 	
 	ambientColor = cJSON_GetObjectItem(data, "ambientColor");
+	primitives = cJSON_GetObjectItem(data, "primitives");
+	meshes = cJSON_GetObjectItem(data, "meshes");
+	
+	// Mesh files, and the textures the scene description refers to, load on a set of threads first.
+	// Parsing the nodes afterwards finds those textures loaded.
+	struct taskGraph *graph = newTaskGraph();
+	size_t textureCount = 0;
+	struct textureLoad *textures = queueTextureLoads(r, graph, data, &textureCount);
+	int fileCount = 0;
+	struct meshFile *files = queueMeshFiles(r, graph, meshes, &fileCount);
+	// Files sent to workers are cached as they're read, and the cache isn't shared between threads
+	const int threadCount = isSet("use_clustering") ? 1 : getSysCores();
+	if (fileCount || textureCount) {
+		logr(info, "Loading %i mesh file%s and %zu texture%s on %i thread%s\n", fileCount, fileCount == 1 ? "" : "s",
+			textureCount, textureCount == 1 ? "" : "s", threadCount, threadCount == 1 ? "" : "s");
+	}
+	struct timeval timer;
+	startTimer(&timer);
+	runTaskGraph(graph, threadCount);
+	destroyTaskGraph(graph);
+	r->scene->loadTimes.meshes = getUs(timer);
+	// Like textures in MTL files, these are counted in with parsing and buildScene() takes them back out
+	for (size_t i = 0; i < textureCount; ++i) {
+		r->scene->loadTimes.parse += textures[i].us;
+		free(textures[i].path);
+	}
+	free(textures);
+	
 	parseAmbientColor(r, ambientColor);
 	
-	primitives = cJSON_GetObjectItem(data, "primitives");
 	if (primitives) {
 		if (cJSON_IsArray(primitives)) {
 			parsePrimitives(r, primitives);
 		}
 	}
 	
-	meshes = cJSON_GetObjectItem(data, "meshes");
-	if (meshes) {
-		if (cJSON_IsArray(meshes)) {
-			parseMeshes(r, meshes);
-		}
-	}
+	if (files) parseMeshes(r, meshes, files, fileCount);
 	
 	return 0;
 }
@@ -1192,8 +1477,14 @@ int parseJSON(struct renderer *r, char *input) {
 		return -2;
 	}
 	
+	if (r->prefs.textureCacheSize) r->scene->textureCache = newTextureCache(r->prefs.textureCacheSize);
+	r->scene->textureRegistry = newTextureRegistry();
+	
 	scene = cJSON_GetObjectItem(json, "scene");
-	if (parseScene(r, scene) == -1) {
+	beginTextureLoads(r->scene->textureRegistry, r->scene->textureCache, r->scene->baked, r->scene->bakeLog);
+	const int result = parseScene(r, scene);
+	endTextureLoads();
+	if (result == -1) {
 		logr(warning, "Scene parse failed!\n");
 		return -2;
 	}
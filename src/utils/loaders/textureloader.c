@@ -11,9 +11,17 @@
 #include "../fileio.h"
 #include "../logging.h"
 #include "../../datatypes/image/texture.h"
+#include "../../datatypes/image/texturecache.h"
 #include "../../datatypes/color.h"
 #include "../../utils/assert.h"
 #include "../../utils/mempool.h"
+#include "../../utils/timer.h"
+#include "../../utils/args.h"
+#include "../../utils/string.h"
+#include "../../utils/platform/mutex.h"
+#include "../../utils/hashtable.h"
+#include "bakedscene.h"
+#include <sys/stat.h>
 
 #define STBI_NO_PSD
 #define STBI_NO_GIF
@@ -31,10 +39,11 @@ void copyToPool(struct block **pool, struct texture *tex) {
 	tex->data.byte_p = newBuf;
 }
 
-static struct texture *loadEnvMap(unsigned char *buf, size_t buflen, const char *path, struct block **pool) {
+static struct texture *loadEnvMap(const unsigned char *buf, size_t buflen, const char *path, struct block **pool) {
 	ASSERT(buf);
 	logr(info, "Loading HDR...");
-	struct texture *tex = allocBlock(pool, sizeof(*tex));
+	struct texture *tex = pool ? allocBlock(pool, sizeof(*tex)) : newTexture(none, 0, 0, 0);
+	if (pool) *tex = (struct texture){ 0 };
 	tex->data.float_p = stbi_loadf_from_memory(buf, (int)buflen, (int *)&tex->width, (int *)&tex->height, (int *)&tex->channels, 0);
 	tex->precision = float_p;
 	if (!tex->data.float_p) {
@@ -42,37 +51,365 @@ static struct texture *loadEnvMap(unsigned char *buf, size_t buflen, const char
 		logr(warning, "Error while decoding HDR from %s - Corrupted?\n", path);
 		return NULL;
 	}
+	textureSelectFetch(tex);
 	char *fsbuf = humanFileSize(buflen);
-	printf(" %s\n", fsbuf);
+	logr(plain, " %s\n", fsbuf);
 	free(fsbuf);
 	return tex;
 }
 
-struct texture *loadTexture(char *filePath, struct block **pool) {
-	size_t len = 0;
-	//Handle the trailing newline here
-	filePath[strcspn(filePath, "\n")] = 0;
-	unsigned char *file = (unsigned char*)loadFile(filePath, &len);
-	if (!file) return NULL;
+// Cumulative time spent in loadTexture(), for scene load statistics.
+static long g_textureLoadUs = 0;
+
+// The uncompressed texture is only needed until it's compressed, so it stays out of the pool
+static struct texture *compressFile(struct texture *full, const char *filePath, struct block **pool) {
+	generateMipmaps(full, NULL);
+	struct texture *compressed = compressTexture(full, pool);
+	if (!compressed) {
+		logr(warning, "Can't compress texture \"%s\", only 8 bit gray, RGB and RGBA images can be. Keeping it uncompressed.\n", filePath);
+		free(full->mips);
+		full->mips = NULL;
+		full->mipCount = 0;
+		return NULL;
+	}
+	destroyTexture(full);
+	return compressed;
+}
+
+static struct texture *decodeTextureFile(const unsigned char *file, size_t len, const char *filePath, enum colorspace colorspace, bool compress, struct block **pool) {
 	struct texture *new = NULL;
-	if (stbi_is_hdr(filePath)) {
-		new = loadEnvMap(file, len, filePath, pool);
+	struct block **decodePool = compress ? NULL : pool;
+	if (stbi_is_hdr_from_memory(file, (int)len)) {
+		new = loadEnvMap(file, len, filePath, decodePool);
 	} else {
-		new = loadTextureFromBuffer(file, (unsigned int)len, pool);
+		new = loadTextureFromBuffer(file, (unsigned int)len, decodePool);
 	}
-	free(file);
-	if (pool) copyToPool(pool, new);
 	if (!new) {
 		logr(warning, "^That happened while decoding texture \"%s\" - Corrupted?\n", filePath);
-		destroyTexture(new);
 		return NULL;
 	}
-	
+	if (decodePool) copyToPool(decodePool, new);
+	// Bytes stay in sRGB and get decoded on lookup, since 8 bits aren't enough for linear darks
+	new->colorspace = colorspace;
+	textureSelectFetch(new);
+	if (new->precision == float_p) textureFromSRGB(new);
+	if (compress) {
+		struct texture *compressed = compressFile(new, filePath, pool);
+		if (compressed) return compressed;
+		if (pool) {
+			struct texture *pooled = allocBlock(pool, sizeof(*pooled));
+			*pooled = *new;
+			copyToPool(pool, pooled);
+			free(new);
+			new = pooled;
+		}
+	}
+	generateMipmaps(new, pool);
 	return new;
 }
 
+static struct texture *loadTextureFile(char *filePath, enum colorspace colorspace, bool compress, struct block **pool) {
+	struct fileView file = mapFile(filePath);
+	if (!file.data) return NULL;
+	struct texture *new = decodeTextureFile((const unsigned char *)file.data, file.size, filePath, colorspace, compress, pool);
+	unmapFile(&file);
+	return new;
+}
+
+static struct textureRegistry *g_registry = NULL;
+static struct textureCache *g_textureCache = NULL;
+static const struct bakedScene *g_bakedScene = NULL;
+static struct bakeLog *g_bakeLog = NULL;
+// Guards the above and g_textureLoadUs while a scene loads textures on several threads
+static struct crMutex *g_loadLock = NULL;
+
+void beginTextureLoads(struct textureRegistry *registry, struct textureCache *cache, const struct bakedScene *scene, struct bakeLog *log) {
+	g_registry = registry;
+	g_textureCache = cache;
+	g_bakedScene = scene;
+	g_bakeLog = log;
+	g_loadLock = createMutex();
+}
+
+void endTextureLoads() {
+	g_registry = NULL;
+	g_textureCache = NULL;
+	g_bakedScene = NULL;
+	g_bakeLog = NULL;
+	free(g_loadLock);
+	g_loadLock = NULL;
+}
+
+// Loads outside of a scene only happen on one thread
+static void lockLoads() {
+	if (g_loadLock) lockMutex(g_loadLock);
+}
+
+static void releaseLoads() {
+	if (g_loadLock) releaseMutex(g_loadLock);
+}
+
+struct textureRegistry {
+	struct hashtable *paths;
+	struct hashtable *contents;
+	struct texture **textures;
+	size_t textureCount;
+	size_t hits;
+	size_t bytesSaved;
+	struct block *pool; // Table buckets and paths
+};
+
+struct registeredPath {
+	const char *path;
+	enum colorspace colorspace;
+	bool compress;
+	struct texture *texture; // NULL if it was preloaded and failed, so it isn't tried again
+	bool preloaded; // By preloadTexture(), and not handed out yet
+};
+
+struct registeredContent {
+	uint32_t hashes[2]; // Two passes with different seeds, along with the size that's plenty to tell files apart
+	size_t size;
+	enum colorspace colorspace;
+	bool compress;
+	struct texture *texture;
+};
+
+#define CONTENT_SEED UINT32_C(0x9E3779B9)
+
+static bool comparePaths(const void *a, const void *b) {
+	const struct registeredPath *A = a, *B = b;
+	return A->colorspace == B->colorspace && A->compress == B->compress && stringEquals(A->path, B->path);
+}
+
+static bool compareContents(const void *a, const void *b) {
+	const struct registeredContent *A = a, *B = b;
+	return A->colorspace == B->colorspace && A->compress == B->compress && A->size == B->size
+		&& A->hashes[0] == B->hashes[0] && A->hashes[1] == B->hashes[1];
+}
+
+static uint32_t hashPath(const struct registeredPath *p) {
+	return hashString(hashCombine(hashCombine(hashInit(), (uint8_t)p->colorspace), p->compress), p->path);
+}
+
+struct textureRegistry *newTextureRegistry() {
+	struct textureRegistry *registry = calloc(1, sizeof(*registry));
+	registry->pool = newBlock(NULL, 1024);
+	registry->paths = newHashtable(comparePaths, &registry->pool);
+	registry->contents = newHashtable(compareContents, &registry->pool);
+	return registry;
+}
+
+// Tiled textures are paged in through a cache, which holds each tile once however many textures use it
+static size_t textureBytes(const struct texture *t) {
+	if (t->tiles) return 0;
+	size_t bytes = textureLevelBytes(t);
+	for (size_t i = 0; i < t->mipCount; ++i) bytes += textureLevelBytes(&t->mips[i]);
+	return bytes;
+}
+
+// These are called with the load lock held
+
+static struct registeredPath *findPath(struct textureRegistry *registry, const char *path, enum colorspace colorspace, bool compress) {
+	const struct registeredPath key = { .path = path, .colorspace = colorspace, .compress = compress };
+	return findInHashtable(registry->paths, &key, hashPath(&key));
+}
+
+static void addPath(struct textureRegistry *registry, const char *path, enum colorspace colorspace, bool compress, struct texture *texture, bool preloaded) {
+	if (findPath(registry, path, colorspace, compress)) return;
+	const size_t length = strlen(path) + 1;
+	char *copy = allocBlock(&registry->pool, length);
+	memcpy(copy, path, length);
+	const struct registeredPath entry = { .path = copy, .colorspace = colorspace, .compress = compress, .texture = texture, .preloaded = preloaded };
+	insertInHashtable(registry->paths, &entry, sizeof(entry), hashPath(&entry));
+}
+
+static void addTexture(struct textureRegistry *registry, struct texture *texture) {
+	texture->shared = true;
+	registry->textures = realloc(registry->textures, (registry->textureCount + 1) * sizeof(*registry->textures));
+	registry->textures[registry->textureCount++] = texture;
+}
+
+static struct texture *countHit(struct textureRegistry *registry, struct texture *texture) {
+	registry->hits++;
+	registry->bytesSaved += textureBytes(texture);
+	return texture;
+}
+
+// A preloaded texture is only shared once it's loaded a second time
+static bool claimPath(struct textureRegistry *registry, const char *path, enum colorspace colorspace, bool compress, struct texture **texture) {
+	struct registeredPath *found = findPath(registry, path, colorspace, compress);
+	if (!found) return false;
+	*texture = found->texture;
+	if (found->preloaded) {
+		found->preloaded = false;
+	} else if (found->texture) {
+		countHit(registry, found->texture);
+	}
+	return true;
+}
+
+// Files are read to find out if something with the same contents was decoded already, under another path
+static struct texture *loadRegisteredTexture(struct textureRegistry *registry, char *filePath, enum colorspace colorspace, bool compress, bool preload) {
+	struct fileView file = mapFile(filePath);
+	if (!file.data) return NULL;
+	struct registeredContent content = {
+		.hashes = { hashBytes(hashInit(), file.data, file.size), hashBytes(CONTENT_SEED, file.data, file.size) },
+		.size = file.size,
+		.colorspace = colorspace,
+		.compress = compress
+	};
+	lockLoads();
+	const struct registeredContent *found = findInHashtable(registry->contents, &content, content.hashes[0]);
+	struct texture *new = found ? countHit(registry, found->texture) : NULL;
+	if (new) addPath(registry, filePath, colorspace, compress, new, preload);
+	releaseLoads();
+	if (new) {
+		unmapFile(&file);
+		return new;
+	}
+
+	new = decodeTextureFile((const unsigned char *)file.data, file.size, filePath, colorspace, compress, NULL);
+	unmapFile(&file);
+	if (!new) return NULL;
+	lockLoads();
+	// Another thread may have decoded the same file in the meantime
+	found = findInHashtable(registry->contents, &content, content.hashes[0]);
+	if (found) {
+		destroyTexture(new);
+		new = countHit(registry, found->texture);
+	} else {
+		content.texture = new;
+		insertInHashtable(registry->contents, &content, sizeof(content), content.hashes[0]);
+		addTexture(registry, new);
+	}
+	addPath(registry, filePath, colorspace, compress, new, preload);
+	releaseLoads();
+	return new;
+}
+
+struct textureRegistryStats textureRegistryStats(const struct textureRegistry *registry) {
+	if (!registry) return (struct textureRegistryStats){ 0 };
+	return (struct textureRegistryStats){
+		.textures = registry->textureCount,
+		.hits = registry->hits,
+		.bytesSaved = registry->bytesSaved
+	};
+}
+
+void destroyTextureRegistry(struct textureRegistry *registry) {
+	if (!registry) return;
+	for (size_t i = 0; i < registry->textureCount; ++i) destroyTexture(registry->textures[i]);
+	free(registry->textures);
+	destroyHashtable(registry->paths);
+	destroyHashtable(registry->contents);
+	destroyBlocks(registry->pool);
+	free(registry);
+}
+
+// Modification time and size, enough to tell when a tiled copy is out of date
+static bool sourceStamp(const char *filePath, uint64_t *stamp) {
+	struct stat info;
+	if (stat(filePath, &info) != 0) return false;
+	*stamp = ((uint64_t)info.st_mtime << 32) ^ (uint64_t)info.st_size;
+	return true;
+}
+
+// Tiled copies live next to the original as <name>.crtx, and are only converted again when the original changes
+static struct texture *loadTiledTexture(char *filePath, enum colorspace colorspace, struct block **pool) {
+	uint64_t stamp = 0;
+	if (!sourceStamp(filePath, &stamp)) return NULL;
+	char *tiledPath = stringConcat(filePath, colorspace == sRGB ? ".srgb.crtx" : ".crtx");
+	struct texture *tex = openTiledTexture(g_textureCache, tiledPath, stamp, pool);
+	if (!tex) {
+		logr(info, "Converting %s to tiles\n", filePath);
+		struct texture *full = loadTextureFile(filePath, colorspace, false, NULL);
+		if (full && writeTiledTexture(full, tiledPath, stamp)) {
+			tex = openTiledTexture(g_textureCache, tiledPath, stamp, pool);
+		} else if (full) {
+			logr(warning, "Couldn't write %s, loading the texture into memory instead.\n", tiledPath);
+		}
+		destroyTexture(full);
+	}
+	free(tiledPath);
+	return tex;
+}
+
+// For textures that weren't found loaded already
+static struct texture *loadNewTexture(char *filePath, enum colorspace colorspace, bool compress, struct block **pool, bool preload) {
+	struct texture *new = NULL;
+	bool found = false;
+	// Workers get their assets over the network, so they always load them whole.
+	// Compressed textures are meant to stay resident, so they skip the cache too.
+	// Baked scenes carry their textures with them, and mapping the file pages them in like the cache would.
+	if (g_textureCache && !compress && !g_bakeLog && !isSet("is_worker")) {
+		// Registers with the cache, and two threads mustn't convert the same file at once
+		lockLoads();
+		if (g_registry) {
+			// Checked again, another thread may have converted it while we waited
+			found = preload ? findPath(g_registry, filePath, colorspace, compress) != NULL : claimPath(g_registry, filePath, colorspace, compress, &new);
+			if (!found && (new = loadTiledTexture(filePath, colorspace, NULL))) {
+				addTexture(g_registry, new);
+				addPath(g_registry, filePath, colorspace, compress, new, preload);
+			}
+		} else {
+			new = loadTiledTexture(filePath, colorspace, pool);
+		}
+		releaseLoads();
+	}
+	if (!new && !found) new = g_registry ? loadRegisteredTexture(g_registry, filePath, colorspace, compress, preload) : loadTextureFile(filePath, colorspace, compress, pool);
+	return new;
+}
+
+struct texture *loadTexture(char *filePath, enum colorspace colorspace, bool compress, struct block **pool) {
+	struct timeval timer;
+	startTimer(&timer);
+	//Handle the trailing newline here
+	filePath[strcspn(filePath, "\n")] = 0;
+	struct texture *new = g_bakedScene ? findBakedTexture(g_bakedScene, filePath, colorspace, compress) : NULL;
+	bool found = new;
+	if (!found && g_registry) {
+		lockLoads();
+		found = claimPath(g_registry, filePath, colorspace, compress, &new);
+		releaseLoads();
+	}
+	if (!found) new = loadNewTexture(filePath, colorspace, compress, pool, false);
+	lockLoads();
+	if (new && g_bakeLog) bakeLogTexture(g_bakeLog, filePath, colorspace, compress, new);
+	g_textureLoadUs += getUs(timer);
+	releaseLoads();
+	return new;
+}
+
+void preloadTexture(const char *filePath, enum colorspace colorspace, bool compress) {
+	if (!g_registry) return;
+	struct timeval timer;
+	startTimer(&timer);
+	char *path = stringCopy(filePath);
+	path[strcspn(path, "\n")] = 0;
+	lockLoads();
+	const bool found = findPath(g_registry, path, colorspace, compress);
+	releaseLoads();
+	if (!found && !(g_bakedScene && findBakedTexture(g_bakedScene, path, colorspace, compress))) {
+		if (!loadNewTexture(path, colorspace, compress, NULL, true)) {
+			lockLoads();
+			addPath(g_registry, path, colorspace, compress, NULL, true);
+			releaseLoads();
+		}
+	}
+	lockLoads();
+	g_textureLoadUs += getUs(timer);
+	releaseLoads();
+	free(path);
+}
+
+long textureLoadTime() {
+	return g_textureLoadUs;
+}
+
 struct texture *loadTextureFromBuffer(const unsigned char *buffer, const unsigned int buflen, struct block **pool) {
 	struct texture *new = pool ? allocBlock(pool, sizeof(*new)) : newTexture(none, 0, 0, 0);
+	if (pool) *new = (struct texture){ 0 };
 	new->data.byte_p = stbi_load_from_memory(buffer, buflen, (int *)&new->width, (int *)&new->height, (int *)&new->channels, 0);
 	if (!new->data.byte_p) {
 		logr(warning, "Failed to decode texture from memory buffer of size %u. Reason: \"%s\"\n", buflen, stbi_failure_reason());
@@ -83,5 +420,6 @@ struct texture *loadTextureFromBuffer(const unsigned char *buffer, const unsigne
 		new->hasAlpha = true;
 	}
 	new->precision = char_p;
+	textureSelectFetch(new);
 	return new;
 }
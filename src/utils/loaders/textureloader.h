@@ -8,11 +8,52 @@
 
 #pragma once
 
+#include "../../datatypes/image/texture.h"
+
 struct block;
+struct textureCache;
 
 /// Load a generic texture. Currently supports: JPEG, PNG, BMP, TGA, PIC, PNM
 /// @param filePath Path to image file on disk
-/// @param pool Optional, memory pool to store image data
-struct texture *loadTexture(char *filePath, struct block **pool);
+/// @param colorspace Colorspace the image is encoded in. Lookups return linear colors either way.
+/// @param compress Store 8 bit images block compressed, in a quarter to a sixth of the memory, at some loss of quality
+/// @param pool Optional, memory pool to store image data. Unused for textures loaded through a textureRegistry, which owns them.
+struct texture *loadTexture(char *filePath, enum colorspace colorspace, bool compress, struct block **pool);
+
+/// Load a texture ahead of time, so a later loadTexture() of it finds it loaded. Safe to call on several threads at once.
+/// Only does something between beginTextureLoads() and endTextureLoads() with a registry, which holds on to the texture.
+void preloadTexture(const char *filePath, enum colorspace colorspace, bool compress);
 
 struct texture *loadTextureFromBuffer(const unsigned char *buffer, const unsigned int buflen, struct block **pool);
+
+struct bakedScene;
+struct bakeLog;
+struct textureRegistry;
+
+/// Textures loaded through a registry are decoded once, and shared read-only by everything that loads them again,
+/// whether by the same path or another path to a file with the same contents. The registry owns them.
+struct textureRegistry *newTextureRegistry(void);
+
+struct textureRegistryStats {
+	size_t textures; // Loaded through the registry
+	size_t hits; // Loads that were handed one of those instead
+	size_t bytesSaved; // Memory loading each of those separately would have taken on top
+};
+
+struct textureRegistryStats textureRegistryStats(const struct textureRegistry *registry);
+
+/// Destroys every texture loaded through the registry
+void destroyTextureRegistry(struct textureRegistry *registry);
+
+/// Load textures for a scene from now on, until endTextureLoads(). loadTexture() can be called from several threads in between.
+/// @param registry Optional, registry to share textures through
+/// @param cache Optional, cache to page textures in through, instead of decoding them into memory
+/// @param scene Optional, baked scene to take textures from, falling back to their files for ones it doesn't have
+/// @param log Optional, log to note down every texture in, so it can be baked into the scene. These are always loaded whole.
+void beginTextureLoads(struct textureRegistry *registry, struct textureCache *cache, const struct bakedScene *scene, struct bakeLog *log);
+
+void endTextureLoads(void);
+
+/// Total time spent in loadTexture() so far
+/// @return Cumulative load time in microseconds
+long textureLoadTime(void);
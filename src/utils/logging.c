@@ -16,19 +16,24 @@
 #include "args.h"
 #include "platform/terminal.h"
 
+// Benchmark mode reserves stdout for the JSON report
+static FILE *logStream() {
+	return isSet("benchmark") ? stderr : stdout;
+}
+
 static void printPrefix(enum logType type) {
 	switch (type) {
 		case info:
-			printf("%sINFO%s ", KGRN, KNRM);
+			fprintf(logStream(), "%sINFO%s ", KGRN, KNRM);
 			break;
 		case warning:
-			printf("%sWARN%s ", KYEL, KNRM);
+			fprintf(logStream(), "%sWARN%s ", KYEL, KNRM);
 			break;
 		case error:
-			printf("%sERR %s ", KRED, KNRM);
+			fprintf(logStream(), "%sERR %s ", KRED, KNRM);
 			break;
 		case debug:
-			printf("%sDEBG%s ", KBLU, KNRM);
+			fprintf(logStream(), "%sDEBG%s ", KBLU, KNRM);
 			break;
 		default:
 			break;
@@ -38,7 +43,7 @@ static void printPrefix(enum logType type) {
 static void printDate() {
 	const time_t curTime = time(NULL);
 	struct tm time = *localtime(&curTime);
-	printf("[%d-%02d-%02d %02d:%02d:%02d] ",
+	fprintf(logStream(), "[%d-%02d-%02d %02d:%02d:%02d] ",
 		   time.tm_year + 1900,
 		   time.tm_mon + 1,
 		   time.tm_mday,
@@ -61,10 +66,10 @@ void logr(enum logType type, const char *fmt, ...) {
 	va_start(vl, fmt);
 	ret += vsnprintf(buf, sizeof(buf), fmt, vl);
 	va_end(vl);
-	printf("%s", buf);
+	fprintf(logStream(), "%s", buf);
 	if (ret > 512) {
 		// Overflowed, indicate that.
-		printf("...\n");
+		fprintf(logStream(), "...\n");
 	}
 	if (type == error) {
 		logr(info, "Aborting due to previous error.\n");
@@ -76,7 +81,7 @@ void logr(enum logType type, const char *fmt, ...) {
 void printSmartTime(unsigned long long ms) {
 	char buf[64];
 	smartTime(ms, buf);
-	printf("%s", buf);
+	fprintf(logStream(), "%s", buf);
 }
 
 // Print to buf a logically formatted string representing time given in milliseconds.
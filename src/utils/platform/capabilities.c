@@ -7,14 +7,22 @@
 //
 
 #include "capabilities.h"
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "../string.h"
 
 #ifdef __APPLE__
 #include <sys/param.h>
 #include <sys/sysctl.h>
+#include <sys/resource.h>
 #elif _WIN32
 #include <windows.h>
+#include <psapi.h>
 #elif __linux__
 #include <unistd.h>
+#include <sys/resource.h>
 #endif
 
 int getSysCores() {
@@ -44,3 +52,51 @@ int getSysCores() {
 	return 1;
 #endif
 }
+
+size_t getPeakRSS() {
+#if defined(__APPLE__) || defined(__linux__)
+	struct rusage usage;
+	if (getrusage(RUSAGE_SELF, &usage)) return 0;
+#ifdef __APPLE__
+	return (size_t)usage.ru_maxrss; // Bytes on macOS
+#else
+	return (size_t)usage.ru_maxrss * 1024; // Kilobytes on Linux
+#endif
+#elif _WIN32
+	PROCESS_MEMORY_COUNTERS counters;
+	if (!GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters))) return 0;
+	return (size_t)counters.PeakWorkingSetSize;
+#else
+	return 0;
+#endif
+}
+
+char *getCPUModel() {
+#ifdef __APPLE__
+	char buf[256];
+	size_t len = sizeof(buf);
+	if (sysctlbyname("machdep.cpu.brand_string", buf, &len, NULL, 0) == 0) return stringCopy(buf);
+#elif __linux__
+	FILE *cpuinfo = fopen("/proc/cpuinfo", "r");
+	if (cpuinfo) {
+		char line[512];
+		while (fgets(line, sizeof(line), cpuinfo)) {
+			// x86 calls it "model name", some ARM kernels only provide "Hardware"
+			if (strncmp(line, "model name", 10) && strncmp(line, "Hardware", 8)) continue;
+			char *value = strchr(line, ':');
+			if (!value) continue;
+			value++;
+			while (*value == ' ' || *value == '\t') value++;
+			value[strcspn(value, "\n")] = 0;
+			fclose(cpuinfo);
+			return stringCopy(value);
+		}
+		fclose(cpuinfo);
+	}
+#elif _WIN32
+	char buf[256];
+	DWORD len = sizeof(buf);
+	if (RegGetValueA(HKEY_LOCAL_MACHINE, "HARDWARE\\DESCRIPTION\\System\\CentralProcessor\\0", "ProcessorNameString", RRF_RT_REG_SZ, NULL, buf, &len) == ERROR_SUCCESS) return stringCopy(buf);
+#endif
+	return stringCopy("Unknown");
+}
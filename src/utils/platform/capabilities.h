@@ -8,7 +8,17 @@
 
 #pragma once
 
+#include <stddef.h>
+
 /// Get amount of logical processing cores on the system
 /// @remark Is unaware of NUMA nodes on high core count systems
 /// @return Amount of logical processing cores
 int getSysCores(void);
+
+/// Get the peak resident set size of this process
+/// @return Peak memory usage in bytes, or 0 if unavailable
+size_t getPeakRSS(void);
+
+/// Get a human-readable CPU model name
+/// @return A newly allocated string, caller frees
+char *getCPUModel(void);
@@ -16,7 +16,6 @@
 #include "../../libraries/cJSON.h"
 #include "../../datatypes/image/imagefile.h"
 #include "../../datatypes/vector.h"
-#include "../../datatypes/vertexbuffer.h"
 #include "../../datatypes/tile.h"
 #include "../../datatypes/image/texture.h"
 #include "../../datatypes/color.h"
@@ -123,6 +122,7 @@ struct texture *decodeTexture(const cJSON *json) {
 	tex->height = cJSON_GetNumberValue(cJSON_GetObjectItem(json, "height"));
 	tex->channels = cJSON_GetNumberValue(cJSON_GetObjectItem(json, "channels"));
 	tex->precision = cJSON_IsTrue(cJSON_GetObjectItem(json, "isFloatPrecision")) ? float_p : char_p;
+	textureSelectFetch(tex);
 	return tex;
 }
 
@@ -52,6 +52,7 @@ struct workerThreadState {
 	struct renderer *renderer;
 	bool threadComplete;
 	uint64_t totalSamples;
+	uint64_t totalRays;
 	int completedSamples;
 	long avgSampleTime;
 };
@@ -144,7 +145,8 @@ static void *workerThread(void *arg) {
 	struct renderTile tile = getWork(sock);
 	releaseMutex(sockMutex);
 	struct texture *tileBuffer = newTexture(char_p, tile.width, tile.height, 3);
-	sampler *sampler = newSampler();
+	sampler sampler = {0};
+	const pathTracer trace = getPathTracer(r->prefs.sampler);
 	
 	struct timeval timer = { 0 };
 	threadState->completedSamples = 1;
@@ -159,11 +161,11 @@ static void *workerThread(void *arg) {
 				for (int x = tile.begin.x; x < tile.end.x; ++x) {
 					if (r->state.renderAborted) return 0;
 					uint32_t pixIdx = (uint32_t)(y * r->prefs.imageWidth + x);
-					initSampler(sampler, Random, threadState->completedSamples - 1, r->prefs.sampleCount, pixIdx);
+					initSampler(&sampler, r->prefs.sampler, threadState->completedSamples - 1, r->prefs.sampleCount, pixIdx);
 					
 					struct color output = textureGetPixel(r->state.renderBuffer, x, y, false);
-					struct lightRay incidentRay = getCameraRay(r->scene->camera, x, y, sampler);
-					struct color sample = pathTrace(&incidentRay, r->scene, r->prefs.bounces, sampler);
+					struct lightRay incidentRay = getCameraRay(r->scene->camera, x, y, &sampler);
+					struct color sample = trace(&incidentRay, r->scene, r->prefs.bounces, &sampler, &threadState->totalRays);
 					
 					//And process the running average
 					output = colorCoef((float)(threadState->completedSamples - 1), output);
@@ -207,7 +209,6 @@ static void *workerThread(void *arg) {
 		tile = getWork(sock);
 		releaseMutex(sockMutex);
 	}
-	destroySampler(sampler);
 	destroyTexture(tileBuffer);
 	
 	threadState->threadComplete = true;
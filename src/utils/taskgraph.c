@@ -0,0 +1,173 @@
+//
+//  taskgraph.c
+//  C-ray
+//
+//  Created by Valtteri Koskivuori on 18/10/2026.
+//  Copyright © 2026 Valtteri Koskivuori. All rights reserved.
+//
+
+#include "../includes.h"
+#include "taskgraph.h"
+#include "logging.h"
+#include "timer.h"
+#include "platform/thread.h"
+#include "platform/mutex.h"
+
+struct task {
+	taskFunc func;
+	void *arg;
+};
+
+struct taskGraph {
+	// Taken from the end, so the latest tasks run first
+	struct task *tasks;
+	size_t taskCount;
+	size_t capacity;
+	int running;
+	int threadCount;
+	struct crMutex *lock;
+};
+
+struct taskGraph *newTaskGraph() {
+	struct taskGraph *graph = calloc(1, sizeof(*graph));
+	graph->lock = createMutex();
+	return graph;
+}
+
+void addTask(struct taskGraph *graph, taskFunc func, void *arg) {
+	lockMutex(graph->lock);
+	if (graph->taskCount == graph->capacity) {
+		graph->capacity = graph->capacity ? graph->capacity * 2 : 16;
+		graph->tasks = realloc(graph->tasks, graph->capacity * sizeof(*graph->tasks));
+	}
+	graph->tasks[graph->taskCount++] = (struct task){ .func = func, .arg = arg };
+	releaseMutex(graph->lock);
+}
+
+// Tasks are only ever added by the caller or by running tasks, so once there are none queued
+// and none running, there won't be any more.
+static void *taskThread(void *arg) {
+	struct taskGraph *graph = (struct taskGraph *)threadUserData(arg);
+	lockMutex(graph->lock);
+	while (graph->taskCount || graph->running) {
+		if (!graph->taskCount) {
+			// Waiting on a running task that may add more
+			releaseMutex(graph->lock);
+			sleepMSec(1);
+			lockMutex(graph->lock);
+			continue;
+		}
+		const struct task task = graph->tasks[--graph->taskCount];
+		graph->running++;
+		releaseMutex(graph->lock);
+		task.func(graph, task.arg);
+		lockMutex(graph->lock);
+		graph->running--;
+	}
+	releaseMutex(graph->lock);
+	return NULL;
+}
+
+void runTaskGraph(struct taskGraph *graph, int threadCount) {
+	graph->threadCount = threadCount > 1 ? threadCount : 1;
+	if (threadCount <= 1) {
+		struct crThread thread = { .userData = graph };
+		taskThread(&thread);
+		graph->threadCount = 0;
+		return;
+	}
+	struct crThread *threads = calloc(threadCount, sizeof(*threads));
+	for (int t = 0; t < threadCount; ++t) {
+		threads[t] = (struct crThread){
+			.threadFunc = taskThread,
+			.userData = graph
+		};
+		if (threadStart(&threads[t])) {
+			logr(error, "Failed to start a task thread\n");
+		}
+	}
+	for (int t = 0; t < threadCount; ++t) {
+		threadWait(&threads[t]);
+	}
+	free(threads);
+	graph->threadCount = 0;
+}
+
+int taskGraphThreads(const struct taskGraph *graph) {
+	return graph ? graph->threadCount : 0;
+}
+
+// Shared by the caller and the helper tasks it queues. Helpers can start long after the elements are done,
+// so whoever is last to let go of it frees it.
+struct parallelRun {
+	void (*func)(void *element);
+	char *elements;
+	size_t elementSize;
+	size_t count;
+	size_t next;
+	size_t done;
+	int references;
+	struct crMutex *lock;
+};
+
+static void runElements(struct parallelRun *run) {
+	lockMutex(run->lock);
+	while (run->next < run->count) {
+		void *element = run->elements + run->next++ * run->elementSize;
+		releaseMutex(run->lock);
+		run->func(element);
+		lockMutex(run->lock);
+		run->done++;
+	}
+	releaseMutex(run->lock);
+}
+
+static void releaseRun(struct parallelRun *run) {
+	lockMutex(run->lock);
+	const bool last = --run->references == 0;
+	releaseMutex(run->lock);
+	if (!last) return;
+	free(run->lock);
+	free(run);
+}
+
+static void parallelTask(struct taskGraph *graph, void *arg) {
+	(void)graph;
+	runElements(arg);
+	releaseRun(arg);
+}
+
+void runParallel(struct taskGraph *graph, void (*func)(void *element), void *elements, size_t elementSize, size_t count) {
+	const size_t helpers = min((size_t)max(taskGraphThreads(graph), 1), count ? count : 1) - 1;
+	if (!helpers) {
+		for (size_t i = 0; i < count; ++i) func((char *)elements + i * elementSize);
+		return;
+	}
+	struct parallelRun *run = calloc(1, sizeof(*run));
+	*run = (struct parallelRun){
+		.func = func,
+		.elements = elements,
+		.elementSize = elementSize,
+		.count = count,
+		.references = (int)helpers + 1,
+		.lock = createMutex()
+	};
+	for (size_t i = 0; i < helpers; ++i) addTask(graph, parallelTask, run);
+	runElements(run);
+	// What's left is running on other threads
+	lockMutex(run->lock);
+	while (run->done < run->count) {
+		releaseMutex(run->lock);
+		sleepMSec(1);
+		lockMutex(run->lock);
+	}
+	releaseMutex(run->lock);
+	releaseRun(run);
+}
+
+void destroyTaskGraph(struct taskGraph *graph) {
+	if (!graph) return;
+	free(graph->tasks);
+	free(graph->lock);
+	free(graph);
+}
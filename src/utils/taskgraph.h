@@ -0,0 +1,37 @@
+//
+//  taskgraph.h
+//  C-ray
+//
+//  Created by Valtteri Koskivuori on 18/10/2026.
+//  Copyright © 2026 Valtteri Koskivuori. All rights reserved.
+//
+
+#pragma once
+
+// Work split into tasks, run on a fixed set of threads. A task can add the tasks that depend on it
+// as it finishes, and those are picked up before anything queued earlier, so follow-up work starts
+// as soon as it's possible instead of waiting for the rest of the queue.
+
+struct taskGraph;
+
+typedef void (*taskFunc)(struct taskGraph *graph, void *arg);
+
+struct taskGraph *newTaskGraph(void);
+
+/// Queue a task. Safe to call from a running task.
+void addTask(struct taskGraph *graph, taskFunc func, void *arg);
+
+/// Run queued tasks until every one of them, including tasks they add, has finished
+/// @param threadCount Threads to run them on, 1 runs them on the calling thread
+void runTaskGraph(struct taskGraph *graph, int threadCount);
+
+/// Threads the graph is running on, 0 if it isn't running
+int taskGraphThreads(const struct taskGraph *graph);
+
+/// Call func on each of count elements, spread over the threads running the graph, and return once all of them are done.
+/// Meant to be called from a running task. The caller works through the elements too, so it never waits on
+/// an element that hasn't started, and the graph doesn't need a thread to spare.
+/// @param graph Optional, without one the elements are processed on the calling thread
+void runParallel(struct taskGraph *graph, void (*func)(void *element), void *elements, size_t elementSize, size_t count);
+
+void destroyTaskGraph(struct taskGraph *graph);
@@ -45,10 +45,17 @@ textBuffer *newTextView(textBuffer *original, const size_t start, const size_t l
 }
 
 textBuffer *newTextBuffer(const char *contents) {
+	if (!contents) return NULL;
+	return newTextBufferWithLength(contents, strlen(contents));
+}
+
+textBuffer *newTextBufferWithLength(const char *contents, size_t length) {
 	if (!contents) return NULL;
 	textBuffer *new = calloc(1, sizeof(*new));
-	new->buf = stringCopy(contents);
-	new->buflen = strlen(contents);
+	new->buf = malloc(length + 1);
+	memcpy(new->buf, contents, length);
+	new->buf[length] = '\0';
+	new->buflen = length;
 	
 	//Figure out the line count and convert newlines
 	size_t lines = 0;
@@ -32,6 +32,9 @@ typedef struct _textBuffer lineBuffer;
 
 textBuffer *newTextBuffer(const char *contents);
 
+// For text that isn't null terminated, like a mapped file
+textBuffer *newTextBufferWithLength(const char *contents, size_t length);
+
 lineBuffer *newLineBuffer(void);
 
 // A subset of a textBuffer
@@ -7,6 +7,10 @@
 //
 
 #include "../../src/utils/fileio.h"
+#include "../../src/utils/loaders/formats/wavefront/wavefront.h"
+#include "../../src/datatypes/mesh.h"
+#include "../../src/utils/taskgraph.h"
+#include "../../src/utils/platform/capabilities.h"
 
 time_t fileio_load(void) {
 	struct timeval test;
@@ -20,3 +24,31 @@ time_t fileio_load(void) {
 	free(bigfile);
 	return us;
 }
+
+struct fileio_parsed {
+	struct mesh *meshes;
+	size_t meshCount;
+};
+
+static void fileio_parseTask(struct taskGraph *graph, void *arg) {
+	struct fileio_parsed *parsed = arg;
+	parsed->meshes = parseWavefront("input/venusscaled.obj", &parsed->meshCount, graph);
+}
+
+time_t fileio_parse(void) {
+	struct timeval test;
+	startTimer(&test);
+	
+	// Scenes parse on a task graph, which big files are split up over
+	struct fileio_parsed parsed = { 0 };
+	struct taskGraph *graph = newTaskGraph();
+	addTask(graph, fileio_parseTask, &parsed);
+	runTaskGraph(graph, getSysCores());
+	destroyTaskGraph(graph);
+	ASSERT(parsed.meshes);
+	
+	time_t us = getUs(test);
+	for (size_t i = 0; i < parsed.meshCount; ++i) destroyMesh(&parsed.meshes[i]);
+	free(parsed.meshes);
+	return us;
+}
@@ -0,0 +1,64 @@
+//
+//  perf_nodes.h
+//  C-Ray
+//
+//  Created by Valtteri Koskivuori on 18/10/2026.
+//  Copyright © 2026 Valtteri Koskivuori. All rights reserved.
+//
+
+#include "../../src/nodes/bsdfnode.h"
+#include "../../src/nodes/compiler.h"
+#include "../../src/datatypes/scene.h"
+#include "../../src/datatypes/hitrecord.h"
+#include "../../src/utils/hashtable.h"
+#include "../../src/utils/mempool.h"
+
+#define PERF_NODES_EVALS (256 * 256)
+
+// Keeps the compiler from discarding the results
+static volatile float perf_nodes_sink;
+
+// A procedural material input, about a dozen nodes deep with some shared subgraphs
+static const struct colorNode *perf_nodes_graph(struct world *w) {
+	const struct valueNode *scaled = newMath(w, newRayLength(w), newMath(w, newConstantValue(w, 2.0f), newConstantValue(w, 3.0f), Power), Multiply);
+	const struct colorNode *checker = newCheckerBoardTexture(w, newBlackbody(w, newConstantValue(w, 3000.0f)), newCombineValue(w, scaled), newConstantValue(w, 4.0f));
+	const struct vectorNode *normal = newVecMath(w, newNormal(w), newConstantVector(w, (struct vector){ 0.0f, 1.0f, 0.0f }), VecAverage);
+	return newCombineRGB(w,
+		newMath(w, scaled, newGrayscaleConverter(w, checker), Max),
+		newGrayscaleConverter(w, newVecToColor(w, normal)),
+		newMath(w, newFresnel(w, newConstantValue(w, 1.5f), NULL), newAlpha(w, checker), Add));
+}
+
+static inline time_t perf_nodes_run(bool compiled) {
+	struct world w = { .nodePool = newBlock(NULL, 1024) };
+	w.nodeTable = newHashtable(compareNodes, &w.nodePool);
+	const struct colorNode *graph = perf_nodes_graph(&w);
+	if (compiled) graph = compileColor(&w, graph);
+	struct hitRecord record = {
+		.incident = { .direction = { 0.0f, -1.0f, 0.0f } },
+		.surfaceNormal = { 0.0f, 1.0f, 0.0f },
+	};
+	float sum = 0.0f;
+	struct timeval test;
+	startTimer(&test);
+	
+	for (int i = 0; i < PERF_NODES_EVALS; ++i) {
+		record.uv = (struct coord){ (i & 255) / 256.0f, (i >> 8) / 256.0f };
+		record.distance = i * 0.001f;
+		sum += graph->eval(graph, &record).red;
+	}
+	
+	time_t us = getUs(test);
+	perf_nodes_sink = sum;
+	destroyHashtable(w.nodeTable);
+	destroyBlocks(w.nodePool);
+	return us;
+}
+
+time_t nodes_graph(void) {
+	return perf_nodes_run(false);
+}
+
+time_t nodes_compiled(void) {
+	return perf_nodes_run(true);
+}
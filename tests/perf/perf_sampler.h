@@ -0,0 +1,60 @@
+//
+//  perf_sampler.h
+//  C-Ray
+//
+//  Created by Valtteri Koskivuori on 18/10/2026.
+//  Copyright © 2026 Valtteri Koskivuori. All rights reserved.
+//
+
+#include "../../src/renderer/samplers/sampler.h"
+
+// Roughly a 256x256 pixel pass, drawing as many dimensions as a few bounces would
+#define PERF_SAMPLER_PIXELS (256 * 256)
+#define PERF_SAMPLER_DIMENSIONS 24
+
+// Keeps the compiler from discarding the samples
+static volatile float perf_sampler_sink;
+
+static inline time_t perf_sampler_run(const enum samplerType type, bool specialized) {
+	sampler s = {0};
+	float sum = 0.0f;
+	
+	struct timeval test;
+	startTimer(&test);
+	
+	for (uint32_t pixel = 0; pixel < PERF_SAMPLER_PIXELS; ++pixel) {
+		initSampler(&s, type, 3, 16, pixel);
+		for (int d = 0; d < PERF_SAMPLER_DIMENSIONS; ++d) {
+			sum += specialized ? getDimensionOf(&s, type) : getDimension(&s);
+		}
+	}
+	
+	time_t us = getUs(test);
+	perf_sampler_sink = sum;
+	return us;
+}
+
+time_t sampler_halton(void) {
+	return perf_sampler_run(Halton, true);
+}
+
+time_t sampler_hammersley(void) {
+	return perf_sampler_run(Hammersley, true);
+}
+
+time_t sampler_random(void) {
+	return perf_sampler_run(Random, true);
+}
+
+time_t sampler_sobol(void) {
+	return perf_sampler_run(Sobol, true);
+}
+
+// Same workload, but dispatching on sampler->type for every dimension
+time_t sampler_sobol_dynamic(void) {
+	return perf_sampler_run(Sobol, false);
+}
+
+time_t sampler_random_dynamic(void) {
+	return perf_sampler_run(Random, false);
+}
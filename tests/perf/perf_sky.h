@@ -0,0 +1,68 @@
+//
+//  perf_sky.h
+//  C-Ray
+//
+//  Created by Valtteri Koskivuori on 18/10/2026.
+//  Copyright © 2026 Valtteri Koskivuori. All rights reserved.
+//
+
+#include "../../src/renderer/sky.h"
+#include "../../src/datatypes/lightray.h"
+#include "../../src/datatypes/image/texture.h"
+#include "../../src/datatypes/hitrecord.h"
+#include "../../src/datatypes/scene.h"
+#include "../../src/nodes/bsdfnode.h"
+#include "../../src/nodes/shaders/background.h"
+#include "../../src/utils/hashtable.h"
+#include "../../src/utils/mempool.h"
+
+// About as many escaped rays as a 512x512 pass with a mostly open view
+#define PERF_SKY_RAYS (512 * 512)
+
+// Keeps the compiler from discarding the results
+static volatile float perf_sky_sink;
+
+static inline struct vector perf_sky_direction(int i) {
+	// Spherical Fibonacci points over the upper hemisphere
+	const float y = (i + 0.5f) / PERF_SKY_RAYS;
+	const float r = sqrtf(1.0f - y * y);
+	const float phi = i * 2.39996323f;
+	return (struct vector){ r * cosf(phi), y, r * sinf(phi) };
+}
+
+time_t sky_analytic(void) {
+	float sum = 0.0f;
+	struct timeval test;
+	startTimer(&test);
+	
+	for (int i = 0; i < PERF_SKY_RAYS; ++i) {
+		sum += sky((struct lightRay){ .direction = perf_sky_direction(i) }).red;
+	}
+	
+	time_t us = getUs(test);
+	perf_sky_sink = sum;
+	return us;
+}
+
+time_t sky_baked(void) {
+	struct world w = { .nodePool = newBlock(NULL, 1024) };
+	w.nodeTable = newHashtable(compareNodes, &w.nodePool);
+	struct texture *lut = newSkyTexture(512, 256, NULL);
+	const struct bsdfNode *background = newBackground(&w, newImageTexture(&w, lut, 0), NULL, NULL);
+	float sum = 0.0f;
+	struct timeval test;
+	startTimer(&test);
+	
+	// Through the background shader, like escaped rays in the renderer
+	for (int i = 0; i < PERF_SKY_RAYS; ++i) {
+		struct hitRecord record = { .incident = { .direction = perf_sky_direction(i) }, .instIndex = -1 };
+		sum += background->sample(background, NULL, &record).color.red;
+	}
+	
+	time_t us = getUs(test);
+	perf_sky_sink = sum;
+	destroyTexture(lut);
+	destroyHashtable(w.nodeTable);
+	destroyBlocks(w.nodePool);
+	return us;
+}
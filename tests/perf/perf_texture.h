@@ -14,7 +14,7 @@ time_t texture_load(void) {
 	struct timeval test;
 	startTimer(&test);
 	
-	struct texture *new = loadTexture("input/", NULL);
+	struct texture *new = loadTexture("input/", linear, false, NULL);
 	
 	ASSERT(new);
 	
@@ -22,3 +22,60 @@ time_t texture_load(void) {
 	destroyTexture(new);
 	return us;
 }
+
+#define PERF_TEXTURE_LOOKUPS (1024 * 1024)
+
+// Keeps the compiler from discarding the results
+static volatile float perf_texture_sink;
+
+static void perf_texture_fill(struct texture *t) {
+	for (size_t y = 0; y < t->height; ++y) {
+		for (size_t x = 0; x < t->width; ++x) {
+			const float v = (float)((x * 31 + y * 17) % 256) / 255.0f;
+			setPixel(t, (struct color){ v, 1.0f - v, 0.5f * v, 1.0f }, x, y);
+		}
+	}
+}
+
+static inline time_t perf_texture_lookups(struct texture *t) {
+	float sum = 0.0f;
+	struct timeval test;
+	startTimer(&test);
+	
+	// Scattered like secondary bounces, so most lookups miss the previous one's cache lines
+	for (int i = 0; i < PERF_TEXTURE_LOOKUPS; ++i) {
+		const float u = (i * 0.618034f) - (int)(i * 0.618034f);
+		const float v = (i * 0.754878f) - (int)(i * 0.754878f);
+		sum += textureGetPixel(t, u, v, true).red;
+	}
+	
+	time_t us = getUs(test);
+	perf_texture_sink = sum;
+	destroyTexture(t);
+	return us;
+}
+
+static inline time_t perf_texture_bilinear(struct texture *t) {
+	perf_texture_fill(t);
+	return perf_texture_lookups(t);
+}
+
+time_t texture_bilinear_srgb(void) {
+	struct texture *t = newTexture(char_p, 1024, 1024, 3);
+	t->colorspace = sRGB;
+	return perf_texture_bilinear(t);
+}
+
+// Same texture as texture_bilinear_srgb, in a sixth of the memory
+time_t texture_bilinear_bc1(void) {
+	struct texture *t = newTexture(char_p, 1024, 1024, 3);
+	t->colorspace = sRGB;
+	perf_texture_fill(t);
+	struct texture *compressed = compressTexture(t, NULL);
+	destroyTexture(t);
+	return perf_texture_lookups(compressed);
+}
+
+time_t texture_bilinear_float(void) {
+	return perf_texture_bilinear(newTexture(float_p, 1000, 1000, 4));
+}
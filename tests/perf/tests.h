@@ -12,11 +12,28 @@ static char *failed_expression;
 #include "perf_texture.h"
 #include "perf_fileio.h"
 #include "perf_base64.h"
+#include "perf_sampler.h"
+#include "perf_sky.h"
+#include "perf_nodes.h"
 
 static perfTest perfTests[] = {
+	{"texture::bilinear_srgb", texture_bilinear_srgb},
+	{"texture::bilinear_bc1", texture_bilinear_bc1},
+	{"texture::bilinear_float", texture_bilinear_float},
 	{"fileio::load", fileio_load},
+	{"fileio::parse", fileio_parse},
 	{"base64::bigfile_encode", base64_bigfile_encode},
 	{"base64::bigfile_decode", base64_bigfile_decode},
+	{"sampler::halton", sampler_halton},
+	{"sampler::hammersley", sampler_hammersley},
+	{"sampler::random", sampler_random},
+	{"sampler::random_dynamic", sampler_random_dynamic},
+	{"sampler::sobol", sampler_sobol},
+	{"sampler::sobol_dynamic", sampler_sobol_dynamic},
+	{"sky::analytic", sky_analytic},
+	{"sky::baked", sky_baked},
+	{"nodes::graph", nodes_graph},
+	{"nodes::compiled", nodes_compiled},
 };
 
 #define perfTestCount (sizeof(perfTests) / sizeof(perfTest))
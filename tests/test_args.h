@@ -0,0 +1,26 @@
+//
+//  test_args.h
+//  C-Ray
+//
+//  Created by Valtteri Koskivuori on 18/10/2026.
+//  Copyright © 2026 Valtteri Koskivuori. All rights reserved.
+//
+
+#include "../src/utils/args.h"
+
+bool args_parseDuration(void) {
+	
+	test_assert(parseDuration("90s") == 90000);
+	test_assert(parseDuration("90") == 90000);
+	test_assert(parseDuration("250ms") == 250);
+	test_assert(parseDuration("1.5m") == 90000);
+	test_assert(parseDuration("2h") == 7200000);
+	
+	test_assert(parseDuration(NULL) == 0);
+	test_assert(parseDuration("") == 0);
+	test_assert(parseDuration("-5s") == 0);
+	test_assert(parseDuration("10parsecs") == 0);
+	test_assert(parseDuration("seconds") == 0);
+	
+	return true;
+}
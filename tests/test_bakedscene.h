@@ -0,0 +1,115 @@
+//
+//  test_bakedscene.h
+//  C-Ray
+//
+//  Created by Valtteri Koskivuori on 18/10/2026.
+//  Copyright © 2026 Valtteri Koskivuori. All rights reserved.
+//
+
+#include "../src/utils/loaders/bakedscene.h"
+#include "../src/utils/loaders/meshloader.h"
+#include "../src/utils/loaders/textureloader.h"
+#include "../src/renderer/renderer.h"
+#include "../src/datatypes/scene.h"
+#include "../src/datatypes/mesh.h"
+#include "../src/datatypes/poly.h"
+#include "../src/accelerators/bvh.h"
+
+bool bakedscene_rejects_invalid(void) {
+	const char *path = "bakedscene_rejects_invalid.crscene";
+	FILE *file = fopen(path, "wb");
+	test_assert(file);
+	fputs("{\"scene\": {}}", file);
+	fclose(file);
+	test_assert(!isBakedScene(path));
+	test_assert(!openBakedScene(path, ""));
+
+	// Right magic, but cut off before the rest of the header, so the version is never looked at
+	const uint32_t header[2] = { 0x43535243, 1 };
+	file = fopen(path, "wb");
+	test_assert(file);
+	fwrite(header, sizeof(header), 1, file);
+	fclose(file);
+	test_assert(isBakedScene(path));
+	test_assert(!openBakedScene(path, ""));
+
+	test_assert(!isBakedScene("bakedscene_missing.crscene"));
+	remove(path);
+	return true;
+}
+
+// Bake a textured OBJ with two objects sharing their vertices and materials, and load it back
+bool bakedscene_round_trip(void) {
+	const unsigned char ppm[] = "P6\n2 2\n255\n\xff\x00\x00\x00\xff\x00\x00\x00\xff\xff\xff\xff";
+	test_assert(texture_writeFile("bakedscene_round_trip.ppm", ppm, sizeof(ppm) - 1));
+	test_assert(meshloader_writeFile("bakedscene_round_trip.mtl", "newmtl checker\nKd 1 1 1\nmap_Kd bakedscene_round_trip.ppm\n"));
+	test_assert(meshloader_writeFile("bakedscene_round_trip.obj",
+		"mtllib bakedscene_round_trip.mtl\n"
+		"v 0 0 0\nv 1 0 0\nv 1 1 0\nv 0 1 0\nv 2 0 1\nvt 0 0\nvt 1 0\nvt 1 1\nvn 0 0 1\n"
+		"o first\nusemtl checker\nf 1/1/1 2/2/1 3/3/1 4/3/1\n"
+		"o second\nusemtl checker\nf 2/1/1 5/2/1 3/3/1\n"));
+	const char *path = "bakedscene_round_trip.crscene";
+
+	struct bakeLog *log = newBakeLog("{\"scene\": {}}");
+	beginTextureLoads(NULL, NULL, NULL, log);
+	size_t meshCount = 0;
+	struct mesh *meshes = loadMesh("bakedscene_round_trip.obj", &meshCount, NULL, NULL, NULL);
+	endTextureLoads();
+	test_assert(meshes && meshCount == 2);
+	bakeLogMeshEntry(log, meshCount, NULL, 0);
+	for (size_t i = 0; i < meshCount; ++i) meshes[i].bvh = buildBottomLevelBvh(&meshes[i]);
+	struct world scene = { .meshes = meshes, .meshCount = (int)meshCount, .bakeLog = log };
+	struct renderer r = { .scene = &scene, .prefs = { .assetPath = "" } };
+	test_assert(bakeScene(&r, path));
+
+	struct bakedScene *baked = openBakedScene(path, "");
+	test_assert(baked);
+	test_assert(stringEquals(bakedSceneJSON(baked), log->json));
+	size_t bakedCount = 0, placementCount = 0;
+	struct meshPlacement *placements = NULL;
+	struct mesh *loaded = loadBakedMeshes(baked, 0, &bakedCount, &placements, &placementCount);
+	test_assert(loaded && bakedCount == meshCount && placementCount == 0);
+	for (size_t i = 0; i < meshCount; ++i) {
+		const struct mesh *a = &meshes[i];
+		const struct mesh *b = &loaded[i];
+		test_assert(stringEquals(a->name, b->name));
+		test_assert(a->vertexCount == b->vertexCount && a->normalCount == b->normalCount && a->textureCoordCount == b->textureCoordCount);
+		test_assert(!memcmp(a->vertices, b->vertices, a->vertexCount * sizeof(*a->vertices)));
+		test_assert(!memcmp(a->texCoords, b->texCoords, a->textureCoordCount * sizeof(*a->texCoords)));
+		test_assert(a->polyCount == b->polyCount);
+		test_assert(!memcmp(a->polygons, b->polygons, a->polyCount * sizeof(*a->polygons)));
+		test_assert(a->materialCount == b->materialCount && stringEquals(a->materials[0].name, b->materials[0].name));
+		const void *nodes = NULL;
+		const int *indices = NULL;
+		unsigned nodeCount = 0, primCount = 0, bakedNodeCount = 0, bakedPrimCount = 0;
+		getBvhData(a->bvh, &nodes, &nodeCount, &indices, &primCount);
+		test_assert(b->bvh);
+		getBvhData(b->bvh, &nodes, &bakedNodeCount, &indices, &bakedPrimCount);
+		test_assert(nodeCount == bakedNodeCount && primCount == bakedPrimCount);
+	}
+	// Vertices and materials are still shared, and so is the texture
+	test_assert(loaded[1].sharedVertices && loaded[1].vertices == loaded[0].vertices);
+	test_assert(loaded[1].sharedMaterials && loaded[1].materials == loaded[0].materials);
+	const struct texture *original = meshes[0].materials[0].texture;
+	const struct texture *texture = loaded[0].materials[0].texture;
+	test_assert(original && texture && texture != original);
+	test_assert(texture->width == 2 && texture->height == 2 && texture->mipCount == original->mipCount);
+	for (size_t i = 0; i < 4; ++i) {
+		test_assert(colorEquals(textureGetPixel(texture, i % 2, i / 2, false), textureGetPixel(original, i % 2, i / 2, false)));
+	}
+	// The MTL loader looks textures up next to the MTL file
+	const struct texture *found = findBakedTexture(baked, "./bakedscene_round_trip.ppm", sRGB, false);
+	test_assert(found && found->data.byte_p == texture->data.byte_p);
+
+	free(placements);
+	free(loaded);
+	closeBakedScene(baked);
+	for (size_t i = 0; i < meshCount; ++i) destroyMesh(&meshes[i]);
+	free(meshes);
+	destroyBakeLog(log);
+	remove(path);
+	remove("bakedscene_round_trip.obj");
+	remove("bakedscene_round_trip.mtl");
+	remove("bakedscene_round_trip.ppm");
+	return true;
+}
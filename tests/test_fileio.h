@@ -6,6 +6,8 @@
 //  Copyright © 2020 Valtteri Koskivuori. All rights reserved.
 //
 
+#include <stdio.h>
+#include <string.h>
 #include "../src/utils/fileio.h"
 
 bool fileio_humanFileSize(void) {
@@ -52,3 +54,22 @@ bool fileio_getFilePath(void) {
 	
 	return true;
 }
+
+bool fileio_mapFile(void) {
+	const char *path = "fileio_mapFile.txt";
+	const char contents[] = "Mapped\nfile";
+	FILE *file = fopen(path, "wb");
+	test_assert(file);
+	fwrite(contents, 1, sizeof(contents) - 1, file);
+	fclose(file);
+	
+	struct fileView view = mapFile(path);
+	test_assert(view.data);
+	test_assert(view.size == sizeof(contents) - 1);
+	test_assert(memcmp(view.data, contents, view.size) == 0);
+	unmapFile(&view);
+	test_assert(!view.data && !view.size);
+	remove(path);
+	
+	return true;
+}
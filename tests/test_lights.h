@@ -0,0 +1,326 @@
+//
+//  test_lights.h
+//  C-Ray
+//
+//  Created by Valtteri Koskivuori on 18/10/2026.
+//  Copyright © 2026 Valtteri Koskivuori. All rights reserved.
+//
+
+#include <float.h>
+#include "../src/renderer/lights.h"
+#include "../src/renderer/samplers/sampler.h"
+#include "../src/datatypes/scene.h"
+#include "../src/datatypes/sphere.h"
+#include "../src/datatypes/instance.h"
+#include "../src/datatypes/hitrecord.h"
+#include "../src/nodes/bsdfnode.h"
+#include "../src/nodes/shaders/background.h"
+#include "../src/datatypes/image/texture.h"
+#include "../src/datatypes/lightray.h"
+#include "../src/renderer/sky.h"
+#include "../src/utils/mempool.h"
+#include "../src/utils/hashtable.h"
+
+static struct world *lights_newWorld(void) {
+	struct world *w = calloc(1, sizeof(*w));
+	w->nodePool = newBlock(NULL, 1024);
+	w->nodeTable = newHashtable(compareNodes, &w->nodePool);
+	return w;
+}
+
+static void lights_destroyWorld(struct world *w) {
+	destroyHashtable(w->nodeTable);
+	destroyBlocks(w->nodePool);
+	free(w->instances);
+	free(w);
+}
+
+static float lights_radicalInverse(uint32_t i) {
+	i = (i << 16) | (i >> 16);
+	i = ((i & 0x00ff00ff) << 8) | ((i & 0xff00ff00) >> 8);
+	i = ((i & 0x0f0f0f0f) << 4) | ((i & 0xf0f0f0f0) >> 4);
+	i = ((i & 0x33333333) << 2) | ((i & 0xcccccccc) >> 2);
+	i = ((i & 0x55555555) << 1) | ((i & 0xaaaaaaaa) >> 1);
+	return i * 0x1p-32f;
+}
+
+static bool lights_closeTo(float a, float b) {
+	return fabsf(a - b) <= 1e-3f * max(fabsf(a), fabsf(b)) + 1e-6f;
+}
+
+// sample() has to report the same density that pdf() gives for its direction, or MIS weights won't sum to one
+bool bsdf_pdf_matches_sample(void) {
+	struct world *w = lights_newWorld();
+	const struct bsdfNode *diffuse = newDiffuse(w, newConstantTexture(w, grayColor));
+	const struct bsdfNode *metal = newMetal(w, newConstantTexture(w, whiteColor), NULL);
+	const struct bsdfNode *mix = newMix(w, diffuse, metal, newConstantValue(w, 0.25f));
+	struct hitRecord record = {
+		.incident = { .start = { 0.0f, 1.0f, 0.0f }, .direction = { 0.0f, -1.0f, 0.0f } },
+		.surfaceNormal = { 0.0f, 1.0f, 0.0f }
+	};
+	sampler s = {0};
+	int evaluable = 0;
+	for (int i = 0; i < 256; ++i) {
+		initSampler(&s, Sobol, i, 256, 7);
+		struct bsdfSample sample = mix->sample(mix, &s, &record);
+		if (sample.pdf <= 0.0f) continue;
+		evaluable++;
+		test_assert(lights_closeTo(sample.pdf, mix->pdf(mix, &record, sample.out)));
+		// Diffuse weight is just the albedo: eval / pdf over the diffuse lobe
+		struct color f = diffuse->eval(diffuse, &record, sample.out);
+		test_assert(lights_closeTo(f.red / diffuse->pdf(diffuse, &record, sample.out), grayColor.red));
+	}
+	// Metal is picked 25% of the time
+	test_assert(evaluable > 160 && evaluable < 224);
+	test_assert(metal->pdf(metal, &record, (struct vector){ 0.0f, 1.0f, 0.0f }) == 0.0f);
+	lights_destroyWorld(w);
+	return true;
+}
+
+bool bsdf_emission(void) {
+	struct world *w = lights_newWorld();
+	const struct bsdfNode *diffuse = newDiffuse(w, newConstantTexture(w, grayColor));
+	const struct bsdfNode *emit = newEmission(w, newConstantTexture(w, whiteColor), newConstantValue(w, 4.0f));
+	const struct bsdfNode *mix = newMix(w, diffuse, emit, newConstantValue(w, 0.5f));
+	struct hitRecord record = { .surfaceNormal = { 0.0f, 1.0f, 0.0f } };
+	test_assert(!diffuse->emission);
+	test_assert(emit->emission);
+	test_assert(mix->emission);
+	test_assert(bsdfEmission(mix, &record).red == 2.0f);
+	lights_destroyWorld(w);
+	return true;
+}
+
+// The pdf of a light sample must match what lightPdf() reports when a BSDF ray hits the same light
+bool lights_sphere_pdf(void) {
+	struct world *w = lights_newWorld();
+	struct sphere sphere = defaultSphere();
+	sphere.radius = 2.0f;
+	sphere.material.emission = whiteColor;
+	sphere.material.bsdf = newDiffuse(w, newConstantTexture(w, blackColor));
+	struct instance instance = newSphereInstance(&sphere);
+	instance.composite = newTransformTranslate(0.0f, 10.0f, 0.0f);
+	addInstanceToScene(w, instance);
+	
+	struct lightList *lights = newLightList(w);
+	test_assert(lightCount(lights) == 1);
+	
+	const struct vector point = vecZero();
+	const struct vector normal = { 0.0f, 1.0f, 0.0f };
+	struct lightSample sample;
+	test_assert(sampleLight(lights, point, normal, 0.5f, 0.3f, 0.7f, &sample));
+	struct lightRay ray = { .start = point, .direction = sample.direction };
+	struct hitRecord isect = { .incident = ray, .distance = FLT_MAX, .instIndex = -1 };
+	test_assert(w->instances[0].intersectFn(&w->instances[0], &ray, &isect));
+	isect.instIndex = 0;
+	test_assert(lightHit(lights, &sample, &isect));
+	test_assert(isect.distance <= sample.distance);
+	test_assert(lights_closeTo(sample.pdf, lightPdf(lights, point, normal, &isect)));
+	// Subtended cone: 1 / (2pi * (1 - cos(asin(r / d))))
+	test_assert(lights_closeTo(sample.pdf, 1.0f / (2.0f * PI * (1.0f - sqrtf(1.0f - 0.04f)))));
+	
+	destroyLightList(lights);
+	lights_destroyWorld(w);
+	return true;
+}
+
+// Emits only from the lower half, so the top of the sphere is dark
+static struct color lights_lowerHalfEval(const struct colorNode *node, const struct hitRecord *record) {
+	(void)node;
+	return record->surfaceNormal.y < 0.0f ? whiteColor : blackColor;
+}
+
+// Power is estimated from a few points on each emitter, and one that's dark at some of them still gets picked
+bool lights_partial_emitter(void) {
+	struct world *w = lights_newWorld();
+	const struct colorNode lowerHalf = { .eval = lights_lowerHalfEval };
+	struct sphere spheres[2] = { defaultSphere(), defaultSphere() };
+	spheres[0].material.bsdf = newEmission(w, &lowerHalf, newConstantValue(w, 1.0f));
+	spheres[1].material.bsdf = newEmission(w, newConstantTexture(w, whiteColor), newConstantValue(w, 1.0f));
+	for (int i = 0; i < 2; ++i) {
+		spheres[i].radius = 0.5f;
+		struct instance instance = newSphereInstance(&spheres[i]);
+		instance.composite = newTransformTranslate(4.0f * i - 2.0f, 10.0f, 0.0f);
+		addInstanceToScene(w, instance);
+	}
+	struct lightList *lights = newLightList(w);
+	test_assert(lightCount(lights) == 2);
+
+	// Both are the same distance away. 5 of the 14 points on the half lit one emit, so it's picked 5 / 19 of the time.
+	const struct vector point = vecZero();
+	const struct vector normal = { 0.0f, 1.0f, 0.0f };
+	int picked[2] = { 0 };
+	for (int i = 0; i < 1024; ++i) {
+		struct lightSample sample;
+		if (!sampleLight(lights, point, normal, (i + 0.5f) / 1024.0f, lights_radicalInverse(i), 0.5f, &sample)) continue;
+		picked[sample.direction.x < 0.0f ? 0 : 1]++;
+	}
+	test_assert(picked[0] > 230 && picked[0] < 310);
+	test_assert(picked[0] + picked[1] == 1024);
+	destroyLightList(lights);
+	lights_destroyWorld(w);
+	return true;
+}
+
+// Picking probabilities from the light tree have to add up to one, and match what sampling reports
+bool lights_tree_pdf(void) {
+	struct world *w = lights_newWorld();
+	const struct bsdfNode *black = newDiffuse(w, newConstantTexture(w, blackColor));
+	enum { sphereCount = 64 };
+	struct sphere spheres[sphereCount];
+	struct vector centers[sphereCount];
+	for (int i = 0; i < sphereCount; ++i) {
+		spheres[i] = defaultSphere();
+		spheres[i].radius = 0.1f + 0.05f * (i % 5);
+		spheres[i].material.emission = colorCoef(1.0f + (i % 7), whiteColor);
+		spheres[i].material.bsdf = black;
+		struct instance instance = newSphereInstance(&spheres[i]);
+		// Spread out on a helix around the origin, some of them below the horizon
+		centers[i] = (struct vector){ 8.0f * cosf(0.7f * i), 0.25f * i - 4.0f, 8.0f * sinf(0.7f * i) };
+		instance.composite = newTransformTranslate(centers[i].x, centers[i].y, centers[i].z);
+		addInstanceToScene(w, instance);
+	}
+	struct lightList *lights = newLightList(w);
+	test_assert(lightCount(lights) == sphereCount);
+	
+	const struct vector point = { 1.0f, 0.0f, -0.5f };
+	const struct vector normal = { 0.0f, 1.0f, 0.0f };
+	float sum = 0.0f;
+	for (int i = 0; i < sphereCount; ++i) {
+		const struct hitRecord isect = { .instIndex = i, .hitPoint = vecZero() };
+		const float distanceSquared = vecLengthSquared(vecSub(centers[i], point));
+		const float cosMax = sqrtf(1.0f - spheres[i].radius * spheres[i].radius / distanceSquared);
+		const float pick = lightPdf(lights, point, normal, &isect) * 2.0f * PI * (1.0f - cosMax);
+		// Entirely below the horizon
+		if (centers[i].y + spheres[i].radius < 0.0f) test_assert(pick == 0.0f);
+		sum += pick;
+	}
+	// Paths that end up at nodes where nothing can reach the point fail, so this can be a little under one
+	test_assert(sum > 0.9f && sum <= 1.0f + 1e-4f);
+	
+	const int count = 4096;
+	int found = 0;
+	for (int i = 0; i < count; ++i) {
+		struct lightSample sample;
+		if (!sampleLight(lights, point, normal, (i + 0.5f) / count, 0.3f, 0.7f, &sample)) continue;
+		found++;
+		const struct hitRecord isect = { .instIndex = sample.light, .hitPoint = vecZero() };
+		test_assert(lights_closeTo(sample.pdf, lightPdf(lights, point, normal, &isect)));
+	}
+	test_assert(fabsf((float)found / count - sum) < 0.01f);
+	
+	destroyLightList(lights);
+	lights_destroyWorld(w);
+	return true;
+}
+
+// In a field of identical lights, the one right above a point should be picked far more often than the rest
+bool lights_tree_prefers_nearby(void) {
+	struct world *w = lights_newWorld();
+	const struct bsdfNode *black = newDiffuse(w, newConstantTexture(w, blackColor));
+	enum { gridSize = 16 };
+	struct sphere spheres[gridSize * gridSize];
+	for (int i = 0; i < gridSize * gridSize; ++i) {
+		spheres[i] = defaultSphere();
+		spheres[i].radius = 1.0f;
+		spheres[i].material.emission = whiteColor;
+		spheres[i].material.bsdf = black;
+		struct instance instance = newSphereInstance(&spheres[i]);
+		instance.composite = newTransformTranslate((i % gridSize) * 50.0f, 30.0f, (i / gridSize) * 50.0f);
+		addInstanceToScene(w, instance);
+	}
+	struct lightList *lights = newLightList(w);
+	
+	// Right below light 5 + 5 * gridSize
+	const struct vector point = { 250.0f, 0.0f, 250.0f };
+	const struct vector normal = { 0.0f, 1.0f, 0.0f };
+	const struct hitRecord isect = { .instIndex = 5 + 5 * gridSize, .hitPoint = vecZero() };
+	const float cosMax = sqrtf(1.0f - 1.0f / (30.0f * 30.0f));
+	const float pick = lightPdf(lights, point, normal, &isect) * 2.0f * PI * (1.0f - cosMax);
+	test_assert(pick > 20.0f / (gridSize * gridSize));
+	
+	destroyLightList(lights);
+	lights_destroyWorld(w);
+	return true;
+}
+
+// A dim sky with one very bright texel. Sampling should find that texel most of the time,
+// and report the same pdf environmentMapPdf() gives for the direction.
+bool lights_environment_pdf(void) {
+	struct world *w = lights_newWorld();
+	struct texture *sky = newTexture(float_p, 64, 32, 3);
+	for (size_t y = 0; y < sky->height; ++y) {
+		for (size_t x = 0; x < sky->width; ++x) {
+			setPixel(sky, (struct color){ 0.1f, 0.1f, 0.1f, 1.0f }, x, y);
+		}
+	}
+	setPixel(sky, (struct color){ 5000.0f, 5000.0f, 5000.0f, 1.0f }, 40, 10);
+	w->background = newBackground(w, newImageTexture(w, sky, NO_BILINEAR), NULL, newConstantValue(w, 0.3f));
+	struct environmentMap *map = newEnvironmentMap(w->background);
+	test_assert(map);
+	
+	const int count = 1024;
+	int bright = 0;
+	for (int i = 0; i < count; ++i) {
+		float pdf = 0.0f;
+		const struct vector direction = sampleEnvironmentMap(map, (i + 0.5f) / count, lights_radicalInverse(i), &pdf);
+		test_assert(lights_closeTo(vecLength(direction), 1.0f));
+		test_assert(lights_closeTo(pdf, environmentMapPdf(map, direction)));
+		struct hitRecord record = { .incident = { .direction = direction }, .instIndex = -1 };
+		if (luminance(w->background->sample(w->background, NULL, &record).color) > 1000.0f) bright++;
+	}
+	test_assert(bright > count * 3 / 4);
+	
+	destroyEnvironmentMap(map);
+	destroyTexture(sky);
+	lights_destroyWorld(w);
+	return true;
+}
+
+// The pdf has to integrate to one over the sphere
+bool lights_environment_integral(void) {
+	struct world *w = lights_newWorld();
+	w->background = newBackground(w, newGradientTexture(w, blackColor, whiteColor), NULL, NULL);
+	struct environmentMap *map = newEnvironmentMap(w->background);
+	test_assert(map);
+	// Spherical Fibonacci points, uniform over the sphere
+	float integral = 0.0f;
+	const int points = 1 << 16;
+	for (int i = 0; i < points; ++i) {
+		const float z = 1.0f - (2.0f * i + 1.0f) / points;
+		const float r = sqrtf(max(0.0f, 1.0f - z * z));
+		const float phi = i * 2.39996323f;
+		integral += environmentMapPdf(map, (struct vector){ r * cosf(phi), z, r * sinf(phi) }) * 4.0f * PI / points;
+	}
+	test_assert(fabsf(integral - 1.0f) < 0.01f);
+	destroyEnvironmentMap(map);
+	lights_destroyWorld(w);
+	return true;
+}
+
+// The baked sky, looked up through the background shader, should agree with the analytic model
+bool lights_sky_lut(void) {
+	struct world *w = lights_newWorld();
+	struct texture *lut = newSkyTexture(1024, 512, NULL);
+	test_assert(lut);
+	w->background = newBackground(w, newImageTexture(w, lut, 0), NULL, NULL);
+	const int points = 4096;
+	for (int i = 0; i < points; ++i) {
+		// Stay clear of the horizon, where the model is discontinuous
+		const float y = 0.05f + 0.95f * (i + 0.5f) / points;
+		const float r = sqrtf(1.0f - y * y);
+		const float phi = i * 2.39996323f;
+		const struct vector direction = { r * cosf(phi), y, r * sinf(phi) };
+		const struct color expected = sky((struct lightRay){ .direction = direction });
+		struct hitRecord record = { .incident = { .direction = direction }, .instIndex = -1 };
+		const struct color baked = w->background->sample(w->background, NULL, &record).color;
+		test_assert(fabsf(luminance(baked) - luminance(expected)) <= 0.02f * luminance(expected) + 1e-4f);
+	}
+	
+	struct environmentMap *map = newEnvironmentMap(w->background);
+	test_assert(map);
+	destroyEnvironmentMap(map);
+	destroyTexture(lut);
+	lights_destroyWorld(w);
+	return true;
+}
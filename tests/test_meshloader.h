@@ -0,0 +1,362 @@
+//
+//  test_meshloader.h
+//  C-Ray
+//
+//  Created by Valtteri Koskivuori on 18/10/2026.
+//  Copyright © 2026 Valtteri Koskivuori. All rights reserved.
+//
+
+#include "../src/utils/loaders/meshloader.h"
+#include "../src/datatypes/mesh.h"
+#include "../src/datatypes/poly.h"
+#include "../src/utils/taskgraph.h"
+
+static bool meshloader_writeFile(const char *path, const char *contents) {
+	FILE *file = fopen(path, "wb");
+	if (!file) return false;
+	fputs(contents, file);
+	fclose(file);
+	return true;
+}
+
+bool meshloader_obj_groups(void) {
+	const char *path = "meshloader_obj_groups.obj";
+	test_assert(meshloader_writeFile(path,
+		"v 0 0 0\nv 1 0 0\nv 1 1 0\nv 0 1 0\nvt 0 0\nvn 0 0 1\n"
+		"f 1 2 3\n"
+		"o first\n"
+		"f 1 2 3 4\n"
+		"g empty\n"
+		"g second\n"
+		"v 2 2 2\n"
+		"f -5/1/1 -4/1/1 -1/1/1\n"));
+	size_t meshCount = 0;
+	struct mesh *meshes = loadMesh((char *)path, &meshCount, NULL, NULL, NULL);
+	test_assert(meshes);
+	// Faces before the first group get their own mesh, and empty groups are dropped
+	test_assert(meshCount == 3);
+	test_assert(stringEquals(meshes[0].name, path));
+	test_assert(stringEquals(meshes[1].name, "first"));
+	test_assert(stringEquals(meshes[2].name, "second"));
+	test_assert(meshes[0].polyCount == 1 && meshes[1].polyCount == 2 && meshes[2].polyCount == 1);
+
+	// Indices point at arrays shared by every mesh in the file, and relative ones count back from the latest element
+	const struct poly *p = &meshes[2].polygons[0];
+	test_assert(p->vertexIndex[0] == 0 && p->vertexIndex[2] == 4);
+	test_assert(meshes[2].vertices == meshes[0].vertices && meshes[2].vertexCount == 5);
+	test_assert(meshes[2].vertices[p->vertexIndex[2]].x == 2.0f);
+	test_assert(p->hasNormals && p->hasTexCoords && meshes[2].attributes[0].textureIndex[0] == 0);
+	test_assert(meshes[0].attributes[0].textureIndex[0] == -1 && !meshes[0].polygons[0].hasTexCoords && !meshes[0].polygons[0].hasNormals);
+
+	// One set of materials, freed with the first mesh
+	test_assert(meshes[1].materials == meshes[0].materials && meshes[2].materials == meshes[0].materials);
+	test_assert(!meshes[0].sharedMaterials && meshes[1].sharedMaterials && meshes[2].sharedMaterials);
+	test_assert(!meshes[0].sharedVertices && meshes[1].sharedVertices && meshes[2].sharedVertices);
+	for (size_t i = 0; i < meshCount; ++i) destroyMesh(&meshes[i]);
+	free(meshes);
+	remove(path);
+	return true;
+}
+
+static bool meshloader_checkQuad(const char *path) {
+	size_t meshCount = 0;
+	struct mesh *mesh = loadMesh((char *)path, &meshCount, NULL, NULL, NULL);
+	test_assert(mesh && meshCount == 1);
+	// One quad, split into two triangles sharing the first corner
+	test_assert(mesh->vertexCount == 4 && mesh->polyCount == 2);
+	test_assert(mesh->normalCount == 4 && mesh->textureCoordCount == 4);
+	const struct poly *p = &mesh->polygons[1];
+	test_assert(p->vertexIndex[0] == 0 && p->vertexIndex[1] == 2 && p->vertexIndex[2] == 3);
+	const struct polyAttributes *a = &mesh->attributes[1];
+	test_assert(p->hasNormals && a->normalIndex[2] == 3 && a->textureIndex[2] == 3);
+	test_assert(vecEquals(mesh->vertices[p->vertexIndex[1]], (struct vector){ 1.0f, 1.0f, 0.5f }));
+	test_assert(meshNormal(mesh, p, 2).z == 1.0f);
+	test_assert(meshTexCoord(mesh, p, 2).x == 0.0f && meshTexCoord(mesh, p, 2).y == 1.0f);
+	destroyMesh(mesh);
+	free(mesh);
+	return true;
+}
+
+bool meshloader_ply(void) {
+	const char *path = "meshloader_ply.ply";
+	const char *header =
+		"ply\n"
+		"format %s 1.0\n"
+		"comment an unused element before the vertices\n"
+		"element material 1\n"
+		"property list uchar float name\n"
+		"element vertex 4\n"
+		"property float x\nproperty float y\nproperty float z\n"
+		"property uchar red\n"
+		"property float nx\nproperty float ny\nproperty float nz\n"
+		"property float s\nproperty float t\n"
+		"element face 1\n"
+		"property list uchar int vertex_indices\n"
+		"end_header\n";
+	const float vertices[4][5] = { { 0, 0, 0, 0, 0 }, { 1, 0, 0, 1, 0 }, { 1, 1, 0.5f, 1, 1 }, { 0, 1, 0, 0, 1 } };
+
+	char text[1024];
+	int length = snprintf(text, sizeof(text), header, "ascii");
+	length += snprintf(text + length, sizeof(text) - length, "2 0.5 1\n");
+	for (int i = 0; i < 4; ++i) {
+		length += snprintf(text + length, sizeof(text) - length, "%g %g %g 255 0 0 1 %g %g\n", vertices[i][0], vertices[i][1], vertices[i][2], vertices[i][3], vertices[i][4]);
+	}
+	snprintf(text + length, sizeof(text) - length, "4 0 1 2 3\n");
+	test_assert(meshloader_writeFile(path, text));
+	test_assert(meshloader_checkQuad(path));
+
+	// Both byte orders, written out by hand
+	for (int bigEndian = 0; bigEndian < 2; ++bigEndian) {
+		unsigned char data[1024];
+		size_t size = (size_t)snprintf((char *)data, sizeof(data), header, bigEndian ? "binary_big_endian" : "binary_little_endian");
+		#define PUT(value) do { unsigned char bytes[sizeof(value)]; memcpy(bytes, &(value), sizeof(value)); \
+			for (size_t b = 0; b < sizeof(value); ++b) data[size++] = bytes[bigEndian ? sizeof(value) - 1 - b : b]; } while (0)
+		const unsigned char two = 2, full = 255, four = 4;
+		const float half = 0.5f, one = 1.0f, zero = 0.0f;
+		PUT(two); PUT(half); PUT(one);
+		for (int i = 0; i < 4; ++i) {
+			PUT(vertices[i][0]); PUT(vertices[i][1]); PUT(vertices[i][2]);
+			PUT(full);
+			PUT(zero); PUT(zero); PUT(one);
+			PUT(vertices[i][3]); PUT(vertices[i][4]);
+		}
+		PUT(four);
+		for (int32_t i = 0; i < 4; ++i) PUT(i);
+		#undef PUT
+		FILE *file = fopen(path, "wb");
+		test_assert(file);
+		fwrite(data, 1, size, file);
+		fclose(file);
+		test_assert(meshloader_checkQuad(path));
+	}
+
+	// Faces pointing past the vertices are rejected
+	test_assert(meshloader_writeFile(path, "ply\nformat ascii 1.0\nelement vertex 1\nproperty float x\nproperty float y\nproperty float z\nelement face 1\nproperty list uchar int vertex_indices\nend_header\n0 0 0\n3 0 0 1\n"));
+	size_t meshCount = 0;
+	test_assert(!loadMesh((char *)path, &meshCount, NULL, NULL, NULL));
+	remove(path);
+	return true;
+}
+
+static bool meshloader_writeGlb(const char *path, const char *json, const unsigned char *bin, uint32_t binLength) {
+	const uint32_t jsonLength = (uint32_t)((strlen(json) + 3) & ~3u);
+	const uint32_t header[3] = { 0x46546C67, 2, 12 + 8 + jsonLength + 8 + binLength };
+	const uint32_t jsonChunk[2] = { jsonLength, 0x4E4F534A };
+	const uint32_t binChunk[2] = { binLength, 0x004E4942 };
+	FILE *file = fopen(path, "wb");
+	if (!file) return false;
+	fwrite(header, 1, sizeof(header), file);
+	fwrite(jsonChunk, 1, sizeof(jsonChunk), file);
+	fwrite(json, 1, strlen(json), file);
+	// JSON chunks are padded with spaces
+	for (size_t i = strlen(json); i < jsonLength; ++i) fputc(' ', file);
+	fwrite(binChunk, 1, sizeof(binChunk), file);
+	fwrite(bin, 1, binLength, file);
+	fclose(file);
+	return true;
+}
+
+bool meshloader_gltf(void) {
+	const char *path = "meshloader_gltf.glb";
+	// The same quad, as two indexed triangles with a material, placed by a child node
+	const char *json =
+		"{\"asset\":{\"version\":\"2.0\"},\"scene\":0,\"scenes\":[{\"nodes\":[0]}],"
+		"\"nodes\":[{\"translation\":[1,2,3],\"children\":[1]},{\"mesh\":0,\"scale\":[2,2,2]}],"
+		"\"meshes\":[{\"name\":\"quad\",\"primitives\":[{\"attributes\":{\"POSITION\":0,\"NORMAL\":1,\"TEXCOORD_0\":2},\"indices\":3,\"material\":0}]}],"
+		"\"materials\":[{\"name\":\"shiny\",\"pbrMetallicRoughness\":{\"baseColorFactor\":[0.5,0.25,1,1],\"roughnessFactor\":0.125},\"emissiveFactor\":[1,0,0]}],"
+		"\"accessors\":["
+		"{\"bufferView\":0,\"componentType\":5126,\"count\":4,\"type\":\"VEC3\"},"
+		"{\"bufferView\":0,\"byteOffset\":48,\"componentType\":5126,\"count\":4,\"type\":\"VEC3\"},"
+		"{\"bufferView\":0,\"byteOffset\":96,\"componentType\":5126,\"count\":4,\"type\":\"VEC2\"},"
+		"{\"bufferView\":1,\"componentType\":5123,\"count\":6,\"type\":\"SCALAR\"}],"
+		"\"bufferViews\":[{\"buffer\":0,\"byteLength\":128},{\"buffer\":0,\"byteOffset\":128,\"byteLength\":12}],"
+		"\"buffers\":[{\"byteLength\":140}]}";
+	const float positions[4][3] = { { 0, 0, 0 }, { 1, 0, 0 }, { 1, 1, 0.5f }, { 0, 1, 0 } };
+	const float normals[4][3] = { { 0, 0, 1 }, { 0, 0, 1 }, { 0, 0, 1 }, { 0, 0, 1 } };
+	// Flipped vertically on load
+	const float coords[4][2] = { { 0, 1 }, { 1, 1 }, { 1, 0 }, { 0, 0 } };
+	const uint16_t indices[6] = { 0, 1, 2, 0, 2, 3 };
+
+	unsigned char bin[140];
+	memcpy(bin, positions, 48);
+	memcpy(bin + 48, normals, 48);
+	memcpy(bin + 96, coords, 32);
+	memcpy(bin + 128, indices, 12);
+	test_assert(meshloader_writeGlb(path, json, bin, sizeof(bin)));
+	test_assert(meshloader_checkQuad(path));
+
+	size_t meshCount = 0;
+	struct meshPlacement *placements = NULL;
+	size_t placementCount = 0;
+	struct mesh *mesh = loadMesh((char *)path, &meshCount, &placements, &placementCount, NULL);
+	test_assert(mesh && meshCount == 1 && stringEquals(mesh->name, "quad"));
+
+	// Parent transforms apply after the child's own
+	test_assert(placements && placementCount == 1 && placements[0].mesh == 0);
+	struct vector corner = { 1.0f, 1.0f, 1.0f };
+	transformPoint(&corner, &placements[0].transform.A);
+	test_assert(vecEquals(corner, (struct vector){ 3.0f, 4.0f, 5.0f }));
+
+	// Plus one default material for primitives without one
+	test_assert(mesh->materialCount == 2 && mesh->polygons[0].materialIndex == 0);
+	const struct material *m = &mesh->materials[0];
+	test_assert(stringEquals(m->name, "shiny"));
+	test_assert(m->diffuse.red == 0.5f && m->diffuse.green == 0.25f && m->diffuse.blue == 1.0f);
+	test_assert(m->roughness == 0.125f && m->illum == 5 && m->emission.red == 1.0f);
+
+	free(placements);
+	destroyMesh(mesh);
+	free(mesh);
+
+	// An index past the last vertex rejects the whole file
+	const uint16_t outOfRange = 4;
+	memcpy(bin + 128 + 2, &outOfRange, sizeof(outOfRange));
+	test_assert(meshloader_writeGlb(path, json, bin, sizeof(bin)));
+	test_assert(!loadMesh((char *)path, &meshCount, NULL, NULL, NULL));
+	remove(path);
+	return true;
+}
+
+bool meshloader_compact_attributes(void) {
+	const char *path = "meshloader_compact_attributes.obj";
+	// Every corner uses the same index for its position, normal and texture coordinate
+	test_assert(meshloader_writeFile(path,
+		"v 0 0 0\nv 1 0 0\nv 1 1 0\nv 0 1 0\n"
+		"vt 0 0\nvt 0.1 0\nvt 0.3 0.7\nvt 0 1\n"
+		"vn 0 0 1\nvn 0 0.6 0.8\nvn -1 0 0\nvn 0.48 -0.6 0.64\n"
+		"f 1/1/1 2/2/2 3/3/3 4/4/4\n"));
+	size_t meshCount = 0;
+	struct mesh *mesh = loadMesh((char *)path, &meshCount, NULL, NULL, NULL);
+	test_assert(mesh && meshCount == 1 && mesh->attributes);
+	struct vector normals[2][3];
+	struct coord texCoords[2][3];
+	for (int i = 0; i < 2; ++i) {
+		for (int c = 0; c < 3; ++c) {
+			normals[i][c] = meshNormal(mesh, &mesh->polygons[i], c);
+			texCoords[i][c] = meshTexCoord(mesh, &mesh->polygons[i], c);
+		}
+	}
+	size_t uncompact = 0;
+	const size_t before = meshBytes(mesh, &uncompact);
+	test_assert(before == uncompact);
+
+	compactMeshes(mesh, 1);
+	test_assert(!mesh->attributes && mesh->packedNormals && mesh->packedTexCoords);
+	const size_t after = meshBytes(mesh, &uncompact);
+	test_assert(after < before && uncompact == before);
+	// Decoded at about half and 16 bit precision
+	for (int i = 0; i < 2; ++i) {
+		for (int c = 0; c < 3; ++c) {
+			const struct vector n = meshNormal(mesh, &mesh->polygons[i], c);
+			const struct coord t = meshTexCoord(mesh, &mesh->polygons[i], c);
+			test_assert(vecLength(vecSub(n, normals[i][c])) < 1e-3f);
+			test_assert(fabsf(t.x - texCoords[i][c].x) < 1e-3f && fabsf(t.y - texCoords[i][c].y) < 1e-3f);
+		}
+	}
+	destroyMesh(mesh);
+	free(mesh);
+
+	// Indices that differ are kept, only the arrays they point to are packed
+	test_assert(meshloader_writeFile(path, "v 0 0 0\nv 1 0 0\nv 1 1 0\nvt 0.5 0.5\nvn 0 1 0\nf 1/1/1 2/1/1 3/1/1\n"));
+	mesh = loadMesh((char *)path, &meshCount, NULL, NULL, NULL);
+	test_assert(mesh && meshCount == 1);
+	compactMeshes(mesh, 1);
+	test_assert(mesh->attributes && mesh->packedNormals && mesh->packedTexCoords);
+	test_assert(meshNormal(mesh, &mesh->polygons[0], 2).y > 0.999f);
+	test_assert(meshTexCoord(mesh, &mesh->polygons[0], 1).x == 0.5f);
+	destroyMesh(mesh);
+	free(mesh);
+	remove(path);
+	return true;
+}
+
+struct meshloader_parsed {
+	const char *path;
+	struct mesh *meshes;
+	size_t meshCount;
+};
+
+static void meshloader_parseTask(struct taskGraph *graph, void *arg) {
+	struct meshloader_parsed *parsed = arg;
+	parsed->meshes = loadMesh((char *)parsed->path, &parsed->meshCount, NULL, NULL, graph);
+}
+
+static size_t meshloader_appendQuad(char *buffer, size_t size, int i, const char *faces) {
+	size += sprintf(buffer + size, "v %i 0 0\nv %i 1 0\nv %i 1 1\nv %i 0 1\nvt 0.25 0.75\nvn 0 0 1\n", i, i, i, i);
+	return size + sprintf(buffer + size, "%s", faces);
+}
+
+bool meshloader_obj_chunks(void) {
+	// Big enough to be split into chunks, which parse on the threads of the graph it's loaded on.
+	// Two threads split it in two, at the first line that ends at or past the middle of the file.
+	const char *path = "meshloader_obj_chunks.obj";
+	const int quads = 40000;
+	char *first = malloc(quads * 128);
+	char *second = malloc(quads * 128);
+	test_assert(first && second);
+	size_t firstSize = 0, secondSize = 0;
+	for (int i = 0; i < quads / 2; ++i) {
+		char face[64];
+		snprintf(face, sizeof(face), "f %i/%i/%i %i/%i/%i %i/%i/%i\n", 4 * i + 1, i + 1, i + 1, 4 * i + 2, i + 1, i + 1, 4 * i + 3, i + 1, i + 1);
+		if (i == quads / 4) firstSize += sprintf(first + firstSize, "o second\n");
+		firstSize = meshloader_appendQuad(first, firstSize, i, face);
+	}
+	// The second half starts with a face counting back into the first one. The rest count back too,
+	// the second face of each quad into the quad before it.
+	secondSize += sprintf(second, "f -4/-1/-1 -3/-1/-1 -2/-1/-1\n");
+	for (int i = quads / 2; i < quads; ++i) {
+		secondSize = meshloader_appendQuad(second, secondSize, i, "f -4/-1/-1 -3/-1/-1 -2/-1/-1\nf -8/-2/-2 -7/-2/-2 -1/-1/-1\n");
+	}
+	// Pad the first half with comments, so the line ending at the middle of the file is its last one
+	test_assert(secondSize >= firstSize);
+	size_t padding = secondSize + 2 - firstSize;
+	while (padding) {
+		const size_t length = padding > 80 ? 64 : padding;
+		firstSize += sprintf(first + firstSize, "#%*s\n", (int)length - 2, "");
+		padding -= length;
+	}
+	test_assert(firstSize == secondSize + 2);
+	FILE *file = fopen(path, "wb");
+	test_assert(file);
+	fwrite(first, 1, firstSize, file);
+	fwrite(second, 1, secondSize, file);
+	fclose(file);
+	free(first);
+	free(second);
+
+	size_t meshCount = 0;
+	struct mesh *whole = loadMesh((char *)path, &meshCount, NULL, NULL, NULL);
+	struct meshloader_parsed parsed = { .path = path };
+	struct taskGraph *graph = newTaskGraph();
+	addTask(graph, meshloader_parseTask, &parsed);
+	runTaskGraph(graph, 2);
+	destroyTaskGraph(graph);
+	remove(path);
+
+	test_assert(whole && meshCount == 2);
+	test_assert(parsed.meshes && parsed.meshCount == meshCount);
+	for (size_t m = 0; m < meshCount; ++m) {
+		const struct mesh *a = &whole[m], *b = &parsed.meshes[m];
+		test_assert(a->polyCount == b->polyCount && a->vertexCount == b->vertexCount && a->vertexCount == 4 * quads);
+		test_assert(stringEquals(a->name, b->name));
+		test_assert(!memcmp(a->polygons, b->polygons, a->polyCount * sizeof(*a->polygons)));
+		test_assert(!memcmp(a->attributes, b->attributes, a->polyCount * sizeof(*a->attributes)));
+		test_assert(!memcmp(a->vertices, b->vertices, a->vertexCount * sizeof(*a->vertices)));
+	}
+	test_assert(whole[0].polyCount + whole[1].polyCount == quads / 2 + 1 + quads);
+	// The face right after the split counts back into the last quad of the first half
+	const struct poly *boundary = &whole[1].polygons[quads / 4];
+	test_assert(boundary->vertexIndex[0] == 2 * quads - 4 && boundary->vertexIndex[2] == 2 * quads - 2);
+	test_assert(whole[1].attributes[quads / 4].textureIndex[0] == quads / 2 - 1 && whole[1].attributes[quads / 4].normalIndex[1] == quads / 2 - 1);
+	// The last face reaches back into the quad before its own
+	const int last = whole[1].polyCount - 1;
+	test_assert(whole[1].polygons[last].vertexIndex[0] == 4 * quads - 8 && whole[1].polygons[last].vertexIndex[2] == 4 * quads - 1);
+	test_assert(whole[1].attributes[last].textureIndex[0] == quads - 2 && whole[1].attributes[last].normalIndex[2] == quads - 1);
+	for (size_t m = 0; m < meshCount; ++m) {
+		destroyMesh(&whole[m]);
+		destroyMesh(&parsed.meshes[m]);
+	}
+	free(whole);
+	free(parsed.meshes);
+	return true;
+}
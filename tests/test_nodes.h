@@ -0,0 +1,129 @@
+//
+//  test_nodes.h
+//  C-Ray
+//
+//  Created by Valtteri Koskivuori on 18/10/2026.
+//  Copyright © 2026 Valtteri Koskivuori. All rights reserved.
+//
+
+#include "../src/nodes/bsdfnode.h"
+#include "../src/nodes/compiler.h"
+#include "../src/datatypes/scene.h"
+#include "../src/datatypes/hitrecord.h"
+#include "../src/utils/mempool.h"
+#include "../src/utils/hashtable.h"
+
+static struct world *nodes_newWorld(void) {
+	struct world *w = calloc(1, sizeof(*w));
+	w->nodePool = newBlock(NULL, 1024);
+	w->nodeTable = newHashtable(compareNodes, &w->nodePool);
+	return w;
+}
+
+static void nodes_destroyWorld(struct world *w) {
+	destroyHashtable(w->nodeTable);
+	destroyBlocks(w->nodePool);
+	free(w);
+}
+
+// Varied hits, with both uv-mapped and unmapped ones for the checkerboard
+static struct hitRecord nodes_hit(int i) {
+	const float t = i * 0.618034f;
+	return (struct hitRecord){
+		.incident = { .direction = vecNormalize((struct vector){ sinf(t), -1.0f, cosf(3.0f * t) }) },
+		.hitPoint = { 3.0f * sinf(2.0f * t), t, cosf(t) },
+		.surfaceNormal = vecNormalize((struct vector){ cosf(t), 1.0f, sinf(5.0f * t) }),
+		.uv = { i % 3 ? t - floorf(t) : -1.0f, fmodf(t * 7.0f, 1.0f) },
+		.distance = 0.1f + t,
+		.instIndex = 0
+	};
+}
+
+bool nodes_constant_folding(void) {
+	struct world *w = nodes_newWorld();
+	const struct valueNode *sum = newMath(w, newConstantValue(w, 1.0f), newMath(w, newConstantValue(w, 4.0f), NULL, SquareRoot), Add);
+	float value = 0.0f;
+	test_assert(!getConstantValue(sum, &value));
+	test_assert(getConstantValue(compileValue(w, sum), &value));
+	test_assert(value == 3.0f);
+
+	// Folded colors end up as the same hash consed constant node
+	const struct colorNode *kelvin = newBlackbody(w, newConstantValue(w, 6500.0f));
+	test_assert(compileColor(w, kelvin) == newConstantTexture(w, colorForKelvin(6500.0f)));
+
+	// Anything that reads the hit can't be folded
+	const struct valueNode *distance = newMath(w, newRayLength(w), newConstantValue(w, 2.0f), Multiply);
+	test_assert(!getConstantValue(compileValue(w, distance), &value));
+	nodes_destroyWorld(w);
+	return true;
+}
+
+bool nodes_program_matches_graph(void) {
+	struct world *w = nodes_newWorld();
+	const struct valueNode *distance = newRayLength(w);
+	const struct valueNode *scaled = newMath(w, distance, newMath(w, newConstantValue(w, 2.0f), newConstantValue(w, 3.0f), Power), Multiply);
+	const struct colorNode *checker = newCheckerBoardTexture(w, newBlackbody(w, newConstantValue(w, 3000.0f)), newCombineValue(w, scaled), newConstantValue(w, 4.0f));
+	const struct vectorNode *normal = newVecMath(w, newNormal(w), newConstantVector(w, (struct vector){ 0.0f, 1.0f, 0.0f }), VecAverage);
+	const struct colorNode *graph = newCombineRGB(w,
+		newMath(w, scaled, newGrayscaleConverter(w, checker), Max),
+		newGrayscaleConverter(w, newVecToColor(w, normal)),
+		newMath(w, newFresnel(w, newConstantValue(w, 1.5f), NULL), newAlpha(w, checker), Add));
+	const struct colorNode *compiled = compileColor(w, graph);
+	test_assert(compiled != graph);
+
+	for (int i = 0; i < 1000; ++i) {
+		const struct hitRecord record = nodes_hit(i);
+		const struct color expected = graph->eval(graph, &record);
+		const struct color actual = compiled->eval(compiled, &record);
+		test_assert(colorEquals(expected, actual));
+	}
+	nodes_destroyWorld(w);
+	return true;
+}
+
+static int nodes_evalCount = 0;
+
+static struct color nodes_countingEval(const struct colorNode *node, const struct hitRecord *record) {
+	(void)node;
+	nodes_evalCount++;
+	return (struct color){ record->uv.y, 0.5f, 0.25f, 1.0f };
+}
+
+// Like the interpreted checkerboard, the compiled one only evaluates the side it picks
+bool nodes_checker_evaluates_one_side(void) {
+	struct world *w = nodes_newWorld();
+	const struct colorNode A = { .eval = nodes_countingEval };
+	const struct colorNode B = { .eval = nodes_countingEval };
+	const struct colorNode *checker = newCheckerBoardTexture(w, &A, &B, newMath(w, newConstantValue(w, 2.0f), newConstantValue(w, 3.0f), Multiply));
+	const struct valueNode *graph = newMath(w, newGrayscaleConverter(w, checker), newRayLength(w), Add);
+	const struct valueNode *compiled = compileValue(w, graph);
+	test_assert(compiled != graph);
+
+	for (int i = 0; i < 100; ++i) {
+		const struct hitRecord record = nodes_hit(i);
+		const float expected = graph->eval(graph, &record);
+		nodes_evalCount = 0;
+		const float actual = compiled->eval(compiled, &record);
+		test_assert(nodes_evalCount == 1);
+		test_assert(expected == actual);
+	}
+	nodes_destroyWorld(w);
+	return true;
+}
+
+// appendAlpha() on an opaque color gives a mix that always picks the base bsdf
+bool nodes_opaque_alpha_prunes_mix(void) {
+	struct world *w = nodes_newWorld();
+	const struct colorNode *color = newConstantTexture(w, (struct color){ 0.8f, 0.5f, 0.2f, 1.0f });
+	const struct bsdfNode *diffuse = newDiffuse(w, color);
+	const struct bsdfNode *mix = newMix(w, newTransparent(w, newConstantTexture(w, whiteColor)), diffuse, newAlpha(w, color));
+	test_assert(mix != diffuse);
+	test_assert(compileBsdf(w, mix) == diffuse);
+
+	// But a partial alpha has to stay a mix
+	const struct colorNode *translucent = newConstantTexture(w, (struct color){ 0.8f, 0.5f, 0.2f, 0.5f });
+	const struct bsdfNode *blend = newMix(w, newTransparent(w, newConstantTexture(w, whiteColor)), newDiffuse(w, translucent), newAlpha(w, translucent));
+	test_assert(compileBsdf(w, blend) != newDiffuse(w, translucent));
+	nodes_destroyWorld(w);
+	return true;
+}
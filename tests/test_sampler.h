@@ -0,0 +1,105 @@
+//
+//  test_sampler.h
+//  C-Ray
+//
+//  Created by Valtteri Koskivuori on 18/10/2026.
+//  Copyright © 2026 Valtteri Koskivuori. All rights reserved.
+//
+
+#include <limits.h>
+#include "../src/renderer/samplers/sampler.h"
+
+bool sampler_sobol_range(void) {
+	sampler *s = newSampler();
+	for (int pass = 0; pass < 64; ++pass) {
+		initSampler(s, Sobol, pass, 64, 1234);
+		for (int dim = 0; dim < 256; ++dim) {
+			float v = getDimension(s);
+			test_assert(v >= 0.0f);
+			test_assert(v < 1.0f);
+		}
+	}
+	destroySampler(s);
+	return true;
+}
+
+// The first 2^m samples of any dimension land in distinct 1/2^m strata,
+// and the first two dimensions of every padded group form a (0,2)-net.
+bool sampler_sobol_stratified(void) {
+	sampler *s = newSampler();
+	const int count = 16;
+	for (int group = 0; group < 4; ++group) {
+		bool strata1D[16] = { 0 };
+		bool strata2D[4][4] = { 0 };
+		for (int pass = 0; pass < count; ++pass) {
+			initSampler(s, Sobol, pass, count, 42);
+			for (int skip = 0; skip < group * 16; ++skip) getDimension(s);
+			float u = getDimension(s);
+			float v = getDimension(s);
+			int cell = (int)(u * count);
+			test_assert(!strata1D[cell]);
+			strata1D[cell] = true;
+			int x = (int)(u * 4);
+			int y = (int)(v * 4);
+			test_assert(!strata2D[x][y]);
+			strata2D[x][y] = true;
+		}
+	}
+	destroySampler(s);
+	return true;
+}
+
+bool sampler_sobol_decorrelated(void) {
+	sampler *a = newSampler();
+	sampler *b = newSampler();
+	initSampler(a, Sobol, 0, 1, 1);
+	initSampler(b, Sobol, 0, 1, 2);
+	int same = 0;
+	for (int dim = 0; dim < 64; ++dim) {
+		if (getDimension(a) == getDimension(b)) same++;
+	}
+	test_assert(same < 4);
+	destroySampler(a);
+	destroySampler(b);
+	return true;
+}
+
+// The inlined PCG step has to produce the same sequence as the library, so renders stay reproducible
+bool sampler_random_matches_pcg(void) {
+	sampler s = {0};
+	initSampler(&s, Random, 5, 16, 777);
+	pcg32_random_t rng;
+	pcg32_srandom_r(&rng, hash64((777ull << 32) | 5), 0);
+	for (int dim = 0; dim < 64; ++dim) {
+		test_assert(getDimension(&s) == (1.0f / (1ull << 32)) * pcg32_random_r(&rng));
+	}
+	return true;
+}
+
+// Time-limited renders have no pass count, and neighbouring pixels must not repeat each other's sequences a few passes later
+bool sampler_random_unbounded_passes(void) {
+	for (uint32_t pixel = 0; pixel < 64; ++pixel) {
+		for (int pass = 0; pass < 8; ++pass) {
+			sampler a = {0};
+			sampler b = {0};
+			initSampler(&a, Random, pass, INT_MAX, pixel);
+			initSampler(&b, Random, pass + 2, INT_MAX, pixel + 2);
+			test_assert(getDimension(&a) != getDimension(&b));
+		}
+	}
+	return true;
+}
+
+bool sampler_specialized_matches_dynamic(void) {
+	const enum samplerType types[] = { Halton, Hammersley, Random, Sobol };
+	for (int t = 0; t < 4; ++t) {
+		sampler a = {0};
+		sampler b = {0};
+		initSampler(&a, types[t], 3, 16, 99);
+		initSampler(&b, types[t], 3, 16, 99);
+		for (int dim = 0; dim < 40; ++dim) {
+			test_assert(getDimension(&a) == getDimensionOf(&b, types[t]));
+		}
+	}
+	return true;
+}
@@ -105,3 +105,17 @@ bool string_startsWith(void) {
 	
 	return true;
 }
+
+bool string_endsWith(void) {
+	
+	char *string = "mesh.ply";
+	
+	test_assert(stringEndsWith(".ply", string));
+	test_assert(stringEndsWith("mesh.ply", string));
+	test_assert(stringEndsWith("", string));
+	
+	test_assert(!stringEndsWith(".obj", string));
+	test_assert(!stringEndsWith("a mesh.ply", string));
+	
+	return true;
+}
@@ -0,0 +1,77 @@
+//
+//  test_taskgraph.h
+//  C-Ray
+//
+//  Created by Valtteri Koskivuori on 18/10/2026.
+//  Copyright © 2026 Valtteri Koskivuori. All rights reserved.
+//
+
+#include "../src/utils/taskgraph.h"
+
+struct taskgraph_node {
+	struct taskgraph_node *children;
+	size_t childCount;
+	bool done;
+	bool childrenDoneFirst; // Should stay false, children can only be queued once their parent is done
+};
+
+static void taskgraph_visit(struct taskGraph *graph, void *arg) {
+	struct taskgraph_node *node = arg;
+	for (size_t i = 0; i < node->childCount; ++i) {
+		if (node->children[i].done) node->childrenDoneFirst = true;
+	}
+	node->done = true;
+	for (size_t i = 0; i < node->childCount; ++i) addTask(graph, taskgraph_visit, &node->children[i]);
+}
+
+static bool taskgraph_run(int threadCount) {
+	struct taskgraph_node roots[8] = { 0 };
+	struct taskgraph_node children[8][16] = { 0 };
+	struct taskGraph *graph = newTaskGraph();
+	for (size_t i = 0; i < 8; ++i) {
+		roots[i].children = children[i];
+		roots[i].childCount = 16;
+		addTask(graph, taskgraph_visit, &roots[i]);
+	}
+	runTaskGraph(graph, threadCount);
+	destroyTaskGraph(graph);
+	// Including every task added by one that ran
+	for (size_t i = 0; i < 8; ++i) {
+		test_assert(roots[i].done && !roots[i].childrenDoneFirst);
+		for (size_t j = 0; j < 16; ++j) test_assert(children[i][j].done);
+	}
+	return true;
+}
+
+bool taskgraph_runs_added_tasks(void) {
+	test_assert(taskgraph_run(1));
+	test_assert(taskgraph_run(4));
+	return true;
+}
+
+static void taskgraph_increment(void *element) {
+	(*(int *)element)++;
+}
+
+// Each of these splits its work up over the graph, while others do the same
+static void taskgraph_split(struct taskGraph *graph, void *arg) {
+	runParallel(graph, taskgraph_increment, arg, sizeof(int), 100);
+}
+
+bool taskgraph_run_parallel(void) {
+	for (int threadCount = 1; threadCount <= 4; threadCount += 3) {
+		int counts[6][100] = { 0 };
+		struct taskGraph *graph = newTaskGraph();
+		for (size_t i = 0; i < 6; ++i) addTask(graph, taskgraph_split, counts[i]);
+		runTaskGraph(graph, threadCount);
+		destroyTaskGraph(graph);
+		for (size_t i = 0; i < 6; ++i) {
+			for (size_t j = 0; j < 100; ++j) test_assert(counts[i][j] == 1);
+		}
+	}
+	// Without a graph, on the calling thread
+	int counts[100] = { 0 };
+	runParallel(NULL, taskgraph_increment, counts, sizeof(int), 100);
+	for (size_t i = 0; i < 100; ++i) test_assert(counts[i] == 1);
+	return true;
+}
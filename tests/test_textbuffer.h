@@ -28,6 +28,17 @@ bool textbuffer_new(void) {
 	return true;
 }
 
+bool textbuffer_with_length(void) {
+	// Only the first two lines, the rest isn't part of the text
+	textBuffer *buffer = newTextBufferWithLength(MULTILINE, 20);
+	test_assert(buffer->amountOf.lines == 2);
+	test_assert(buffer->buflen == 20);
+	test_assert(stringEquals(firstLine(buffer), "This is a"));
+	test_assert(stringEquals(nextLine(buffer), "Multiline"));
+	freeTextBuffer(buffer);
+	return true;
+}
+
 bool textbuffer_gotoline(void) {
 	char *string = MULTILINE;
 	textBuffer *original = newTextBuffer(string);
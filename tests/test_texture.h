@@ -0,0 +1,273 @@
+//
+//  test_texture.h
+//  C-Ray
+//
+//  Created by Valtteri Koskivuori on 18/10/2026.
+//  Copyright © 2026 Valtteri Koskivuori. All rights reserved.
+//
+
+#include "../src/datatypes/image/texture.h"
+#include "../src/datatypes/image/texturecache.h"
+#include "../src/utils/loaders/textureloader.h"
+
+static bool texture_closeTo(float a, float b) {
+	return fabsf(a - b) <= 1e-5f;
+}
+
+static bool texture_colorsClose(struct color a, struct color b) {
+	return texture_closeTo(a.red, b.red) && texture_closeTo(a.green, b.green) && texture_closeTo(a.blue, b.blue) && texture_closeTo(a.alpha, b.alpha);
+}
+
+// Red ramp along x, green along y
+static struct texture *texture_newRamp(size_t width, size_t height) {
+	struct texture *t = newTexture(float_p, width, height, 3);
+	for (size_t y = 0; y < height; ++y) {
+		for (size_t x = 0; x < width; ++x) {
+			setPixel(t, (struct color){ (float)x / width, (float)y / height, 0.5f, 1.0f }, x, y);
+		}
+	}
+	return t;
+}
+
+bool texture_mipmap_chain(void) {
+	struct texture *t = texture_newRamp(8, 4);
+	generateMipmaps(t, NULL);
+	test_assert(t->mipCount == 3);
+	test_assert(t->mips[0].width == 4 && t->mips[0].height == 2);
+	test_assert(t->mips[1].width == 2 && t->mips[1].height == 1);
+	test_assert(t->mips[2].width == 1 && t->mips[2].height == 1);
+
+	// The last level is the average of the whole texture
+	const struct color average = textureGetPixel(&t->mips[2], 0, 0, false);
+	test_assert(texture_closeTo(average.red, 3.5f / 8.0f));
+	test_assert(texture_closeTo(average.green, 1.5f / 4.0f));
+	test_assert(texture_closeTo(average.blue, 0.5f));
+	destroyTexture(t);
+
+	// Byte textures round instead of drifting darker every level
+	struct texture *bytes = newTexture(char_p, 2, 2, 3);
+	setPixel(bytes, (struct color){ 1.0f, 1.0f, 1.0f, 1.0f }, 0, 0);
+	setPixel(bytes, (struct color){ 1.0f, 1.0f, 1.0f, 1.0f }, 1, 0);
+	setPixel(bytes, (struct color){ 1.0f, 1.0f, 1.0f, 1.0f }, 0, 1);
+	setPixel(bytes, (struct color){ 0.0f, 0.0f, 0.0f, 1.0f }, 1, 1);
+	generateMipmaps(bytes, NULL);
+	test_assert(bytes->mipCount == 1);
+	test_assert(bytes->mips[0].data.byte_p[0] == 191);
+	destroyTexture(bytes);
+	return true;
+}
+
+bool texture_lod_selection(void) {
+	struct texture *t = texture_newRamp(16, 16);
+	generateMipmaps(t, NULL);
+	const float u = 0.3f;
+	const float v = 0.6f;
+
+	// No footprint is a plain bilinear lookup
+	test_assert(colorEquals(textureGetPixelLod(t, u, v, 0.0f), textureGetPixel(t, u, v, true)));
+	// A footprint of one texel at level 1 only reads from that level
+	test_assert(colorEquals(textureGetPixelLod(t, u, v, 2.0f / 16.0f), textureGetPixel(&t->mips[0], u, v, true)));
+	// Inbetween, the two closest levels are blended
+	const struct color blended = textureGetPixelLod(t, u, v, sqrtf(2.0f) * 2.0f / 16.0f);
+	const struct color expected = lerp(textureGetPixel(&t->mips[0], u, v, true), textureGetPixel(&t->mips[1], u, v, true), 0.5f);
+	test_assert(texture_closeTo(blended.red, expected.red));
+	test_assert(texture_closeTo(blended.green, expected.green));
+	// Anything wider than the texture is the average
+	test_assert(colorEquals(textureGetPixelLod(t, u, v, 100.0f), textureGetPixel(&t->mips[t->mipCount - 1], u, v, true)));
+	destroyTexture(t);
+	return true;
+}
+
+bool texture_srgb_decode(void) {
+	// sRGB bytes are decoded on lookup
+	struct texture *t = newTexture(char_p, 2, 2, 3);
+	t->colorspace = sRGB;
+	textureSelectFetch(t);
+	t->data.byte_p[0] = 128;
+	test_assert(texture_closeTo(textureGetPixel(t, 0, 1, false).red, SRGBToLinear(128 / 255.0f)));
+	test_assert(textureGetPixel(t, 1, 1, false).red == 0.0f);
+
+	// A black and white checker averages to half the light, not to half the code value
+	for (size_t i = 0; i < 12; ++i) t->data.byte_p[i] = (i / 3) % 3 ? 0 : 255;
+	generateMipmaps(t, NULL);
+	const float average = textureGetPixel(&t->mips[0], 0, 0, false).red;
+	test_assert(fabsf(average - 0.5f) < 0.005f);
+	destroyTexture(t);
+
+	// Float textures convert in place, and back
+	struct texture *f = newTexture(float_p, 1, 1, 4);
+	setPixel(f, (struct color){ 0.5f, 0.02f, 1.0f, 0.5f }, 0, 0);
+	f->colorspace = sRGB;
+	textureFromSRGB(f);
+	const struct color decoded = textureGetPixel(f, 0, 0, false);
+	test_assert(f->colorspace == linear);
+	test_assert(texture_closeTo(decoded.red, SRGBToLinear(0.5f)) && texture_closeTo(decoded.green, SRGBToLinear(0.02f)));
+	test_assert(decoded.alpha == 0.5f);
+	textureToSRGB(f);
+	test_assert(texture_closeTo(textureGetPixel(f, 0, 0, false).red, 0.5f));
+	destroyTexture(f);
+	return true;
+}
+
+// Tiles and their borders have to give back exactly what the texture in memory does
+bool texture_tiled_cache(void) {
+	struct texture *t = newTexture(char_p, 200, 130, 4);
+	for (size_t y = 0; y < t->height; ++y) {
+		for (size_t x = 0; x < t->width; ++x) {
+			setPixel(t, (struct color){ (x * 7 % 256) / 255.0f, (y * 13 % 256) / 255.0f, ((x ^ y) % 256) / 255.0f, 0.5f }, x, y);
+		}
+	}
+	generateMipmaps(t, NULL);
+	const char *path = "texture_tiled_cache.crtx";
+	test_assert(writeTiledTexture(t, path, 42));
+	// Nothing fits, so every shard only holds on to its last tile
+	struct textureCache *cache = newTextureCache(0);
+	test_assert(!openTiledTexture(cache, path, 43, NULL));
+	struct texture *tiled = openTiledTexture(cache, path, 42, NULL);
+	test_assert(tiled);
+	test_assert(tiled->width == t->width && tiled->height == t->height && tiled->mipCount == t->mipCount);
+
+	for (int i = 0; i < 2000; ++i) {
+		const float u = fmodf(i * 0.618034f, 1.0f);
+		const float v = fmodf(i * 0.414214f, 1.0f);
+		test_assert(texture_colorsClose(textureGetPixel(tiled, u, v, true), textureGetPixel(t, u, v, true)));
+		test_assert(colorEquals(textureGetPixel(tiled, i % 200, i % 130, false), textureGetPixel(t, i % 200, i % 130, false)));
+		const float footprint = (i % 9) / 64.0f;
+		test_assert(texture_colorsClose(textureGetPixelLod(tiled, u, v, footprint), textureGetPixelLod(t, u, v, footprint)));
+	}
+	const struct textureCacheStats stats = getTextureCacheStats(cache);
+	test_assert(stats.hits > 0 && stats.misses > 0);
+	test_assert(stats.evictions > 0);
+	free(tiled);
+	destroyTextureCache(cache);
+	destroyTexture(t);
+	remove(path);
+	return true;
+}
+
+// Largest difference between the decoded texels of two textures, in any channel
+static float texture_maxError(const struct texture *a, const struct texture *b) {
+	float error = 0.0f;
+	for (size_t y = 0; y < a->height; ++y) {
+		for (size_t x = 0; x < a->width; ++x) {
+			const struct color ca = textureGetPixel(a, x, y, false);
+			const struct color cb = textureGetPixel(b, x, y, false);
+			error = max(error, max(max(fabsf(ca.red - cb.red), fabsf(ca.green - cb.green)), max(fabsf(ca.blue - cb.blue), fabsf(ca.alpha - cb.alpha))));
+		}
+	}
+	return error;
+}
+
+bool texture_block_compression(void) {
+	// Smooth gradients, with sizes that aren't multiples of the block size. BC1 puts the colors of a block
+	// on a line, so they only vary along one, while alpha is compressed separately and can vary along the other.
+	struct texture *t = newTexture(char_p, 37, 21, 4);
+	for (size_t y = 0; y < t->height; ++y) {
+		for (size_t x = 0; x < t->width; ++x) {
+			setPixel(t, (struct color){ x / 36.0f, 1.0f - x / 36.0f, 0.25f, 1.0f - y / 40.0f }, x, y);
+		}
+	}
+	generateMipmaps(t, NULL);
+	struct texture *bc3 = compressTexture(t, NULL);
+	test_assert(bc3 && bc3->compression == bc3_c && bc3->hasAlpha);
+	test_assert(bc3->mipCount == t->mipCount);
+	test_assert(texture_maxError(t, bc3) < 0.03f);
+	for (size_t i = 0; i < t->mipCount; ++i) test_assert(texture_maxError(&t->mips[i], &bc3->mips[i]) < 0.03f);
+	// Compressed textures can't be compressed or mipmapped again
+	test_assert(!compressTexture(bc3, NULL));
+	destroyTexture(bc3);
+	destroyTexture(t);
+
+	// Endpoints that fit in 5:6:5 come back exactly, decoded from sRGB
+	struct texture *rgb = newTexture(char_p, 4, 4, 3);
+	rgb->colorspace = sRGB;
+	textureSelectFetch(rgb);
+	for (size_t i = 0; i < 16; ++i) setPixel(rgb, i % 3 ? (struct color){ 1.0f, 0.0f, 0.0f, 1.0f } : (struct color){ 0.0f, 0.0f, 1.0f, 1.0f }, i % 4, i / 4);
+	struct texture *bc1 = compressTexture(rgb, NULL);
+	test_assert(bc1 && bc1->compression == bc1_c);
+	test_assert(texture_maxError(rgb, bc1) == 0.0f);
+	destroyTexture(bc1);
+	destroyTexture(rgb);
+
+	// Grayscale goes to BC4, with eight levels per block
+	struct texture *gray = newTexture(char_p, 8, 8, 1);
+	for (size_t i = 0; i < 64; ++i) gray->data.byte_p[i] = (unsigned char)i;
+	struct texture *bc4 = compressTexture(gray, NULL);
+	test_assert(bc4 && bc4->compression == bc4_c);
+	test_assert(texture_maxError(gray, bc4) <= 3.0f / 255.0f);
+	destroyTexture(bc4);
+	destroyTexture(gray);
+
+	// Floats are left alone
+	struct texture *hdr = newTexture(float_p, 4, 4, 3);
+	test_assert(!compressTexture(hdr, NULL));
+	destroyTexture(hdr);
+	return true;
+}
+
+static bool texture_writeFile(const char *path, const unsigned char *contents, size_t bytes) {
+	FILE *file = fopen(path, "wb");
+	if (!file) return false;
+	const bool written = fwrite(contents, 1, bytes, file) == bytes;
+	fclose(file);
+	return written;
+}
+
+bool texture_registry_dedup(void) {
+	// A 2x2 binary PPM, written under two names
+	const unsigned char ppm[] = "P6\n2 2\n255\n\xff\x00\x00\x00\xff\x00\x00\x00\xff\xff\xff\xff";
+	test_assert(texture_writeFile("texture_registry_a.ppm", ppm, sizeof(ppm) - 1));
+	test_assert(texture_writeFile("texture_registry_b.ppm", ppm, sizeof(ppm) - 1));
+	char pathA[] = "texture_registry_a.ppm";
+	char pathA2[] = "texture_registry_a.ppm\n";
+	char pathB[] = "texture_registry_b.ppm";
+
+	struct textureRegistry *registry = newTextureRegistry();
+	beginTextureLoads(registry, NULL, NULL, NULL);
+	struct texture *a = loadTexture(pathA, sRGB, false, NULL);
+	struct texture *again = loadTexture(pathA2, sRGB, false, NULL);
+	struct texture *copy = loadTexture(pathB, sRGB, false, NULL);
+	struct texture *linearCopy = loadTexture(pathB, linear, false, NULL);
+	endTextureLoads();
+
+	test_assert(a && a->width == 2 && a->height == 2 && a->shared);
+	test_assert(again == a);
+	test_assert(copy == a);
+	test_assert(linearCopy && linearCopy != a);
+	const struct textureRegistryStats stats = textureRegistryStats(registry);
+	test_assert(stats.textures == 2);
+	test_assert(stats.hits == 2);
+	test_assert(stats.bytesSaved >= 2 * 2 * 2 * 3);
+	destroyTextureRegistry(registry);
+	remove("texture_registry_a.ppm");
+	remove("texture_registry_b.ppm");
+	return true;
+}
+
+bool texture_registry_preload(void) {
+	const unsigned char ppm[] = "P6\n2 2\n255\n\xff\x00\x00\x00\xff\x00\x00\x00\xff\xff\xff\xff";
+	test_assert(texture_writeFile("texture_preload.ppm", ppm, sizeof(ppm) - 1));
+	char path[] = "texture_preload.ppm";
+	char missing[] = "texture_preload_missing.ppm";
+
+	struct textureRegistry *registry = newTextureRegistry();
+	beginTextureLoads(registry, NULL, NULL, NULL);
+	preloadTexture(path, sRGB, false);
+	preloadTexture(path, sRGB, false);
+	preloadTexture(missing, sRGB, false);
+	struct texture *first = loadTexture(path, sRGB, false, NULL);
+	struct texture *second = loadTexture(path, sRGB, false, NULL);
+	struct texture *failed = loadTexture(missing, sRGB, false, NULL);
+	endTextureLoads();
+
+	test_assert(first && first->width == 2 && first->shared);
+	test_assert(second == first);
+	test_assert(!failed);
+	// Handing out a preloaded texture the first time isn't a hit
+	const struct textureRegistryStats stats = textureRegistryStats(registry);
+	test_assert(stats.textures == 1);
+	test_assert(stats.hits == 1);
+	destroyTextureRegistry(registry);
+	remove("texture_preload.ppm");
+	return true;
+}
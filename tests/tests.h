@@ -19,6 +19,14 @@ static char *failed_expression;
 #include "test_hashtable.h"
 #include "test_mempool.h"
 #include "test_base64.h"
+#include "test_args.h"
+#include "test_sampler.h"
+#include "test_lights.h"
+#include "test_nodes.h"
+#include "test_texture.h"
+#include "test_meshloader.h"
+#include "test_bakedscene.h"
+#include "test_taskgraph.h"
 
 static test tests[] = {
 	{"transforms::transpose", transform_transpose},
@@ -43,6 +51,7 @@ static test tests[] = {
 	{"textbuffer::textview", textbuffer_textview},
 	{"textbuffer::tokenizer", textbuffer_tokenizer},
 	{"textbuffer::new", textbuffer_new},
+	{"textbuffer::with_length", textbuffer_with_length},
 	{"textbuffer::gotoline", textbuffer_gotoline},
 	{"textbuffer::peekline", textbuffer_peekline},
 	{"textbuffer::nextline", textbuffer_nextline},
@@ -55,6 +64,7 @@ static test tests[] = {
 	{"fileio::humanFileSize", fileio_humanFileSize},
 	{"fileio::getFileName", fileio_getFileName},
 	{"fileio::getFilePath", fileio_getFilePath},
+	{"fileio::mapFile", fileio_mapFile},
 	
 	{"string::stringEquals", string_stringEquals},
 	{"string::stringContains", string_stringContains},
@@ -62,6 +72,7 @@ static test tests[] = {
 	{"string::concatString", string_concatString},
 	{"string::lowerCase", string_lowerCase},
 	{"string::startsWith", string_startsWith},
+	{"string::endsWith", string_endsWith},
 	
 	{"hashtable::mixed", hashtable_mixed},
 	{"hashtable::fill", hashtable_fill},
@@ -78,6 +89,45 @@ static test tests[] = {
 	{"mempool::tinyalloc4096", mempool_tiny_4096},
 	
 	{"base64::basic", base64_basic},
+	
+	{"args::parseDuration", args_parseDuration},
+	
+	{"sampler::sobol_range", sampler_sobol_range},
+	{"sampler::sobol_stratified", sampler_sobol_stratified},
+	{"sampler::sobol_decorrelated", sampler_sobol_decorrelated},
+	{"sampler::random_matches_pcg", sampler_random_matches_pcg},
+	{"sampler::random_unbounded_passes", sampler_random_unbounded_passes},
+	{"sampler::specialized_matches_dynamic", sampler_specialized_matches_dynamic},
+	
+	{"bsdf::pdf_matches_sample", bsdf_pdf_matches_sample},
+	{"bsdf::emission", bsdf_emission},
+	{"lights::sphere_pdf", lights_sphere_pdf},
+	{"lights::partial_emitter", lights_partial_emitter},
+	{"lights::tree_pdf", lights_tree_pdf},
+	{"lights::tree_prefers_nearby", lights_tree_prefers_nearby},
+	{"lights::environment_pdf", lights_environment_pdf},
+	{"lights::environment_integral", lights_environment_integral},
+	{"lights::sky_lut", lights_sky_lut},
+	{"nodes::constant_folding", nodes_constant_folding},
+	{"nodes::program_matches_graph", nodes_program_matches_graph},
+	{"nodes::checker_evaluates_one_side", nodes_checker_evaluates_one_side},
+	{"nodes::opaque_alpha_prunes_mix", nodes_opaque_alpha_prunes_mix},
+	{"texture::mipmap_chain", texture_mipmap_chain},
+	{"texture::lod_selection", texture_lod_selection},
+	{"texture::srgb_decode", texture_srgb_decode},
+	{"texture::tiled_cache", texture_tiled_cache},
+	{"texture::block_compression", texture_block_compression},
+	{"texture::registry_dedup", texture_registry_dedup},
+	{"texture::registry_preload", texture_registry_preload},
+	{"meshloader::obj_groups", meshloader_obj_groups},
+	{"meshloader::ply", meshloader_ply},
+	{"meshloader::gltf", meshloader_gltf},
+	{"meshloader::compact_attributes", meshloader_compact_attributes},
+	{"meshloader::obj_chunks", meshloader_obj_chunks},
+	{"bakedscene::rejects_invalid", bakedscene_rejects_invalid},
+	{"bakedscene::round_trip", bakedscene_round_trip},
+	{"taskgraph::runs_added_tasks", taskgraph_runs_added_tasks},
+	{"taskgraph::run_parallel", taskgraph_run_parallel},
 };
 
 #define testCount (sizeof(tests) / sizeof(test))